@@ -0,0 +1,104 @@
+/**
+ * @file main.cpp
+ *
+ * @brief Benchmark: compute region launch overhead with MIMMO_PRESENT()
+ * and with the descriptor table.
+ *
+ * Twenty dual arrays are touched by a tiny serial region, launched many
+ * times in a row. With MIMMO_PRESENT() each launch copies the twenty
+ * DualArray structs to device; with the descriptor table only the table
+ * pointer is passed.
+ *
+ * @ingroup benchmarks
+ *
+ * @see DualMemoryManager::descriptor_table()
+ * @see MIMMO_PRESENT
+ * @see MIMMO_TABLE_PRESENT
+ */
+
+#include "mimmo/api.hpp"
+#include <chrono>
+#include <iostream>
+
+#define NUM_LAUNCHES 10000
+#define DIM 1024
+
+/* list of benchmark arrays */
+#define ARRAYS(X)                                                              \
+  X(a0) X(a1) X(a2) X(a3) X(a4) X(a5) X(a6) X(a7) X(a8) X(a9) X(a10) X(a11)    \
+      X(a12) X(a13) X(a14) X(a15) X(a16) X(a17) X(a18) X(a19)
+
+#define DECLARE(x) MiMMO::DualArray<double> x;
+#define PRESENT(x) MIMMO_PRESENT(x)
+#define TOUCH(x) MIMMO_GET_PTR(x)[0] += 1.0;
+
+ARRAYS(DECLARE)
+
+int main() {
+  /* instantiate a dual memory manager */
+  MiMMO::DualMemoryManager dual_memory_manager = MiMMO::DualMemoryManager();
+
+  /* allocate and initialize dual arrays */
+#define ALLOC(x)                                                               \
+  dual_memory_manager.alloc_array(x, #x, DIM, true);                           \
+  for (int i = 0; i < DIM; i++)                                                \
+    x.host_ptr[i] = 0.0;                                                       \
+  dual_memory_manager.update_array_host_to_device(x, 0, x.size);
+  ARRAYS(ALLOC)
+
+  /* regions with one MIMMO_PRESENT() per array */
+  const auto start_present = std::chrono::steady_clock::now();
+
+  for (int n = 0; n < NUM_LAUNCHES; n++) {
+#pragma acc serial ARRAYS(PRESENT) default(none)
+    {
+      ARRAYS(TOUCH)
+    }
+  }
+
+  const auto end_present = std::chrono::steady_clock::now();
+
+  /* regions with the descriptor table (arrays have consecutive slots) */
+  const MiMMO::Descriptor *table = dual_memory_manager.descriptor_table();
+  const size_t first_slot = dual_memory_manager.descriptor_slot(a0);
+
+  const auto start_table = std::chrono::steady_clock::now();
+
+  for (int n = 0; n < NUM_LAUNCHES; n++) {
+#pragma acc serial MIMMO_TABLE_PRESENT(table) firstprivate(first_slot)        \
+    default(none)
+    {
+      for (size_t k = first_slot; k < first_slot + 20; k++)
+        MIMMO_TABLE_GET_PTR(table, double, k)[0] += 1.0;
+    }
+  }
+
+  const auto end_table = std::chrono::steady_clock::now();
+
+  /* check results */
+  dual_memory_manager.update_array_device_to_host(a19, 0, a19.size);
+  std::cout << "Check value: " << a19.host_ptr[0] << " (expected "
+            << 2 * NUM_LAUNCHES << ")\n";
+
+  /* print timings */
+  const double time_present =
+      std::chrono::duration<double, std::micro>(end_present - start_present)
+          .count() /
+      NUM_LAUNCHES;
+  const double time_table =
+      std::chrono::duration<double, std::micro>(end_table - start_table)
+          .count() /
+      NUM_LAUNCHES;
+
+  std::cout << "Region launch with MIMMO_PRESENT():       " << time_present
+            << " us\n";
+  std::cout << "Region launch with MIMMO_TABLE_PRESENT(): " << time_table
+            << " us\n";
+  std::cout << std::endl;
+
+  /* free dual array memory */
+#define FREE(x) dual_memory_manager.free_array(x);
+  ARRAYS(FREE)
+
+  return 0;
+}
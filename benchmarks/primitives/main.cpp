@@ -0,0 +1,100 @@
+/**
+ * @file main.cpp
+ *
+ * @brief Benchmark: hand-written loops and parallel primitives on host.
+ *
+ * Fill, axpy, scalar product and inclusive scan of large dual arrays are
+ * timed both as plain serial loops and through the corresponding
+ * primitives, which split the work among threads and vectorize the inner
+ * loops.
+ *
+ * @ingroup benchmarks
+ *
+ * @see MiMMO::fill
+ * @see MiMMO::axpy
+ * @see MiMMO::dot
+ * @see MiMMO::inclusive_scan
+ */
+
+#include "mimmo/api.hpp"
+#include <chrono>
+#include <iostream>
+
+#define NUM_REPETITIONS 10
+#define DIM (1 << 25)
+
+/* times a statement, in milliseconds per repetition (the call to a
+ * library function keeps the compiler from merging repetitions) */
+#define TIME(statement)                                                        \
+  [&]() {                                                                      \
+    const auto start = std::chrono::steady_clock::now();                       \
+    for (int r = 0; r < NUM_REPETITIONS; r++) {                                \
+      statement;                                                               \
+      MiMMO::host_num_threads();                                               \
+    }                                                                          \
+    const auto end = std::chrono::steady_clock::now();                         \
+    return std::chrono::duration<double, std::milli>(end - start).count() /    \
+           NUM_REPETITIONS;                                                    \
+  }()
+
+int main() {
+  /* instantiate a dual memory manager */
+  MiMMO::DualMemoryManager dual_memory_manager = MiMMO::DualMemoryManager();
+
+  /* allocate dual arrays and scalar */
+  MiMMO::DualArray<double> x;
+  dual_memory_manager.alloc_array(x, "x", DIM, false);
+  MiMMO::DualArray<double> y;
+  dual_memory_manager.alloc_array(y, "y", DIM, false);
+  MiMMO::DualScalar<double> result;
+  dual_memory_manager.create_scalar(result, "result", 0.0, false);
+
+  double *const px = x.host_ptr;
+  double *const py = y.host_ptr;
+  double sum = 0.0;
+  double product = 0.0;
+
+  /* fill */
+  const double fill_loop = TIME(for (size_t i = 0; i < DIM; i++) px[i] = 1.0);
+  const double fill_prim = TIME(MiMMO::fill(x, 1.0));
+
+  /* axpy */
+  MiMMO::fill(y, 0.0);
+  const double axpy_loop =
+      TIME(for (size_t i = 0; i < DIM; i++) py[i] += 0.5 * px[i]);
+  const double axpy_prim = TIME(MiMMO::axpy(y, 0.5, x));
+
+  /* scalar product */
+  const double dot_loop =
+      TIME(product = 0.0; for (size_t i = 0; i < DIM; i++)
+               product += px[i] * py[i]);
+  const double dot_prim = TIME(MiMMO::dot(result, x, y));
+
+  /* inclusive scan */
+  const double scan_loop = TIME(sum = 0.0; for (size_t i = 0; i < DIM; i++) {
+    sum += px[i];
+    py[i] = sum;
+  });
+  const double scan_prim = TIME(MiMMO::inclusive_scan(y, x));
+
+  /* print timings */
+  std::cout << "Threads: " << MiMMO::host_num_threads() << "\n";
+  std::cout << "Check values: " << product << " " << result.host_value
+            << " (scalar product), " << sum << " (last prefix sum)\n";
+  std::cout << "fill:           loop " << fill_loop << " ms, primitive "
+            << fill_prim << " ms\n";
+  std::cout << "axpy:           loop " << axpy_loop << " ms, primitive "
+            << axpy_prim << " ms\n";
+  std::cout << "dot:            loop " << dot_loop << " ms, primitive "
+            << dot_prim << " ms\n";
+  std::cout << "inclusive_scan: loop " << scan_loop << " ms, primitive "
+            << scan_prim << " ms\n";
+  std::cout << std::endl;
+
+  /* free dual array memory */
+  dual_memory_manager.free_array(x);
+  dual_memory_manager.free_array(y);
+  dual_memory_manager.destroy_scalar(result);
+
+  return 0;
+}
@@ -40,7 +40,33 @@
 #pragma once
 
 #include "../private/abort.hpp"
+#include "../private/bit_arrays.hpp"
+#include "../private/deferred_frees.hpp"
+#include "../private/delta_sync.hpp"
+#include "../private/descriptor_table.hpp"
+#include "../private/device_backend.hpp"
+#include "../private/groups.hpp"
+#include "../private/host_memcpy.hpp"
+#include "../private/host_parallel.hpp"
+#include "../private/memory_reconciliation.hpp"
 #include "../private/memory_tracker.hpp"
+#include "../private/numa.hpp"
+#include "../private/phase_profiler.hpp"
+#include "../private/prefetch.hpp"
+#include "../private/scratch_arena.hpp"
+#include "../private/shared_memory.hpp"
+#include "../private/stats_export.hpp"
+#include "../private/task_graph.hpp"
+#include "../private/transfer_planner.hpp"
+#include "../private/transfer_profiler.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <vector>
 #ifdef _OPENACC
 #include <openacc.h>
 #endif // _OPENACC
@@ -56,13 +82,17 @@ namespace MiMMO {
  * This struct contains all needed information related to a dual
  * array, i.e. the couple host pointer-device pointer.
  *
+ * Elements may have a different type on device (e.g. float on device for
+ * double on host), in which case they are converted during transfers.
+ *
  * @tparam T Type of elements in the array.
+ * @tparam D Type of elements in the array on device.
  */
-template <typename T> struct DualArray {
+template <typename T, typename D = T> struct DualArray {
   T *host_ptr;       /*!< pointer to host memory */
-  T *dev_ptr;        /*!< pointer to device memory */
+  D *dev_ptr;        /*!< pointer to device memory */
   size_t size;       /*!< number of elements in the array */
-  size_t size_bytes; /*!< size in bytes of the array */
+  size_t size_bytes; /*!< size in bytes of the array (on host) */
 };
 
 /**
@@ -79,6 +109,137 @@ template <typename T> struct DualScalar {
   T *dev_ptr;   /*!< pointer to value on device */
 };
 
+/**
+ * @brief Stores partitioned dual array data.
+ *
+ * @details
+ * The extent of the array is split into contiguous partitions, each
+ * stored in a dual array on its own device. Each partition also holds
+ * halo elements on both sides (overlapping neighbouring partitions),
+ * which are refreshed by DualMemoryManager::exchange_halos(). Element i of
+ * partition p is the global element first[p] + i, and the elements owned
+ * by partition p are the global elements from offsets[p] to
+ * offsets[p + 1] - 1.
+ *
+ * @tparam T Type of elements in the array.
+ */
+template <typename T> struct PartitionedDualArray {
+  std::vector<DualArray<T>> partitions; /*!< partitions, including halos */
+  std::vector<int> devices;             /*!< device of each partition */
+  std::vector<size_t> first;   /*!< global index of the first element of
+                                    each partition (halo included) */
+  std::vector<size_t> offsets; /*!< global index of the first element
+                                    owned by each partition, followed by
+                                    the size of the array */
+  size_t size;                 /*!< number of elements in the array */
+  size_t halo;                 /*!< number of halo elements on each side
+                                    of each partition */
+};
+
+/**
+ * @brief Stores a sparse matrix in compressed sparse row (CSR) format, on
+ * host and device.
+ *
+ * @details
+ * Values, column indices and row offsets live in a single tracked
+ * allocation (storage), in this order, so the whole matrix moves in one
+ * transfer and values alone in another one. The three components are
+ * views into the storage, usable as dual arrays in compute regions (e.g.
+ * through MIMMO_GET_PTR()), but not tracked on their own.
+ *
+ * @tparam T     Type of matrix values.
+ * @tparam Index Type of column indices and row offsets (e.g. 32-bit to
+ *               save memory and bandwidth, or 64-bit for more than 2^31
+ *               non-zeros).
+ */
+template <typename T, typename Index = int32_t> struct DualCSR {
+  DualArray<unsigned char> storage; /*!< allocation holding all
+                                         components */
+  DualArray<T> values;              /*!< non-zero values */
+  DualArray<Index> col_idx;         /*!< column of each non-zero value */
+  DualArray<Index> row_ptr;         /*!< offset of the first non-zero value
+                                         of each row, followed by the
+                                         number of non-zero values */
+  size_t num_rows;                  /*!< number of rows */
+  size_t num_cols;                  /*!< number of columns */
+};
+
+/**
+ * @brief Stores jagged (array-of-arrays) dual array data.
+ *
+ * @details
+ * Rows of different lengths are flattened into one value buffer, with
+ * the offset of each row, in a single tracked allocation (storage), so
+ * the whole array moves in one transfer. Values and offsets are views
+ * into the storage, not tracked on their own. Inside compute regions,
+ * rows are accessed through MIMMO_JAGGED_ROW_PTR() and
+ * MIMMO_JAGGED_ROW_SIZE().
+ *
+ * @tparam T Type of elements in the array.
+ */
+template <typename T> struct DualJaggedArray {
+  DualArray<unsigned char> storage; /*!< allocation holding values and
+                                         offsets */
+  DualArray<T> values;              /*!< values of all rows, row after
+                                         row */
+  DualArray<size_t> offsets;        /*!< offset of the first value of each
+                                         row, followed by the number of
+                                         values */
+  size_t num_rows;                  /*!< number of rows */
+};
+
+/**
+ * @brief Stores several time levels of a field (e.g. u^{n+1}, u^n,
+ * u^{n-1}) as a ring, on host and device.
+ *
+ * @details
+ * All levels live in a single tracked allocation (storage), one slot
+ * after the other, followed by a descriptor holding the offset of the
+ * slot of each level. Level 0 is the newest level. Rotating the ring
+ * (see DualMemoryManager::rotate_ring()) shifts every level to the next
+ * older one and reuses the slot of the oldest level for level 0, without
+ * moving any data: only the descriptor changes. Inside compute regions,
+ * levels are accessed through MIMMO_RING_LEVEL_PTR().
+ *
+ * @tparam T      Type of elements in each level.
+ * @tparam Levels Number of time levels.
+ */
+template <typename T, size_t Levels> struct DualRing {
+  static_assert(Levels > 0, "A ring needs at least one level.");
+
+  DualArray<unsigned char> storage; /*!< allocation holding the slots
+                                         and the descriptor */
+  DualArray<T> values;              /*!< values of all slots, slot after
+                                         slot */
+  DualArray<size_t> offsets;        /*!< descriptor: offset of the first
+                                         value of each level */
+  size_t size;                      /*!< number of elements of each
+                                         level */
+  size_t head;                      /*!< slot of level 0 */
+};
+
+/**
+ * @brief Stores bit-packed dual array data.
+ *
+ * @details
+ * Bits are packed into 64-bit words, stored in a dual array. Inside
+ * compute regions, bits are accessed through get_bit(), set_bit() and
+ * set_bit_atomic() on MIMMO_GET_PTR(words). Bits past the size in the
+ * last word are kept cleared.
+ */
+struct DualBitArray {
+  DualArray<uint64_t> words; /*!< words storing the bits */
+  size_t size;               /*!< number of bits in the array */
+};
+
+/**
+ * @brief Side (host or device) on which an operation is performed.
+ */
+enum class Side {
+  Host,  /*!< host memory */
+  Device /*!< device memory */
+};
+
 /**
  * @brief Class for host-device memory management.
  *
@@ -88,215 +249,3236 @@ template <typename T> struct DualScalar {
  *
  * The memory manager keeps track of allocated arrays on host and device
  * using its tracker.
+ *
+ * Device memory operations go through a DeviceBackend. By default this is
+ * OpenACC if enabled; otherwise there is no device memory, and dual
+ * objects only live on host.
+ *
+ * With several devices, dual objects are allocated on the current device
+ * (see set_device()) and operations on them use that device.
  */
 class DualMemoryManager {
 private:
   std::pair<size_t, size_t> total_memory; /*!< total used memory on host
                                                and device */
-  std::map<void *, std::tuple<std::string, size_t, bool>>
+  std::map<void *, TrackerEntry>
       memory_tracker; /*!< memory tracker for reports */
+  std::map<std::string, LabelMemory>
+      label_memory; /*!< memory used by the tracked objects of each label */
+  void *staging_host_ptr;           /*!< host staging buffer for packed
+                                         transfers */
+  void *staging_dev_ptr;            /*!< device staging buffer for packed
+                                         transfers */
+  size_t staging_size_bytes;        /*!< size in bytes of each staging
+                                         buffer */
+  int staging_device;               /*!< device of the device staging
+                                         buffer */
+  double indexed_density_threshold; /*!< ratio between indexed and
+                                         contiguous transfer volume above
+                                         which indexed transfers fall back
+                                         to a contiguous copy */
+  ScratchArena scratch_arena;       /*!< arena for device-only scratch
+                                         arrays */
+  std::map<std::string, AllocationGroup> groups; /*!< allocation groups */
+  DescriptorTable descriptors; /*!< descriptor table of tracked objects */
+  std::shared_ptr<DeviceBackend> backend; /*!< backend performing device
+                                               memory operations */
+  TransferModel transfer_model; /*!< transfer model used by the planner */
+  NumaPolicy numa_policy;       /*!< NUMA placement of host memory */
+  int numa_node;                /*!< NUMA node of the Bind policy */
+  std::map<void *, size_t> host_buffers; /*!< host buffers allocated by the
+                                              manager, with their size in
+                                              bytes */
+  std::map<void *, SharedSegment> shared_segments; /*!< shared-memory
+                                                        segments of shared
+                                                        dual arrays */
+  std::map<void *, DeltaSyncState> delta_states; /*!< delta synchronization
+                                                      state of dual
+                                                      arrays */
+  bool transfer_profiling; /*!< whether transfers are profiled */
+  std::map<void *, std::map<std::pair<size_t, size_t>, uint64_t>>
+      transfer_shadows; /*!< shadow checksums of the ranges (offset and
+                             size in bytes) last transferred for each
+                             object */
+  std::map<std::tuple<std::string, std::string, int, bool>,
+           TransferSiteStats>
+      transfer_sites; /*!< statistics of profiled transfers by label, call
+                           site and direction */
+  PhaseProfiler phases; /*!< statistics of nested phases */
+  std::chrono::steady_clock::time_point
+      creation_time; /*!< instant of construction of the manager */
+  std::vector<MemorySample> memory_samples; /*!< history of memory
+                                                 samples */
+  size_t low_memory_bytes;         /*!< free device memory below which the
+                                        low-memory alarm is raised */
+  LowMemoryAlarm low_memory_alarm; /*!< callback of the low-memory alarm
+                                        (empty if disabled) */
+  bool low_memory_raised;          /*!< whether the low-memory alarm is
+                                        running */
+  StatsExporter stats_exporter; /*!< exporter of live statistics */
+  std::vector<DeferredBlock> pending_frees; /*!< buffers waiting for their
+                                                 queue to be released */
+  std::vector<DeferredBlock> reuse_cache;   /*!< released buffers kept for
+                                                 reuse, oldest first */
+  size_t reuse_cache_limit;                 /*!< maximum bytes in the
+                                                 reuse cache */
+  DeferredFreeStats deferred_stats;         /*!< counters of deferred
+                                                 frees */
+  std::vector<PrefetchEntry> prefetches; /*!< prefetches not yet
+                                              required */
+  std::map<std::string, std::vector<PrefetchEntry>>
+      phase_prefetches;         /*!< prefetches required when each phase
+                                     begins */
+  PrefetchStats prefetch_stats; /*!< counters of prefetches */
 
-public:
   /**
-   * @brief Class constructor.
+   * @brief Allocates host memory according to the NUMA placement policy.
+   *
+   * @param num_elements  Number of elements to be allocated.
+   * @param element_bytes Size in bytes of each element.
+   *
+   * @return              Pointer to host memory (nullptr if allocation
+   *                      failed).
    */
-  DualMemoryManager() : total_memory({0, 0}), memory_tracker({}) {}
+  void *host_alloc(const size_t num_elements, const size_t element_bytes);
 
   /**
-   * @brief Allocates dual array memory.
+   * @brief Frees host memory allocated by host_alloc().
    *
-   * @details
-   * This function allocates memory on host and (if requested) on device
-   * for a certain array. It returns an object of type DualArray,
-   * containing host and device pointers.
+   * @param host_ptr Pointer to host memory (nullptr is ignored).
+   */
+  void host_free(void *const host_ptr);
+
+  /**
+   * @brief Allocates device memory through the backend.
    *
-   * @param dual_array Dual array to be allocated.
-   * @param label      Label that should be used to track the array in
-   *                   memory.
-   * @param size       Number of elements in the array.
-   * @param on_device  Whether the array should be allocated on device as
-   *                   well (ignored if main code compiled without OpenACC
-   *                   support).
+   * @param size_bytes Number of bytes to be allocated.
+   *
+   * @return           Pointer to device memory.
+   *
+   * @note If allocation fails, the program aborts.
    */
-  template <typename T>
-  void alloc_array(DualArray<T> &dual_array, const std::string label,
-                   const size_t size, const bool on_device = false);
+  void *device_alloc(const size_t size_bytes);
 
   /**
-   * @brief Copies data from host to device.
+   * @brief Raises the low-memory alarm, if set, when an allocation would
+   * leave too little free memory on the current device.
    *
-   * @tparam T           Type of elements in the array.
+   * @param size_bytes Number of bytes about to be allocated.
+   */
+  void check_low_memory(const size_t size_bytes);
+
+  /**
+   * @brief Records allocations and frees of dual objects for phases and
+   * live statistics.
    *
-   * @param dual_array   Dual array to synchronize.
-   * @param offset       Index of first element to be copied.
-   * @param num_elements Number of elements to be copied.
+   * @param num_allocs Number of allocated objects.
+   * @param num_frees  Number of freed objects.
+   */
+  void record_memory(const size_t num_allocs, const size_t num_frees);
+
+  /**
+   * @brief Records a host-device transfer for phases and live statistics.
    *
-   * @note If OpenACC is not enabled, this function does nothing.
+   * @param to_device  Whether data was copied from host to device (or the
+   *                   other way round).
+   * @param size_bytes Number of bytes copied.
+   * @param seconds    Time of the transfer, in s (only measured while a
+   *                   phase is open).
    */
-  template <typename T>
-  void update_array_host_to_device(DualArray<T> dual_array, const size_t offset,
-                                   const size_t num_elements);
+  void record_transfer(const bool to_device, const size_t size_bytes,
+                       const double seconds);
 
   /**
-   * @brief Copies data from device to host.
+   * @brief Writes live statistics, with memory used by label, into the
+   * statistics page.
+   */
+  void export_stats();
+
+  /**
+   * @brief Frees device memory through the backend.
+   *
+   * @param dev_ptr Pointer to device memory (nullptr is ignored).
+   */
+  void device_free(void *const dev_ptr);
+
+  /**
+   * @brief Frees device memory of a given device through the backend.
+   *
+   * @param dev_ptr Pointer to device memory (nullptr is ignored).
+   * @param device  Device owning the memory.
+   */
+  void device_free(void *const dev_ptr, const int device);
+
+  /**
+   * @brief Returns the device on which a tracked object is allocated.
+   *
+   * @param object Pointer to the dual object.
+   *
+   * @return       Device of the object (current device if not tracked).
+   */
+  int object_device(const void *const object);
+
+  /**
+   * @brief Checks that host memory of a dual object can be written.
+   *
+   * @param object Pointer to the dual object.
+   *
+   * @note If host memory is shared and read-only in this process
+   *       (attached, or already published), the program aborts.
+   */
+  void check_host_writable(const void *const object);
+
+  /**
+   * @brief Copies data from host to device through the backend.
+   *
+   * @param dev_ptr    Destination on device.
+   * @param host_ptr   Source on host.
+   * @param size_bytes Number of bytes to be copied.
+   */
+  void copy_to_device(void *const dev_ptr, const void *const host_ptr,
+                      const size_t size_bytes);
+
+  /**
+   * @brief Copies data from device to host through the backend.
+   *
+   * @param host_ptr   Destination on host.
+   * @param dev_ptr    Source on device.
+   * @param size_bytes Number of bytes to be copied.
+   */
+  void copy_from_device(void *const host_ptr, const void *const dev_ptr,
+                        const size_t size_bytes);
+
+  /**
+   * @brief Makes sure staging buffers can hold a given number of bytes.
+   *
+   * @param size_bytes Minimum size in bytes of the staging buffers.
+   */
+  void reserve_staging_buffers(const size_t size_bytes);
+
+  /**
+   * @brief Assigns a descriptor table slot to a tracked object.
+   *
+   * @param object   Pointer to the tracked dual object.
+   * @param host_ptr Host pointer of the object.
+   * @param dev_ptr  Device pointer of the object.
+   * @param size     Number of elements of the object.
+   */
+  void register_descriptor(void *const object, void *const host_ptr,
+                           void *const dev_ptr, const size_t size);
+
+  /**
+   * @brief Updates the pointer stored in the descriptor of an object.
+   *
+   * @param object   Pointer to the tracked dual object.
+   * @param host_ptr Host pointer of the object.
+   * @param dev_ptr  Device pointer of the object.
+   */
+  void update_descriptor(void *const object, void *const host_ptr,
+                         void *const dev_ptr);
+
+  /**
+   * @brief Releases the descriptor table slot of an object.
+   *
+   * @param slot Slot to be released.
+   */
+  void unregister_descriptor(const size_t slot);
+
+  /**
+   * @brief Performs an indexed transfer in the requested direction.
    *
    * @tparam T           Type of elements in the array.
    *
    * @param dual_array   Dual array to synchronize.
-   * @param offset       Index of first element to be copied.
-   * @param num_elements Number of elements to be copied.
-   *
-   * @note If OpenACC is not enabled, this function does nothing.
+   * @param host_indices Indices of the elements to be copied, on host.
+   * @param dev_indices  Same indices on device, or nullptr if they must be
+   *                     transferred together with the values.
+   * @param num_indices  Number of indices.
+   * @param to_device    Whether data should be copied from host to device
+   *                     (or the other way round).
    */
   template <typename T>
-  void update_array_device_to_host(DualArray<T> dual_array, const size_t offset,
-                                   const size_t num_elements);
+  void update_array_indexed(DualArray<T> &dual_array,
+                            const size_t *const host_indices,
+                            const size_t *const dev_indices,
+                            const size_t num_indices, const bool to_device);
 
   /**
-   * @brief Frees memory allocated for a given dual array.
+   * @brief Copies a contiguous buffer between host and device, possibly
+   * split into pipelined chunks.
+   *
+   * @param dst_ptr     Destination buffer.
+   * @param src_ptr     Source buffer.
+   * @param size_bytes  Number of bytes to be copied.
+   * @param to_device   Whether data is copied from host to device (or the
+   *                    other way round).
+   * @param chunk_bytes Size of chunks (0 for a single transfer).
+   */
+  void transfer_chunked(void *const dst_ptr, const void *const src_ptr,
+                        const size_t size_bytes, const bool to_device,
+                        const size_t chunk_bytes);
+
+  /**
+   * @brief Performs a planned multi-range transfer in the requested
+   * direction.
    *
    * @tparam T         Type of elements in the array.
    *
-   * @param dual_array Dual array to be freed.
+   * @param dual_array Dual array to synchronize.
+   * @param ranges     Ranges of elements to be copied.
+   * @param to_device  Whether data should be copied from host to device (or
+   *                   the other way round).
    *
-   * @note If the array is not tracked, the program aborts.
+   * @return           Number of bytes moved between host and device.
    */
-  template <typename T> void free_array(DualArray<T> &dual_array);
+  template <typename T>
+  size_t update_array_ranges(DualArray<T> &dual_array,
+                           const std::vector<TransferRange> &ranges,
+                           const bool to_device);
 
   /**
-   * @brief Creates a dual scalar.
+   * @brief Copies the blocks of a range of a dual array that changed since
+   * the last upload from host to device.
    *
-   * @details
-   * This function creates a scalar variable on host and optionally on
-   * device (allocating a one-element array), and assigns the requested
-   * value. It returns an object of type DualScalar that contains the host
-   * value and the device pointer.
+   * @tparam T           Type of elements in the array.
    *
-   * @param dual_scalar Dual scalar to be created.
-   * @param label       Label that should be used to track the scalar in
-   *                    memory.
-   * @param value       Value to which the scalar should be initialized.
-   * @param on_device   Whether the scalar should be created on device as
-   *                    well (ignored if main code compiled without OpenACC
-   *                    support).
+   * @param dual_array   Dual array to synchronize.
+   * @param offset       Index of first element to be copied.
+   * @param num_elements Number of elements to be copied.
+   * @param state        Delta synchronization state of the array.
    */
   template <typename T>
-  void create_scalar(DualScalar<T> &dual_scalar, const std::string label,
-                     const T value, const bool on_device = false);
+  void update_array_delta(DualArray<T> &dual_array, const size_t offset,
+                          const size_t num_elements, DeltaSyncState &state);
 
   /**
-   * @brief Updates the value of a dual scalar from host to device.
+   * @brief Records a profiled transfer of a tracked object.
    *
-   * @tparam T          Type of the scalar variable.
+   * @param object     Pointer to the tracked object.
+   * @param offset     Offset in bytes of the range in the object.
+   * @param size_bytes Number of bytes transferred.
+   * @param old_hash   Checksum of host data before the transfer.
+   * @param new_hash   Checksum of host data after the transfer.
+   * @param to_device  Whether data was copied from host to device (or the
+   *                   other way round).
+   * @param location   Call site of the transfer.
+   */
+  void profile_transfer(void *const object, const size_t offset,
+                        const size_t size_bytes, const uint64_t old_hash,
+                        const uint64_t new_hash, const bool to_device,
+                        const SourceLocation &location);
+
+  /**
+   * @brief Drops the transfer state (delta synchronization, shadow
+   * checksums and prefetches) of an object being freed.
    *
-   * @param dual_scalar Dual scalar to synchronize.
+   * @param object Pointer to the object.
+   */
+  void release_transfer_state(void *const object);
+
+  /**
+   * @brief Tracks a dual array whose memory was just allocated.
    *
-   * @note The scalar must have been previously created using create_scalar().
-   *       If the scalar is not present on device, the program aborts.
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array, with its pointers and sizes set.
+   * @param label      Label that should be used to track the array in
+   *                   memory.
+   * @param on_device  Whether the array is allocated on device.
    */
   template <typename T>
-  void update_scalar_host_to_device(DualScalar<T> &dual_scalar);
+  void track_array(DualArray<T> &dual_array, const std::string label,
+                   const bool on_device);
 
   /**
-   * @brief Updates the value of a dual scalar from device to host.
+   * @brief Stops tracking a dual array being freed.
    *
-   * @tparam T          Type of the scalar variable.
+   * @tparam T         Type of elements in the array.
    *
-   * @param dual_scalar Dual scalar to synchronize.
+   * @param dual_array Dual array to be freed.
    *
-   * @note The scalar must have been previously created using create_scalar().
-   *       If the scalar is not present on device, the program aborts.
-   *       If OpenACC is not enabled, this function does nothing.
+   * @return           Device of the array.
+   *
+   * @note If the array is not tracked, belongs to an allocation group, or
+   *       is shared, the program aborts.
    */
-  template <typename T>
-  void update_scalar_device_to_host(DualScalar<T> &dual_scalar);
+  template <typename T> int untrack_array(DualArray<T> &dual_array);
 
   /**
-   * @brief Frees memory allocated on device for a given scalar.
+   * @brief Stops tracking a dual scalar being destroyed.
    *
    * @tparam T          Type of the scalar variable.
    *
    * @param dual_scalar Dual scalar to be destroyed.
    *
+   * @return            Device of the scalar.
+   *
    * @note If the scalar is not tracked, the program aborts.
-   *       If OpenACC is not enabled, this function does nothing.
    */
-  template <typename T> void destroy_scalar(DualScalar<T> &dual_scalar);
+  template <typename T> int untrack_scalar(DualScalar<T> &dual_scalar);
 
   /**
-   * @brief Returns the total host and device memory allocated by
-   * the memory manager.
+   * @brief Puts a buffer on the pending list of a queue.
    *
-   * @details
-   * This function returns a pair where the elements are the total
-   * memory allocated on host and device, respectively.
+   * @param ptr        Pointer to the buffer (nullptr is ignored).
+   * @param size_bytes Size in bytes of the buffer.
+   * @param on_device  Whether the buffer is device (or host) memory.
+   * @param device     Device of the buffer and of the queue.
+   * @param queue      Queue after which the buffer may be released.
+   */
+  void defer_free(void *const ptr, const size_t size_bytes,
+                  const bool on_device, const int device, const int queue);
+
+  /**
+   * @brief Takes a buffer of a given size out of the reuse cache, or out
+   * of the pending list of the same queue for device memory.
    *
-   * @return (total host memory used, total device memory used)
+   * @param size_bytes Size in bytes of the buffer.
+   * @param on_device  Whether device (or host) memory is needed.
+   * @param queue      Queue on which the buffer will be used.
+   *
+   * @return           Pointer to the buffer (nullptr if none is found).
    */
-  std::pair<size_t, size_t> return_total_memory_usage();
+  void *take_deferred_block(const size_t size_bytes, const bool on_device,
+                            const int queue);
 
   /**
-   * @brief Reports memory used by the memory manager.
+   * @brief Releases a buffer whose free was deferred.
    *
-   * @details
-   * This function prints to standard output a complete report of memory
-   * usage of the memory manager.
+   * @param block Buffer to be released.
+   */
+  void release_deferred_block(const DeferredBlock &block);
+
+  /**
+   * @brief Marks the prefetches of a device as complete.
    *
-   * A list of all allocated arrays is shown, with size (in bytes) and
-   * whether the array is present on device or not.
+   * @param device Device whose prefetch queue is idle.
    */
-  void report_memory_usage();
+  void mark_prefetches_complete(const int device);
 
-  /// @todo Consider adding a destructor to clean up tracked memory.
-};
+  /**
+   * @brief Completes the prefetches of an object overlapping a range,
+   * waiting for them if they are still in flight.
+   *
+   * @param object       Address of the object.
+   * @param to_device    Whether data is needed on device (or host).
+   * @param offset_bytes Offset in bytes of the needed range.
+   * @param size_bytes   Size in bytes of the needed range.
+   *
+   * @return             Whether prefetches covered the whole range
+   *                     (counted as a hit or as late).
+   */
+  bool consume_prefetches(const void *const object, const bool to_device,
+                          const size_t offset_bytes, const size_t size_bytes);
 
-} // namespace MiMMO
+  /**
+   * @brief Drops the prefetches of an object being freed, waiting for
+   * those still in flight.
+   *
+   * @param object Pointer to the object.
+   */
+  void drop_prefetches(const void *const object);
 
-/**
- * @brief Returns the device or host pointer depending on compilation flags.
- *
- * @param x Dual array from which the pointer should be selected.
- *
- * @note Use inside OpenACC compute regions only.
- */
-#ifdef _OPENACC
-#define MIMMO_GET_PTR(x) (x).dev_ptr
-#else
-#define MIMMO_GET_PTR(x) (x).host_ptr
-#endif // _OPENACC
+  /**
+   * @brief Requires the prefetches declared for a phase.
+   *
+   * @param name Name of the phase.
+   */
+  void require_phase_prefetches(const std::string &name);
 
-/**
- * @brief Returns the device or host value depending on compilation flags.
- *
- * @param x Dual scalar from which the value should be selected.
- *
- * @note Use inside OpenACC compute regions only.
- */
-#ifdef _OPENACC
-#define MIMMO_GET_VALUE(x) *((x).dev_ptr)
-#else
-#define MIMMO_GET_VALUE(x) (x).host_value
-#endif // _OPENACC
+public:
+  /**
+   * @brief Class constructor.
+   */
+  DualMemoryManager() : DualMemoryManager(default_device_backend()) {}
 
-/**
- * @brief Communicates in an OpenACC pragma that a dual array or scalar is
- * present on device.
- *
- * @param x Dual array or scalar present on device.
- *
- * @note Must be used inside an OpenACC pragma at the beginning of a compute
- *       region.
- * @note Takes only one argument; use multiple calls for multiple objects.
- * @note No copy variant exists by design; use DualMemoryManager methods for
- *       data movement.
- */
-#ifdef _OPENACC
-#define MIMMO_PRESENT(x) copyin(x) deviceptr(x.dev_ptr)
-#else
-#define MIMMO_PRESENT(x)
+  /**
+   * @brief Class constructor with a given device backend.
+   *
+   * @details
+   * All device memory operations of the memory manager go through the
+   * backend, e.g. an EmulatedDeviceBackend to exercise transfers without
+   * a GPU.
+   *
+   * @param backend Backend performing device memory operations.
+   */
+  explicit DualMemoryManager(std::shared_ptr<DeviceBackend> backend)
+      : total_memory({0, 0}), memory_tracker({}), label_memory({}),
+        staging_host_ptr(nullptr),
+        staging_dev_ptr(nullptr), staging_size_bytes(0), staging_device(0),
+        indexed_density_threshold(0.5),
+        scratch_arena({nullptr, 0, 0, 0, false, 0, {}}), groups({}),
+        descriptors({{}, nullptr, 0, 0, {}, false}),
+        backend(std::move(backend)),
+        transfer_model(default_transfer_model()),
+        numa_policy(NumaPolicy::Default), numa_node(0), host_buffers({}),
+        shared_segments({}), delta_states({}), transfer_profiling(false),
+        transfer_shadows({}), transfer_sites({}), phases(),
+        creation_time(std::chrono::steady_clock::now()), memory_samples({}),
+        low_memory_bytes(0), low_memory_alarm(), low_memory_raised(false),
+        stats_exporter(), pending_frees({}), reuse_cache({}),
+        reuse_cache_limit(0), deferred_stats({0, 0, 0, 0, 0, 0, 0, 0, 0}),
+        prefetches({}), phase_prefetches({}),
+        prefetch_stats({0, 0, 0, 0, 0, 0, 0.0}) {
+    if (!(this->backend))
+      abort_mimmo("Device backend is a null pointer.");
+  }
+
+  /**
+   * @brief Class destructor.
+   *
+   * @details
+   * Releases the internal staging buffers, the scratch arena, the
+   * descriptor table and buffers of deferred frees. Dual arrays and
+   * scalars are not freed and must be released by the user.
+   */
+  ~DualMemoryManager();
+
+  DualMemoryManager(const DualMemoryManager &) = delete;
+  DualMemoryManager &operator=(const DualMemoryManager &) = delete;
+
+  /**
+   * @brief Allocates dual array memory.
+   *
+   * @details
+   * This function allocates memory on host and (if requested) on device
+   * for a certain array. It returns an object of type DualArray,
+   * containing host and device pointers.
+   *
+   * @param dual_array Dual array to be allocated.
+   * @param label      Label that should be used to track the array in
+   *                   memory.
+   * @param size       Number of elements in the array.
+   * @param on_device  Whether the array should be allocated on device as
+   *                   well (ignored without device memory).
+   */
+  template <typename T>
+  void alloc_array(DualArray<T> &dual_array, const std::string label,
+                   const size_t size, const bool on_device = false);
+
+  /**
+   * @brief Reserves dual array memory, deferring allocation to first use.
+   *
+   * @details
+   * This function tracks a dual array without allocating any memory.
+   * Host and device memory are materialized separately the first time
+   * they are needed: by a transfer, by an access through get_host_ptr()
+   * or get_dev_ptr(), or by an explicit call to materialize(). Memory
+   * that is never used is never allocated.
+   *
+   * Until materialized, the corresponding pointer of the dual array is a
+   * null pointer.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to be reserved.
+   * @param label      Label that should be used to track the array in
+   *                   memory.
+   * @param size       Number of elements in the array.
+   * @param on_device  Whether the array may be materialized on device as
+   *                   well (ignored without device memory).
+   */
+  template <typename T>
+  void alloc_array_lazy(DualArray<T> &dual_array, const std::string label,
+                        const size_t size, const bool on_device = false);
+
+  /**
+   * @brief Materializes memory of a dual array on one side.
+   *
+   * @details
+   * If memory on the requested side is already allocated, this function
+   * does nothing.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to be materialized.
+   * @param side       Side on which memory should be materialized.
+   *
+   * @note If the array is not tracked, or it is materialized on device
+   *       while not reserved on device, the program aborts.
+   * @note Without device memory, materializing on device does
+   *       nothing.
+   */
+  template <typename T>
+  void materialize(DualArray<T> &dual_array, const Side side);
+
+  /**
+   * @brief Returns the host pointer of a dual array, materializing host
+   * memory if needed.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to be accessed.
+   *
+   * @return           Pointer to host memory of the array.
+   */
+  template <typename T> T *get_host_ptr(DualArray<T> &dual_array);
+
+  /**
+   * @brief Returns the device pointer of a dual array, materializing
+   * device memory if needed.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to be accessed.
+   *
+   * @return           Pointer to device memory of the array (nullptr
+   *                   without device memory).
+   */
+  template <typename T> T *get_dev_ptr(DualArray<T> &dual_array);
+
+  /**
+   * @brief Copies data from host to device.
+   *
+   * @tparam T           Type of elements in the array.
+   *
+   * @param dual_array   Dual array to synchronize.
+   * @param offset       Index of first element to be copied.
+   * @param num_elements Number of elements to be copied.
+   * @param location     Call site, recorded in profiling mode (filled in
+   *                     automatically).
+   *
+   * @note Memory of lazily allocated arrays is materialized on both
+   *       sides.
+   * @note With delta synchronization (see enable_delta_sync()), only the
+   *       blocks of the range that changed since the last upload are
+   *       copied.
+   * @note In profiling mode, uploads are profiled as requested, even if
+   *       delta synchronization then skips unchanged blocks.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_array_host_to_device(
+      DualArray<T> &dual_array, const size_t offset, const size_t num_elements,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies data from device to host.
+   *
+   * @tparam T           Type of elements in the array.
+   *
+   * @param dual_array   Dual array to synchronize.
+   * @param offset       Index of first element to be copied.
+   * @param num_elements Number of elements to be copied.
+   * @param location     Call site, recorded in profiling mode (filled in
+   *                     automatically).
+   *
+   * @note Memory of lazily allocated arrays is materialized on both
+   *       sides.
+   * @note If host memory is shared and read-only, the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_array_device_to_host(
+      DualArray<T> &dual_array, const size_t offset, const size_t num_elements,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Enqueues a copy of data from host to device.
+   *
+   * @details
+   * The copy is only guaranteed to be complete after wait_queue() or
+   * wait_all_queues(), and host data must not be modified until then.
+   *
+   * @tparam T           Type of elements in the array.
+   *
+   * @param dual_array   Dual array to synchronize.
+   * @param offset       Index of first element to be copied.
+   * @param num_elements Number of elements to be copied.
+   * @param queue        Queue on which the copy is enqueued (on the device
+   *                     of the array).
+   *
+   * @note Memory of lazily allocated arrays is materialized on both
+   *       sides.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_array_host_to_device_async(DualArray<T> &dual_array,
+                                         const size_t offset,
+                                         const size_t num_elements,
+                                         const int queue);
+
+  /**
+   * @brief Enqueues a copy of data from device to host.
+   *
+   * @details
+   * The copy is only guaranteed to be complete after wait_queue() or
+   * wait_all_queues(), and host data must not be accessed until then.
+   *
+   * @tparam T           Type of elements in the array.
+   *
+   * @param dual_array   Dual array to synchronize.
+   * @param offset       Index of first element to be copied.
+   * @param num_elements Number of elements to be copied.
+   * @param queue        Queue on which the copy is enqueued (on the device
+   *                     of the array).
+   *
+   * @note Memory of lazily allocated arrays is materialized on both
+   *       sides.
+   * @note If host memory is shared and read-only, the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_array_device_to_host_async(DualArray<T> &dual_array,
+                                         const size_t offset,
+                                         const size_t num_elements,
+                                         const int queue);
+
+  /**
+   * @brief Waits for all copies enqueued on a queue of the current device.
+   *
+   * @param queue Queue to wait for.
+   */
+  void wait_queue(const int queue);
+
+  /**
+   * @brief Waits for all copies enqueued on any queue.
+   */
+  void wait_all_queues();
+
+  /**
+   * @brief Makes a queue of the current device wait for all work enqueued
+   * on another queue so far, without blocking the host if possible.
+   *
+   * @details
+   * With OpenACC this is acc_wait_async(). Backends that cannot order
+   * queues make the host wait for the other queue instead.
+   *
+   * @param queue         Queue to wait for.
+   * @param waiting_queue Queue whose later work must wait.
+   */
+  void wait_queue_async(const int queue, const int waiting_queue);
+
+  /**
+   * @brief Checks whether all copies enqueued on a queue are complete,
+   * without blocking.
+   *
+   * @param queue Queue to be checked.
+   *
+   * @return      Whether the queue is idle.
+   */
+  bool test_queue(const int queue);
+
+  /**
+   * @brief Allocates dual array memory in order with a queue.
+   *
+   * @details
+   * Like alloc_array(), but buffers of the same size released by deferred
+   * frees are reused when possible: from the reuse cache, or, for device
+   * memory, from the pending list of the same queue, since work enqueued
+   * on the queue runs after the work still using them. Host memory is
+   * only reused once idle.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to be allocated.
+   * @param label      Label that should be used to track the array in
+   *                   memory.
+   * @param size       Number of elements in the array.
+   * @param queue      Queue on which the array will be used (on the
+   *                   current device).
+   * @param on_device  Whether the array should be allocated on device as
+   *                   well (ignored without device memory).
+   *
+   * @note Device memory taken from the pending list of the queue must
+   *       only be accessed by work enqueued on that queue until it is
+   *       idle.
+   */
+  template <typename T>
+  void alloc_array_async(DualArray<T> &dual_array, const std::string label,
+                         const size_t size, const int queue,
+                         const bool on_device = false);
+
+  /**
+   * @brief Frees memory of a dual array once a queue is idle.
+   *
+   * @details
+   * The array is untracked immediately, but its buffers are put on the
+   * pending list of the queue, so that work enqueued on the queue may
+   * still use them and the host does not wait for the device. Pending
+   * buffers are released, or moved to the reuse cache, by later calls to
+   * alloc_array_async(), free_array_async(), destroy_scalar_async() or
+   * collect_deferred_frees() that find the queue idle.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to be freed.
+   * @param queue      Queue of the last work using the array (on the
+   *                   device of the array).
+   *
+   * @note If the array is not tracked, belongs to an allocation group, or
+   *       is shared, the program aborts.
+   */
+  template <typename T>
+  void free_array_async(DualArray<T> &dual_array, const int queue);
+
+  /**
+   * @brief Frees device memory of a dual scalar once a queue is idle.
+   *
+   * @tparam T          Type of the scalar variable.
+   *
+   * @param dual_scalar Dual scalar to be destroyed.
+   * @param queue       Queue of the last work using the scalar (on the
+   *                    device of the scalar).
+   *
+   * @note If the scalar is not tracked, the program aborts.
+   */
+  template <typename T>
+  void destroy_scalar_async(DualScalar<T> &dual_scalar, const int queue);
+
+  /**
+   * @brief Releases pending buffers whose queue is idle, without
+   * blocking.
+   *
+   * @details
+   * Released buffers are kept in the reuse cache while it has room (see
+   * set_reuse_cache_limit()), and freed otherwise.
+   */
+  void collect_deferred_frees();
+
+  /**
+   * @brief Waits for the queues of all pending buffers, then frees them
+   * together with the reuse cache.
+   */
+  void flush_deferred_frees();
+
+  /**
+   * @brief Sets the maximum memory kept in the reuse cache.
+   *
+   * @details
+   * The oldest buffers beyond the limit are freed. By default the limit
+   * is 0, so that released buffers are freed.
+   *
+   * @param limit_bytes Maximum bytes of host and device memory kept for
+   *                    reuse.
+   */
+  void set_reuse_cache_limit(const size_t limit_bytes);
+
+  /**
+   * @brief Returns statistics of deferred frees, including memory still
+   * pending (e.g. to spot queues that never become idle).
+   *
+   * @return Statistics of pending and cached buffers, with counters of
+   *         deferred, reused and released buffers.
+   */
+  DeferredFreeStats return_deferred_free_stats();
+
+  /**
+   * @brief Enqueues a copy of data from host to device in the background.
+   *
+   * @details
+   * The copy runs on a dedicated queue (prefetch_queue) while the host
+   * keeps working. Call require() before using the data on device; host
+   * data must not be modified until then.
+   *
+   * @tparam T           Type of elements in the array.
+   *
+   * @param dual_array   Dual array to synchronize.
+   * @param offset       Index of first element to be copied.
+   * @param num_elements Number of elements to be copied.
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void prefetch_to_device(DualArray<T> &dual_array, const size_t offset,
+                          const size_t num_elements);
+
+  /**
+   * @brief Enqueues a copy of data from device to host in the background.
+   *
+   * @details
+   * The copy runs on a dedicated queue (prefetch_queue) while the host
+   * keeps working. Call require() before using the data on host; host
+   * data must not be accessed until then.
+   *
+   * @tparam T           Type of elements in the array.
+   *
+   * @param dual_array   Dual array to synchronize.
+   * @param offset       Index of first element to be copied.
+   * @param num_elements Number of elements to be copied.
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void prefetch_to_host(DualArray<T> &dual_array, const size_t offset,
+                        const size_t num_elements);
+
+  /**
+   * @brief Makes sure that data is up to date on one side before it is
+   * used.
+   *
+   * @details
+   * If prefetches of the array towards that side cover the range, this
+   * function only blocks if they have not finished yet (a late prefetch,
+   * otherwise a hit). Otherwise the range is copied synchronously (a
+   * miss). Required prefetches are consumed.
+   *
+   * @tparam T           Type of elements in the array.
+   *
+   * @param dual_array   Dual array to be used.
+   * @param side         Side on which data is used.
+   * @param offset       Index of first element to be used.
+   * @param num_elements Number of elements to be used.
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void require(DualArray<T> &dual_array, const Side side, const size_t offset,
+               const size_t num_elements);
+
+  /**
+   * @brief Prefetches whole dual arrays to device for a phase, and requires
+   * them when the phase begins.
+   *
+   * @details
+   * Call it as soon as the arrays used on device by the next phase are
+   * final on host: uploads overlap with the end of the current phase, and
+   * begin_phase() only blocks on those that have not finished.
+   *
+   * @tparam T     Types of elements in the arrays.
+   *
+   * @param phase  Name of the phase.
+   * @param arrays Dual arrays used on device by the phase.
+   */
+  template <typename... T>
+  void next_phase_uses(const std::string &phase, DualArray<T> &...arrays);
+
+  /**
+   * @brief Returns statistics of prefetches.
+   *
+   * @return Numbers of prefetches, hits, late prefetches and misses, and
+   *         of prefetches of objects freed before being required.
+   */
+  PrefetchStats return_prefetch_stats();
+
+  /**
+   * @brief Returns the number of devices.
+   *
+   * @return Number of devices (0 without device memory).
+   */
+  int num_devices() const;
+
+  /**
+   * @brief Returns the current device.
+   *
+   * @return Index of the current device.
+   */
+  int get_device() const;
+
+  /**
+   * @brief Makes a device current.
+   *
+   * @details
+   * New allocations go to the current device (e.g. through
+   * acc_set_device_num() with OpenACC), and compute regions run on it.
+   * Each dual object remembers its device: operations on existing objects
+   * switch to it temporarily, whatever the current device.
+   *
+   * @param device Index of the device.
+   *
+   * @note If the device does not exist, the program aborts.
+   */
+  void set_device(const int device);
+
+  /**
+   * @brief Sets the NUMA placement policy of host memory.
+   *
+   * @details
+   * The policy applies to host memory allocated afterwards by dual arrays,
+   * allocation groups and the scratch arena; existing memory is not moved.
+   * With NumaPolicy::FirstTouch, host memory of each array is zeroed at
+   * allocation by the threads of the host pool, each touching the range it
+   * works on in host parallel loops (e.g. the parallel primitives).
+   *
+   * @param policy NUMA placement policy.
+   * @param node   NUMA node on which memory is placed (NumaPolicy::Bind
+   *               only).
+   *
+   * @note If the node does not exist with NumaPolicy::Bind, the program
+   *       aborts.
+   */
+  void set_numa_policy(const NumaPolicy policy, const int node = 0);
+
+  /**
+   * @brief Returns the NUMA placement policy of host memory.
+   *
+   * @return Current NUMA placement policy.
+   */
+  NumaPolicy get_numa_policy() const;
+
+  /**
+   * @brief Measures transfer latency and bandwidth, or loads them from a
+   * calibration file.
+   *
+   * @details
+   * Host-to-device and device-to-host transfer times are measured for
+   * sizes from 1 KiB to max_bytes, and latency and bandwidth are fitted to
+   * them. The resulting model drives the planner of
+   * update_array_ranges_host_to_device() and
+   * update_array_ranges_device_to_host(). Until calibration, a model of a
+   * typical PCIe-attached device is used.
+   *
+   * @param cache_file Calibration file to be read if valid for the current
+   *                   backend, and written otherwise (empty for none).
+   * @param max_bytes  Size in bytes of the largest measured transfer.
+   *
+   * @note If the calibration file cannot be written, a warning is
+   *       printed and the measured calibration is still used.
+   * @note Without device memory, this function does nothing.
+   */
+  void calibrate_transfers(const std::string cache_file = "",
+                           const size_t max_bytes = size_t(1) << 26);
+
+  /**
+   * @brief Sets the transfer model used by the planner.
+   *
+   * @param model Transfer model (e.g. measured on another run).
+   *
+   * @note If a bandwidth is not positive, the program aborts.
+   */
+  void set_transfer_model(const TransferModel &model);
+
+  /**
+   * @brief Returns the transfer model used by the planner.
+   *
+   * @return Current transfer model.
+   */
+  const TransferModel &get_transfer_model() const;
+
+  /**
+   * @brief Copies several ranges of elements from host to device.
+   *
+   * @details
+   * Ranges are planned with the transfer model: overlapping ranges are
+   * merged, many small ranges are packed into a staging buffer and
+   * unpacked on device by a kernel, and large payloads are split into
+   * chunks so that packing overlaps with transfers. Only the requested
+   * elements are copied.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to synchronize.
+   * @param ranges     Ranges of elements to be copied (in any order,
+   *                   possibly overlapping).
+   *
+   * @note Memory of lazily allocated arrays is materialized on both
+   *       sides.
+   * @note If a range exceeds the size of the array, the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void
+  update_array_ranges_host_to_device(DualArray<T> &dual_array,
+                                     const std::vector<TransferRange> &ranges);
+
+  /**
+   * @brief Copies several ranges of elements from device to host.
+   *
+   * @details
+   * Ranges are planned as in update_array_ranges_host_to_device(); staged
+   * ranges are packed on device by a kernel and unpacked on host.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to synchronize.
+   * @param ranges     Ranges of elements to be copied (in any order,
+   *                   possibly overlapping).
+   *
+   * @note Memory of lazily allocated arrays is materialized on both
+   *       sides.
+   * @note If a range exceeds the size of the array, the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void
+  update_array_ranges_device_to_host(DualArray<T> &dual_array,
+                                     const std::vector<TransferRange> &ranges);
+
+  /**
+   * @brief Copies scattered elements from host to device.
+   *
+   * @details
+   * Selected elements are packed on host into a staging buffer together
+   * with their indices, moved to device with a single transfer, and
+   * scattered into the array by a device kernel.
+   *
+   * If the indexed transfer would move at least as many bytes as a
+   * contiguous copy of the range covering all indices (scaled by the
+   * threshold set with set_indexed_transfer_threshold()), the covering
+   * range is copied instead. In that case elements between the requested
+   * indices are copied as well.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to synchronize.
+   * @param indices    Indices of the elements to be copied.
+   *
+   * @note If an index is out of range, the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_array_indexed_host_to_device(DualArray<T> &dual_array,
+                                           const std::vector<size_t> &indices);
+
+  /**
+   * @brief Copies scattered elements from host to device, using an index
+   * list already present on device.
+   *
+   * @details
+   * Same as the overload taking a std::vector, but indices are read from
+   * a dual array that is valid on both host and device, so that they do
+   * not need to be transferred.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to synchronize.
+   * @param indices    Dual array with the indices of the elements to be
+   *                   copied (all its elements are used).
+   *
+   * @note If an index is out of range, the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_array_indexed_host_to_device(DualArray<T> &dual_array,
+                                           const DualArray<size_t> &indices);
+
+  /**
+   * @brief Copies scattered elements from device to host.
+   *
+   * @details
+   * Selected elements are gathered on device into a staging buffer by a
+   * device kernel, moved to host with a single transfer, and unpacked
+   * into the host array.
+   *
+   * The same fallback to a contiguous copy as in
+   * update_array_indexed_host_to_device() applies.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to synchronize.
+   * @param indices    Indices of the elements to be copied.
+   *
+   * @note If an index is out of range, the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_array_indexed_device_to_host(DualArray<T> &dual_array,
+                                           const std::vector<size_t> &indices);
+
+  /**
+   * @brief Copies scattered elements from device to host, using an index
+   * list already present on device.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to synchronize.
+   * @param indices    Dual array with the indices of the elements to be
+   *                   copied (all its elements are used).
+   *
+   * @note If an index is out of range, the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_array_indexed_device_to_host(DualArray<T> &dual_array,
+                                           const DualArray<size_t> &indices);
+
+  /**
+   * @brief Sets the density threshold of indexed transfers.
+   *
+   * @details
+   * An indexed transfer falls back to a contiguous copy of the range
+   * covering all indices when the bytes it would move (values plus
+   * indices) are at least `threshold` times the bytes of the contiguous
+   * copy. The default is 0.5; values above 1 make the fallback less
+   * likely, 0 makes it unconditional.
+   *
+   * @param threshold Ratio between indexed and contiguous transfer volume.
+   */
+  void set_indexed_transfer_threshold(const double threshold);
+
+  /**
+   * @brief Enables delta synchronization of a dual array.
+   *
+   * @details
+   * The array is split into blocks, and the hash of each block is kept as
+   * last uploaded. From then on, update_array_host_to_device() hashes the
+   * blocks of the range on host with multiple threads and copies only
+   * those whose hash changed, which pays off for arrays written by host
+   * code that cannot report what it modified. Calling this function again
+   * forgets the stored hashes and resets statistics.
+   *
+   * @tparam T          Type of elements in the array.
+   *
+   * @param dual_array  Dual array whose uploads should be synchronized by
+   *                    delta.
+   * @param block_bytes Size in bytes of hashed blocks (rounded down to a
+   *                    whole number of elements, at least one).
+   *
+   * @note Device memory is assumed to hold what was last uploaded: blocks
+   *       written on device are overwritten by an upload only if their
+   *       host content changed, so call this function again after
+   *       writing the array on device without downloading it.
+   * @note If the array is not tracked or the block size is 0, the program
+   *       aborts.
+   */
+  template <typename T>
+  void enable_delta_sync(DualArray<T> &dual_array,
+                         const size_t block_bytes = default_delta_block_bytes);
+
+  /**
+   * @brief Disables delta synchronization of a dual array.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array whose uploads should copy whole ranges
+   *                   again.
+   *
+   * @note If delta synchronization is not enabled, this function does
+   *       nothing.
+   */
+  template <typename T> void disable_delta_sync(DualArray<T> &dual_array);
+
+  /**
+   * @brief Returns statistics of delta synchronization of a dual array.
+   *
+   * @details
+   * Comparing hashed and transferred bytes tells whether the mode pays
+   * off for the array: when most blocks change anyway, hashing only adds
+   * host work.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array synchronized by delta.
+   *
+   * @return           Statistics since delta synchronization was enabled.
+   *
+   * @note If delta synchronization is not enabled, the program aborts.
+   */
+  template <typename T>
+  DeltaSyncStats return_delta_sync_stats(const DualArray<T> &dual_array);
+
+  /**
+   * @brief Copies elements between two dual arrays on one side.
+   *
+   * @details
+   * Data is copied entirely on the requested side, without going through
+   * the other one: on device the copy is done by the OpenACC runtime, on
+   * host by a multithreaded copy that uses non-temporal stores for large
+   * sizes.
+   *
+   * @tparam T           Type of elements in the arrays.
+   *
+   * @param dst          Destination dual array.
+   * @param dst_offset   Index of first element to be written in dst.
+   * @param src          Source dual array.
+   * @param src_offset   Index of first element to be read in src.
+   * @param num_elements Number of elements to be copied.
+   * @param side         Side on which the copy should be performed.
+   *
+   * @note If a range exceeds the size of its array, source and
+   *       destination ranges overlap, or host memory of dst is shared
+   *       and read-only (on host), the program aborts.
+   * @note Without device memory, a copy on device is performed on
+   *       host, since compute regions work on host data.
+   * @note Arrays on different devices are copied device-to-device.
+   */
+  template <typename T>
+  void copy_array(DualArray<T> &dst, const size_t dst_offset,
+                  const DualArray<T> &src, const size_t src_offset,
+                  const size_t num_elements, const Side side);
+
+  /**
+   * @brief Allocates a dual array as a copy of an existing one.
+   *
+   * @details
+   * The clone has the same size as the source and is allocated on device
+   * if the source is. Host data is copied on host and device data on
+   * device, so the clone reproduces both sides of the source without any
+   * host-device transfer. The clone is tracked as a new array.
+   *
+   * @tparam T         Type of elements in the arrays.
+   *
+   * @param clone      Dual array to be allocated.
+   * @param src        Dual array to be cloned.
+   * @param label      Label that should be used to track the clone in
+   *                   memory.
+   *
+   * @note The clone is allocated on the device of the source.
+   */
+  template <typename T>
+  void clone_array(DualArray<T> &clone, const DualArray<T> &src,
+                   const std::string label);
+
+  /**
+   * @brief Frees memory allocated for a given dual array.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to be freed.
+   *
+   * @note If the array is not tracked, belongs to an allocation group, or
+   *       is shared, the program aborts.
+   */
+  template <typename T> void free_array(DualArray<T> &dual_array);
+
+  /**
+   * @brief Allocates a dual array whose host memory is shared by the
+   * processes of a node.
+   *
+   * @details
+   * Host memory is a named POSIX shared-memory segment. The first process
+   * allocating the name creates it, fills host memory, and then calls
+   * publish_shared_array(). The other processes wait for publication and
+   * attach host memory read-only. Each process has its own device memory,
+   * to be filled with update_array_host_to_device().
+   *
+   * Shared host memory is not counted in the host memory used by the
+   * memory manager (see return_shared_memory_usage()), so that it is not
+   * counted once per process when summing over processes.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to be allocated.
+   * @param label      Label that should be used to track the array in
+   *                   memory.
+   * @param name       Name of the shared-memory segment, the same in all
+   *                   processes.
+   * @param size       Number of elements in the array.
+   * @param on_device  Whether the array should be allocated on device as
+   *                   well (ignored without device memory).
+   *
+   * @return           'true' if this process created the segment and must
+   *                   fill it, 'false' if data is already available.
+   *
+   * @note If the segment cannot be created, has a different size, or is
+   *       not published within shared_attach_timeout seconds, the program
+   *       aborts.
+   */
+  template <typename T>
+  bool alloc_shared_array(DualArray<T> &dual_array, const std::string label,
+                          const std::string name, const size_t size,
+                          const bool on_device = false);
+
+  /**
+   * @brief Publishes host memory of a shared dual array to the other
+   * processes.
+   *
+   * @details
+   * From then on, host memory is read-only in the creating process as
+   * well. In processes that attached the array, this function does
+   * nothing.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Shared dual array to be published.
+   *
+   * @note If the array is not a tracked shared array, the program aborts.
+   */
+  template <typename T>
+  void publish_shared_array(DualArray<T> &dual_array);
+
+  /**
+   * @brief Frees memory of a shared dual array.
+   *
+   * @details
+   * The process detaches from the shared-memory segment, which is removed
+   * once no process is attached anymore.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Shared dual array to be freed.
+   *
+   * @note If the array is not a tracked shared array, the program aborts.
+   */
+  template <typename T> void free_shared_array(DualArray<T> &dual_array);
+
+  /**
+   * @brief Allocates a mixed-precision dual array, whose elements have a
+   * different type on host and device.
+   *
+   * @details
+   * Elements are converted during transfers, so that only device-typed
+   * elements are moved and stored on device (e.g. half the volume for
+   * double on host and float on device). Without device memory, device
+   * elements live in a separate host buffer, used by compute regions
+   * through MIMMO_GET_PTR().
+   *
+   * @tparam T         Type of elements in the array on host.
+   * @tparam D         Type of elements in the array on device.
+   *
+   * @param dual_array Dual array to be allocated.
+   * @param label      Label that should be used to track the array in
+   *                   memory.
+   * @param size       Number of elements in the array.
+   * @param on_device  Whether the array should be allocated on device as
+   *                   well.
+   */
+  template <typename T, typename D>
+  void alloc_array(DualArray<T, D> &dual_array, const std::string label,
+                   const size_t size, const bool on_device = false);
+
+  /**
+   * @brief Converts data of a mixed-precision dual array from host to
+   * device.
+   *
+   * @details
+   * Elements are converted on host with multiple threads, one chunk at a
+   * time, and each converted chunk is copied to device.
+   *
+   * @tparam T           Type of elements in the array on host.
+   * @tparam D           Type of elements in the array on device.
+   *
+   * @param dual_array   Dual array to synchronize.
+   * @param offset       Index of first element to be copied.
+   * @param num_elements Number of elements to be copied.
+   *
+   * @note If the array has no device elements, this function does nothing.
+   */
+  template <typename T, typename D>
+  void update_array_host_to_device(DualArray<T, D> &dual_array,
+                                   const size_t offset,
+                                   const size_t num_elements);
+
+  /**
+   * @brief Converts data of a mixed-precision dual array from device to
+   * host.
+   *
+   * @details
+   * Device elements are copied back one chunk at a time, and each chunk is
+   * converted on host with multiple threads.
+   *
+   * @tparam T           Type of elements in the array on host.
+   * @tparam D           Type of elements in the array on device.
+   *
+   * @param dual_array   Dual array to synchronize.
+   * @param offset       Index of first element to be copied.
+   * @param num_elements Number of elements to be copied.
+   *
+   * @note If the array has no device elements, this function does nothing.
+   */
+  template <typename T, typename D>
+  void update_array_device_to_host(DualArray<T, D> &dual_array,
+                                   const size_t offset,
+                                   const size_t num_elements);
+
+  /**
+   * @brief Frees memory allocated for a mixed-precision dual array.
+   *
+   * @tparam T         Type of elements in the array on host.
+   * @tparam D         Type of elements in the array on device.
+   *
+   * @param dual_array Dual array to be freed.
+   *
+   * @note If the array is not tracked, the program aborts.
+   */
+  template <typename T, typename D>
+  void free_array(DualArray<T, D> &dual_array);
+
+  /**
+   * @brief Allocates a dual array partitioned across devices.
+   *
+   * @details
+   * The extent of the array is split into one contiguous partition per
+   * device, with sizes differing by at most one element. Each partition
+   * is a dual array allocated on host and on its device, extended with
+   * halo elements on both sides (clipped at the ends of the array).
+   * Partitions are tracked as separate arrays, labelled label[p], and can
+   * be transferred on their own with the dual array methods.
+   *
+   * @tparam T                Type of elements in the array.
+   *
+   * @param partitioned_array Partitioned dual array to be allocated.
+   * @param label             Label that should be used to track the
+   *                          partitions in memory.
+   * @param size              Number of elements in the array.
+   * @param halo              Number of halo elements on each side of each
+   *                          partition.
+   * @param devices           Device of each partition (empty for one
+   *                          partition per device).
+   *
+   * @note If a device does not exist, the array has fewer elements than
+   *       partitions, or the halo is larger than a partition, the program
+   *       aborts.
+   * @note The partitions are tracked by address, so the partitioned
+   *       array must not be copied or moved while allocated.
+   */
+  template <typename T>
+  void alloc_partitioned_array(PartitionedDualArray<T> &partitioned_array,
+                               const std::string label, const size_t size,
+                               const size_t halo = 0,
+                               const std::vector<int> devices = {});
+
+  /**
+   * @brief Copies all partitions of a partitioned dual array (halos
+   * included) from host to device.
+   *
+   * @tparam T                Type of elements in the array.
+   *
+   * @param partitioned_array Partitioned dual array to synchronize.
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_partitioned_array_host_to_device(
+      PartitionedDualArray<T> &partitioned_array);
+
+  /**
+   * @brief Copies all partitions of a partitioned dual array (halos
+   * included) from device to host.
+   *
+   * @tparam T                Type of elements in the array.
+   *
+   * @param partitioned_array Partitioned dual array to synchronize.
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_partitioned_array_device_to_host(
+      PartitionedDualArray<T> &partitioned_array);
+
+  /**
+   * @brief Refreshes halo elements of each partition with the elements
+   * owned by its neighbours.
+   *
+   * @details
+   * On device, halos of partitions on different devices are exchanged
+   * with peer copies.
+   *
+   * @tparam T                Type of elements in the array.
+   *
+   * @param partitioned_array Partitioned dual array whose halos should be
+   *                          exchanged.
+   * @param side              Side on which halos should be exchanged.
+   *
+   * @note Without device memory, an exchange on device is performed on
+   *       host, since compute regions work on host data.
+   */
+  template <typename T>
+  void exchange_halos(PartitionedDualArray<T> &partitioned_array,
+                      const Side side = Side::Device);
+
+  /**
+   * @brief Frees all partitions of a partitioned dual array.
+   *
+   * @tparam T                Type of elements in the array.
+   *
+   * @param partitioned_array Partitioned dual array to be freed.
+   *
+   * @note If a partition is not tracked, the program aborts.
+   */
+  template <typename T>
+  void free_partitioned_array(PartitionedDualArray<T> &partitioned_array);
+
+  /**
+   * @brief Allocates a sparse matrix in CSR format.
+   *
+   * @tparam T        Type of matrix values.
+   * @tparam Index    Type of column indices and row offsets.
+   *
+   * @param csr       Sparse matrix to be allocated.
+   * @param label     Label that should be used to track the matrix in
+   *                  memory.
+   * @param num_rows  Number of rows.
+   * @param num_cols  Number of columns.
+   * @param nnz       Number of non-zero values.
+   * @param on_device Whether the matrix should be allocated on device as
+   *                  well (ignored without device memory).
+   *
+   * @note If the index type cannot represent the number of columns or
+   *       non-zero values, the program aborts.
+   */
+  template <typename T, typename Index>
+  void alloc_csr(DualCSR<T, Index> &csr, const std::string label,
+                 const size_t num_rows, const size_t num_cols,
+                 const size_t nnz, const bool on_device = false);
+
+  /**
+   * @brief Copies a sparse matrix (values and sparsity pattern) from host
+   * to device, in one transfer.
+   *
+   * @tparam T       Type of matrix values.
+   * @tparam Index   Type of column indices and row offsets.
+   *
+   * @param csr      Sparse matrix to synchronize.
+   * @param location Call site, recorded in profiling mode (filled in
+   *                 automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T, typename Index>
+  void update_csr_host_to_device(
+      DualCSR<T, Index> &csr,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies a sparse matrix (values and sparsity pattern) from
+   * device to host, in one transfer.
+   *
+   * @tparam T       Type of matrix values.
+   * @tparam Index   Type of column indices and row offsets.
+   *
+   * @param csr      Sparse matrix to synchronize.
+   * @param location Call site, recorded in profiling mode (filled in
+   *                 automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T, typename Index>
+  void update_csr_device_to_host(
+      DualCSR<T, Index> &csr,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies the values of a sparse matrix from host to device,
+   * keeping the sparsity pattern.
+   *
+   * @tparam T       Type of matrix values.
+   * @tparam Index   Type of column indices and row offsets.
+   *
+   * @param csr      Sparse matrix to synchronize.
+   * @param location Call site, recorded in profiling mode (filled in
+   *                 automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T, typename Index>
+  void update_csr_values_host_to_device(
+      DualCSR<T, Index> &csr,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies the values of a sparse matrix from device to host,
+   * keeping the sparsity pattern.
+   *
+   * @tparam T       Type of matrix values.
+   * @tparam Index   Type of column indices and row offsets.
+   *
+   * @param csr      Sparse matrix to synchronize.
+   * @param location Call site, recorded in profiling mode (filled in
+   *                 automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T, typename Index>
+  void update_csr_values_device_to_host(
+      DualCSR<T, Index> &csr,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Frees memory allocated for a sparse matrix.
+   *
+   * @tparam T     Type of matrix values.
+   * @tparam Index Type of column indices and row offsets.
+   *
+   * @param csr    Sparse matrix to be freed.
+   *
+   * @note If the matrix is not tracked, the program aborts.
+   */
+  template <typename T, typename Index>
+  void free_csr(DualCSR<T, Index> &csr);
+
+  /**
+   * @brief Allocates a jagged dual array with given row sizes.
+   *
+   * @tparam T        Type of elements in the array.
+   *
+   * @param jagged    Jagged dual array to be allocated.
+   * @param label     Label that should be used to track the array in
+   *                  memory.
+   * @param row_sizes Number of elements of each row.
+   * @param on_device Whether the array should be allocated on device as
+   *                  well (ignored without device memory).
+   */
+  template <typename T>
+  void alloc_jagged_array(DualJaggedArray<T> &jagged, const std::string label,
+                          const std::vector<size_t> &row_sizes,
+                          const bool on_device = false);
+
+  /**
+   * @brief Allocates a jagged dual array and fills it on host from
+   * containers.
+   *
+   * @tparam T        Type of elements in the array.
+   *
+   * @param jagged    Jagged dual array to be allocated.
+   * @param label     Label that should be used to track the array in
+   *                  memory.
+   * @param rows      Elements of each row.
+   * @param on_device Whether the array should be allocated on device as
+   *                  well (ignored without device memory).
+   */
+  template <typename T>
+  void alloc_jagged_array(DualJaggedArray<T> &jagged, const std::string label,
+                          const std::vector<std::vector<T>> &rows,
+                          const bool on_device = false);
+
+  /**
+   * @brief Copies a jagged dual array (values and offsets) from host to
+   * device, in one transfer.
+   *
+   * @tparam T       Type of elements in the array.
+   *
+   * @param jagged   Jagged dual array to synchronize.
+   * @param location Call site, recorded in profiling mode (filled in
+   *                 automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_jagged_array_host_to_device(
+      DualJaggedArray<T> &jagged,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies a jagged dual array (values and offsets) from device to
+   * host, in one transfer.
+   *
+   * @tparam T       Type of elements in the array.
+   *
+   * @param jagged   Jagged dual array to synchronize.
+   * @param location Call site, recorded in profiling mode (filled in
+   *                 automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_jagged_array_device_to_host(
+      DualJaggedArray<T> &jagged,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies the values of consecutive rows of a jagged dual array
+   * from host to device, in one transfer.
+   *
+   * @tparam T        Type of elements in the array.
+   *
+   * @param jagged    Jagged dual array to synchronize.
+   * @param first_row Index of first row to be copied.
+   * @param num_rows  Number of rows to be copied.
+   * @param location  Call site, recorded in profiling mode (filled in
+   *                  automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_jagged_rows_host_to_device(
+      DualJaggedArray<T> &jagged, const size_t first_row,
+      const size_t num_rows = 1,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies the values of consecutive rows of a jagged dual array
+   * from device to host, in one transfer.
+   *
+   * @tparam T        Type of elements in the array.
+   *
+   * @param jagged    Jagged dual array to synchronize.
+   * @param first_row Index of first row to be copied.
+   * @param num_rows  Number of rows to be copied.
+   * @param location  Call site, recorded in profiling mode (filled in
+   *                  automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_jagged_rows_device_to_host(
+      DualJaggedArray<T> &jagged, const size_t first_row,
+      const size_t num_rows = 1,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Frees memory allocated for a jagged dual array.
+   *
+   * @tparam T     Type of elements in the array.
+   *
+   * @param jagged Jagged dual array to be freed.
+   *
+   * @note If the array is not tracked, the program aborts.
+   */
+  template <typename T> void free_jagged_array(DualJaggedArray<T> &jagged);
+
+  /**
+   * @brief Allocates a ring of time levels.
+   *
+   * @details
+   * Level l starts in slot l. The descriptor is computed on host and, if
+   * the ring is on device, copied to device.
+   *
+   * @tparam T        Type of elements in each level.
+   * @tparam Levels   Number of time levels.
+   *
+   * @param ring      Ring to be allocated.
+   * @param label     Label that should be used to track the ring in
+   *                  memory.
+   * @param size      Number of elements of each level.
+   * @param on_device Whether the ring should be allocated on device as
+   *                  well (ignored without device memory).
+   */
+  template <typename T, size_t Levels>
+  void alloc_ring(DualRing<T, Levels> &ring, const std::string label,
+                  const size_t size, const bool on_device = false);
+
+  /**
+   * @brief Shifts every level of a ring to the next older one, in O(1).
+   *
+   * @details
+   * The slot of the oldest level becomes level 0, and its values are
+   * kept until overwritten. No data is moved: only the descriptor is
+   * updated on host and, if the ring is on device, copied to device, so
+   * call this function once per step, outside compute regions.
+   *
+   * @tparam T      Type of elements in each level.
+   * @tparam Levels Number of time levels.
+   *
+   * @param ring    Ring to be rotated.
+   */
+  template <typename T, size_t Levels>
+  void rotate_ring(DualRing<T, Levels> &ring);
+
+  /**
+   * @brief Copies all levels of a ring (and its descriptor) from host to
+   * device, in one transfer.
+   *
+   * @tparam T       Type of elements in each level.
+   * @tparam Levels  Number of time levels.
+   *
+   * @param ring     Ring to synchronize.
+   * @param location Call site, recorded in profiling mode (filled in
+   *                 automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T, size_t Levels>
+  void update_ring_host_to_device(
+      DualRing<T, Levels> &ring,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies all levels of a ring (and its descriptor) from device to
+   * host, in one transfer.
+   *
+   * @tparam T       Type of elements in each level.
+   * @tparam Levels  Number of time levels.
+   *
+   * @param ring     Ring to synchronize.
+   * @param location Call site, recorded in profiling mode (filled in
+   *                 automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T, size_t Levels>
+  void update_ring_device_to_host(
+      DualRing<T, Levels> &ring,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies one level of a ring from host to device.
+   *
+   * @tparam T       Type of elements in each level.
+   * @tparam Levels  Number of time levels.
+   *
+   * @param ring     Ring to synchronize.
+   * @param level    Level to be copied (0 for the newest).
+   * @param location Call site, recorded in profiling mode (filled in
+   *                 automatically).
+   *
+   * @note If the level is out of range, the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T, size_t Levels>
+  void update_ring_level_host_to_device(
+      DualRing<T, Levels> &ring, const size_t level,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies one level of a ring from device to host.
+   *
+   * @tparam T       Type of elements in each level.
+   * @tparam Levels  Number of time levels.
+   *
+   * @param ring     Ring to synchronize.
+   * @param level    Level to be copied (0 for the newest).
+   * @param location Call site, recorded in profiling mode (filled in
+   *                 automatically).
+   *
+   * @note If the level is out of range, the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  template <typename T, size_t Levels>
+  void update_ring_level_device_to_host(
+      DualRing<T, Levels> &ring, const size_t level,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Frees memory allocated for a ring.
+   *
+   * @tparam T      Type of elements in each level.
+   * @tparam Levels Number of time levels.
+   *
+   * @param ring    Ring to be freed.
+   *
+   * @note If the ring is not tracked, the program aborts.
+   */
+  template <typename T, size_t Levels>
+  void free_ring(DualRing<T, Levels> &ring);
+
+  /**
+   * @brief Allocates a bit-packed dual array, with all bits cleared.
+   *
+   * @details
+   * Bits are cleared on host and, if the array is on device, on device
+   * as well.
+   *
+   * @param bit_array Bit-packed dual array to be allocated.
+   * @param label     Label that should be used to track the array in
+   *                  memory.
+   * @param size      Number of bits in the array.
+   * @param on_device Whether the array should be allocated on device as
+   *                  well (ignored without device memory).
+   */
+  void alloc_bit_array(DualBitArray &bit_array, const std::string label,
+                       const size_t size, const bool on_device = false);
+
+  /**
+   * @brief Copies a range of bits of a bit-packed dual array from host to
+   * device.
+   *
+   * @details
+   * Whole words are copied, so bits sharing a word with the range are
+   * copied as well.
+   *
+   * @param bit_array Bit-packed dual array to synchronize.
+   * @param first_bit Index of first bit to be copied.
+   * @param num_bits  Number of bits to be copied.
+   * @param location  Call site, recorded in profiling mode (filled in
+   *                  automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  void update_bit_array_host_to_device(
+      DualBitArray &bit_array, const size_t first_bit, const size_t num_bits,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Copies a range of bits of a bit-packed dual array from device to
+   * host.
+   *
+   * @details
+   * Whole words are copied, so bits sharing a word with the range are
+   * copied as well.
+   *
+   * @param bit_array Bit-packed dual array to synchronize.
+   * @param first_bit Index of first bit to be copied.
+   * @param num_bits  Number of bits to be copied.
+   * @param location  Call site, recorded in profiling mode (filled in
+   *                  automatically).
+   *
+   * @note Without device memory, this function does nothing.
+   */
+  void update_bit_array_device_to_host(
+      DualBitArray &bit_array, const size_t first_bit, const size_t num_bits,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Frees memory allocated for a bit-packed dual array.
+   *
+   * @param bit_array Bit-packed dual array to be freed.
+   *
+   * @note If the array is not tracked, the program aborts.
+   */
+  void free_bit_array(DualBitArray &bit_array);
+
+  /**
+   * @brief Creates a named allocation group.
+   *
+   * @details
+   * Allocation groups collect related dual arrays (e.g. all fields of a
+   * module), so that they can be transferred and freed together. If a
+   * slab size is given, arrays of the group are carved from one
+   * contiguous backing buffer on host (and one on device), and group
+   * transfers move the whole slab with a single copy.
+   *
+   * @param name       Name of the group.
+   * @param slab_bytes Capacity in bytes of the backing slab (0 for no
+   *                   slab, i.e. each array is allocated on its own).
+   * @param on_device  Whether arrays of the group should be allocated on
+   *                   device as well (ignored if main code compiled
+   *                   without OpenACC support).
+   *
+   * @note The whole slab is counted in total memory usage, rather than
+   *       the arrays carved from it.
+   * @note If a group with the same name exists, the program aborts.
+   */
+  void create_group(const std::string name, const size_t slab_bytes = 0,
+                    const bool on_device = false);
+
+  /**
+   * @brief Allocates dual array memory inside an allocation group.
+   *
+   * @details
+   * The array is tracked as usual (with its group recorded), and is
+   * allocated on device if the group is.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to be allocated.
+   * @param label      Label that should be used to track the array in
+   *                   memory.
+   * @param size       Number of elements in the array.
+   * @param group_name Name of the group.
+   *
+   * @note If the group does not exist, or its slab is exhausted, the
+   *       program aborts.
+   */
+  template <typename T>
+  void alloc_array_in_group(DualArray<T> &dual_array, const std::string label,
+                            const size_t size, const std::string group_name);
+
+  /**
+   * @brief Copies all arrays of a group from host to device.
+   *
+   * @param name Name of the group.
+   *
+   * @note If the group does not exist, or it is not allocated on device,
+   *       the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  void upload_group(const std::string name);
+
+  /**
+   * @brief Copies all arrays of a group from device to host.
+   *
+   * @param name Name of the group.
+   *
+   * @note If the group does not exist, or it is not allocated on device,
+   *       the program aborts.
+   * @note Without device memory, this function does nothing.
+   */
+  void download_group(const std::string name);
+
+  /**
+   * @brief Frees all arrays of a group, and the group itself.
+   *
+   * @details
+   * Pointers of all dual arrays of the group are reset to null pointers.
+   *
+   * @param name Name of the group.
+   *
+   * @note If the group does not exist, the program aborts.
+   */
+  void free_group(const std::string name);
+
+  /**
+   * @brief Returns host and device memory used by the arrays of a group.
+   *
+   * @param name Name of the group.
+   *
+   * @return     (host memory used by the group, device memory used by the
+   *             group)
+   *
+   * @note If the group does not exist, the program aborts.
+   */
+  std::pair<size_t, size_t> return_group_memory_usage(const std::string name);
+
+  /**
+   * @brief Reserves memory for the scratch arena.
+   *
+   * @details
+   * The scratch arena is a single device allocation from which
+   * device-only scratch arrays are carved (see alloc_scratch_array()),
+   * on the current device. Reserving the arena again replaces the
+   * previous one.
+   *
+   * @param size_bytes Capacity in bytes of the arena.
+   *
+   * @note If a frame is currently open, the program aborts.
+   * @note Without device memory, the arena is allocated on host.
+   */
+  void reserve_scratch_arena(const size_t size_bytes);
+
+  /**
+   * @brief Releases memory of the scratch arena.
+   *
+   * @note If a frame is currently open, the program aborts.
+   */
+  void release_scratch_arena();
+
+  /**
+   * @brief Opens a new scratch frame.
+   *
+   * @details
+   * Scratch arrays allocated after this call are released together by
+   * the matching call to pop_frame(). Frames can be nested.
+   */
+  void push_frame();
+
+  /**
+   * @brief Closes the innermost scratch frame.
+   *
+   * @details
+   * All scratch arrays allocated since the matching push_frame() are
+   * released at once, and must not be used anymore.
+   *
+   * @note If no frame is open, the program aborts.
+   */
+  void pop_frame();
+
+  /**
+   * @brief Allocates a device-only scratch array in the current frame.
+   *
+   * @details
+   * The array is carved from the scratch arena by bumping a pointer, with
+   * no host allocation and no call to the OpenACC allocator. Its host
+   * pointer is a null pointer, so it can be used in compute regions but
+   * not transferred. It is not tracked individually (the arena is), and
+   * it is released by pop_frame() rather than free_array().
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Dual array to be allocated.
+   * @param size       Number of elements in the array.
+   *
+   * @note If no frame is open, or the arena is exhausted, the program
+   *       aborts.
+   * @note Without device memory, the array lives on host (in the
+   *       host pointer), where compute regions run.
+   */
+  template <typename T>
+  void alloc_scratch_array(DualArray<T> &dual_array, const size_t size);
+
+  /**
+   * @brief Returns usage statistics of the scratch arena.
+   *
+   * @return (bytes currently in use, high-water mark in bytes)
+   */
+  std::pair<size_t, size_t> return_scratch_arena_usage();
+
+  /**
+   * @brief Creates a dual scalar.
+   *
+   * @details
+   * This function creates a scalar variable on host and optionally on
+   * device (allocating a one-element array), and assigns the requested
+   * value. It returns an object of type DualScalar that contains the host
+   * value and the device pointer.
+   *
+   * @param dual_scalar Dual scalar to be created.
+   * @param label       Label that should be used to track the scalar in
+   *                    memory.
+   * @param value       Value to which the scalar should be initialized.
+   * @param on_device   Whether the scalar should be created on device as
+   *                    well (ignored without device memory).
+   */
+  template <typename T>
+  void create_scalar(DualScalar<T> &dual_scalar, const std::string label,
+                     const T value, const bool on_device = false);
+
+  /**
+   * @brief Updates the value of a dual scalar from host to device.
+   *
+   * @tparam T          Type of the scalar variable.
+   *
+   * @param dual_scalar Dual scalar to synchronize.
+   * @param location    Call site, recorded in profiling mode (filled in
+   *                    automatically).
+   *
+   * @note The scalar must have been previously created using create_scalar().
+   *       If the scalar is not present on device, the program aborts.
+   */
+  template <typename T>
+  void update_scalar_host_to_device(
+      DualScalar<T> &dual_scalar,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Updates the value of a dual scalar from device to host.
+   *
+   * @tparam T          Type of the scalar variable.
+   *
+   * @param dual_scalar Dual scalar to synchronize.
+   * @param location    Call site, recorded in profiling mode (filled in
+   *                    automatically).
+   *
+   * @note The scalar must have been previously created using create_scalar().
+   *       If the scalar is not present on device, the program aborts.
+   *       Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_scalar_device_to_host(
+      DualScalar<T> &dual_scalar,
+      const SourceLocation location = SourceLocation::current());
+
+  /**
+   * @brief Enqueues a copy of the value of a dual scalar from host to
+   * device.
+   *
+   * @details
+   * The copy is only guaranteed to be complete after wait_queue() or
+   * wait_all_queues(), and the host value must not be modified until
+   * then.
+   *
+   * @tparam T          Type of the scalar variable.
+   *
+   * @param dual_scalar Dual scalar to synchronize.
+   * @param queue       Queue on which the copy is enqueued (on the device
+   *                    of the scalar).
+   *
+   * @note If the scalar is not present on device, the program aborts.
+   *       Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_scalar_host_to_device_async(DualScalar<T> &dual_scalar,
+                                          const int queue);
+
+  /**
+   * @brief Enqueues a copy of the value of a dual scalar from device to
+   * host.
+   *
+   * @details
+   * The copy is only guaranteed to be complete after wait_queue() or
+   * wait_all_queues(), and the host value must not be accessed until
+   * then.
+   *
+   * @tparam T          Type of the scalar variable.
+   *
+   * @param dual_scalar Dual scalar to synchronize.
+   * @param queue       Queue on which the copy is enqueued (on the device
+   *                    of the scalar).
+   *
+   * @note If the scalar is not present on device, the program aborts.
+   *       Without device memory, this function does nothing.
+   */
+  template <typename T>
+  void update_scalar_device_to_host_async(DualScalar<T> &dual_scalar,
+                                          const int queue);
+
+  /**
+   * @brief Frees memory allocated on device for a given scalar.
+   *
+   * @tparam T          Type of the scalar variable.
+   *
+   * @param dual_scalar Dual scalar to be destroyed.
+   *
+   * @note If the scalar is not tracked, the program aborts.
+   *       Without device memory, this function does nothing.
+   */
+  template <typename T> void destroy_scalar(DualScalar<T> &dual_scalar);
+
+  /**
+   * @brief Returns the descriptor table to be used in compute regions.
+   *
+   * @details
+   * The manager keeps a table with one descriptor (pointer and number of
+   * elements) for each tracked dual array and scalar, mirrored on device.
+   * Inside compute regions, objects can be reached through the table with
+   * MIMMO_TABLE_GET_PTR() and related macros, so that only the table
+   * needs to be declared with MIMMO_TABLE_PRESENT(), instead of copying
+   * each object struct with MIMMO_PRESENT() at every region entry.
+   *
+   * The device copy is refreshed by this function, with a single
+   * transfer, only if allocations changed since the last call. The
+   * returned pointer may change after allocations, so it should be
+   * requested again after allocating or freeing objects. The device copy
+   * lives on the current device, and moves when it changes.
+   *
+   * @return Pointer to the table (on the current device if device memory
+   *         exists).
+   *
+   * @note Scratch arrays are not tracked, hence not in the table.
+   */
+  const Descriptor *descriptor_table();
+
+  /**
+   * @brief Returns the descriptor table slot of a dual array.
+   *
+   * @details
+   * Slots do not change during the lifetime of an object, so they can be
+   * retrieved once and reused for all compute regions.
+   *
+   * @tparam T         Type of elements in the array.
+   *
+   * @param dual_array Tracked dual array.
+   *
+   * @return           Slot of the array in the descriptor table.
+   *
+   * @note If the array is not tracked, the program aborts.
+   */
+  template <typename T>
+  size_t descriptor_slot(const DualArray<T> &dual_array);
+
+  /**
+   * @brief Returns the descriptor table slot of a dual scalar.
+   *
+   * @tparam T          Type of the scalar variable.
+   *
+   * @param dual_scalar Tracked dual scalar.
+   *
+   * @return            Slot of the scalar in the descriptor table.
+   *
+   * @note If the scalar is not tracked, the program aborts.
+   */
+  template <typename T>
+  size_t descriptor_slot(const DualScalar<T> &dual_scalar);
+
+  /**
+   * @brief Returns the total host and device memory allocated by
+   * the memory manager.
+   *
+   * @details
+   * This function returns a pair where the elements are the total
+   * memory allocated on host and device, respectively.
+   *
+   * @return (total host memory used, total device memory used)
+   */
+  std::pair<size_t, size_t> return_total_memory_usage();
+
+  /**
+   * @brief Returns the total host and device memory reserved by the
+   * memory manager.
+   *
+   * @details
+   * Reserved memory includes memory of lazily allocated arrays that has
+   * not been materialized yet. For eagerly allocated objects reserved and
+   * used memory coincide. Shared host memory is not counted, and group
+   * slabs are counted as a whole rather than the arrays carved from them.
+   *
+   * @return (total host memory reserved, total device memory reserved)
+   */
+  std::pair<size_t, size_t> return_reserved_memory_usage();
+
+  /**
+   * @brief Returns the memory used by the memory manager on one device.
+   *
+   * @param device Index of the device.
+   *
+   * @return       Device memory used on the device, in bytes.
+   */
+  size_t return_device_memory_usage(const int device);
+
+  /**
+   * @brief Returns the host memory used by the memory manager on each NUMA
+   * node.
+   *
+   * @details
+   * Pages of host memory that were never touched reside on no node and
+   * are not counted, so the total may be lower than the host memory used.
+   *
+   * @return Host memory used on each node, in bytes.
+   */
+  std::vector<size_t> return_numa_distribution();
+
+  /**
+   * @brief Returns the label of a tracked object.
+   *
+   * @param object Address of the dual object.
+   *
+   * @return       Label of the object (empty if it is not tracked).
+   */
+  std::string return_label(const void *const object);
+
+  /**
+   * @brief Returns the host memory of shared dual arrays attached by the
+   * memory manager.
+   *
+   * @return Shared host memory, in bytes (not counted in host memory
+   *         used).
+   */
+  size_t return_shared_memory_usage();
+
+  /**
+   * @brief Enables or disables profiling mode of transfers.
+   *
+   * @details
+   * In profiling mode, each transfer of update_array_host_to_device(),
+   * update_array_device_to_host(), update_scalar_host_to_device() and
+   * update_scalar_device_to_host() checksums host data, to detect
+   * redundant transfers, i.e. transfers moving data already identical on
+   * both sides:
+   * - an upload is redundant if host data matches the shadow checksum
+   *   left by the last transfer of the same range, in either direction;
+   * - a download is redundant if it leaves host data unchanged.
+   *
+   * Wasted bytes are counted per label and call site, and ranked in the
+   * "wasted bandwidth" section of report_memory_usage(). Calling this
+   * function clears checksums and statistics.
+   *
+   * @param enabled Whether transfers should be profiled.
+   *
+   * @note Checksums cost host time on every transfer, so profiling mode
+   *       is meant for debugging runs.
+   * @note Device data written by compute regions is not checksummed, so an
+   *       upload after such writes may be reported as redundant although
+   *       it restores host data on device.
+   */
+  void set_transfer_profiling(const bool enabled);
+
+  /**
+   * @brief Returns the statistics of profiled transfers of each call site.
+   *
+   * @return Statistics of each label, call site and direction, by
+   *         decreasing wasted bytes.
+   */
+  std::vector<TransferSiteStats> return_transfer_profile();
+
+  /**
+   * @brief Reports memory used by the memory manager.
+   *
+   * @details
+   * This function prints to standard output a complete report of memory
+   * usage of the memory manager.
+   *
+   * A list of all allocated arrays is shown, with size (in bytes),
+   * whether the array is present on device or not, and on which sides its
+   * memory is materialized. Subtotals of allocation groups follow, and
+   * totals of each device if there are several, as well as host memory on
+   * each NUMA node if there are several or a placement policy is set.
+   * Shared host memory is marked as such, and totaled separately. Sizes
+   * of mixed-precision arrays are shown on host and device (host/device).
+   * Memory of pending frees and of the reuse cache is shown if any.
+   * Prefetch hits, late prefetches and misses are shown if any.
+   * In profiling mode, call sites with redundant transfers are ranked by
+   * wasted bytes.
+   */
+  void report_memory_usage();
+
+  /**
+   * @brief Opens a phase, nested in the innermost open phase.
+   *
+   * @details
+   * Until the phase is closed, allocations and frees of dual objects,
+   * peak memory, and host-device transfers (bytes, counts and time) are
+   * charged to it. Entering a phase with the same name inside the same
+   * enclosing phase accumulates into the same statistics.
+   * Prefer PhaseScope, which closes the phase at the end of a scope.
+   * Prefetches declared with next_phase_uses() are required first.
+   *
+   * @param name Name of the phase.
+   *
+   * @note Asynchronous transfers are counted when enqueued, with no time.
+   */
+  void begin_phase(const std::string &name);
+
+  /**
+   * @brief Closes the innermost open phase.
+   *
+   * @param name Name of the phase.
+   *
+   * @note If no phase is open or the innermost one has a different name,
+   *       the program aborts.
+   */
+  void end_phase(const std::string &name);
+
+  /**
+   * @brief Returns the statistics of all phases.
+   *
+   * @details
+   * Counters are given inclusive and exclusive of child phases. Open
+   * phases are included, with their time up to now, so statistics are
+   * available at any time.
+   *
+   * @return Statistics of each phase, in depth-first order.
+   */
+  std::vector<PhaseStats> return_phase_stats();
+
+  /**
+   * @brief Returns the statistics of all phases as a JSON document.
+   *
+   * @return JSON object whose "phases" member holds the tree of phases,
+   *         each with inclusive and exclusive counters and its children.
+   */
+  std::string return_phase_report_json();
+
+  /**
+   * @brief Prints the statistics of all phases to standard output, as a
+   * table indented by nesting depth.
+   */
+  void report_phases();
+
+  /**
+   * @brief Forgets the statistics of all phases.
+   *
+   * @note If a phase is open, the program aborts.
+   */
+  void reset_phases();
+
+  /**
+   * @brief Samples tracked memory against actual memory of the process and
+   * of the current device, and appends the sample to the history.
+   *
+   * @details
+   * Host values are the resident memory of the process, read from
+   * /proc/self/status (VmRSS and its peak VmHWM). Device values are the
+   * free and total memory reported by the backend (OpenACC device
+   * properties, or the capacity of an emulated device).
+   *
+   * @return Sample taken.
+   *
+   * @note Values that cannot be read are marked as unknown in the sample.
+   */
+  MemorySample sample_memory();
+
+  /**
+   * @brief Returns the history of memory samples.
+   *
+   * @return Samples, in the order they were taken.
+   */
+  std::vector<MemorySample> return_memory_samples();
+
+  /**
+   * @brief Forgets the history of memory samples.
+   */
+  void clear_memory_samples();
+
+  /**
+   * @brief Reports tracked memory against actual memory over time.
+   *
+   * @details
+   * This function takes a sample, then prints to standard output all
+   * samples of the history: for host and device, memory tracked by the
+   * manager, memory actually used, and the untracked gap between them
+   * (runtime, libraries and application data). A negative host gap means
+   * that tracked memory was not touched yet, so it is not resident.
+   *
+   * @note Memory of an emulated device lives on host, so it is resident
+   *       memory of the process as well.
+   */
+  void report_memory_reconciliation();
+
+  /**
+   * @brief Sets a callback raised before device allocations that would
+   * leave little free memory.
+   *
+   * @details
+   * Before each device allocation, free memory of the current device is
+   * queried; if the allocation would leave less than the given amount,
+   * the callback is invoked with a new sample (also appended to the
+   * history) and may release memory before the allocation is attempted.
+   * Allocations made by the callback do not raise the alarm again.
+   *
+   * @param min_free_bytes Free device memory below which the alarm is
+   *                       raised, in bytes.
+   * @param alarm          Callback of the alarm (empty to disable it).
+   *
+   * @note If the backend does not report device memory, the alarm is
+   *       never raised.
+   */
+  void set_low_memory_alarm(const size_t min_free_bytes,
+                            const LowMemoryAlarm alarm);
+
+  /**
+   * @brief Starts publishing live statistics into a shared-memory page.
+   *
+   * @details
+   * Totals and peaks of host and device memory, memory used by label,
+   * and counts and bytes of host-device transfers are published into a
+   * named POSIX shared-memory page, which external tools (e.g. mimmo-top)
+   * can read while the program runs. The page is updated on allocations,
+   * frees and transfers, at most once per interval, through a sequence
+   * lock: updates never wait for readers.
+   *
+   * @param name       Name of the page (by default "mimmo-stats-<pid>").
+   * @param interval_s Minimum interval between updates, in seconds.
+   *
+   * @return           Name of the page.
+   *
+   * @note If the page cannot be created, the program aborts.
+   */
+  std::string
+  enable_stats_export(const std::string &name = "",
+                      const double interval_s = default_stats_interval);
+
+  /**
+   * @brief Stops publishing live statistics and removes the page.
+   */
+  void disable_stats_export();
+
+  /**
+   * @brief Updates the live statistics page immediately (e.g. before a
+   * long computation without allocations or transfers).
+   */
+  void publish_stats();
+
+  /// @todo Consider adding a destructor to clean up tracked memory.
+};
+
+/**
+ * @brief Opens a phase of a memory manager for the lifetime of the
+ * object, then closes it.
+ */
+class PhaseScope {
+public:
+  /**
+   * @brief Class constructor.
+   *
+   * @param manager Memory manager whose phase is opened.
+   * @param name    Name of the phase.
+   */
+  PhaseScope(DualMemoryManager &manager, const std::string &name)
+      : manager(manager), name(name) {
+    manager.begin_phase(name);
+  }
+
+  /**
+   * @brief Class destructor.
+   */
+  ~PhaseScope() { manager.end_phase(name); }
+
+  PhaseScope(const PhaseScope &) = delete;
+  PhaseScope &operator=(const PhaseScope &) = delete;
+
+private:
+  DualMemoryManager &manager; /*!< memory manager of the phase */
+  const std::string name;     /*!< name of the phase */
+};
+
+/**
+ * @brief Runs tasks on host and device, inserting the transfers and
+ * the ordering between asynchronous queues they need.
+ *
+ * @details
+ * Each task declares the dual objects it reads and writes (see reads(),
+ * writes() and reads_writes()), and whether it accesses them on host or
+ * device. Tasks run in the order they were added, which must be a valid
+ * sequential order. During execute():
+ * - an object read on a side where it is not up to date is copied there
+ *   first, and an object written on a side becomes out of date on the
+ *   other side;
+ * - a device task runs on the queue of a task it depends on, or on a
+ *   queue of its own if it is independent of the device work in flight,
+ *   so that independent tasks and their uploads overlap;
+ * - dependencies between queues are ordered with wait_queue_async(), and
+ *   the host only waits for queues whose results a host task needs.
+ *
+ * The work of a device task is launched by its callable, which is given
+ * the queue of the task, e.g. with
+ * `#pragma acc parallel loop present(...) async(queue)`. Without
+ * OpenACC, the host waits for the queue of a device task before running
+ * it. Objects are assumed to be up to date on host only when first
+ * accessed, unless set_valid() says otherwise.
+ *
+ * @note Accessed objects must outlive the graph, and must not be
+ *       modified outside of it unless set_valid() is called.
+ */
+class TaskGraph {
+public:
+  /**
+   * @brief Class constructor.
+   *
+   * @param manager    Memory manager of the accessed objects.
+   * @param queue_base First asynchronous queue of the graph.
+   * @param num_queues Number of asynchronous queues of the graph.
+   */
+  TaskGraph(DualMemoryManager &manager, const int queue_base = task_queue_base,
+            const int num_queues = task_num_queues);
+
+  TaskGraph(const TaskGraph &) = delete;
+  TaskGraph &operator=(const TaskGraph &) = delete;
+
+  /**
+   * @brief Adds a task at the end of the graph.
+   *
+   * @param name     Name of the task.
+   * @param side     Side on which the task accesses its objects.
+   * @param accesses Objects accessed by the task.
+   * @param run      Work of the task, given its queue (-1 for host
+   *                 tasks).
+   *
+   * @note If an object is accessed twice by the task, the program aborts.
+   */
+  void add_task(const std::string &name, const Side side,
+                const std::vector<TaskAccess> &accesses,
+                const std::function<void(int)> &run);
+
+  /**
+   * @brief Declares on which sides a dual object is up to date.
+   *
+   * @param object     Address of the dual object.
+   * @param host_valid Whether host data is up to date.
+   * @param dev_valid  Whether device data is up to date.
+   */
+  void set_valid(const void *const object, const bool host_valid,
+                 const bool dev_valid);
+
+  /**
+   * @brief Runs all tasks, then waits for the queues of the graph.
+   *
+   * @details
+   * The graph can be executed again (e.g. at each time step): objects
+   * keep the sides on which they are up to date, so transfers that are
+   * no longer needed are skipped.
+   */
+  void execute();
+
+  /**
+   * @brief Returns statistics of the last execution.
+   *
+   * @return Numbers of tasks, transfers and waits.
+   */
+  TaskGraphStats return_stats() const;
+
+  /**
+   * @brief Returns the graph of the last execution in DOT format.
+   *
+   * @details
+   * Tasks are boxes and inserted transfers are ellipses, colored by
+   * queue (black on host), with an edge from each node to the nodes
+   * depending on it.
+   *
+   * @return Graph description for Graphviz.
+   */
+  std::string return_dot() const;
+
+private:
+  /**
+   * @brief Returns the next queue of the graph, in round-robin order.
+   *
+   * @return Asynchronous queue.
+   */
+  int next_queue();
+
+  /**
+   * @brief Orders a node after its dependencies.
+   *
+   * @details
+   * Work on a queue waits for dependencies on other queues; the host
+   * waits for the queues of the dependencies of host work.
+   *
+   * @param node Node to be ordered.
+   */
+  void order_after_deps(const GraphNode &node);
+
+  DualMemoryManager &manager; /*!< memory manager of the objects */
+  const int queue_base;       /*!< first queue of the graph */
+  const int num_queues;       /*!< number of queues of the graph */
+  int queue_counter;          /*!< number of queues handed out */
+  std::vector<GraphTask> tasks; /*!< tasks, in order */
+  std::map<const void *, GraphObjectState>
+      states;                   /*!< sides on which objects are up to
+                                     date */
+  std::vector<GraphNode> nodes; /*!< nodes of the last execution */
+  TaskGraphStats stats;         /*!< statistics of the last execution */
+  std::map<std::pair<int, int>, size_t>
+      ordered; /*!< for each queue and waiting queue (-1 for the host),
+                    number of nodes ordered by the last wait */
+};
+
+/**
+ * @name Task accesses
+ *
+ * Declarations of the accesses of a task to dual objects, for
+ * TaskGraph::add_task().
+ */
+///@{
+
+/**
+ * @brief Declares that a task reads a dual array.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array read by the task.
+ *
+ * @return           Access of the task.
+ */
+template <typename T> TaskAccess reads(DualArray<T> &dual_array);
+
+/**
+ * @brief Declares that a task overwrites a dual array without reading
+ * it.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array written by the task.
+ *
+ * @return           Access of the task.
+ */
+template <typename T> TaskAccess writes(DualArray<T> &dual_array);
+
+/**
+ * @brief Declares that a task reads and modifies a dual array.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array read and written by the task.
+ *
+ * @return           Access of the task.
+ */
+template <typename T> TaskAccess reads_writes(DualArray<T> &dual_array);
+
+/**
+ * @brief Declares that a task reads a dual scalar.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar read by the task.
+ *
+ * @return            Access of the task.
+ */
+template <typename T> TaskAccess reads(DualScalar<T> &dual_scalar);
+
+/**
+ * @brief Declares that a task overwrites a dual scalar without reading
+ * it.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar written by the task.
+ *
+ * @return            Access of the task.
+ */
+template <typename T> TaskAccess writes(DualScalar<T> &dual_scalar);
+
+/**
+ * @brief Declares that a task reads and modifies a dual scalar.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar read and written by the task.
+ *
+ * @return            Access of the task.
+ */
+template <typename T> TaskAccess reads_writes(DualScalar<T> &dual_scalar);
+
+///@}
+
+/**
+ * @name Parallel primitives
+ *
+ * Common operations on whole dual arrays. With OpenACC they run on
+ * device memory, otherwise they run on host memory using multiple
+ * threads. Data is not synchronized between host and device.
+ */
+///@{
+
+/**
+ * @brief Sets all elements of a dual array to a value.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be filled.
+ * @param value      Value to be assigned.
+ */
+template <typename T> void fill(DualArray<T> &dual_array, const T value);
+
+/**
+ * @brief Sets elements of a dual array to consecutive values.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be filled.
+ * @param start      Value of the first element.
+ */
+template <typename T> void iota(DualArray<T> &dual_array, const T start);
+
+/**
+ * @brief Copies all elements of a dual array into another one.
+ *
+ * @tparam T  Type of elements in the arrays.
+ *
+ * @param dst Destination dual array.
+ * @param src Source dual array.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T> void copy(DualArray<T> &dst, const DualArray<T> &src);
+
+/**
+ * @brief Applies an operation to each element of a dual array.
+ *
+ * @tparam T  Type of elements in the arrays.
+ * @tparam F  Type of the operation.
+ *
+ * @param dst Dual array receiving the results (can be src).
+ * @param src Dual array to be transformed.
+ * @param op  Operation taking an element and returning its result.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T, typename F>
+void transform(DualArray<T> &dst, const DualArray<T> &src, F op);
+
+/**
+ * @brief Sums all elements of a dual array into a dual scalar.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param result     Dual scalar receiving the sum (on host and, if
+ *                   present, on device).
+ * @param dual_array Dual array to be reduced.
+ */
+template <typename T>
+void reduce(DualScalar<T> &result, const DualArray<T> &dual_array);
+
+/**
+ * @brief Computes the scalar product of two dual arrays into a dual
+ * scalar.
+ *
+ * @tparam T     Type of elements in the arrays.
+ *
+ * @param result Dual scalar receiving the product (on host and, if
+ *               present, on device).
+ * @param first  First dual array.
+ * @param second Second dual array.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T>
+void dot(DualScalar<T> &result, const DualArray<T> &first,
+         const DualArray<T> &second);
+
+/**
+ * @brief Adds a scaled dual array to another one (y = alpha * x + y).
+ *
+ * @tparam T    Type of elements in the arrays.
+ *
+ * @param y     Dual array to be updated.
+ * @param alpha Scaling factor.
+ * @param x     Dual array to be scaled and added.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T>
+void axpy(DualArray<T> &y, const T alpha, const DualArray<T> &x);
+
+/**
+ * @brief Computes the inclusive prefix sum of a dual array.
+ *
+ * @tparam T  Type of elements in the arrays.
+ *
+ * @param dst Dual array receiving the prefix sums (can be src).
+ * @param src Dual array to be scanned.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T>
+void inclusive_scan(DualArray<T> &dst, const DualArray<T> &src);
+
+/**
+ * @brief Computes the exclusive prefix sum of a dual array.
+ *
+ * @tparam T   Type of elements in the arrays.
+ *
+ * @param dst  Dual array receiving the prefix sums (can be src).
+ * @param src  Dual array to be scanned.
+ * @param init Value of the first sum.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T>
+void exclusive_scan(DualArray<T> &dst, const DualArray<T> &src,
+                    const T init = T());
+
+/**
+ * @brief Multiplies a sparse matrix by a dual array (y = A x).
+ *
+ * @details
+ * Each row is computed by one device thread with OpenACC, and rows are
+ * split among host threads otherwise.
+ *
+ * @tparam T     Type of matrix values and array elements.
+ * @tparam Index Type of column indices and row offsets.
+ *
+ * @param y      Dual array receiving the product (one element per row).
+ * @param matrix Sparse matrix.
+ * @param x      Dual array to be multiplied (one element per column).
+ *
+ * @note If sizes do not match the matrix, the program aborts.
+ */
+template <typename T, typename Index>
+void spmv(DualArray<T> &y, const DualCSR<T, Index> &matrix,
+          const DualArray<T> &x);
+
+/**
+ * @brief Counts the bits set in a bit-packed dual array into a dual
+ * scalar.
+ *
+ * @param result    Dual scalar receiving the count (on host and, if
+ *                  present, on device).
+ * @param bit_array Bit-packed dual array to be counted.
+ */
+void popcount(DualScalar<size_t> &result, const DualBitArray &bit_array);
+
+/**
+ * @brief Checks whether any bit of a bit-packed dual array is set, into a
+ * dual scalar.
+ *
+ * @param result    Dual scalar receiving the answer (on host and, if
+ *                  present, on device).
+ * @param bit_array Bit-packed dual array to be checked.
+ */
+void any(DualScalar<bool> &result, const DualBitArray &bit_array);
+
+/**
+ * @brief Checks whether all bits of a bit-packed dual array are set, into
+ * a dual scalar.
+ *
+ * @param result    Dual scalar receiving the answer (on host and, if
+ *                  present, on device).
+ * @param bit_array Bit-packed dual array to be checked.
+ *
+ * @note An empty array has all its bits set.
+ */
+void all(DualScalar<bool> &result, const DualBitArray &bit_array);
+
+///@}
+
+/**
+ * @brief Returns a view of one level of a ring.
+ *
+ * @details
+ * The view is a dual array sharing the memory of the current slot of the
+ * level, e.g. to pass the level to parallel primitives. It is not
+ * tracked, and refers to another level once the ring is rotated.
+ *
+ * @tparam T      Type of elements in each level.
+ * @tparam Levels Number of time levels.
+ *
+ * @param ring    Ring holding the level.
+ * @param level   Level to be viewed (0 for the newest).
+ *
+ * @return        View of the level.
+ *
+ * @note If the level is out of range, the program aborts.
+ */
+template <typename T, size_t Levels>
+DualArray<T> ring_level(const DualRing<T, Levels> &ring, const size_t level);
+
+/**
+ * @brief Returns the pointer used by compute regions without OpenACC.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array from which the pointer should be selected.
+ *
+ * @return           Device pointer if device memory is emulated, host
+ *                   pointer otherwise.
+ *
+ * @note Used by MIMMO_GET_PTR().
+ */
+template <typename T> T *compute_ptr(const DualArray<T> &dual_array) {
+  return dual_array.dev_ptr != nullptr ? dual_array.dev_ptr
+                                       : dual_array.host_ptr;
+}
+
+/**
+ * @brief Returns the pointer used by compute regions without OpenACC, for
+ * mixed-precision dual arrays.
+ *
+ * @tparam T         Type of elements in the array on host.
+ * @tparam D         Type of elements in the array on device.
+ *
+ * @param dual_array Dual array from which the pointer should be selected.
+ *
+ * @return           Pointer to device elements (kept in host memory
+ *                   without device memory).
+ *
+ * @note Used by MIMMO_GET_PTR().
+ */
+template <typename T, typename D>
+D *compute_ptr(const DualArray<T, D> &dual_array) {
+  return dual_array.dev_ptr;
+}
+
+} // namespace MiMMO
+
+/**
+ * @brief Returns the device or host pointer depending on compilation flags.
+ *
+ * @param x Dual array from which the pointer should be selected.
+ *
+ * @note Use inside OpenACC compute regions only.
+ * @note Without OpenACC, the device pointer is selected only if device
+ *       memory is emulated (see EmulatedDeviceBackend), or for
+ *       mixed-precision arrays.
+ */
+#ifdef _OPENACC
+#define MIMMO_GET_PTR(x) (x).dev_ptr
+#else
+#define MIMMO_GET_PTR(x) MiMMO::compute_ptr(x)
+#endif // _OPENACC
+
+/**
+ * @brief Returns the device or host value depending on compilation flags.
+ *
+ * @param x Dual scalar from which the value should be selected.
+ *
+ * @note Use inside OpenACC compute regions only.
+ * @note Without OpenACC, the device value is selected only if device
+ *       memory is emulated (see EmulatedDeviceBackend).
+ */
+#ifdef _OPENACC
+#define MIMMO_GET_VALUE(x) *((x).dev_ptr)
+#else
+#define MIMMO_GET_VALUE(x)                                                     \
+  ((x).dev_ptr != nullptr ? *((x).dev_ptr) : (x).host_value)
+#endif // _OPENACC
+
+/**
+ * @brief Communicates in an OpenACC pragma that a dual array or scalar is
+ * present on device.
+ *
+ * @param x Dual array or scalar present on device.
+ *
+ * @note Must be used inside an OpenACC pragma at the beginning of a compute
+ *       region.
+ * @note Takes only one argument; use multiple calls for multiple objects.
+ * @note No copy variant exists by design; use DualMemoryManager methods for
+ *       data movement.
+ */
+#ifdef _OPENACC
+#define MIMMO_PRESENT(x) copyin(x) deviceptr(x.dev_ptr)
+#else
+#define MIMMO_PRESENT(x)
+#endif // _OPENACC
+
+/**
+ * @brief Communicates in an OpenACC pragma that the descriptor table is
+ * present on device.
+ *
+ * @param table Descriptor table, as returned by
+ *              DualMemoryManager::descriptor_table().
+ *
+ * @note Must be used inside an OpenACC pragma at the beginning of a compute
+ *       region.
+ * @note Unlike MIMMO_PRESENT(), no struct is copied at region entry.
+ */
+#ifdef _OPENACC
+#define MIMMO_TABLE_PRESENT(table) deviceptr(table)
+#else
+#define MIMMO_TABLE_PRESENT(table)
+#endif // _OPENACC
+
+/**
+ * @brief Returns the device or host pointer of a tracked object, through
+ * the descriptor table.
+ *
+ * @param table Descriptor table.
+ * @param T     Type of elements of the object.
+ * @param slot  Slot of the object in the descriptor table.
+ *
+ * @note Use inside OpenACC compute regions only.
+ */
+#define MIMMO_TABLE_GET_PTR(table, T, slot) ((T *)((table)[slot].ptr))
+
+/**
+ * @brief Returns the device or host value of a tracked dual scalar,
+ * through the descriptor table.
+ *
+ * @param table Descriptor table.
+ * @param T     Type of the scalar variable.
+ * @param slot  Slot of the scalar in the descriptor table.
+ *
+ * @note Use inside OpenACC compute regions only.
+ */
+#define MIMMO_TABLE_GET_VALUE(table, T, slot) (*((T *)((table)[slot].ptr)))
+
+/**
+ * @brief Returns the number of elements of a tracked object, through the
+ * descriptor table.
+ *
+ * @param table Descriptor table.
+ * @param slot  Slot of the object in the descriptor table.
+ *
+ * @note Use inside OpenACC compute regions only.
+ */
+#define MIMMO_TABLE_GET_SIZE(table, slot) ((table)[slot].size)
+
+/**
+ * @brief Returns the pointer to a row of a jagged dual array, on device
+ * or host depending on compilation flags.
+ *
+ * @param x   Jagged dual array.
+ * @param row Index of the row.
+ *
+ * @note Use inside OpenACC compute regions only, with the array present
+ *       (see MIMMO_JAGGED_PRESENT()).
+ */
+#define MIMMO_JAGGED_ROW_PTR(x, row)                                           \
+  (MIMMO_GET_PTR((x).values) + MIMMO_GET_PTR((x).offsets)[row])
+
+/**
+ * @brief Returns the number of elements of a row of a jagged dual array.
+ *
+ * @param x   Jagged dual array.
+ * @param row Index of the row.
+ *
+ * @note Use inside OpenACC compute regions only, with the array present
+ *       (see MIMMO_JAGGED_PRESENT()).
+ */
+#define MIMMO_JAGGED_ROW_SIZE(x, row)                                          \
+  (MIMMO_GET_PTR((x).offsets)[(row) + 1] - MIMMO_GET_PTR((x).offsets)[row])
+
+/**
+ * @brief Communicates in an OpenACC pragma that a jagged dual array is
+ * present on device.
+ *
+ * @param x Jagged dual array present on device.
+ *
+ * @note Must be used inside an OpenACC pragma at the beginning of a compute
+ *       region.
+ * @note Only the struct, holding device pointers, is copied at region
+ *       entry.
+ */
+#ifdef _OPENACC
+#define MIMMO_JAGGED_PRESENT(x) copyin(x)
+#else
+#define MIMMO_JAGGED_PRESENT(x)
+#endif // _OPENACC
+
+/**
+ * @brief Returns the pointer to a level of a ring, on device or host
+ * depending on compilation flags.
+ *
+ * @param x     Ring.
+ * @param level Level (0 for the newest).
+ *
+ * @note Use inside OpenACC compute regions only, with the ring present
+ *       (see MIMMO_RING_PRESENT()).
+ */
+#define MIMMO_RING_LEVEL_PTR(x, level)                                         \
+  (MIMMO_GET_PTR((x).values) + MIMMO_GET_PTR((x).offsets)[level])
+
+/**
+ * @brief Communicates in an OpenACC pragma that a ring is present on
+ * device.
+ *
+ * @param x Ring present on device.
+ *
+ * @note Must be used inside an OpenACC pragma at the beginning of a compute
+ *       region.
+ * @note Only the struct, holding device pointers, is copied at region
+ *       entry.
+ */
+#ifdef _OPENACC
+#define MIMMO_RING_PRESENT(x) copyin(x)
+#else
+#define MIMMO_RING_PRESENT(x)
 #endif // _OPENACC
 
 /* include of templated methods definitions */
 
 #include "../private/arrays.inl"
+#include "../private/bit_arrays.inl"
+#include "../private/csr.inl"
+#include "../private/deferred_frees.inl"
+#include "../private/delta_sync.inl"
+#include "../private/descriptor_table.inl"
+#include "../private/device_backend.inl"
+#include "../private/groups.inl"
+#include "../private/indexed_transfers.inl"
+#include "../private/jagged_arrays.inl"
+#include "../private/memory_reconciliation.inl"
+#include "../private/mixed_arrays.inl"
+#include "../private/numa.inl"
+#include "../private/partitioned_arrays.inl"
+#include "../private/phase_profiler.inl"
+#include "../private/prefetch.inl"
+#include "../private/primitives.inl"
+#include "../private/rings.inl"
 #include "../private/scalars.inl"
+#include "../private/scratch_arena.inl"
+#include "../private/shared_arrays.inl"
+#include "../private/staging.inl"
+#include "../private/stats_export.inl"
+#include "../private/task_graph.inl"
+#include "../private/transfer_planner.inl"
+#include "../private/transfer_profiler.inl"
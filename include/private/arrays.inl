@@ -5,9 +5,17 @@
  *
  * Implements the following DualMemoryManager methods:
  * - alloc_array()
+ * - alloc_array_lazy()
+ * - materialize()
+ * - get_host_ptr()
+ * - get_dev_ptr()
  * - update_array_host_to_device()
  * - update_array_device_to_host()
+ * - copy_array()
+ * - clone_array()
  * - free_array()
+ * - track_array()
+ * - untrack_array()
  *
  * @see api.hpp for the corresponding declarations
  */
@@ -16,9 +24,40 @@
 
 namespace MiMMO {
 
+/**
+ * @brief Points a view into the storage of a packed container (e.g. a
+ * component of a sparse matrix).
+ *
+ * @details
+ * Views are dual arrays sharing the memory of the storage; they are not
+ * tracked on their own.
+ *
+ * @tparam T      Type of elements of the view.
+ *
+ * @param view    View to be set.
+ * @param storage Storage of the container.
+ * @param offset  Offset in bytes of the view in the storage.
+ * @param size    Number of elements of the view.
+ */
+template <typename T>
+void set_storage_view(DualArray<T> &view,
+                      const DualArray<unsigned char> &storage,
+                      const size_t offset, const size_t size) {
+  view.host_ptr = (T *)(storage.host_ptr + offset);
+  view.dev_ptr =
+      storage.dev_ptr != nullptr ? (T *)(storage.dev_ptr + offset) : nullptr;
+  view.size = size;
+  view.size_bytes = size * sizeof(T);
+  return;
+}
+
 /**
  * @brief Allocates dual array memory.
  *
+ * @details
+ * Device memory is allocated on the current device, which is recorded so
+ * that later operations on the array use it.
+ *
  * @tparam T         Type of elements in the array.
  *
  * @param dual_array Dual array to be allocated.
@@ -26,8 +65,7 @@ namespace MiMMO {
  *                   memory.
  * @param size       Number of elements in the array.
  * @param on_device  Whether the array should be allocated on device as
- *                   well (ignored if main code compiled without OpenACC
- *                   support).
+ *                   well (ignored without device memory).
  */
 template <typename T>
 void DualMemoryManager::alloc_array(DualArray<T> &dual_array,
@@ -35,47 +73,209 @@ void DualMemoryManager::alloc_array(DualArray<T> &dual_array,
                                     const bool on_device) {
 
   /* allocate memory on host */
-  dual_array.host_ptr = (T *)std::malloc(size * sizeof(T));
+  dual_array.host_ptr = (T *)host_alloc(size, sizeof(T));
 
   /* if required, allocate memory on device */
-#ifdef _OPENACC
-  if (on_device) {
-    dual_array.dev_ptr = (T *)acc_malloc(size * sizeof(T));
+  const bool dev_alloc = on_device && backend->has_device();
+  dual_array.dev_ptr = nullptr;
+
+  if (dev_alloc) {
+    check_low_memory(size * sizeof(T));
+    dual_array.dev_ptr = (T *)backend->alloc(size * sizeof(T));
 
     if (!(dual_array.dev_ptr)) {
-      std::free(dual_array.host_ptr);
+      host_free(dual_array.host_ptr);
       dual_array.host_ptr = nullptr;
       abort_mimmo("Failed to allocate device memory.");
     }
-
-  } else {
-    dual_array.dev_ptr = nullptr;
   }
-#else
+
+  /* update number of elements and bytes */
+  dual_array.size = size;
+  dual_array.size_bytes = size * sizeof(T);
+
+  track_array(dual_array, label, dev_alloc);
+
+  return;
+}
+
+/**
+ * @brief Tracks a dual array whose memory was just allocated.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array, with its pointers and sizes set.
+ * @param label      Label that should be used to track the array in
+ *                   memory.
+ * @param on_device  Whether the array is allocated on device.
+ */
+template <typename T>
+void DualMemoryManager::track_array(DualArray<T> &dual_array,
+                                    const std::string label,
+                                    const bool on_device) {
+
+  /* update memory tracker */
+  const bool ret = add_to_memory_tracker(
+      memory_tracker, total_memory, label_memory, (void *)&dual_array, label,
+      dual_array.size_bytes, on_device, false, backend->get_device());
+
+  if (ret)
+    abort_mimmo("Failed to track memory for dual array '" + label + "'.");
+
+  record_memory(1, 0);
+
+  /* assign descriptor table slot */
+  register_descriptor((void *)&dual_array, (void *)dual_array.host_ptr,
+                      (void *)dual_array.dev_ptr, dual_array.size);
+
+  return;
+}
+
+/**
+ * @brief Reserves dual array memory, deferring allocation to first use.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be reserved.
+ * @param label      Label that should be used to track the array in
+ *                   memory.
+ * @param size       Number of elements in the array.
+ * @param on_device  Whether the array may be materialized on device as
+ *                   well (ignored without device memory).
+ */
+template <typename T>
+void DualMemoryManager::alloc_array_lazy(DualArray<T> &dual_array,
+                                         const std::string label,
+                                         const size_t size,
+                                         const bool on_device) {
+
+  /* no memory is allocated until first use */
+  dual_array.host_ptr = nullptr;
   dual_array.dev_ptr = nullptr;
-#endif // _OPENACC
 
   /* update number of elements and bytes */
   dual_array.size = size;
   dual_array.size_bytes = size * sizeof(T);
 
   /* update memory tracker */
-#ifdef _OPENACC
-  const bool ret =
-      add_to_memory_tracker(memory_tracker, total_memory, (void *)&dual_array,
-                            label, dual_array.size_bytes, on_device);
-#else
-  const bool ret =
-      add_to_memory_tracker(memory_tracker, total_memory, (void *)&dual_array,
-                            label, dual_array.size_bytes, false);
-#endif // _OPENACC
+  const bool ret = add_to_memory_tracker(
+      memory_tracker, total_memory, label_memory, (void *)&dual_array, label,
+      dual_array.size_bytes, on_device && backend->has_device(), true,
+      backend->get_device());
 
   if (ret)
     abort_mimmo("Failed to track memory for dual array '" + label + "'.");
 
+  record_memory(1, 0);
+
+  /* assign descriptor table slot */
+  register_descriptor((void *)&dual_array, (void *)dual_array.host_ptr,
+                      (void *)dual_array.dev_ptr, size);
+
+  return;
+}
+
+/**
+ * @brief Materializes memory of a dual array on one side.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be materialized.
+ * @param side       Side on which memory should be materialized.
+ *
+ * @note If the array is not tracked, or it is materialized on device
+ *       while not reserved on device, the program aborts.
+ * @note Without device memory, materializing on device does
+ *       nothing.
+ */
+template <typename T>
+void DualMemoryManager::materialize(DualArray<T> &dual_array,
+                                    const Side side) {
+
+  if (side == Side::Host) {
+    /* nothing to do if host memory is already allocated */
+    if (dual_array.host_ptr != nullptr)
+      return;
+
+    /* check that array was actually recorded */
+    if (memory_tracker.find((void *)&dual_array) == memory_tracker.end())
+      abort_mimmo("Dual array was not found by memory manager.");
+
+    /* allocate memory on host */
+    dual_array.host_ptr = (T *)host_alloc(dual_array.size, sizeof(T));
+
+    if (!(dual_array.host_ptr))
+      abort_mimmo("Failed to allocate host memory.");
+
+    mark_as_materialized(memory_tracker, total_memory, label_memory,
+                         (void *)&dual_array, false);
+    record_memory(0, 0);
+    update_descriptor((void *)&dual_array, (void *)dual_array.host_ptr,
+                      (void *)dual_array.dev_ptr);
+
+    return;
+  }
+
+  /* nothing to do without device memory, or if it is already allocated */
+  if (!backend->has_device() || dual_array.dev_ptr != nullptr)
+    return;
+
+  /* check that array was actually recorded on device */
+  const auto it = memory_tracker.find((void *)&dual_array);
+
+  if (it == memory_tracker.end())
+    abort_mimmo("Dual array was not found by memory manager.");
+
+  if (!(it->second.on_device))
+    abort_mimmo("Dual array '" + it->second.label +
+                "' was not allocated on device.");
+
+  /* allocate memory on the device recorded at reservation */
+  const DeviceScope scope(*backend, it->second.device);
+  dual_array.dev_ptr = (T *)device_alloc(dual_array.size_bytes);
+
+  mark_as_materialized(memory_tracker, total_memory, label_memory,
+                       (void *)&dual_array, true);
+  record_memory(0, 0);
+  update_descriptor((void *)&dual_array, (void *)dual_array.host_ptr,
+                    (void *)dual_array.dev_ptr);
+
   return;
 }
 
+/**
+ * @brief Returns the host pointer of a dual array, materializing host
+ * memory if needed.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be accessed.
+ *
+ * @return           Pointer to host memory of the array.
+ */
+template <typename T>
+T *DualMemoryManager::get_host_ptr(DualArray<T> &dual_array) {
+  materialize(dual_array, Side::Host);
+  return dual_array.host_ptr;
+}
+
+/**
+ * @brief Returns the device pointer of a dual array, materializing
+ * device memory if needed.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be accessed.
+ *
+ * @return           Pointer to device memory of the array (nullptr
+ *                   without device memory).
+ */
+template <typename T>
+T *DualMemoryManager::get_dev_ptr(DualArray<T> &dual_array) {
+  materialize(dual_array, Side::Device);
+  return dual_array.dev_ptr;
+}
+
 /**
  * @brief Copies data from host to device.
  *
@@ -84,26 +284,51 @@ void DualMemoryManager::alloc_array(DualArray<T> &dual_array,
  * @param dual_array   Dual array to synchronize.
  * @param offset       Index of first element to be copied.
  * @param num_elements Number of elements to be copied.
+ * @param location     Call site, recorded in profiling mode.
  *
- * @note If OpenACC is not enabled, this function does nothing.
+ * @note Memory of lazily allocated arrays is materialized on both
+ *       sides.
+ * @note With delta synchronization (see enable_delta_sync()), only the
+ *       blocks of the range that changed since the last upload are
+ *       copied.
+ * @note In profiling mode, uploads are profiled as requested, even if
+ *       delta synchronization then skips unchanged blocks.
+ * @note Without device memory, this function does nothing.
  */
 template <typename T>
-void DualMemoryManager::update_array_host_to_device(DualArray<T> dual_array,
-                                                    const size_t offset,
-                                                    const size_t num_elements) {
-  /* check that host pointer is initialized */
+void DualMemoryManager::update_array_host_to_device(
+    DualArray<T> &dual_array, const size_t offset, const size_t num_elements,
+    const SourceLocation location) {
+  /* materialize lazily allocated memory */
   if (dual_array.host_ptr == nullptr)
-    abort_mimmo("Host pointer of dual array is a null pointer.");
+    materialize(dual_array, Side::Host);
+
+  if (!backend->has_device())
+    return;
+
+  const DeviceScope scope(*backend, object_device(&dual_array));
 
-#ifdef _OPENACC
-  /* check that device pointer is initialized */
   if (dual_array.dev_ptr == nullptr)
-    abort_mimmo("Device pointer of dual array is a null pointer.");
+    materialize(dual_array, Side::Device);
+
+  /* in profiling mode, compare host data with the shadow checksum */
+  if (transfer_profiling) {
+    const uint64_t hash =
+        xxh64(dual_array.host_ptr + offset, num_elements * sizeof(T));
+    profile_transfer((void *)&dual_array, offset * sizeof(T),
+                     num_elements * sizeof(T), hash, hash, true, location);
+  }
+
+  /* with delta synchronization, copy only changed blocks */
+  const auto delta = delta_states.find((void *)&dual_array);
+  if (delta != delta_states.end()) {
+    update_array_delta(dual_array, offset, num_elements, delta->second);
+    return;
+  }
 
   /* copy data from host to device */
-  acc_memcpy_to_device(dual_array.dev_ptr + offset,
-                       dual_array.host_ptr + offset, num_elements * sizeof(T));
-#endif // _OPENACC
+  copy_to_device(dual_array.dev_ptr + offset, dual_array.host_ptr + offset,
+                 num_elements * sizeof(T));
 
   return;
 }
@@ -116,26 +341,150 @@ void DualMemoryManager::update_array_host_to_device(DualArray<T> dual_array,
  * @param dual_array   Dual array to synchronize.
  * @param offset       Index of first element to be copied.
  * @param num_elements Number of elements to be copied.
+ * @param location     Call site, recorded in profiling mode.
  *
- * @note If OpenACC is not enabled, this function does nothing.
+ * @note Memory of lazily allocated arrays is materialized on both
+ *       sides.
+ * @note If host memory is shared and read-only, the program aborts.
+ * @note Without device memory, this function does nothing.
  */
 template <typename T>
-void DualMemoryManager::update_array_device_to_host(DualArray<T> dual_array,
-                                                    const size_t offset,
-                                                    const size_t num_elements) {
-  /* check that host pointer is initialized */
+void DualMemoryManager::update_array_device_to_host(
+    DualArray<T> &dual_array, const size_t offset, const size_t num_elements,
+    const SourceLocation location) {
+  /* materialize lazily allocated memory */
   if (dual_array.host_ptr == nullptr)
-    abort_mimmo("Host pointer of dual array is a null pointer.");
+    materialize(dual_array, Side::Host);
+
+  if (!backend->has_device())
+    return;
+
+  check_host_writable(&dual_array);
+
+  const DeviceScope scope(*backend, object_device(&dual_array));
 
-#ifdef _OPENACC
-  /* check that device pointer is initialized */
   if (dual_array.dev_ptr == nullptr)
-    abort_mimmo("Device pointer of dual array is a null pointer.");
+    materialize(dual_array, Side::Device);
+
+  /* in profiling mode, checksum host data before and after the copy */
+  const uint64_t old_hash =
+      transfer_profiling
+          ? xxh64(dual_array.host_ptr + offset, num_elements * sizeof(T))
+          : 0;
 
   /* copy data from device to host */
-  acc_memcpy_from_device(dual_array.host_ptr + offset,
-                         dual_array.dev_ptr + offset, num_elements * sizeof(T));
-#endif
+  copy_from_device(dual_array.host_ptr + offset, dual_array.dev_ptr + offset,
+                   num_elements * sizeof(T));
+
+  if (transfer_profiling)
+    profile_transfer(
+        (void *)&dual_array, offset * sizeof(T), num_elements * sizeof(T),
+        old_hash,
+        xxh64(dual_array.host_ptr + offset, num_elements * sizeof(T)), false,
+        location);
+
+  return;
+}
+
+/**
+ * @brief Copies elements between two dual arrays on one side.
+ *
+ * @tparam T           Type of elements in the arrays.
+ *
+ * @param dst          Destination dual array.
+ * @param dst_offset   Index of first element to be written in dst.
+ * @param src          Source dual array.
+ * @param src_offset   Index of first element to be read in src.
+ * @param num_elements Number of elements to be copied.
+ * @param side         Side on which the copy should be performed.
+ *
+ * @note If a range exceeds the size of its array, source and
+ *       destination ranges overlap, or host memory of dst is shared
+ *       and read-only (on host), the program aborts.
+ * @note Without device memory, a copy on device is performed on
+ *       host, since compute regions work on host data.
+ * @note Arrays on different devices are copied device-to-device.
+ */
+template <typename T>
+void DualMemoryManager::copy_array(DualArray<T> &dst, const size_t dst_offset,
+                                   const DualArray<T> &src,
+                                   const size_t src_offset,
+                                   const size_t num_elements, const Side side) {
+  /* check that ranges are valid */
+  if (dst_offset + num_elements > dst.size ||
+      src_offset + num_elements > src.size)
+    abort_mimmo("Copy range exceeds size of dual array.");
+
+  if (num_elements == 0)
+    return;
+
+  /* select pointers on the requested side */
+  const bool on_device = (side == Side::Device) && backend->has_device();
+
+  /* materialize lazily allocated destination */
+  materialize(dst, on_device ? Side::Device : Side::Host);
+
+  T *const dst_ptr = on_device ? dst.dev_ptr : dst.host_ptr;
+  const T *const src_ptr = on_device ? src.dev_ptr : src.host_ptr;
+
+  /* check that pointers are initialized */
+  if (dst_ptr == nullptr || src_ptr == nullptr)
+    abort_mimmo(std::string(on_device ? "Device" : "Host") +
+                " pointer of dual array is a null pointer.");
+
+  /* check that ranges do not overlap */
+  if (dst_ptr + dst_offset < src_ptr + src_offset + num_elements &&
+      src_ptr + src_offset < dst_ptr + dst_offset + num_elements)
+    abort_mimmo("Source and destination ranges of copy overlap.");
+
+  /* copy data on the requested side */
+  if (!on_device)
+    check_host_writable(&dst);
+
+  if (on_device) {
+    backend->memcpy_peer(dst_ptr + dst_offset, object_device(&dst),
+                         src_ptr + src_offset, object_device(&src),
+                         num_elements * sizeof(T));
+  } else {
+    parallel_memcpy(dst_ptr + dst_offset, src_ptr + src_offset,
+                    num_elements * sizeof(T));
+  }
+
+  return;
+}
+
+/**
+ * @brief Allocates a dual array as a copy of an existing one.
+ *
+ * @tparam T         Type of elements in the arrays.
+ *
+ * @param clone      Dual array to be allocated.
+ * @param src        Dual array to be cloned.
+ * @param label      Label that should be used to track the clone in
+ *                   memory.
+ *
+ * @note The clone is allocated on the device of the source.
+ */
+template <typename T>
+void DualMemoryManager::clone_array(DualArray<T> &clone,
+                                    const DualArray<T> &src,
+                                    const std::string label) {
+  /* check that host pointer of source is initialized */
+  if (src.host_ptr == nullptr)
+    abort_mimmo("Host pointer of dual array is a null pointer.");
+
+  /* allocate clone with the same layout (and device) as the source */
+  {
+    const DeviceScope scope(*backend, object_device(&src));
+    alloc_array(clone, label, src.size, src.dev_ptr != nullptr);
+  }
+
+  /* copy host data */
+  copy_array(clone, 0, src, 0, src.size, Side::Host);
+
+  /* copy device data */
+  if (src.dev_ptr != nullptr)
+    copy_array(clone, 0, src, 0, src.size, Side::Device);
 
   return;
 }
@@ -148,37 +497,65 @@ void DualMemoryManager::update_array_device_to_host(DualArray<T> dual_array,
  * @param dual_array Dual array to be freed.
  *
  * @note If the array is not tracked (i.e. was not allocated using this
- *       memory manager, or it was already freed), the program aborts.
+ *       memory manager, or it was already freed), belongs to an allocation
+ *       group, or is shared, the program aborts.
  */
 template <typename T>
 void DualMemoryManager::free_array(DualArray<T> &dual_array) {
-  /* check that host pointer is not null */
-  if (dual_array.host_ptr == nullptr) {
-    abort_mimmo("Host pointer of dual array is a null pointer.");
-  }
 
-  /* check that array was actually recorded and update memory
-   * tracker
+  const int device = untrack_array(dual_array);
+
+  /* free memory on host (a null pointer means it was never materialized) */
+  host_free(dual_array.host_ptr);
+  dual_array.host_ptr = nullptr;
+
+  /* free memory on its device */
+  device_free(dual_array.dev_ptr, device);
+  dual_array.dev_ptr = nullptr;
+
+  return;
+}
+
+/**
+ * @brief Stops tracking a dual array being freed.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be freed.
+ *
+ * @return           Device of the array.
+ *
+ * @note If the array is not tracked, belongs to an allocation group, or
+ *       is shared, the program aborts.
+ */
+template <typename T>
+int DualMemoryManager::untrack_array(DualArray<T> &dual_array) {
+  /* check that array was actually recorded, does not belong to a
+   * group and is not shared
    * */
-  const bool ret = remove_from_memory_tracker(memory_tracker, total_memory,
-                                              (void *)&dual_array);
-  if (ret) {
+  const auto it = memory_tracker.find((void *)&dual_array);
+  if (it == memory_tracker.end()) {
     abort_mimmo("Dual array was not found by memory manager.");
   }
+  if (!(it->second.group.empty())) {
+    abort_mimmo("Dual array belongs to group '" + it->second.group +
+                "' and must be freed with free_group().");
+  }
+  if (it->second.shared) {
+    abort_mimmo("Dual array '" + it->second.label +
+                "' is shared and must be freed with free_shared_array().");
+  }
 
-  /* free memory on host */
-  std::free(dual_array.host_ptr);
-  dual_array.host_ptr = nullptr;
+  const int device = it->second.device;
 
-  /* free memory on device */
-#ifdef _OPENACC
-  if (dual_array.dev_ptr != nullptr) {
-    acc_free(dual_array.dev_ptr);
-    dual_array.dev_ptr = nullptr;
-  }
-#endif // _OPENACC
+  /* update memory tracker and descriptor table */
+  unregister_descriptor(it->second.slot);
+  remove_from_memory_tracker(memory_tracker, total_memory, label_memory,
+                             (void *)&dual_array);
+  release_transfer_state((void *)&dual_array);
+  record_memory(0, 1);
 
-  return;
+  return device;
 }
 
 } // namespace MiMMO
@@ -0,0 +1,130 @@
+/**
+ * @file bit_arrays.hpp
+ *
+ * @brief Declaration of accessors for bit-packed arrays.
+ *
+ * Functions for reading and writing single bits of word-packed arrays,
+ * callable from host code and from OpenACC compute regions.
+ * Used with the words of a DualBitArray, e.g. through
+ * MIMMO_GET_PTR(bit_array.words).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Marks the following function as callable from OpenACC compute
+ * regions.
+ */
+#ifdef _OPENACC
+#define MIMMO_ROUTINE _Pragma("acc routine seq")
+#else
+#define MIMMO_ROUTINE
+#endif // _OPENACC
+
+namespace MiMMO {
+
+/**
+ * @brief Number of bits stored in each word of a bit-packed array.
+ */
+constexpr size_t bits_per_word = 64;
+
+/**
+ * @brief Returns the number of words storing a number of bits.
+ *
+ * @param num_bits Number of bits.
+ *
+ * @return         Number of words.
+ */
+inline size_t num_bit_words(const size_t num_bits) {
+  return (num_bits + bits_per_word - 1) / bits_per_word;
+}
+
+/**
+ * @brief Returns a bit of a bit-packed array.
+ *
+ * @param words Words of the array.
+ * @param index Index of the bit.
+ *
+ * @return      Value of the bit.
+ */
+MIMMO_ROUTINE
+inline bool get_bit(const uint64_t *const words, const size_t index) {
+  return (words[index / bits_per_word] >> (index % bits_per_word)) & 1;
+}
+
+/**
+ * @brief Sets a bit of a bit-packed array.
+ *
+ * @param words Words of the array.
+ * @param index Index of the bit.
+ * @param value Value of the bit.
+ *
+ * @note Not safe if other threads write bits of the same word at the same
+ *       time; use set_bit_atomic() in that case.
+ */
+MIMMO_ROUTINE
+inline void set_bit(uint64_t *const words, const size_t index,
+                    const bool value) {
+  const uint64_t mask = uint64_t(1) << (index % bits_per_word);
+  uint64_t &word = words[index / bits_per_word];
+  word = value ? (word | mask) : (word & ~mask);
+  return;
+}
+
+/**
+ * @brief Sets a bit of a bit-packed array atomically.
+ *
+ * @details
+ * Other threads may write other bits of the same word at the same time.
+ *
+ * @param words Words of the array.
+ * @param index Index of the bit.
+ * @param value Value of the bit.
+ */
+MIMMO_ROUTINE
+inline void set_bit_atomic(uint64_t *const words, const size_t index,
+                           const bool value) {
+  const uint64_t mask = uint64_t(1) << (index % bits_per_word);
+  uint64_t *const word = words + index / bits_per_word;
+
+#ifdef _OPENACC
+  if (value) {
+#pragma acc atomic update
+    *word |= mask;
+  } else {
+#pragma acc atomic update
+    *word &= ~mask;
+  }
+#else
+  if (value)
+    __atomic_fetch_or(word, mask, __ATOMIC_RELAXED);
+  else
+    __atomic_fetch_and(word, ~mask, __ATOMIC_RELAXED);
+#endif // _OPENACC
+
+  return;
+}
+
+/**
+ * @brief Counts the bits set in a word.
+ *
+ * @details
+ * Bits are summed in parallel within the word, which needs no special
+ * instruction and vectorizes on host.
+ *
+ * @param word Word to be counted.
+ *
+ * @return     Number of bits set.
+ */
+MIMMO_ROUTINE
+inline size_t count_word_bits(uint64_t word) {
+  word = word - ((word >> 1) & 0x5555555555555555ULL);
+  word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+  word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<size_t>((word * 0x0101010101010101ULL) >> 56);
+}
+
+} // namespace MiMMO
@@ -0,0 +1,125 @@
+/**
+ * @file bit_arrays.inl
+ *
+ * @brief Definition of methods for managing bit-packed dual arrays.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - alloc_bit_array()
+ * - update_bit_array_host_to_device()
+ * - update_bit_array_device_to_host()
+ * - free_bit_array()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Allocates a bit-packed dual array, with all bits cleared.
+ *
+ * @details
+ * Bits are cleared on host and, if the array is on device, on device
+ * as well.
+ *
+ * @param bit_array Bit-packed dual array to be allocated.
+ * @param label     Label that should be used to track the array in
+ *                  memory.
+ * @param size      Number of bits in the array.
+ * @param on_device Whether the array should be allocated on device as
+ *                  well (ignored without device memory).
+ */
+inline void DualMemoryManager::alloc_bit_array(DualBitArray &bit_array,
+                                               const std::string label,
+                                               const size_t size,
+                                               const bool on_device) {
+
+  alloc_array(bit_array.words, label, num_bit_words(size), on_device);
+  bit_array.size = size;
+
+  /* clear bits on both sides */
+  std::memset(bit_array.words.host_ptr, 0, bit_array.words.size_bytes);
+
+  if (bit_array.words.dev_ptr != nullptr)
+    update_array_host_to_device(bit_array.words, 0, bit_array.words.size);
+
+  return;
+}
+
+/**
+ * @brief Copies a range of bits of a bit-packed dual array from host to
+ * device.
+ *
+ * @details
+ * Whole words are copied, so bits sharing a word with the range are
+ * copied as well.
+ *
+ * @param bit_array Bit-packed dual array to synchronize.
+ * @param first_bit Index of first bit to be copied.
+ * @param num_bits  Number of bits to be copied.
+ * @param location  Call site, recorded in profiling mode.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+inline void DualMemoryManager::update_bit_array_host_to_device(
+    DualBitArray &bit_array, const size_t first_bit, const size_t num_bits,
+    const SourceLocation location) {
+
+  if (num_bits == 0)
+    return;
+
+  const size_t first_word = first_bit / bits_per_word;
+  const size_t end_word = num_bit_words(first_bit + num_bits);
+
+  update_array_host_to_device(bit_array.words, first_word,
+                              end_word - first_word, location);
+
+  return;
+}
+
+/**
+ * @brief Copies a range of bits of a bit-packed dual array from device to
+ * host.
+ *
+ * @details
+ * Whole words are copied, so bits sharing a word with the range are
+ * copied as well.
+ *
+ * @param bit_array Bit-packed dual array to synchronize.
+ * @param first_bit Index of first bit to be copied.
+ * @param num_bits  Number of bits to be copied.
+ * @param location  Call site, recorded in profiling mode.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+inline void DualMemoryManager::update_bit_array_device_to_host(
+    DualBitArray &bit_array, const size_t first_bit, const size_t num_bits,
+    const SourceLocation location) {
+
+  if (num_bits == 0)
+    return;
+
+  const size_t first_word = first_bit / bits_per_word;
+  const size_t end_word = num_bit_words(first_bit + num_bits);
+
+  update_array_device_to_host(bit_array.words, first_word,
+                              end_word - first_word, location);
+
+  return;
+}
+
+/**
+ * @brief Frees memory allocated for a bit-packed dual array.
+ *
+ * @param bit_array Bit-packed dual array to be freed.
+ *
+ * @note If the array is not tracked, the program aborts.
+ */
+inline void DualMemoryManager::free_bit_array(DualBitArray &bit_array) {
+  free_array(bit_array.words);
+  bit_array.size = 0;
+  return;
+}
+
+} // namespace MiMMO
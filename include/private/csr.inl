@@ -0,0 +1,176 @@
+/**
+ * @file csr.inl
+ *
+ * @brief Definition of template methods for managing sparse matrices in
+ * CSR format.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - alloc_csr()
+ * - update_csr_host_to_device()
+ * - update_csr_device_to_host()
+ * - update_csr_values_host_to_device()
+ * - update_csr_values_device_to_host()
+ * - free_csr()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Allocates a sparse matrix in CSR format.
+ *
+ * @details
+ * Components are laid out in one allocation as values, column indices
+ * and row offsets, each aligned for its type.
+ *
+ * @tparam T        Type of matrix values.
+ * @tparam Index    Type of column indices and row offsets.
+ *
+ * @param csr       Sparse matrix to be allocated.
+ * @param label     Label that should be used to track the matrix in
+ *                  memory.
+ * @param num_rows  Number of rows.
+ * @param num_cols  Number of columns.
+ * @param nnz       Number of non-zero values.
+ * @param on_device Whether the matrix should be allocated on device as
+ *                  well (ignored without device memory).
+ *
+ * @note If the index type cannot represent the number of columns or
+ *       non-zero values, the program aborts.
+ */
+template <typename T, typename Index>
+void DualMemoryManager::alloc_csr(DualCSR<T, Index> &csr,
+                                  const std::string label,
+                                  const size_t num_rows, const size_t num_cols,
+                                  const size_t nnz, const bool on_device) {
+
+  const size_t max_index =
+      static_cast<size_t>(std::numeric_limits<Index>::max());
+
+  if (nnz > max_index || num_cols > max_index)
+    abort_mimmo("Index type of sparse matrix '" + label +
+                "' is too narrow for its size.");
+
+  /* lay out components, each aligned for its type */
+  const size_t col_idx_offset =
+      (nnz * sizeof(T) + alignof(Index) - 1) / alignof(Index) * alignof(Index);
+  const size_t row_ptr_offset = col_idx_offset + nnz * sizeof(Index);
+  const size_t size_bytes = row_ptr_offset + (num_rows + 1) * sizeof(Index);
+
+  alloc_array(csr.storage, label, size_bytes, on_device);
+
+  set_storage_view(csr.values, csr.storage, 0, nnz);
+  set_storage_view(csr.col_idx, csr.storage, col_idx_offset, nnz);
+  set_storage_view(csr.row_ptr, csr.storage, row_ptr_offset, num_rows + 1);
+  csr.num_rows = num_rows;
+  csr.num_cols = num_cols;
+
+  return;
+}
+
+/**
+ * @brief Copies a sparse matrix (values and sparsity pattern) from host
+ * to device, in one transfer.
+ *
+ * @tparam T       Type of matrix values.
+ * @tparam Index   Type of column indices and row offsets.
+ *
+ * @param csr      Sparse matrix to synchronize.
+ * @param location Call site, recorded in profiling mode.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T, typename Index>
+void DualMemoryManager::update_csr_host_to_device(
+    DualCSR<T, Index> &csr, const SourceLocation location) {
+  update_array_host_to_device(csr.storage, 0, csr.storage.size, location);
+  return;
+}
+
+/**
+ * @brief Copies a sparse matrix (values and sparsity pattern) from
+ * device to host, in one transfer.
+ *
+ * @tparam T       Type of matrix values.
+ * @tparam Index   Type of column indices and row offsets.
+ *
+ * @param csr      Sparse matrix to synchronize.
+ * @param location Call site, recorded in profiling mode.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T, typename Index>
+void DualMemoryManager::update_csr_device_to_host(
+    DualCSR<T, Index> &csr, const SourceLocation location) {
+  update_array_device_to_host(csr.storage, 0, csr.storage.size, location);
+  return;
+}
+
+/**
+ * @brief Copies the values of a sparse matrix from host to device,
+ * keeping the sparsity pattern.
+ *
+ * @tparam T       Type of matrix values.
+ * @tparam Index   Type of column indices and row offsets.
+ *
+ * @param csr      Sparse matrix to synchronize.
+ * @param location Call site, recorded in profiling mode.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T, typename Index>
+void DualMemoryManager::update_csr_values_host_to_device(
+    DualCSR<T, Index> &csr, const SourceLocation location) {
+  update_array_host_to_device(csr.storage, 0, csr.values.size_bytes,
+                              location);
+  return;
+}
+
+/**
+ * @brief Copies the values of a sparse matrix from device to host,
+ * keeping the sparsity pattern.
+ *
+ * @tparam T       Type of matrix values.
+ * @tparam Index   Type of column indices and row offsets.
+ *
+ * @param csr      Sparse matrix to synchronize.
+ * @param location Call site, recorded in profiling mode.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T, typename Index>
+void DualMemoryManager::update_csr_values_device_to_host(
+    DualCSR<T, Index> &csr, const SourceLocation location) {
+  update_array_device_to_host(csr.storage, 0, csr.values.size_bytes,
+                              location);
+  return;
+}
+
+/**
+ * @brief Frees memory allocated for a sparse matrix.
+ *
+ * @tparam T     Type of matrix values.
+ * @tparam Index Type of column indices and row offsets.
+ *
+ * @param csr    Sparse matrix to be freed.
+ *
+ * @note If the matrix is not tracked, the program aborts.
+ */
+template <typename T, typename Index>
+void DualMemoryManager::free_csr(DualCSR<T, Index> &csr) {
+
+  free_array(csr.storage);
+
+  csr.values = {nullptr, nullptr, 0, 0};
+  csr.col_idx = {nullptr, nullptr, 0, 0};
+  csr.row_ptr = {nullptr, nullptr, 0, 0};
+  csr.num_rows = 0;
+  csr.num_cols = 0;
+
+  return;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,51 @@
+/**
+ * @file deferred_frees.hpp
+ *
+ * @brief Declaration of the structures of deferred frees.
+ *
+ * Freeing device memory may synchronize the device and stall the host
+ * while work is in flight. Deferred frees put the buffers of a dual
+ * object on a pending list of the queue that last uses them: buffers are
+ * released, or kept in a reuse cache, only once the queue is idle, and
+ * device buffers can be reused right away by allocations ordered on the
+ * same queue.
+ *
+ * @see deferred_frees.inl for the corresponding DualMemoryManager methods
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace MiMMO {
+
+/**
+ * @brief Stores a buffer whose release is deferred.
+ */
+struct DeferredBlock {
+  void *ptr;         /*!< pointer to the buffer */
+  size_t size_bytes; /*!< size in bytes of the buffer */
+  bool on_device;    /*!< whether the buffer is device (or host) memory */
+  int device;        /*!< device of the buffer, and of its queue */
+  int queue;         /*!< queue after which the buffer may be released */
+};
+
+/**
+ * @brief Stores statistics of deferred frees.
+ */
+struct DeferredFreeStats {
+  size_t pending_blocks;     /*!< number of buffers waiting for their
+                                  queue */
+  size_t pending_host_bytes; /*!< host memory waiting for its queue */
+  size_t pending_dev_bytes;  /*!< device memory waiting for its queue */
+  size_t cached_blocks;      /*!< number of buffers in the reuse cache */
+  size_t cached_host_bytes;  /*!< host memory in the reuse cache */
+  size_t cached_dev_bytes;   /*!< device memory in the reuse cache */
+  size_t num_deferred;       /*!< number of buffers whose free was
+                                  deferred */
+  size_t num_reused;         /*!< number of buffers reused by
+                                  allocations */
+  size_t num_released;       /*!< number of buffers actually released */
+};
+
+} // namespace MiMMO
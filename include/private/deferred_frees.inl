@@ -0,0 +1,331 @@
+/**
+ * @file deferred_frees.inl
+ *
+ * @brief Definition of methods for deferred frees and queue-ordered
+ * allocations.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - defer_free()
+ * - take_deferred_block()
+ * - release_deferred_block()
+ * - alloc_array_async()
+ * - free_array_async()
+ * - destroy_scalar_async()
+ * - collect_deferred_frees()
+ * - flush_deferred_frees()
+ * - set_reuse_cache_limit()
+ * - return_deferred_free_stats()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Puts a buffer on the pending list of a queue.
+ *
+ * @param ptr        Pointer to the buffer (nullptr is ignored).
+ * @param size_bytes Size in bytes of the buffer.
+ * @param on_device  Whether the buffer is device (or host) memory.
+ * @param device     Device of the buffer and of the queue.
+ * @param queue      Queue after which the buffer may be released.
+ */
+inline void DualMemoryManager::defer_free(void *const ptr,
+                                          const size_t size_bytes,
+                                          const bool on_device,
+                                          const int device, const int queue) {
+  if (ptr == nullptr)
+    return;
+
+  /* pending host memory is no longer used by the manager */
+  if (!on_device)
+    host_buffers.erase(ptr);
+
+  pending_frees.push_back({ptr, size_bytes, on_device, device, queue});
+  deferred_stats.num_deferred++;
+
+  return;
+}
+
+/**
+ * @brief Takes a buffer of a given size out of the reuse cache, or out
+ * of the pending list of the same queue for device memory.
+ *
+ * @details
+ * Buffers of the current device are considered, the least recently
+ * released first.
+ *
+ * @param size_bytes Size in bytes of the buffer.
+ * @param on_device  Whether device (or host) memory is needed.
+ * @param queue      Queue on which the buffer will be used.
+ *
+ * @return           Pointer to the buffer (nullptr if none is found).
+ */
+inline void *DualMemoryManager::take_deferred_block(const size_t size_bytes,
+                                                    const bool on_device,
+                                                    const int queue) {
+
+  const int device = backend->get_device();
+
+  const auto matches = [&](const DeferredBlock &block) {
+    return block.size_bytes == size_bytes && block.on_device == on_device &&
+           (!on_device || block.device == device);
+  };
+
+  /* host writes are not ordered with the queue, so only device memory
+   * can be taken before the queue is idle */
+  std::vector<DeferredBlock> *const lists[] = {&reuse_cache, &pending_frees};
+
+  for (std::vector<DeferredBlock> *const list : lists) {
+    for (auto it = list->begin(); it != list->end(); it++) {
+      if (!matches(*it) ||
+          (list == &pending_frees && (!on_device || it->queue != queue)))
+        continue;
+
+      void *const ptr = it->ptr;
+      list->erase(it);
+      deferred_stats.num_reused++;
+
+      if (!on_device)
+        host_buffers[ptr] = size_bytes;
+
+      return ptr;
+    }
+  }
+
+  return nullptr;
+}
+
+/**
+ * @brief Releases a buffer whose free was deferred.
+ *
+ * @param block Buffer to be released.
+ */
+inline void
+DualMemoryManager::release_deferred_block(const DeferredBlock &block) {
+
+  if (block.on_device)
+    device_free(block.ptr, block.device);
+  else
+    host_free(block.ptr);
+
+  deferred_stats.num_released++;
+
+  return;
+}
+
+/**
+ * @brief Allocates dual array memory in order with a queue.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be allocated.
+ * @param label      Label that should be used to track the array in
+ *                   memory.
+ * @param size       Number of elements in the array.
+ * @param queue      Queue on which the array will be used (on the
+ *                   current device).
+ * @param on_device  Whether the array should be allocated on device as
+ *                   well (ignored without device memory).
+ */
+template <typename T>
+void DualMemoryManager::alloc_array_async(DualArray<T> &dual_array,
+                                          const std::string label,
+                                          const size_t size,
+                                          const int queue,
+                                          const bool on_device) {
+
+  collect_deferred_frees();
+
+  const size_t size_bytes = size * sizeof(T);
+  const bool dev_alloc = on_device && backend->has_device();
+
+  /* reuse buffers of the same size, or allocate new ones */
+  dual_array.host_ptr = (T *)take_deferred_block(size_bytes, false, queue);
+
+  if (dual_array.host_ptr == nullptr)
+    dual_array.host_ptr = (T *)host_alloc(size, sizeof(T));
+
+  dual_array.dev_ptr =
+      dev_alloc ? (T *)take_deferred_block(size_bytes, true, queue) : nullptr;
+
+  if (dev_alloc && dual_array.dev_ptr == nullptr) {
+    check_low_memory(size_bytes);
+    dual_array.dev_ptr = (T *)backend->alloc(size_bytes);
+
+    if (!(dual_array.dev_ptr)) {
+      host_free(dual_array.host_ptr);
+      dual_array.host_ptr = nullptr;
+      abort_mimmo("Failed to allocate device memory.");
+    }
+  }
+
+  /* update number of elements and bytes */
+  dual_array.size = size;
+  dual_array.size_bytes = size_bytes;
+
+  track_array(dual_array, label, dev_alloc);
+
+  return;
+}
+
+/**
+ * @brief Frees memory of a dual array once a queue is idle.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be freed.
+ * @param queue      Queue of the last work using the array (on the
+ *                   device of the array).
+ */
+template <typename T>
+void DualMemoryManager::free_array_async(DualArray<T> &dual_array,
+                                         const int queue) {
+
+  const int device = untrack_array(dual_array);
+
+  defer_free(dual_array.host_ptr, dual_array.size_bytes, false, device,
+             queue);
+  dual_array.host_ptr = nullptr;
+
+  defer_free(dual_array.dev_ptr, dual_array.size_bytes, true, device, queue);
+  dual_array.dev_ptr = nullptr;
+
+  collect_deferred_frees();
+
+  return;
+}
+
+/**
+ * @brief Frees device memory of a dual scalar once a queue is idle.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar to be destroyed.
+ * @param queue       Queue of the last work using the scalar (on the
+ *                    device of the scalar).
+ */
+template <typename T>
+void DualMemoryManager::destroy_scalar_async(DualScalar<T> &dual_scalar,
+                                             const int queue) {
+
+  const int device = untrack_scalar(dual_scalar);
+
+  defer_free(dual_scalar.dev_ptr, sizeof(T), true, device, queue);
+  dual_scalar.dev_ptr = nullptr;
+
+  collect_deferred_frees();
+
+  return;
+}
+
+/**
+ * @brief Releases pending buffers whose queue is idle, without
+ * blocking.
+ */
+inline void DualMemoryManager::collect_deferred_frees() {
+
+  if (pending_frees.empty())
+    return;
+
+  /* test each queue once */
+  std::map<std::pair<int, int>, bool> idle;
+  std::vector<DeferredBlock> still_pending;
+
+  for (const DeferredBlock &block : pending_frees) {
+    const std::pair<int, int> key = {block.device, block.queue};
+
+    if (idle.find(key) == idle.end()) {
+      const DeviceScope scope(*backend, block.device);
+      idle[key] = backend->test(block.queue);
+    }
+
+    if (!idle[key])
+      still_pending.push_back(block);
+    else
+      reuse_cache.push_back(block);
+  }
+
+  pending_frees.swap(still_pending);
+
+  /* free what does not fit in the cache */
+  set_reuse_cache_limit(reuse_cache_limit);
+
+  return;
+}
+
+/**
+ * @brief Waits for the queues of all pending buffers, then frees them
+ * together with the reuse cache.
+ */
+inline void DualMemoryManager::flush_deferred_frees() {
+
+  for (const DeferredBlock &block : pending_frees) {
+    const DeviceScope scope(*backend, block.device);
+    backend->wait(block.queue);
+  }
+
+  for (const DeferredBlock &block : pending_frees)
+    release_deferred_block(block);
+  pending_frees.clear();
+
+  for (const DeferredBlock &block : reuse_cache)
+    release_deferred_block(block);
+  reuse_cache.clear();
+
+  return;
+}
+
+/**
+ * @brief Sets the maximum memory kept in the reuse cache.
+ *
+ * @param limit_bytes Maximum bytes of host and device memory kept for
+ *                    reuse.
+ */
+inline void DualMemoryManager::set_reuse_cache_limit(const size_t limit_bytes) {
+
+  reuse_cache_limit = limit_bytes;
+
+  size_t cached_bytes = 0;
+  for (const DeferredBlock &block : reuse_cache)
+    cached_bytes += block.size_bytes;
+
+  /* free the oldest buffers first */
+  size_t num_freed = 0;
+  while (cached_bytes > reuse_cache_limit) {
+    cached_bytes -= reuse_cache[num_freed].size_bytes;
+    release_deferred_block(reuse_cache[num_freed]);
+    num_freed++;
+  }
+
+  reuse_cache.erase(reuse_cache.begin(), reuse_cache.begin() + num_freed);
+
+  return;
+}
+
+/**
+ * @brief Returns statistics of deferred frees.
+ *
+ * @return Statistics of pending and cached buffers, with counters of
+ *         deferred, reused and released buffers.
+ */
+inline DeferredFreeStats DualMemoryManager::return_deferred_free_stats() {
+
+  DeferredFreeStats stats = deferred_stats;
+
+  stats.pending_blocks = pending_frees.size();
+  for (const DeferredBlock &block : pending_frees)
+    (block.on_device ? stats.pending_dev_bytes : stats.pending_host_bytes) +=
+        block.size_bytes;
+
+  stats.cached_blocks = reuse_cache.size();
+  for (const DeferredBlock &block : reuse_cache)
+    (block.on_device ? stats.cached_dev_bytes : stats.cached_host_bytes) +=
+        block.size_bytes;
+
+  return stats;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,65 @@
+/**
+ * @file delta_sync.hpp
+ *
+ * @brief Declaration of content hashing for delta synchronization.
+ *
+ * Internal utilities for detecting which blocks of a host buffer changed
+ * since the last upload: each block is hashed with XXH64, and only
+ * blocks whose hash differs from the stored one are transferred.
+ *
+ * @see delta_sync.cpp for implementations
+ * @see delta_sync.inl for the corresponding DualMemoryManager methods
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace MiMMO {
+
+/**
+ * @brief Default size in bytes of the blocks hashed by delta
+ * synchronization.
+ */
+constexpr size_t default_delta_block_bytes = size_t(1) << 16;
+
+/**
+ * @brief Stores statistics of delta synchronization of a dual array.
+ */
+struct DeltaSyncStats {
+  size_t num_syncs;         /*!< number of delta uploads */
+  size_t hashed_bytes;      /*!< bytes hashed on host */
+  size_t transferred_bytes; /*!< bytes sent to device for changed blocks */
+};
+
+/**
+ * @brief Stores the delta synchronization state of a dual array.
+ */
+struct DeltaSyncState {
+  size_t block_bytes;           /*!< size in bytes of hashed blocks */
+  std::vector<uint64_t> hashes; /*!< hash of each block as last synced */
+  std::vector<unsigned char>
+      known;            /*!< whether the hash of each block matches device
+                             memory */
+  DeltaSyncStats stats; /*!< statistics of delta uploads */
+};
+
+/**
+ * @brief Computes the XXH64 hash of a buffer.
+ *
+ * @details
+ * Four independent 64-bit lanes are processed per 32-byte stripe, which
+ * keeps hashing close to memory bandwidth on a single thread.
+ *
+ * @param data       Buffer to be hashed.
+ * @param size_bytes Size in bytes of the buffer.
+ * @param seed       Seed of the hash.
+ *
+ * @return           Hash of the buffer.
+ */
+uint64_t xxh64(const void *const data, const size_t size_bytes,
+               const uint64_t seed = 0);
+
+} // namespace MiMMO
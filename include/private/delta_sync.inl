@@ -0,0 +1,182 @@
+/**
+ * @file delta_sync.inl
+ *
+ * @brief Definition of template methods for delta synchronization of dual
+ * arrays.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - update_array_delta()
+ * - enable_delta_sync()
+ * - disable_delta_sync()
+ * - return_delta_sync_stats()
+ *
+ * @see api.hpp for the corresponding declarations
+ * @see delta_sync.cpp for the hash function
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Copies the blocks of a range of a dual array that changed since
+ * the last upload from host to device.
+ *
+ * @details
+ * Blocks fully inside the range are hashed on host, one block per chunk
+ * of the thread pool, and compared with the stored hashes. Blocks only
+ * partly inside the range are copied without hashing, and their stored
+ * hash is forgotten. Changed blocks are then moved as ranges planned by
+ * the transfer planner, which copies exactly these blocks; statistics
+ * count the bytes actually sent to device.
+ *
+ * @tparam T           Type of elements in the array.
+ *
+ * @param dual_array   Dual array to synchronize.
+ * @param offset       Index of first element to be copied.
+ * @param num_elements Number of elements to be copied.
+ * @param state        Delta synchronization state of the array.
+ */
+template <typename T>
+void DualMemoryManager::update_array_delta(DualArray<T> &dual_array,
+                                           const size_t offset,
+                                           const size_t num_elements,
+                                           DeltaSyncState &state) {
+
+  if (num_elements == 0)
+    return;
+
+  const size_t block = state.block_bytes / sizeof(T);
+  const size_t end = offset + num_elements;
+  const size_t first_block = offset / block;
+  const size_t num_blocks = (end + block - 1) / block - first_block;
+
+  /* hash blocks in parallel and flag the changed ones */
+  std::vector<unsigned char> changed(num_blocks);
+  std::vector<size_t> hashed(num_blocks);
+
+  parallel_for_chunks(num_blocks, [&](const size_t b) {
+    const size_t index = first_block + b;
+    const size_t block_begin = index * block;
+    const size_t block_end = std::min(block_begin + block, dual_array.size);
+
+    if (block_begin < offset || block_end > end) {
+      changed[b] = 1;
+      hashed[b] = 0;
+      state.known[index] = 0;
+      return;
+    }
+
+    const uint64_t hash = xxh64(dual_array.host_ptr + block_begin,
+                                (block_end - block_begin) * sizeof(T));
+    changed[b] = !state.known[index] || state.hashes[index] != hash;
+    hashed[b] = (block_end - block_begin) * sizeof(T);
+    state.hashes[index] = hash;
+    state.known[index] = 1;
+  });
+
+  /* merge consecutive changed blocks into ranges */
+  std::vector<TransferRange> ranges;
+
+  for (size_t b = 0; b < num_blocks; b++) {
+    state.stats.hashed_bytes += hashed[b];
+
+    if (!changed[b])
+      continue;
+
+    const size_t begin = std::max((first_block + b) * block, offset);
+    const size_t count =
+        std::min((first_block + b + 1) * block, end) - begin;
+
+    if (!ranges.empty() &&
+        ranges.back().offset + ranges.back().num_elements == begin)
+      ranges.back().num_elements += count;
+    else
+      ranges.push_back({begin, count});
+  }
+
+  state.stats.num_syncs++;
+
+  if (!ranges.empty())
+    state.stats.transferred_bytes +=
+        update_array_ranges(dual_array, ranges, true);
+
+  return;
+}
+
+/**
+ * @brief Enables delta synchronization of a dual array.
+ *
+ * @tparam T          Type of elements in the array.
+ *
+ * @param dual_array  Dual array whose uploads should be synchronized by
+ *                    delta.
+ * @param block_bytes Size in bytes of hashed blocks (rounded down to a
+ *                    whole number of elements, at least one).
+ *
+ * @note If the array is not tracked or the block size is 0, the program
+ *       aborts.
+ */
+template <typename T>
+void DualMemoryManager::enable_delta_sync(DualArray<T> &dual_array,
+                                          const size_t block_bytes) {
+
+  if (memory_tracker.find((void *)&dual_array) == memory_tracker.end())
+    abort_mimmo("Dual array was not found by memory manager.");
+
+  if (block_bytes == 0)
+    abort_mimmo("Block size of delta synchronization must be positive.");
+
+  const size_t block = std::max(block_bytes / sizeof(T), size_t(1));
+  const size_t num_blocks = (dual_array.size + block - 1) / block;
+
+  /* no block is known until it is uploaded */
+  DeltaSyncState &state = delta_states[(void *)&dual_array];
+  state.block_bytes = block * sizeof(T);
+  state.hashes.assign(num_blocks, 0);
+  state.known.assign(num_blocks, 0);
+  state.stats = {0, 0, 0};
+
+  return;
+}
+
+/**
+ * @brief Disables delta synchronization of a dual array.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array whose uploads should copy whole ranges
+ *                   again.
+ *
+ * @note If delta synchronization is not enabled, this function does
+ *       nothing.
+ */
+template <typename T>
+void DualMemoryManager::disable_delta_sync(DualArray<T> &dual_array) {
+  delta_states.erase((void *)&dual_array);
+  return;
+}
+
+/**
+ * @brief Returns statistics of delta synchronization of a dual array.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array synchronized by delta.
+ *
+ * @return           Statistics since delta synchronization was enabled.
+ *
+ * @note If delta synchronization is not enabled, the program aborts.
+ */
+template <typename T>
+DeltaSyncStats
+DualMemoryManager::return_delta_sync_stats(const DualArray<T> &dual_array) {
+
+  const auto it = delta_states.find((void *)&dual_array);
+  if (it == delta_states.end())
+    abort_mimmo("Delta synchronization is not enabled for dual array.");
+
+  return it->second.stats;
+}
+
+} // namespace MiMMO
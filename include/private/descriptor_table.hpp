@@ -0,0 +1,53 @@
+/**
+ * @file descriptor_table.hpp
+ *
+ * @brief Declaration of the descriptor table data structures.
+ *
+ * Internal data structures for the device-resident table describing all
+ * tracked dual arrays and scalars.
+ * Used by DualMemoryManager so that compute regions can reach tracked
+ * objects without copying their structs to device.
+ *
+ * @see descriptor_table.inl for the corresponding DualMemoryManager methods
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace MiMMO {
+
+/**
+ * @brief Describes a tracked dual array or scalar inside compute regions.
+ *
+ * @details
+ * The pointer is the device pointer if the main code is compiled with
+ * OpenACC support, and the host pointer otherwise (like MIMMO_GET_PTR()).
+ */
+struct Descriptor {
+  void *ptr;   /*!< pointer to data used inside compute regions */
+  size_t size; /*!< number of elements */
+};
+
+/**
+ * @brief Stores descriptor table data.
+ *
+ * @details
+ * The table is kept on host and mirrored on device. Slots of freed
+ * objects are reused, and the device copy is refreshed (with a single
+ * transfer) only when an allocation changed since the last refresh.
+ */
+struct DescriptorTable {
+  std::vector<Descriptor> host_table; /*!< host copy of the table */
+  Descriptor *dev_table;              /*!< device copy of the table */
+  size_t dev_capacity;                /*!< number of slots of the device
+                                           copy */
+  int dev_device;                     /*!< device holding the device
+                                           copy */
+  std::vector<size_t> free_slots;     /*!< slots that can be reused */
+  bool dirty;                         /*!< whether the device copy is out
+                                           of date */
+};
+
+} // namespace MiMMO
@@ -0,0 +1,184 @@
+/**
+ * @file descriptor_table.inl
+ *
+ * @brief Definition of methods for managing the descriptor table.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - register_descriptor()
+ * - update_descriptor()
+ * - unregister_descriptor()
+ * - descriptor_table()
+ * - descriptor_slot()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Assigns a descriptor table slot to a tracked object.
+ *
+ * @param object   Pointer to the tracked dual object.
+ * @param host_ptr Host pointer of the object.
+ * @param dev_ptr  Device pointer of the object.
+ * @param size     Number of elements of the object.
+ */
+inline void DualMemoryManager::register_descriptor(void *const object,
+                                                   void *const host_ptr,
+                                                   void *const dev_ptr,
+                                                   const size_t size) {
+
+  /* reuse a free slot, if any */
+  size_t slot = descriptors.host_table.size();
+
+  if (descriptors.free_slots.empty()) {
+    descriptors.host_table.push_back({nullptr, 0});
+  } else {
+    slot = descriptors.free_slots.back();
+    descriptors.free_slots.pop_back();
+  }
+
+  /* fill descriptor */
+  memory_tracker[object].slot = slot;
+  descriptors.host_table[slot].size = size;
+  update_descriptor(object, host_ptr, dev_ptr);
+
+  return;
+}
+
+/**
+ * @brief Updates the pointer stored in the descriptor of an object.
+ *
+ * @param object   Pointer to the tracked dual object.
+ * @param host_ptr Host pointer of the object.
+ * @param dev_ptr  Device pointer of the object.
+ */
+inline void DualMemoryManager::update_descriptor(void *const object,
+                                                 void *const host_ptr,
+                                                 void *const dev_ptr) {
+
+  const size_t slot = memory_tracker[object].slot;
+
+  descriptors.host_table[slot].ptr =
+      backend->has_device() ? dev_ptr : host_ptr;
+
+  descriptors.dirty = true;
+
+  return;
+}
+
+/**
+ * @brief Releases the descriptor table slot of an object.
+ *
+ * @param slot Slot to be released.
+ */
+inline void DualMemoryManager::unregister_descriptor(const size_t slot) {
+
+  descriptors.host_table[slot] = {nullptr, 0};
+  descriptors.free_slots.push_back(slot);
+  descriptors.dirty = true;
+
+  return;
+}
+
+/**
+ * @brief Returns the descriptor table to be used in compute regions.
+ *
+ * @return Pointer to the table (on the current device if device memory
+ *         exists).
+ */
+inline const Descriptor *DualMemoryManager::descriptor_table() {
+
+  /* without device memory, compute regions use the host table */
+  if (!backend->has_device()) {
+    descriptors.dirty = false;
+    return descriptors.host_table.data();
+  }
+
+  /* device copy follows the current device */
+  const int device = backend->get_device();
+
+  if (descriptors.dev_table != nullptr && descriptors.dev_device != device) {
+    device_free(descriptors.dev_table, descriptors.dev_device);
+    descriptors.dev_table = nullptr;
+    descriptors.dev_capacity = 0;
+    descriptors.dirty = true;
+  }
+
+  if (descriptors.dirty) {
+    const size_t num_slots = descriptors.host_table.size();
+
+    /* grow device copy if needed */
+    if (num_slots > descriptors.dev_capacity) {
+      device_free(descriptors.dev_table);
+
+      descriptors.dev_capacity =
+          std::max(num_slots, 2 * descriptors.dev_capacity);
+      check_low_memory(descriptors.dev_capacity * sizeof(Descriptor));
+      descriptors.dev_table = (Descriptor *)backend->alloc(
+          descriptors.dev_capacity * sizeof(Descriptor));
+
+      if (!(descriptors.dev_table))
+        abort_mimmo("Failed to allocate device descriptor table.");
+
+      descriptors.dev_device = device;
+    }
+
+    /* refresh device copy with a single transfer */
+    if (num_slots > 0)
+      copy_to_device(descriptors.dev_table, descriptors.host_table.data(),
+                     num_slots * sizeof(Descriptor));
+
+    descriptors.dirty = false;
+  }
+
+  return descriptors.dev_table;
+}
+
+/**
+ * @brief Returns the descriptor table slot of a dual array.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Tracked dual array.
+ *
+ * @return           Slot of the array in the descriptor table.
+ *
+ * @note If the array is not tracked, the program aborts.
+ */
+template <typename T>
+size_t DualMemoryManager::descriptor_slot(const DualArray<T> &dual_array) {
+
+  const auto it = memory_tracker.find((void *)&dual_array);
+
+  if (it == memory_tracker.end())
+    abort_mimmo("Dual array was not found by memory manager.");
+
+  return it->second.slot;
+}
+
+/**
+ * @brief Returns the descriptor table slot of a dual scalar.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Tracked dual scalar.
+ *
+ * @return            Slot of the scalar in the descriptor table.
+ *
+ * @note If the scalar is not tracked, the program aborts.
+ */
+template <typename T>
+size_t DualMemoryManager::descriptor_slot(const DualScalar<T> &dual_scalar) {
+
+  const auto it = memory_tracker.find((void *)&dual_scalar);
+
+  if (it == memory_tracker.end())
+    abort_mimmo("Dual scalar was not found by memory manager.");
+
+  return it->second.slot;
+}
+
+} // namespace MiMMO
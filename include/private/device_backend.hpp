@@ -0,0 +1,587 @@
+/**
+ * @file device_backend.hpp
+ *
+ * @brief Declaration of device backends.
+ *
+ * Device backends perform all device memory operations of
+ * DualMemoryManager (allocations, transfers and asynchronous queues).
+ * Three backends are available:
+ * - NoDeviceBackend, used without OpenACC, where no device memory exists
+ * - OpenACCDeviceBackend, used with OpenACC
+ * - EmulatedDeviceBackend, which emulates device memory with separate
+ *   host buffers and models transfer latency and bandwidth
+ *
+ * Backends may drive several devices: one of them is current, and all
+ * allocations, transfers and queues refer to it.
+ *
+ * The OpenACC backend is defined in this header, like all other OpenACC
+ * calls, so that it follows the compilation flags of the main code.
+ *
+ * @see device_backend.cpp for the other implementations
+ * @see device_backend.inl for the corresponding DualMemoryManager methods
+ */
+
+#pragma once
+
+#include "abort.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENACC
+#include <openacc.h>
+#endif // _OPENACC
+
+namespace MiMMO {
+
+/**
+ * @brief Interface of device memory operations.
+ *
+ * @details
+ * Asynchronous transfers are enqueued on integer queues: transfers on the
+ * same queue complete in order, and are only guaranteed to be complete
+ * after wait() or wait_all() (or test() returning true) on their queue.
+ * Host buffers involved in asynchronous transfers must not be modified or
+ * released until then.
+ */
+class DeviceBackend {
+public:
+  virtual ~DeviceBackend() = default;
+
+  /**
+   * @brief Returns the name of the backend.
+   *
+   * @return Name of the backend.
+   */
+  virtual const char *name() const = 0;
+
+  /**
+   * @brief Returns whether device memory exists (i.e. it is separate
+   * from host memory).
+   *
+   * @return Whether device memory exists.
+   */
+  virtual bool has_device() const = 0;
+
+  /**
+   * @brief Allocates device memory.
+   *
+   * @param size_bytes Number of bytes to be allocated.
+   *
+   * @return           Pointer to device memory (nullptr on failure).
+   */
+  virtual void *alloc(const size_t size_bytes) = 0;
+
+  /**
+   * @brief Frees device memory.
+   *
+   * @param dev_ptr Pointer to device memory.
+   */
+  virtual void free(void *const dev_ptr) = 0;
+
+  /**
+   * @brief Copies data from host to device.
+   *
+   * @param dev_ptr    Destination on device.
+   * @param host_ptr   Source on host.
+   * @param size_bytes Number of bytes to be copied.
+   */
+  virtual void memcpy_to_device(void *const dev_ptr,
+                                const void *const host_ptr,
+                                const size_t size_bytes) = 0;
+
+  /**
+   * @brief Copies data from device to host.
+   *
+   * @param host_ptr   Destination on host.
+   * @param dev_ptr    Source on device.
+   * @param size_bytes Number of bytes to be copied.
+   */
+  virtual void memcpy_from_device(void *const host_ptr,
+                                  const void *const dev_ptr,
+                                  const size_t size_bytes) = 0;
+
+  /**
+   * @brief Copies data between two device buffers.
+   *
+   * @param dst_ptr    Destination on device.
+   * @param src_ptr    Source on device.
+   * @param size_bytes Number of bytes to be copied.
+   */
+  virtual void memcpy_device(void *const dst_ptr, const void *const src_ptr,
+                             const size_t size_bytes) = 0;
+
+  /**
+   * @brief Enqueues a copy from host to device.
+   *
+   * @param dev_ptr    Destination on device.
+   * @param host_ptr   Source on host.
+   * @param size_bytes Number of bytes to be copied.
+   * @param queue      Queue on which the copy is enqueued.
+   */
+  virtual void memcpy_to_device_async(void *const dev_ptr,
+                                      const void *const host_ptr,
+                                      const size_t size_bytes,
+                                      const int queue) = 0;
+
+  /**
+   * @brief Enqueues a copy from device to host.
+   *
+   * @param host_ptr   Destination on host.
+   * @param dev_ptr    Source on device.
+   * @param size_bytes Number of bytes to be copied.
+   * @param queue      Queue on which the copy is enqueued.
+   */
+  virtual void memcpy_from_device_async(void *const host_ptr,
+                                        const void *const dev_ptr,
+                                        const size_t size_bytes,
+                                        const int queue) = 0;
+
+  /**
+   * @brief Waits for all operations enqueued on a queue.
+   *
+   * @param queue Queue to wait for.
+   */
+  virtual void wait(const int queue) = 0;
+
+  /**
+   * @brief Waits for all operations enqueued on any queue.
+   */
+  virtual void wait_all() = 0;
+
+  /**
+   * @brief Checks whether all operations enqueued on a queue are
+   * complete, without blocking.
+   *
+   * @param queue Queue to be checked.
+   *
+   * @return      Whether the queue is idle.
+   */
+  virtual bool test(const int queue) = 0;
+
+  /**
+   * @brief Makes a queue wait for all operations enqueued on another
+   * queue so far.
+   *
+   * @details
+   * By default the host waits for the other queue, which orders the two
+   * queues at the cost of blocking.
+   *
+   * @param queue         Queue to wait for.
+   * @param waiting_queue Queue whose later operations must wait.
+   */
+  virtual void wait_async(const int queue, const int waiting_queue);
+
+  /**
+   * @brief Returns the number of devices driven by the backend.
+   *
+   * @return Number of devices (0 without device memory).
+   */
+  virtual int num_devices() const;
+
+  /**
+   * @brief Returns the current device.
+   *
+   * @return Index of the current device.
+   */
+  virtual int get_device() const;
+
+  /**
+   * @brief Makes a device current.
+   *
+   * @param device Index of the device.
+   *
+   * @note If the device does not exist, the program aborts.
+   */
+  virtual void set_device(const int device);
+
+  /**
+   * @brief Copies data between buffers on two (possibly different)
+   * devices.
+   *
+   * @details
+   * By default, data goes through a temporary host buffer. The current
+   * device is left unchanged.
+   *
+   * @param dst_ptr    Destination on device.
+   * @param dst_device Device of the destination.
+   * @param src_ptr    Source on device.
+   * @param src_device Device of the source.
+   * @param size_bytes Number of bytes to be copied.
+   */
+  virtual void memcpy_peer(void *const dst_ptr, const int dst_device,
+                           const void *const src_ptr, const int src_device,
+                           const size_t size_bytes);
+
+  /**
+   * @brief Returns free and total memory of the current device.
+   *
+   * @details
+   * By default, memory of the device is not known.
+   *
+   * @param free_bytes  Free device memory, in bytes.
+   * @param total_bytes Total device memory, in bytes.
+   *
+   * @return            Whether device memory is known (otherwise both
+   *                    values are left unchanged).
+   */
+  virtual bool memory_info(size_t &free_bytes, size_t &total_bytes) const;
+};
+
+/**
+ * @brief Makes a device current for the lifetime of the object, then
+ * restores the previous one.
+ */
+class DeviceScope {
+public:
+  /**
+   * @brief Class constructor.
+   *
+   * @param backend Backend whose current device is switched.
+   * @param device  Device to be made current.
+   */
+  DeviceScope(DeviceBackend &backend, const int device)
+      : backend(backend), previous(backend.get_device()) {
+    if (device != previous)
+      backend.set_device(device);
+  }
+
+  /**
+   * @brief Class destructor.
+   */
+  ~DeviceScope() {
+    if (backend.get_device() != previous)
+      backend.set_device(previous);
+  }
+
+  DeviceScope(const DeviceScope &) = delete;
+  DeviceScope &operator=(const DeviceScope &) = delete;
+
+private:
+  DeviceBackend &backend; /*!< backend whose device is switched */
+  const int previous;     /*!< device current before the scope */
+};
+
+/**
+ * @brief Backend without device memory.
+ *
+ * @details
+ * Allocations return nullptr and transfers do nothing, so that dual
+ * objects only live on host.
+ */
+class NoDeviceBackend : public DeviceBackend {
+public:
+  const char *name() const override;
+  bool has_device() const override;
+  void *alloc(const size_t size_bytes) override;
+  void free(void *const dev_ptr) override;
+  void memcpy_to_device(void *const dev_ptr, const void *const host_ptr,
+                        const size_t size_bytes) override;
+  void memcpy_from_device(void *const host_ptr, const void *const dev_ptr,
+                          const size_t size_bytes) override;
+  void memcpy_device(void *const dst_ptr, const void *const src_ptr,
+                     const size_t size_bytes) override;
+  void memcpy_to_device_async(void *const dev_ptr, const void *const host_ptr,
+                              const size_t size_bytes,
+                              const int queue) override;
+  void memcpy_from_device_async(void *const host_ptr,
+                                const void *const dev_ptr,
+                                const size_t size_bytes,
+                                const int queue) override;
+  void wait(const int queue) override;
+  void wait_all() override;
+  bool test(const int queue) override;
+};
+
+/**
+ * @brief Stores the performance model of an emulated device.
+ */
+struct EmulatedDeviceConfig {
+  double latency_us;        /*!< fixed cost of each host-device transfer,
+                                 in microseconds */
+  double bandwidth_gbs;     /*!< bandwidth of host-device transfers, in
+                                 GB/s (0 for unlimited) */
+  double dev_bandwidth_gbs; /*!< bandwidth of device-to-device copies, in
+                                 GB/s (0 for unlimited) */
+  size_t capacity_bytes;    /*!< device memory capacity in bytes (0 for
+                                 unlimited) */
+  bool inject_delays;       /*!< whether transfers actually take their
+                                 modeled time (otherwise it is only
+                                 accounted) */
+};
+
+/**
+ * @brief Stores transfer statistics of an emulated device.
+ */
+struct EmulatedDeviceStats {
+  size_t num_to_device;        /*!< number of host-to-device transfers */
+  size_t num_from_device;      /*!< number of device-to-host transfers */
+  size_t num_device_copies;    /*!< number of device-to-device copies */
+  size_t bytes_to_device;      /*!< bytes moved from host to device */
+  size_t bytes_from_device;    /*!< bytes moved from device to host */
+  size_t bytes_device_copy;    /*!< bytes copied on device */
+  double modeled_time_s;       /*!< total modeled transfer time, in
+                                    seconds */
+  size_t allocated_bytes;      /*!< device memory currently allocated */
+  size_t peak_allocated_bytes; /*!< maximum device memory ever
+                                    allocated */
+};
+
+/**
+ * @brief Backend emulating a device with separate host buffers.
+ *
+ * @details
+ * Device memory is allocated on host but kept separate from host memory,
+ * so that missing or wrong transfers show up as wrong results even
+ * without a GPU. New allocations are filled with a garbage pattern.
+ *
+ * Each transfer is given a modeled time (latency plus size over
+ * bandwidth). Transfers in the same direction share one link, while the
+ * two directions can overlap. If delays are injected, synchronous
+ * transfers block for their modeled time; asynchronous transfers are
+ * performed when their queue is waited for, not before the time at which
+ * they would complete.
+ *
+ * Several identical devices can be emulated: each has its own
+ * allocations, links, queues and statistics, and transfers abort if they
+ * involve memory of a device other than the current one. Peer copies
+ * between devices use the host-device bandwidth.
+ *
+ * @note Intended for builds without OpenACC, where compute regions run
+ *       on host and can access emulated device memory through
+ *       MIMMO_GET_PTR().
+ */
+class EmulatedDeviceBackend : public DeviceBackend {
+public:
+  /**
+   * @brief Class constructor.
+   *
+   * @param config      Performance model of each device.
+   * @param num_devices Number of emulated devices.
+   */
+  explicit EmulatedDeviceBackend(
+      const EmulatedDeviceConfig config = {10.0, 16.0, 0.0, 0, true},
+      const int num_devices = 1);
+  ~EmulatedDeviceBackend() override;
+
+  const char *name() const override;
+  bool has_device() const override;
+  void *alloc(const size_t size_bytes) override;
+  void free(void *const dev_ptr) override;
+  void memcpy_to_device(void *const dev_ptr, const void *const host_ptr,
+                        const size_t size_bytes) override;
+  void memcpy_from_device(void *const host_ptr, const void *const dev_ptr,
+                          const size_t size_bytes) override;
+  void memcpy_device(void *const dst_ptr, const void *const src_ptr,
+                     const size_t size_bytes) override;
+  void memcpy_to_device_async(void *const dev_ptr, const void *const host_ptr,
+                              const size_t size_bytes,
+                              const int queue) override;
+  void memcpy_from_device_async(void *const host_ptr,
+                                const void *const dev_ptr,
+                                const size_t size_bytes,
+                                const int queue) override;
+  void wait(const int queue) override;
+  void wait_all() override;
+  bool test(const int queue) override;
+  int num_devices() const override;
+  int get_device() const override;
+  void set_device(const int device) override;
+  void memcpy_peer(void *const dst_ptr, const int dst_device,
+                   const void *const src_ptr, const int src_device,
+                   const size_t size_bytes) override;
+  bool memory_info(size_t &free_bytes, size_t &total_bytes) const override;
+
+  /**
+   * @brief Returns transfer statistics of all devices.
+   *
+   * @return Statistics since construction or last reset.
+   */
+  EmulatedDeviceStats stats();
+
+  /**
+   * @brief Returns transfer statistics of one device.
+   *
+   * @param device Index of the device.
+   *
+   * @return       Statistics since construction or last reset.
+   */
+  EmulatedDeviceStats stats(const int device);
+
+  /**
+   * @brief Resets transfer counters and modeled time (allocation
+   * statistics are kept).
+   */
+  void reset_stats();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Stores an enqueued transfer.
+   */
+  struct PendingCopy {
+    void *dst_ptr;                /*!< destination buffer */
+    const void *src_ptr;          /*!< source buffer */
+    size_t size_bytes;            /*!< number of bytes */
+    Clock::time_point completion; /*!< modeled completion time */
+  };
+
+  /**
+   * @brief Stores an emulated device buffer.
+   */
+  struct Allocation {
+    size_t size_bytes; /*!< number of bytes */
+    int device;        /*!< device owning the buffer */
+  };
+
+  /**
+   * @brief Identifies the link used by a transfer.
+   */
+  enum Link { ToDevice = 0, FromDevice = 1, OnDevice = 2, Peer = 3 };
+
+  double model_transfer(const Link link, const size_t size_bytes,
+                        const int device);
+  Clock::time_point schedule(const Link link, const double seconds,
+                             const int device);
+  void complete(std::vector<PendingCopy> &copies);
+  void check_range(const void *const dev_ptr, const size_t size_bytes,
+                   const int device);
+
+  EmulatedDeviceConfig config;  /*!< performance model */
+  EmulatedDeviceStats counters; /*!< transfer statistics of all devices */
+  std::vector<EmulatedDeviceStats>
+      device_counters; /*!< transfer statistics of each device */
+  std::map<const char *, Allocation>
+      allocations; /*!< device buffers, with their sizes and devices */
+  std::map<std::pair<int, int>, std::vector<PendingCopy>>
+      queues; /*!< enqueued transfers, per device and queue */
+  std::vector<std::array<Clock::time_point, 3>>
+      link_ready;           /*!< time at which each link of each device
+                                 becomes idle */
+  int current_device;       /*!< index of the current device */
+  mutable std::mutex mutex; /*!< protects all members */
+};
+
+#ifdef _OPENACC
+/**
+ * @brief Backend performing device operations through OpenACC.
+ */
+class OpenACCDeviceBackend : public DeviceBackend {
+public:
+  const char *name() const override { return "openacc"; }
+
+  bool has_device() const override { return true; }
+
+  void *alloc(const size_t size_bytes) override {
+    return acc_malloc(size_bytes);
+  }
+
+  void free(void *const dev_ptr) override {
+    acc_free(dev_ptr);
+    return;
+  }
+
+  void memcpy_to_device(void *const dev_ptr, const void *const host_ptr,
+                        const size_t size_bytes) override {
+    acc_memcpy_to_device(dev_ptr, (void *)host_ptr, size_bytes);
+    return;
+  }
+
+  void memcpy_from_device(void *const host_ptr, const void *const dev_ptr,
+                          const size_t size_bytes) override {
+    acc_memcpy_from_device(host_ptr, (void *)dev_ptr, size_bytes);
+    return;
+  }
+
+  void memcpy_device(void *const dst_ptr, const void *const src_ptr,
+                     const size_t size_bytes) override {
+    acc_memcpy_device(dst_ptr, (void *)src_ptr, size_bytes);
+    return;
+  }
+
+  void memcpy_to_device_async(void *const dev_ptr, const void *const host_ptr,
+                              const size_t size_bytes,
+                              const int queue) override {
+    acc_memcpy_to_device_async(dev_ptr, (void *)host_ptr, size_bytes, queue);
+    return;
+  }
+
+  void memcpy_from_device_async(void *const host_ptr,
+                                const void *const dev_ptr,
+                                const size_t size_bytes,
+                                const int queue) override {
+    acc_memcpy_from_device_async(host_ptr, (void *)dev_ptr, size_bytes,
+                                 queue);
+    return;
+  }
+
+  void wait(const int queue) override {
+    acc_wait(queue);
+    return;
+  }
+
+  void wait_all() override {
+    acc_wait_all();
+    return;
+  }
+
+  bool test(const int queue) override { return acc_async_test(queue) != 0; }
+
+  void wait_async(const int queue, const int waiting_queue) override {
+    acc_wait_async(queue, waiting_queue);
+    return;
+  }
+
+  int num_devices() const override {
+    return acc_get_num_devices(acc_get_device_type());
+  }
+
+  int get_device() const override {
+    return acc_get_device_num(acc_get_device_type());
+  }
+
+  void set_device(const int device) override {
+    if (device < 0 || device >= num_devices())
+      abort_mimmo("Device " + std::to_string(device) + " does not exist.");
+    acc_set_device_num(device, acc_get_device_type());
+    return;
+  }
+
+  bool memory_info(size_t &free_bytes, size_t &total_bytes) const override {
+    const acc_device_t type = acc_get_device_type();
+    const int device = acc_get_device_num(type);
+    const size_t total = acc_get_property(device, type, acc_property_memory);
+
+    /* implementations may not report memory of the device */
+    if (total == 0)
+      return false;
+
+    total_bytes = total;
+    free_bytes = acc_get_property(device, type, acc_property_free_memory);
+    return true;
+  }
+};
+#endif // _OPENACC
+
+/**
+ * @brief Returns the backend matching the compilation flags.
+ *
+ * @return OpenACC backend if OpenACC is enabled, backend without device
+ *         otherwise.
+ */
+inline std::shared_ptr<DeviceBackend> default_device_backend() {
+#ifdef _OPENACC
+  return std::make_shared<OpenACCDeviceBackend>();
+#else
+  return std::make_shared<NoDeviceBackend>();
+#endif // _OPENACC
+}
+
+} // namespace MiMMO
@@ -0,0 +1,301 @@
+/**
+ * @file device_backend.inl
+ *
+ * @brief Definition of methods performing device memory operations
+ * through the device backend.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - device_alloc()
+ * - device_free()
+ * - object_device()
+ * - copy_to_device()
+ * - copy_from_device()
+ * - update_array_host_to_device_async()
+ * - update_array_device_to_host_async()
+ * - wait_queue()
+ * - wait_all_queues()
+ * - wait_queue_async()
+ * - test_queue()
+ * - num_devices()
+ * - get_device()
+ * - set_device()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Allocates device memory through the backend.
+ *
+ * @param size_bytes Number of bytes to be allocated.
+ *
+ * @return           Pointer to device memory.
+ *
+ * @note If allocation fails, the program aborts.
+ */
+inline void *DualMemoryManager::device_alloc(const size_t size_bytes) {
+
+  check_low_memory(size_bytes);
+
+  void *const dev_ptr = backend->alloc(size_bytes);
+
+  if (!dev_ptr)
+    abort_mimmo("Failed to allocate device memory.");
+
+  return dev_ptr;
+}
+
+/**
+ * @brief Frees device memory through the backend.
+ *
+ * @param dev_ptr Pointer to device memory (nullptr is ignored).
+ */
+inline void DualMemoryManager::device_free(void *const dev_ptr) {
+  if (dev_ptr != nullptr)
+    backend->free(dev_ptr);
+  return;
+}
+
+/**
+ * @brief Frees device memory of a given device through the backend.
+ *
+ * @param dev_ptr Pointer to device memory (nullptr is ignored).
+ * @param device  Device owning the memory.
+ */
+inline void DualMemoryManager::device_free(void *const dev_ptr,
+                                           const int device) {
+  if (dev_ptr == nullptr)
+    return;
+
+  const DeviceScope scope(*backend, device);
+  backend->free(dev_ptr);
+
+  return;
+}
+
+/**
+ * @brief Returns the device on which a tracked object is allocated.
+ *
+ * @param object Pointer to the dual object.
+ *
+ * @return       Device of the object (current device if not tracked).
+ */
+inline int DualMemoryManager::object_device(const void *const object) {
+  const auto it = memory_tracker.find((void *)object);
+  return (it != memory_tracker.end()) ? it->second.device
+                                      : backend->get_device();
+}
+
+/**
+ * @brief Copies data from host to device through the backend.
+ *
+ * @param dev_ptr    Destination on device.
+ * @param host_ptr   Source on host.
+ * @param size_bytes Number of bytes to be copied.
+ */
+inline void DualMemoryManager::copy_to_device(void *const dev_ptr,
+                                              const void *const host_ptr,
+                                              const size_t size_bytes) {
+
+  /* time is only measured for phases */
+  if (!phases.active()) {
+    backend->memcpy_to_device(dev_ptr, host_ptr, size_bytes);
+    record_transfer(true, size_bytes, 0.0);
+    return;
+  }
+
+  /* time the copy for the innermost open phase */
+  const auto start = std::chrono::steady_clock::now();
+  backend->memcpy_to_device(dev_ptr, host_ptr, size_bytes);
+  record_transfer(true, size_bytes, seconds_since(start));
+
+  return;
+}
+
+/**
+ * @brief Copies data from device to host through the backend.
+ *
+ * @param host_ptr   Destination on host.
+ * @param dev_ptr    Source on device.
+ * @param size_bytes Number of bytes to be copied.
+ */
+inline void DualMemoryManager::copy_from_device(void *const host_ptr,
+                                                const void *const dev_ptr,
+                                                const size_t size_bytes) {
+
+  /* time is only measured for phases */
+  if (!phases.active()) {
+    backend->memcpy_from_device(host_ptr, dev_ptr, size_bytes);
+    record_transfer(false, size_bytes, 0.0);
+    return;
+  }
+
+  /* time the copy for the innermost open phase */
+  const auto start = std::chrono::steady_clock::now();
+  backend->memcpy_from_device(host_ptr, dev_ptr, size_bytes);
+  record_transfer(false, size_bytes, seconds_since(start));
+
+  return;
+}
+
+/**
+ * @brief Enqueues a copy of data from host to device.
+ *
+ * @tparam T           Type of elements in the array.
+ *
+ * @param dual_array   Dual array to synchronize.
+ * @param offset       Index of first element to be copied.
+ * @param num_elements Number of elements to be copied.
+ * @param queue        Queue on which the copy is enqueued (on the device
+ *                     of the array).
+ *
+ * @note Memory of lazily allocated arrays is materialized on both
+ *       sides.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_array_host_to_device_async(
+    DualArray<T> &dual_array, const size_t offset, const size_t num_elements,
+    const int queue) {
+  /* materialize lazily allocated memory */
+  if (dual_array.host_ptr == nullptr)
+    materialize(dual_array, Side::Host);
+
+  if (!backend->has_device())
+    return;
+
+  const DeviceScope scope(*backend, object_device(&dual_array));
+
+  if (dual_array.dev_ptr == nullptr)
+    materialize(dual_array, Side::Device);
+
+  /* enqueue copy from host to device (its time is not known) */
+  backend->memcpy_to_device_async(dual_array.dev_ptr + offset,
+                                  dual_array.host_ptr + offset,
+                                  num_elements * sizeof(T), queue);
+  record_transfer(true, num_elements * sizeof(T), 0.0);
+
+  return;
+}
+
+/**
+ * @brief Enqueues a copy of data from device to host.
+ *
+ * @tparam T           Type of elements in the array.
+ *
+ * @param dual_array   Dual array to synchronize.
+ * @param offset       Index of first element to be copied.
+ * @param num_elements Number of elements to be copied.
+ * @param queue        Queue on which the copy is enqueued (on the device
+ *                     of the array).
+ *
+ * @note Memory of lazily allocated arrays is materialized on both
+ *       sides.
+ * @note If host memory is shared and read-only, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_array_device_to_host_async(
+    DualArray<T> &dual_array, const size_t offset, const size_t num_elements,
+    const int queue) {
+  /* materialize lazily allocated memory */
+  if (dual_array.host_ptr == nullptr)
+    materialize(dual_array, Side::Host);
+
+  if (!backend->has_device())
+    return;
+
+  check_host_writable(&dual_array);
+
+  const DeviceScope scope(*backend, object_device(&dual_array));
+
+  if (dual_array.dev_ptr == nullptr)
+    materialize(dual_array, Side::Device);
+
+  /* enqueue copy from device to host (its time is not known) */
+  backend->memcpy_from_device_async(dual_array.host_ptr + offset,
+                                    dual_array.dev_ptr + offset,
+                                    num_elements * sizeof(T), queue);
+  record_transfer(false, num_elements * sizeof(T), 0.0);
+
+  return;
+}
+
+/**
+ * @brief Waits for all copies enqueued on a queue of the current device.
+ *
+ * @param queue Queue to wait for.
+ */
+inline void DualMemoryManager::wait_queue(const int queue) {
+  backend->wait(queue);
+  return;
+}
+
+/**
+ * @brief Waits for all copies enqueued on any queue.
+ */
+inline void DualMemoryManager::wait_all_queues() {
+  backend->wait_all();
+  return;
+}
+
+/**
+ * @brief Makes a queue of the current device wait for all work enqueued
+ * on another queue so far, without blocking the host if possible.
+ *
+ * @param queue         Queue to wait for.
+ * @param waiting_queue Queue whose later work must wait.
+ */
+inline void DualMemoryManager::wait_queue_async(const int queue,
+                                                const int waiting_queue) {
+  if (queue != waiting_queue)
+    backend->wait_async(queue, waiting_queue);
+  return;
+}
+
+/**
+ * @brief Checks whether all copies enqueued on a queue are complete,
+ * without blocking.
+ *
+ * @param queue Queue to be checked.
+ *
+ * @return      Whether the queue is idle.
+ */
+inline bool DualMemoryManager::test_queue(const int queue) {
+  return backend->test(queue);
+}
+
+/**
+ * @brief Returns the number of devices.
+ *
+ * @return Number of devices (0 without device memory).
+ */
+inline int DualMemoryManager::num_devices() const {
+  return backend->num_devices();
+}
+
+/**
+ * @brief Returns the current device.
+ *
+ * @return Index of the current device.
+ */
+inline int DualMemoryManager::get_device() const {
+  return backend->get_device();
+}
+
+/**
+ * @brief Makes a device current.
+ *
+ * @param device Index of the device.
+ *
+ * @note If the device does not exist, the program aborts.
+ */
+inline void DualMemoryManager::set_device(const int device) {
+  backend->set_device(device);
+  return;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,61 @@
+/**
+ * @file groups.hpp
+ *
+ * @brief Declaration of the allocation group data structures.
+ *
+ * Internal data structures for named groups of dual arrays, optionally
+ * carved from one contiguous backing slab.
+ * Used by DualMemoryManager for group-level transfers and frees.
+ *
+ * @see groups.inl for the corresponding DualMemoryManager methods
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace MiMMO {
+
+/**
+ * @brief Alignment in bytes of dual arrays inside a group slab.
+ */
+constexpr size_t slab_alignment = 256;
+
+/**
+ * @brief Stores data of a dual array belonging to a group.
+ */
+struct GroupMember {
+  void *object;                /*!< pointer to the dual array (tracker
+                                    key) */
+  void *host_ptr;              /*!< pointer to host memory */
+  void *dev_ptr;               /*!< pointer to device memory */
+  size_t size_bytes;           /*!< size in bytes of the array */
+  std::function<void()> reset; /*!< resets the pointers of the dual
+                                    array once freed */
+};
+
+/**
+ * @brief Stores allocation group data.
+ *
+ * @details
+ * If the group has a slab, its arrays are carved from two contiguous
+ * buffers (one on host and one on device), so that the whole group can
+ * be moved with a single transfer and freed with a single call.
+ * Otherwise each array has its own allocation, and group operations act
+ * on each of them.
+ */
+struct AllocationGroup {
+  void *slab_host_ptr;              /*!< host slab (nullptr if none) */
+  void *slab_dev_ptr;               /*!< device slab (nullptr if none) */
+  size_t slab_capacity;             /*!< size in bytes of the slab */
+  size_t slab_offset;               /*!< bytes of the slab in use */
+  bool on_device;                   /*!< whether arrays of the group are
+                                         allocated on device */
+  int device;                       /*!< device on which arrays of the
+                                         group are allocated */
+  std::vector<GroupMember> members; /*!< arrays of the group */
+};
+
+} // namespace MiMMO
@@ -0,0 +1,350 @@
+/**
+ * @file groups.inl
+ *
+ * @brief Definition of methods for managing allocation groups.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - create_group()
+ * - alloc_array_in_group()
+ * - upload_group()
+ * - download_group()
+ * - free_group()
+ * - return_group_memory_usage()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Creates a named allocation group.
+ *
+ * @param name       Name of the group.
+ * @param slab_bytes Capacity in bytes of the backing slab (0 for no
+ *                   slab).
+ * @param on_device  Whether arrays of the group should be allocated on
+ *                   device as well (ignored without device memory).
+ *
+ * @note The whole slab is counted in total memory usage, rather than
+ *       the arrays carved from it.
+ * @note If a group with the same name exists, the program aborts.
+ */
+inline void DualMemoryManager::create_group(const std::string name,
+                                            const size_t slab_bytes,
+                                            const bool on_device) {
+
+  /* check that group does not exist yet */
+  if (groups.find(name) != groups.end())
+    abort_mimmo("Group '" + name + "' already exists.");
+
+  AllocationGroup group = {nullptr, nullptr, slab_bytes, 0,
+                           on_device && backend->has_device(),
+                           backend->get_device(), {}};
+
+  /* allocate slab on host and, if required, on device */
+  if (slab_bytes > 0) {
+    group.slab_host_ptr = host_alloc(slab_bytes, 1);
+
+    if (!(group.slab_host_ptr))
+      abort_mimmo("Failed to allocate host slab of group '" + name + "'.");
+
+    if (group.on_device) {
+      check_low_memory(slab_bytes);
+      group.slab_dev_ptr = backend->alloc(slab_bytes);
+
+      if (!(group.slab_dev_ptr)) {
+        host_free(group.slab_host_ptr);
+        abort_mimmo("Failed to allocate device slab of group '" + name +
+                    "'.");
+      }
+    }
+
+    /* update total memory usage (the whole slab is counted) */
+    total_memory.first += slab_bytes;
+    if (group.on_device)
+      total_memory.second += slab_bytes;
+
+    record_memory(0, 0);
+  }
+
+  groups.emplace(name, std::move(group));
+
+  return;
+}
+
+/**
+ * @brief Allocates dual array memory inside an allocation group.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be allocated.
+ * @param label      Label that should be used to track the array in
+ *                   memory.
+ * @param size       Number of elements in the array.
+ * @param group_name Name of the group.
+ *
+ * @note If the group does not exist, or its slab is exhausted, the
+ *       program aborts.
+ */
+template <typename T>
+void DualMemoryManager::alloc_array_in_group(DualArray<T> &dual_array,
+                                             const std::string label,
+                                             const size_t size,
+                                             const std::string group_name) {
+
+  /* look for group */
+  const auto it = groups.find(group_name);
+
+  if (it == groups.end())
+    abort_mimmo("Group '" + group_name + "' was not found.");
+
+  AllocationGroup &group = it->second;
+  const size_t size_bytes = size * sizeof(T);
+
+  if (group.slab_capacity > 0) {
+    /* carve array from slab */
+    const size_t begin = (group.slab_offset + slab_alignment - 1) /
+                         slab_alignment * slab_alignment;
+    const size_t end = begin + size_bytes;
+
+    if (end > group.slab_capacity)
+      abort_mimmo("Slab of group '" + group_name + "' exhausted (" +
+                  std::to_string(group.slab_capacity) + " bytes).");
+
+    group.slab_offset = end;
+
+    dual_array.host_ptr = (T *)((char *)group.slab_host_ptr + begin);
+    dual_array.dev_ptr =
+        group.on_device ? (T *)((char *)group.slab_dev_ptr + begin) : nullptr;
+
+  } else {
+    /* allocate array on its own */
+    dual_array.host_ptr = (T *)host_alloc(size, sizeof(T));
+    dual_array.dev_ptr = nullptr;
+
+    if (!(dual_array.host_ptr))
+      abort_mimmo("Failed to allocate host memory.");
+
+    if (group.on_device) {
+      const DeviceScope scope(*backend, group.device);
+      check_low_memory(size_bytes);
+      dual_array.dev_ptr = (T *)backend->alloc(size_bytes);
+
+      if (!(dual_array.dev_ptr)) {
+        host_free(dual_array.host_ptr);
+        dual_array.host_ptr = nullptr;
+        abort_mimmo("Failed to allocate device memory.");
+      }
+    }
+  }
+
+  /* update number of elements and bytes */
+  dual_array.size = size;
+  dual_array.size_bytes = size_bytes;
+
+  /* update memory tracker */
+  const bool ret = add_to_memory_tracker(
+      memory_tracker, total_memory, label_memory, (void *)&dual_array, label,
+      size_bytes, group.on_device, false, group.device);
+
+  if (ret)
+    abort_mimmo("Failed to track memory for dual array '" + label + "'.");
+
+  memory_tracker[(void *)&dual_array].group = group_name;
+
+  /* arrays carved from the slab are already counted in it */
+  if (group.slab_capacity > 0) {
+    total_memory.first -= size_bytes;
+    if (group.on_device)
+      total_memory.second -= size_bytes;
+  }
+
+  record_memory(1, 0);
+
+  /* assign descriptor table slot */
+  register_descriptor((void *)&dual_array, (void *)dual_array.host_ptr,
+                      (void *)dual_array.dev_ptr, size);
+
+  /* register array in group */
+  DualArray<T> *const object = &dual_array;
+  group.members.push_back({(void *)object, (void *)dual_array.host_ptr,
+                           (void *)dual_array.dev_ptr, size_bytes,
+                           [object]() {
+                             object->host_ptr = nullptr;
+                             object->dev_ptr = nullptr;
+                           }});
+
+  return;
+}
+
+/**
+ * @brief Copies all arrays of a group from host to device.
+ *
+ * @param name Name of the group.
+ *
+ * @note If the group does not exist, or it is not allocated on device,
+ *       the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+inline void DualMemoryManager::upload_group(const std::string name) {
+
+  /* look for group */
+  const auto it = groups.find(name);
+
+  if (it == groups.end())
+    abort_mimmo("Group '" + name + "' was not found.");
+
+  if (!backend->has_device())
+    return;
+
+  const AllocationGroup &group = it->second;
+
+  if (!group.on_device)
+    abort_mimmo("Group '" + name + "' is not allocated on device.");
+
+  const DeviceScope scope(*backend, group.device);
+
+  /* copy slab with a single transfer, or each array on its own */
+  if (group.slab_capacity > 0) {
+    if (group.slab_offset > 0)
+      copy_to_device(group.slab_dev_ptr, group.slab_host_ptr,
+                     group.slab_offset);
+  } else {
+    for (const GroupMember &member : group.members)
+      copy_to_device(member.dev_ptr, member.host_ptr, member.size_bytes);
+  }
+
+  return;
+}
+
+/**
+ * @brief Copies all arrays of a group from device to host.
+ *
+ * @param name Name of the group.
+ *
+ * @note If the group does not exist, or it is not allocated on device,
+ *       the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+inline void DualMemoryManager::download_group(const std::string name) {
+
+  /* look for group */
+  const auto it = groups.find(name);
+
+  if (it == groups.end())
+    abort_mimmo("Group '" + name + "' was not found.");
+
+  if (!backend->has_device())
+    return;
+
+  const AllocationGroup &group = it->second;
+
+  if (!group.on_device)
+    abort_mimmo("Group '" + name + "' is not allocated on device.");
+
+  const DeviceScope scope(*backend, group.device);
+
+  /* copy slab with a single transfer, or each array on its own */
+  if (group.slab_capacity > 0) {
+    if (group.slab_offset > 0)
+      copy_from_device(group.slab_host_ptr, group.slab_dev_ptr,
+                       group.slab_offset);
+  } else {
+    for (const GroupMember &member : group.members)
+      copy_from_device(member.host_ptr, member.dev_ptr, member.size_bytes);
+  }
+
+  return;
+}
+
+/**
+ * @brief Frees all arrays of a group, and the group itself.
+ *
+ * @param name Name of the group.
+ *
+ * @note If the group does not exist, the program aborts.
+ */
+inline void DualMemoryManager::free_group(const std::string name) {
+
+  /* look for group */
+  const auto it = groups.find(name);
+
+  if (it == groups.end())
+    abort_mimmo("Group '" + name + "' was not found.");
+
+  AllocationGroup &group = it->second;
+
+  /* untrack arrays and free them, unless they live in the slab */
+  for (GroupMember &member : group.members) {
+    /* arrays carved from the slab were not counted on their own */
+    if (group.slab_capacity > 0) {
+      total_memory.first += member.size_bytes;
+      if (group.on_device)
+        total_memory.second += member.size_bytes;
+    }
+
+    unregister_descriptor(memory_tracker[member.object].slot);
+    remove_from_memory_tracker(memory_tracker, total_memory, label_memory,
+                               member.object);
+    release_transfer_state(member.object);
+    record_memory(0, 1);
+
+    if (group.slab_capacity == 0) {
+      host_free(member.host_ptr);
+      device_free(member.dev_ptr, group.device);
+    }
+
+    member.reset();
+  }
+
+  /* free slab */
+  host_free(group.slab_host_ptr);
+  device_free(group.slab_dev_ptr, group.device);
+
+  if (group.slab_capacity > 0) {
+    total_memory.first -= group.slab_capacity;
+    if (group.on_device)
+      total_memory.second -= group.slab_capacity;
+
+    record_memory(0, 0);
+  }
+
+  groups.erase(it);
+
+  return;
+}
+
+/**
+ * @brief Returns host and device memory used by the arrays of a group.
+ *
+ * @param name Name of the group.
+ *
+ * @return     (host memory used by the group, device memory used by the
+ *             group)
+ *
+ * @note If the group does not exist, the program aborts.
+ */
+inline std::pair<size_t, size_t>
+DualMemoryManager::return_group_memory_usage(const std::string name) {
+
+  /* look for group */
+  const auto it = groups.find(name);
+
+  if (it == groups.end())
+    abort_mimmo("Group '" + name + "' was not found.");
+
+  /* sum sizes of arrays */
+  std::pair<size_t, size_t> group_memory = {0, 0};
+
+  for (const GroupMember &member : it->second.members) {
+    group_memory.first += member.size_bytes;
+    if (it->second.on_device)
+      group_memory.second += member.size_bytes;
+  }
+
+  return group_memory;
+}
+
+} // namespace MiMMO
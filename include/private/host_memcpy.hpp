@@ -0,0 +1,37 @@
+/**
+ * @file host_memcpy.hpp
+ *
+ * @brief Declaration of host memory copy utilities.
+ *
+ * Internal utilities for copying large host buffers using multiple
+ * threads and non-temporal stores.
+ * Used by DualMemoryManager for host-side copies between dual arrays.
+ *
+ * @see host_memcpy.cpp for implementation
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace MiMMO {
+
+/**
+ * @brief Copies a host buffer using multiple threads.
+ *
+ * @details
+ * Small copies are performed by a single std::memcpy call. Larger copies
+ * are split into chunks copied by separate threads; when available,
+ * non-temporal (streaming) stores are used so that the destination does
+ * not evict useful data from cache.
+ *
+ * @param dst        Destination buffer.
+ * @param src        Source buffer.
+ * @param size_bytes Number of bytes to be copied.
+ *
+ * @note Source and destination buffers must not overlap.
+ */
+void parallel_memcpy(void *const dst, const void *const src,
+                     const size_t size_bytes);
+
+} // namespace MiMMO
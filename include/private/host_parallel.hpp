@@ -0,0 +1,112 @@
+/**
+ * @file host_parallel.hpp
+ *
+ * @brief Declaration of host-side parallel loop utilities.
+ *
+ * Internal utilities for running loops on host with multiple threads,
+ * through a persistent pool of worker threads.
+ * Used by DualMemoryManager and by the parallel primitives on dual arrays
+ * when running on host.
+ *
+ * @see host_parallel.cpp for implementations
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief Hints the compiler that iterations of the following loop are
+ * independent and can be vectorized.
+ */
+#if defined(_OPENMP)
+#define MIMMO_SIMD _Pragma("omp simd")
+#elif defined(__clang__)
+#define MIMMO_SIMD _Pragma("clang loop vectorize(enable)")
+#elif defined(__GNUC__) && !defined(__NVCOMPILER)
+#define MIMMO_SIMD _Pragma("GCC ivdep")
+#else
+#define MIMMO_SIMD
+#endif
+
+namespace MiMMO {
+
+/**
+ * @brief Minimum number of loop iterations assigned to each chunk.
+ */
+constexpr size_t host_parallel_grain = size_t(1) << 15;
+
+/**
+ * @brief Returns the number of threads used for host-side parallel loops.
+ *
+ * @return Number of threads (including the calling one).
+ */
+size_t host_num_threads();
+
+/**
+ * @brief Runs a function on a number of chunks using the thread pool.
+ *
+ * @details
+ * Chunks are distributed statically among the worker threads and the
+ * calling thread (chunk c runs on thread c modulo the number of threads),
+ * and the function returns once all chunks are done.
+ * Calls made while the pool is busy (e.g. from inside a chunk) run
+ * serially on the calling thread.
+ *
+ * @param num_chunks Number of chunks.
+ * @param chunk_fn   Function called with the index of each chunk.
+ */
+void parallel_for_chunks(const size_t num_chunks,
+                         const std::function<void(size_t)> &chunk_fn);
+
+/**
+ * @brief Returns the number of chunks a loop should be split into.
+ *
+ * @param num_iterations Number of loop iterations.
+ *
+ * @return               Number of chunks (at least 1).
+ */
+inline size_t host_num_chunks(const size_t num_iterations) {
+  return std::max(std::min(num_iterations / host_parallel_grain,
+                           host_num_threads()),
+                  static_cast<size_t>(1));
+}
+
+/**
+ * @brief Runs a loop on host with multiple threads.
+ *
+ * @details
+ * The iteration space is split into contiguous ranges, and the body is
+ * called once per range. Short loops run on the calling thread only.
+ *
+ * @tparam F             Type of the loop body.
+ *
+ * @param num_iterations Number of loop iterations.
+ * @param body           Function called with the begin and end indices of
+ *                       each range.
+ */
+template <typename F>
+void host_parallel_for(const size_t num_iterations, const F &body) {
+
+  const size_t num_chunks = host_num_chunks(num_iterations);
+
+  if (num_chunks == 1) {
+    body(static_cast<size_t>(0), num_iterations);
+    return;
+  }
+
+  const size_t chunk = (num_iterations + num_chunks - 1) / num_chunks;
+
+  parallel_for_chunks(num_chunks, [&](const size_t c) {
+    const size_t begin = std::min(c * chunk, num_iterations);
+    const size_t end = std::min(begin + chunk, num_iterations);
+    if (begin < end)
+      body(begin, end);
+  });
+
+  return;
+}
+
+} // namespace MiMMO
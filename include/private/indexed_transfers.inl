@@ -0,0 +1,264 @@
+/**
+ * @file indexed_transfers.inl
+ *
+ * @brief Definition of template methods for indexed (gather/scatter)
+ * transfers of dual arrays.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - update_array_indexed_host_to_device()
+ * - update_array_indexed_device_to_host()
+ * - update_array_indexed()
+ * - set_indexed_transfer_threshold()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Performs an indexed transfer in the requested direction.
+ *
+ * @details
+ * The staging buffers are laid out as the packed values followed (if
+ * needed) by the indices, so that a host-to-device transfer moves both
+ * with a single copy.
+ *
+ * @tparam T           Type of elements in the array.
+ *
+ * @param dual_array   Dual array to synchronize.
+ * @param host_indices Indices of the elements to be copied, on host.
+ * @param dev_indices  Same indices on device, or nullptr if they must be
+ *                     transferred together with the values.
+ * @param num_indices  Number of indices.
+ * @param to_device    Whether data should be copied from host to device
+ *                     (or the other way round).
+ */
+template <typename T>
+void DualMemoryManager::update_array_indexed(DualArray<T> &dual_array,
+                                             const size_t *const host_indices,
+                                             const size_t *const dev_indices,
+                                             const size_t num_indices,
+                                             const bool to_device) {
+  /* materialize lazily allocated memory */
+  if (dual_array.host_ptr == nullptr)
+    materialize(dual_array, Side::Host);
+
+  if (num_indices == 0)
+    return;
+
+  /* find range covering all indices and check bounds */
+  size_t min_index = host_indices[0];
+  size_t max_index = host_indices[0];
+  for (size_t i = 1; i < num_indices; i++) {
+    min_index = std::min(min_index, host_indices[i]);
+    max_index = std::max(max_index, host_indices[i]);
+  }
+
+  if (max_index >= dual_array.size)
+    abort_mimmo("Index of indexed transfer out of range.");
+
+  if (!backend->has_device())
+    return;
+
+  if (!to_device)
+    check_host_writable(&dual_array);
+
+  const DeviceScope scope(*backend, object_device(&dual_array));
+
+  if (dual_array.dev_ptr == nullptr)
+    materialize(dual_array, Side::Device);
+
+  /* fall back to a contiguous copy if the indices are dense enough */
+  const size_t range_bytes = (max_index - min_index + 1) * sizeof(T);
+  const size_t index_bytes =
+      (dev_indices == nullptr) ? num_indices * sizeof(size_t) : 0;
+  const size_t indexed_bytes = num_indices * sizeof(T) + index_bytes;
+
+  if (indexed_bytes >= indexed_density_threshold * range_bytes) {
+    if (to_device)
+      copy_to_device(dual_array.dev_ptr + min_index,
+                     dual_array.host_ptr + min_index, range_bytes);
+    else
+      copy_from_device(dual_array.host_ptr + min_index,
+                       dual_array.dev_ptr + min_index, range_bytes);
+    return;
+  }
+
+  /* prepare staging buffers (indices are aligned after values) */
+  const size_t values_bytes = ((num_indices * sizeof(T) + sizeof(size_t) - 1) /
+                               sizeof(size_t)) *
+                              sizeof(size_t);
+  reserve_staging_buffers(values_bytes + index_bytes);
+
+  T *const host_values = (T *)staging_host_ptr;
+  T *const dev_values = (T *)staging_dev_ptr;
+  const size_t *const dev_idx =
+      (dev_indices != nullptr)
+          ? dev_indices
+          : (const size_t *)((char *)staging_dev_ptr + values_bytes);
+
+  if (dev_indices == nullptr)
+    std::memcpy((char *)staging_host_ptr + values_bytes, host_indices,
+                index_bytes);
+
+  T *const array_dev_ptr = dual_array.dev_ptr;
+
+  if (to_device) {
+    /* pack values on host */
+    for (size_t i = 0; i < num_indices; i++)
+      host_values[i] = dual_array.host_ptr[host_indices[i]];
+
+    /* move values and indices with a single transfer */
+    copy_to_device(staging_dev_ptr, staging_host_ptr,
+                   values_bytes + index_bytes);
+
+    /* scatter values on device */
+#ifdef _OPENACC
+#pragma acc parallel loop deviceptr(array_dev_ptr, dev_values, dev_idx)
+    for (size_t i = 0; i < num_indices; i++)
+      array_dev_ptr[dev_idx[i]] = dev_values[i];
+#else
+    /* emulated device memory is addressable from host */
+    for (size_t i = 0; i < num_indices; i++)
+      array_dev_ptr[dev_idx[i]] = dev_values[i];
+#endif // _OPENACC
+
+  } else {
+    /* move indices to device if needed */
+    if (dev_indices == nullptr)
+      copy_to_device((char *)staging_dev_ptr + values_bytes,
+                     (char *)staging_host_ptr + values_bytes, index_bytes);
+
+    /* gather values on device */
+#ifdef _OPENACC
+#pragma acc parallel loop deviceptr(array_dev_ptr, dev_values, dev_idx)
+    for (size_t i = 0; i < num_indices; i++)
+      dev_values[i] = array_dev_ptr[dev_idx[i]];
+#else
+    /* emulated device memory is addressable from host */
+    for (size_t i = 0; i < num_indices; i++)
+      dev_values[i] = array_dev_ptr[dev_idx[i]];
+#endif // _OPENACC
+
+    /* move values with a single transfer */
+    copy_from_device(staging_host_ptr, staging_dev_ptr,
+                     num_indices * sizeof(T));
+
+    /* unpack values on host */
+    for (size_t i = 0; i < num_indices; i++)
+      dual_array.host_ptr[host_indices[i]] = host_values[i];
+  }
+
+  return;
+}
+
+/**
+ * @brief Copies scattered elements from host to device.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to synchronize.
+ * @param indices    Indices of the elements to be copied.
+ *
+ * @note If an index is out of range, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_array_indexed_host_to_device(
+    DualArray<T> &dual_array, const std::vector<size_t> &indices) {
+  update_array_indexed(dual_array, indices.data(), nullptr, indices.size(),
+                       true);
+  return;
+}
+
+/**
+ * @brief Copies scattered elements from host to device, using an index
+ * list already present on device.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to synchronize.
+ * @param indices    Dual array with the indices of the elements to be
+ *                   copied (all its elements are used).
+ *
+ * @note If an index is out of range, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_array_indexed_host_to_device(
+    DualArray<T> &dual_array, const DualArray<size_t> &indices) {
+  /* check that index pointers are initialized */
+  if (indices.host_ptr == nullptr)
+    abort_mimmo("Host pointer of index dual array is a null pointer.");
+  if (backend->has_device() && indices.dev_ptr == nullptr)
+    abort_mimmo("Device pointer of index dual array is a null pointer.");
+
+  update_array_indexed(dual_array, indices.host_ptr, indices.dev_ptr,
+                       indices.size, true);
+  return;
+}
+
+/**
+ * @brief Copies scattered elements from device to host.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to synchronize.
+ * @param indices    Indices of the elements to be copied.
+ *
+ * @note If an index is out of range, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_array_indexed_device_to_host(
+    DualArray<T> &dual_array, const std::vector<size_t> &indices) {
+  update_array_indexed(dual_array, indices.data(), nullptr, indices.size(),
+                       false);
+  return;
+}
+
+/**
+ * @brief Copies scattered elements from device to host, using an index
+ * list already present on device.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to synchronize.
+ * @param indices    Dual array with the indices of the elements to be
+ *                   copied (all its elements are used).
+ *
+ * @note If an index is out of range, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_array_indexed_device_to_host(
+    DualArray<T> &dual_array, const DualArray<size_t> &indices) {
+  /* check that index pointers are initialized */
+  if (indices.host_ptr == nullptr)
+    abort_mimmo("Host pointer of index dual array is a null pointer.");
+  if (backend->has_device() && indices.dev_ptr == nullptr)
+    abort_mimmo("Device pointer of index dual array is a null pointer.");
+
+  update_array_indexed(dual_array, indices.host_ptr, indices.dev_ptr,
+                       indices.size, false);
+  return;
+}
+
+/**
+ * @brief Sets the density threshold of indexed transfers.
+ *
+ * @param threshold Ratio between indexed and contiguous transfer volume.
+ */
+inline void
+DualMemoryManager::set_indexed_transfer_threshold(const double threshold) {
+  if (threshold < 0.0)
+    abort_mimmo("Indexed transfer threshold must be non-negative.");
+
+  indexed_density_threshold = threshold;
+
+  return;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,240 @@
+/**
+ * @file jagged_arrays.inl
+ *
+ * @brief Definition of template methods for managing jagged dual arrays.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - alloc_jagged_array()
+ * - update_jagged_array_host_to_device()
+ * - update_jagged_array_device_to_host()
+ * - update_jagged_rows_host_to_device()
+ * - update_jagged_rows_device_to_host()
+ * - free_jagged_array()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Allocates a jagged dual array with given row sizes.
+ *
+ * @details
+ * Values and row offsets are laid out in one allocation, each aligned for
+ * its type. Offsets are computed on host and, if the array is on device,
+ * copied to device, so that rows can be updated on their own right away.
+ *
+ * @tparam T        Type of elements in the array.
+ *
+ * @param jagged    Jagged dual array to be allocated.
+ * @param label     Label that should be used to track the array in
+ *                  memory.
+ * @param row_sizes Number of elements of each row.
+ * @param on_device Whether the array should be allocated on device as
+ *                  well (ignored without device memory).
+ */
+template <typename T>
+void DualMemoryManager::alloc_jagged_array(DualJaggedArray<T> &jagged,
+                                           const std::string label,
+                                           const std::vector<size_t> &row_sizes,
+                                           const bool on_device) {
+
+  const size_t num_rows = row_sizes.size();
+
+  size_t num_values = 0;
+  for (const size_t row_size : row_sizes)
+    num_values += row_size;
+
+  /* lay out components, each aligned for its type */
+  const size_t offsets_offset = (num_values * sizeof(T) + alignof(size_t) - 1) /
+                                alignof(size_t) * alignof(size_t);
+  const size_t size_bytes = offsets_offset + (num_rows + 1) * sizeof(size_t);
+
+  alloc_array(jagged.storage, label, size_bytes, on_device);
+
+  set_storage_view(jagged.values, jagged.storage, 0, num_values);
+  set_storage_view(jagged.offsets, jagged.storage, offsets_offset,
+                   num_rows + 1);
+  jagged.num_rows = num_rows;
+
+  /* compute row offsets on host, then copy them to device */
+  jagged.offsets.host_ptr[0] = 0;
+  for (size_t row = 0; row < num_rows; row++)
+    jagged.offsets.host_ptr[row + 1] =
+        jagged.offsets.host_ptr[row] + row_sizes[row];
+
+  if (jagged.storage.dev_ptr != nullptr)
+    update_array_host_to_device(jagged.storage, offsets_offset,
+                                jagged.offsets.size_bytes);
+
+  return;
+}
+
+/**
+ * @brief Allocates a jagged dual array and fills it on host from
+ * containers.
+ *
+ * @details
+ * Values are copied on host only; use update_jagged_array_host_to_device()
+ * to send them to device.
+ *
+ * @tparam T        Type of elements in the array.
+ *
+ * @param jagged    Jagged dual array to be allocated.
+ * @param label     Label that should be used to track the array in
+ *                  memory.
+ * @param rows      Elements of each row.
+ * @param on_device Whether the array should be allocated on device as
+ *                  well (ignored without device memory).
+ */
+template <typename T>
+void DualMemoryManager::alloc_jagged_array(
+    DualJaggedArray<T> &jagged, const std::string label,
+    const std::vector<std::vector<T>> &rows, const bool on_device) {
+
+  std::vector<size_t> row_sizes(rows.size());
+  for (size_t row = 0; row < rows.size(); row++)
+    row_sizes[row] = rows[row].size();
+
+  alloc_jagged_array(jagged, label, row_sizes, on_device);
+
+  /* copy rows on host */
+  for (size_t row = 0; row < rows.size(); row++)
+    std::copy(rows[row].begin(), rows[row].end(),
+              jagged.values.host_ptr + jagged.offsets.host_ptr[row]);
+
+  return;
+}
+
+/**
+ * @brief Copies a jagged dual array (values and offsets) from host to
+ * device, in one transfer.
+ *
+ * @tparam T       Type of elements in the array.
+ *
+ * @param jagged   Jagged dual array to synchronize.
+ * @param location Call site, recorded in profiling mode.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_jagged_array_host_to_device(
+    DualJaggedArray<T> &jagged, const SourceLocation location) {
+  update_array_host_to_device(jagged.storage, 0, jagged.storage.size,
+                              location);
+  return;
+}
+
+/**
+ * @brief Copies a jagged dual array (values and offsets) from device to
+ * host, in one transfer.
+ *
+ * @tparam T       Type of elements in the array.
+ *
+ * @param jagged   Jagged dual array to synchronize.
+ * @param location Call site, recorded in profiling mode.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_jagged_array_device_to_host(
+    DualJaggedArray<T> &jagged, const SourceLocation location) {
+  update_array_device_to_host(jagged.storage, 0, jagged.storage.size,
+                              location);
+  return;
+}
+
+/**
+ * @brief Copies the values of consecutive rows of a jagged dual array
+ * from host to device, in one transfer.
+ *
+ * @details
+ * Rows are contiguous in the value buffer, so only their values are
+ * copied; offsets are left untouched.
+ *
+ * @tparam T        Type of elements in the array.
+ *
+ * @param jagged    Jagged dual array to synchronize.
+ * @param first_row Index of first row to be copied.
+ * @param num_rows  Number of rows to be copied.
+ * @param location  Call site, recorded in profiling mode.
+ *
+ * @note If the rows are out of range, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_jagged_rows_host_to_device(
+    DualJaggedArray<T> &jagged, const size_t first_row, const size_t num_rows,
+    const SourceLocation location) {
+
+  if (first_row + num_rows > jagged.num_rows)
+    abort_mimmo("Rows out of range of jagged dual array.");
+
+  const size_t *const offsets = jagged.offsets.host_ptr;
+  update_array_host_to_device(
+      jagged.storage, offsets[first_row] * sizeof(T),
+      (offsets[first_row + num_rows] - offsets[first_row]) * sizeof(T),
+      location);
+
+  return;
+}
+
+/**
+ * @brief Copies the values of consecutive rows of a jagged dual array
+ * from device to host, in one transfer.
+ *
+ * @details
+ * Rows are contiguous in the value buffer, so only their values are
+ * copied; offsets are left untouched.
+ *
+ * @tparam T        Type of elements in the array.
+ *
+ * @param jagged    Jagged dual array to synchronize.
+ * @param first_row Index of first row to be copied.
+ * @param num_rows  Number of rows to be copied.
+ * @param location  Call site, recorded in profiling mode.
+ *
+ * @note If the rows are out of range, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_jagged_rows_device_to_host(
+    DualJaggedArray<T> &jagged, const size_t first_row, const size_t num_rows,
+    const SourceLocation location) {
+
+  if (first_row + num_rows > jagged.num_rows)
+    abort_mimmo("Rows out of range of jagged dual array.");
+
+  const size_t *const offsets = jagged.offsets.host_ptr;
+  update_array_device_to_host(
+      jagged.storage, offsets[first_row] * sizeof(T),
+      (offsets[first_row + num_rows] - offsets[first_row]) * sizeof(T),
+      location);
+
+  return;
+}
+
+/**
+ * @brief Frees memory allocated for a jagged dual array.
+ *
+ * @tparam T     Type of elements in the array.
+ *
+ * @param jagged Jagged dual array to be freed.
+ *
+ * @note If the array is not tracked, the program aborts.
+ */
+template <typename T>
+void DualMemoryManager::free_jagged_array(DualJaggedArray<T> &jagged) {
+
+  free_array(jagged.storage);
+
+  jagged.values = {nullptr, nullptr, 0, 0};
+  jagged.offsets = {nullptr, nullptr, 0, 0};
+  jagged.num_rows = 0;
+
+  return;
+}
+
+} // namespace MiMMO
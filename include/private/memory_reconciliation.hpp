@@ -0,0 +1,58 @@
+/**
+ * @file memory_reconciliation.hpp
+ *
+ * @brief Declaration of samples reconciling tracked and actual memory.
+ *
+ * Memory tracked by the memory manager only covers dual objects: the
+ * process also holds memory of the runtime, of libraries and of the
+ * application itself. Samples put tracked memory side by side with the
+ * resident memory of the process and with the memory used on device, so
+ * that the untracked gap can be followed over time.
+ *
+ * @see memory_reconciliation.cpp for implementations
+ * @see memory_reconciliation.inl for the corresponding DualMemoryManager
+ *      methods
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace MiMMO {
+
+/**
+ * @brief Stores a sample of tracked and actual memory usage.
+ */
+struct MemorySample {
+  double seconds;            /*!< time since construction of the memory
+                                  manager, in s */
+  size_t tracked_host_bytes; /*!< host memory used by the manager */
+  size_t tracked_dev_bytes;  /*!< memory used by the manager on the
+                                  current device */
+  bool host_known;           /*!< whether host values below are known */
+  size_t host_rss_bytes;     /*!< resident memory of the process (VmRSS) */
+  size_t host_hwm_bytes;     /*!< peak resident memory of the process
+                                  (VmHWM) */
+  bool dev_known;            /*!< whether device values below are known */
+  size_t dev_free_bytes;     /*!< free memory of the current device */
+  size_t dev_total_bytes;    /*!< total memory of the current device */
+};
+
+/**
+ * @brief Callback invoked when free device memory runs low.
+ */
+using LowMemoryAlarm = std::function<void(const MemorySample &)>;
+
+/**
+ * @brief Reads resident memory of the process from /proc/self/status.
+ *
+ * @param rss_bytes Resident memory (VmRSS), in bytes.
+ * @param hwm_bytes Peak resident memory (VmHWM), in bytes.
+ *
+ * @return          Whether both values could be read (otherwise they
+ *                  are left unchanged).
+ */
+bool read_process_memory(size_t &rss_bytes, size_t &hwm_bytes);
+
+} // namespace MiMMO
@@ -0,0 +1,81 @@
+/**
+ * @file memory_reconciliation.inl
+ *
+ * @brief Definition of methods reconciling tracked and actual memory.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - check_low_memory()
+ * - return_memory_samples()
+ * - clear_memory_samples()
+ * - set_low_memory_alarm()
+ *
+ * @see api.hpp for the corresponding declarations
+ * @see memory_reconciliation.cpp for sampling and reporting
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Raises the low-memory alarm, if set, when an allocation would
+ * leave too little free memory on the current device.
+ *
+ * @param size_bytes Number of bytes about to be allocated.
+ */
+inline void DualMemoryManager::check_low_memory(const size_t size_bytes) {
+
+  /* allocations made by the alarm itself do not raise it again */
+  if (!low_memory_alarm || low_memory_raised)
+    return;
+
+  size_t free_bytes = 0;
+  size_t total_bytes = 0;
+
+  if (!backend->memory_info(free_bytes, total_bytes))
+    return;
+
+  if (free_bytes >= size_bytes && free_bytes - size_bytes >= low_memory_bytes)
+    return;
+
+  low_memory_raised = true;
+  low_memory_alarm(sample_memory());
+  low_memory_raised = false;
+
+  return;
+}
+
+/**
+ * @brief Returns the history of memory samples.
+ *
+ * @return Samples, in the order they were taken.
+ */
+inline std::vector<MemorySample> DualMemoryManager::return_memory_samples() {
+  return memory_samples;
+}
+
+/**
+ * @brief Forgets the history of memory samples.
+ */
+inline void DualMemoryManager::clear_memory_samples() {
+  memory_samples.clear();
+  return;
+}
+
+/**
+ * @brief Sets a callback raised before device allocations that would
+ * leave little free memory.
+ *
+ * @param min_free_bytes Free device memory below which the alarm is
+ *                       raised, in bytes.
+ * @param alarm          Callback of the alarm (empty to disable it).
+ */
+inline void
+DualMemoryManager::set_low_memory_alarm(const size_t min_free_bytes,
+                                        const LowMemoryAlarm alarm) {
+  low_memory_bytes = min_free_bytes;
+  low_memory_alarm = alarm;
+  return;
+}
+
+} // namespace MiMMO
@@ -16,26 +16,110 @@
 
 namespace MiMMO {
 
+/**
+ * @brief Stores tracking information of a dual object.
+ *
+ * @details
+ * Objects allocated lazily are reserved when tracked, and their host and
+ * device memory is materialized separately on first use. Eagerly
+ * allocated objects are materialized on both sides as soon as they are
+ * tracked.
+ */
+struct TrackerEntry {
+  std::string label;      /*!< label of the object */
+  size_t size;            /*!< size in bytes of the object */
+  size_t dev_size;        /*!< size in bytes of the object on device
+                               (differs from size for mixed-precision
+                               arrays) */
+  bool on_device;         /*!< whether the object is allocated on device */
+  bool host_materialized; /*!< whether host memory is allocated */
+  bool dev_materialized;  /*!< whether device memory is allocated */
+  std::string group;      /*!< name of the allocation group of the object
+                               (empty if none) */
+  size_t slot;            /*!< slot of the object in the descriptor
+                               table */
+  int device;             /*!< device on which device memory is
+                               allocated */
+  bool shared;            /*!< whether host memory is shared with other
+                               processes (and not counted as used) */
+};
+
+/**
+ * @brief Stores the memory used by the tracked objects of a label.
+ *
+ * @details
+ * Totals are updated along with the memory tracker, so that memory used
+ * by label is known without walking all tracked objects.
+ */
+struct LabelMemory {
+  size_t num_objects; /*!< number of tracked objects with the label */
+  size_t host_bytes;  /*!< host memory used by the objects */
+  size_t dev_bytes;   /*!< device memory used by the objects */
+};
+
 /**
  * @brief Adds an entry to the given memory tracker.
  *
  * @param memory_tracker   Memory tracker to update.
  * @param tot_memory_usage Pair containing total host and device memory
  *                         usage.
+ * @param label_memory     Memory used by label, to update.
  * @param object           Pointer to dual object to be added.
  * @param label            Label of the array to be added.
  * @param size             Size in bytes of the array to be added.
  * @param on_device        Whether the array is allocated on device.
+ * @param lazy             Whether memory is only reserved, and will be
+ *                         materialized later.
+ * @param device           Device on which device memory is allocated.
  *
  * @return                 'true' if the array was already tracked, 'false'
  *                         otherwise.
  *
  * @note If the label (key) is already present, the entry is ignored.
  */
-bool add_to_memory_tracker(
-    std::map<void *, std::tuple<std::string, size_t, bool>> &memory_tracker,
-    std::pair<size_t, size_t> &tot_memory_usage, void *const object,
-    const std::string label, const size_t size, const bool on_device);
+bool add_to_memory_tracker(std::map<void *, TrackerEntry> &memory_tracker,
+                           std::pair<size_t, size_t> &tot_memory_usage,
+                           std::map<std::string, LabelMemory> &label_memory,
+                           void *const object, const std::string label,
+                           const size_t size, const bool on_device,
+                           const bool lazy = false, const int device = 0);
+
+/**
+ * @brief Marks memory of a tracked object as materialized on one side.
+ *
+ * @param memory_tracker   Memory tracker to update.
+ * @param tot_memory_usage Pair containing total host and device memory
+ *                         usage.
+ * @param label_memory     Memory used by label, to update.
+ * @param object           Pointer to tracked dual object.
+ * @param on_device        Whether device (rather than host) memory was
+ *                         materialized.
+ *
+ * @return                 'true' if the object was not tracked, 'false'
+ *                         otherwise.
+ */
+bool mark_as_materialized(std::map<void *, TrackerEntry> &memory_tracker,
+                          std::pair<size_t, size_t> &tot_memory_usage,
+                          std::map<std::string, LabelMemory> &label_memory,
+                          void *const object, const bool on_device);
+
+/**
+ * @brief Sets the size of device memory of a tracked object.
+ *
+ * @param memory_tracker   Memory tracker to update.
+ * @param tot_memory_usage Pair containing total host and device memory
+ *                         usage.
+ * @param label_memory     Memory used by label, to update.
+ * @param object           Pointer to tracked dual object.
+ * @param dev_size         Size in bytes of the object on device.
+ *
+ * @return                 'true' if the object was not tracked, 'false'
+ *                         otherwise.
+ */
+bool set_device_size(std::map<void *, TrackerEntry> &memory_tracker,
+                     std::pair<size_t, size_t> &tot_memory_usage,
+                     std::map<std::string, LabelMemory> &label_memory,
+                     void *const object, const size_t dev_size);
 
 /**
  * @brief Removes an entry from the given memory tracker.
@@ -43,15 +127,18 @@ bool add_to_memory_tracker(
  * @param memory_tracker   Memory tracker to update.
  * @param tot_memory_usage Pair containing total host and device memory
  *                         usage.
+ * @param label_memory     Memory used by label, to update.
  * @param object           Pointer to dual object to be removed.
  *
  * @return                 'true' if the array was not tracked, 'false'
  *                         otherwise.
  *
  * @note If the object is not tracked, the operation is ignored.
+ * @note Shared host memory is not subtracted, since it was not counted.
  */
 bool remove_from_memory_tracker(
-    std::map<void *, std::tuple<std::string, size_t, bool>> &memory_tracker,
-    std::pair<size_t, size_t> &tot_memory_usage, void *const object);
+    std::map<void *, TrackerEntry> &memory_tracker,
+    std::pair<size_t, size_t> &tot_memory_usage,
+    std::map<std::string, LabelMemory> &label_memory, void *const object);
 
 } // namespace MiMMO
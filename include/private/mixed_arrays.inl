@@ -0,0 +1,264 @@
+/**
+ * @file mixed_arrays.inl
+ *
+ * @brief Definition of template methods for managing mixed-precision dual
+ * arrays.
+ *
+ * Implements the following DualMemoryManager methods, for dual arrays
+ * whose elements have a different type on host and device:
+ * - alloc_array()
+ * - update_array_host_to_device()
+ * - update_array_device_to_host()
+ * - free_array()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Size in bytes of the device elements converted and transferred
+ * at a time by mixed-precision transfers.
+ */
+constexpr size_t mixed_chunk_bytes = size_t(1) << 22;
+
+/**
+ * @brief Converts elements from one type to another with multiple threads.
+ *
+ * @tparam Dst          Type of destination elements.
+ * @tparam Src          Type of source elements.
+ *
+ * @param dst           Destination elements.
+ * @param src           Source elements.
+ * @param num_elements  Number of elements to be converted.
+ */
+template <typename Dst, typename Src>
+void convert_elements(Dst *const dst, const Src *const src,
+                      const size_t num_elements) {
+  host_parallel_for(num_elements, [&](const size_t begin, const size_t end) {
+    MIMMO_SIMD
+    for (size_t i = begin; i < end; i++)
+      dst[i] = static_cast<Dst>(src[i]);
+  });
+  return;
+}
+
+/**
+ * @brief Allocates a mixed-precision dual array, whose elements have a
+ * different type on host and device.
+ *
+ * @details
+ * Elements are converted during transfers, so that only device-typed
+ * elements are moved and stored on device (e.g. half the volume for
+ * double on host and float on device). Without device memory, device
+ * elements live in a separate host buffer, used by compute regions
+ * through MIMMO_GET_PTR().
+ *
+ * @tparam T         Type of elements in the array on host.
+ * @tparam D         Type of elements in the array on device.
+ *
+ * @param dual_array Dual array to be allocated.
+ * @param label      Label that should be used to track the array in
+ *                   memory.
+ * @param size       Number of elements in the array.
+ * @param on_device  Whether the array should be allocated on device as
+ *                   well.
+ */
+template <typename T, typename D>
+void DualMemoryManager::alloc_array(DualArray<T, D> &dual_array,
+                                    const std::string label, const size_t size,
+                                    const bool on_device) {
+
+  /* allocate memory on host */
+  dual_array.host_ptr = (T *)host_alloc(size, sizeof(T));
+
+  if (!(dual_array.host_ptr))
+    abort_mimmo("Failed to allocate host memory.");
+
+  /* if required, allocate device elements (on host without device) */
+  const bool dev_alloc = on_device && backend->has_device();
+  dual_array.dev_ptr = nullptr;
+
+  if (dev_alloc)
+    dual_array.dev_ptr = (D *)device_alloc(size * sizeof(D));
+  else if (on_device)
+    dual_array.dev_ptr = (D *)host_alloc(size, sizeof(D));
+
+  if (on_device && !(dual_array.dev_ptr)) {
+    host_free(dual_array.host_ptr);
+    dual_array.host_ptr = nullptr;
+    abort_mimmo("Failed to allocate memory of device elements.");
+  }
+
+  /* update number of elements and bytes */
+  dual_array.size = size;
+  dual_array.size_bytes = size * sizeof(T);
+
+  /* update memory tracker (device elements kept on host count as host
+   * memory) */
+  const size_t host_bytes =
+      dual_array.size_bytes + (on_device && !dev_alloc ? size * sizeof(D) : 0);
+
+  const bool ret = add_to_memory_tracker(
+      memory_tracker, total_memory, label_memory, (void *)&dual_array, label,
+      host_bytes, dev_alloc, false, backend->get_device());
+
+  if (ret)
+    abort_mimmo("Failed to track memory for dual array '" + label + "'.");
+
+  set_device_size(memory_tracker, total_memory, label_memory,
+                  (void *)&dual_array, size * sizeof(D));
+
+  record_memory(1, 0);
+
+  /* assign descriptor table slot */
+  register_descriptor((void *)&dual_array, (void *)dual_array.host_ptr,
+                      (void *)dual_array.dev_ptr, size);
+
+  return;
+}
+
+/**
+ * @brief Converts data of a mixed-precision dual array from host to
+ * device.
+ *
+ * @details
+ * Elements are converted on host with multiple threads, one chunk at a
+ * time, and each converted chunk is copied to device.
+ *
+ * @tparam T           Type of elements in the array on host.
+ * @tparam D           Type of elements in the array on device.
+ *
+ * @param dual_array   Dual array to synchronize.
+ * @param offset       Index of first element to be copied.
+ * @param num_elements Number of elements to be copied.
+ *
+ * @note If the array has no device elements, this function does nothing.
+ */
+template <typename T, typename D>
+void DualMemoryManager::update_array_host_to_device(
+    DualArray<T, D> &dual_array, const size_t offset,
+    const size_t num_elements) {
+
+  if (dual_array.dev_ptr == nullptr)
+    return;
+
+  /* without device memory, convert directly into device elements */
+  if (!backend->has_device()) {
+    convert_elements(dual_array.dev_ptr + offset, dual_array.host_ptr + offset,
+                     num_elements);
+    return;
+  }
+
+  const DeviceScope scope(*backend, object_device(&dual_array));
+
+  /* convert a chunk at a time in the staging buffer, then send it */
+  const size_t chunk = std::max(mixed_chunk_bytes / sizeof(D), size_t(1));
+  reserve_staging_buffers(std::min(chunk, num_elements) * sizeof(D));
+  D *const staging_ptr = (D *)staging_host_ptr;
+
+  for (size_t begin = 0; begin < num_elements; begin += chunk) {
+    const size_t count = std::min(chunk, num_elements - begin);
+    convert_elements(staging_ptr, dual_array.host_ptr + offset + begin,
+                     count);
+    copy_to_device(dual_array.dev_ptr + offset + begin, staging_ptr,
+                   count * sizeof(D));
+  }
+
+  return;
+}
+
+/**
+ * @brief Converts data of a mixed-precision dual array from device to
+ * host.
+ *
+ * @details
+ * Device elements are copied back one chunk at a time, and each chunk is
+ * converted on host with multiple threads.
+ *
+ * @tparam T           Type of elements in the array on host.
+ * @tparam D           Type of elements in the array on device.
+ *
+ * @param dual_array   Dual array to synchronize.
+ * @param offset       Index of first element to be copied.
+ * @param num_elements Number of elements to be copied.
+ *
+ * @note If the array has no device elements, this function does nothing.
+ */
+template <typename T, typename D>
+void DualMemoryManager::update_array_device_to_host(
+    DualArray<T, D> &dual_array, const size_t offset,
+    const size_t num_elements) {
+
+  if (dual_array.dev_ptr == nullptr)
+    return;
+
+  /* without device memory, convert directly from device elements */
+  if (!backend->has_device()) {
+    convert_elements(dual_array.host_ptr + offset, dual_array.dev_ptr + offset,
+                     num_elements);
+    return;
+  }
+
+  const DeviceScope scope(*backend, object_device(&dual_array));
+
+  /* receive a chunk at a time in the staging buffer, then convert it */
+  const size_t chunk = std::max(mixed_chunk_bytes / sizeof(D), size_t(1));
+  reserve_staging_buffers(std::min(chunk, num_elements) * sizeof(D));
+  D *const staging_ptr = (D *)staging_host_ptr;
+
+  for (size_t begin = 0; begin < num_elements; begin += chunk) {
+    const size_t count = std::min(chunk, num_elements - begin);
+    copy_from_device(staging_ptr, dual_array.dev_ptr + offset + begin,
+                     count * sizeof(D));
+    convert_elements(dual_array.host_ptr + offset + begin, staging_ptr,
+                     count);
+  }
+
+  return;
+}
+
+/**
+ * @brief Frees memory allocated for a mixed-precision dual array.
+ *
+ * @tparam T         Type of elements in the array on host.
+ * @tparam D         Type of elements in the array on device.
+ *
+ * @param dual_array Dual array to be freed.
+ *
+ * @note If the array is not tracked, the program aborts.
+ */
+template <typename T, typename D>
+void DualMemoryManager::free_array(DualArray<T, D> &dual_array) {
+
+  /* check that array was actually recorded */
+  const auto it = memory_tracker.find((void *)&dual_array);
+  if (it == memory_tracker.end())
+    abort_mimmo("Dual array was not found by memory manager.");
+
+  const bool on_device = it->second.on_device;
+  const int device = it->second.device;
+
+  /* update memory tracker and descriptor table */
+  unregister_descriptor(it->second.slot);
+  remove_from_memory_tracker(memory_tracker, total_memory, label_memory,
+                             (void *)&dual_array);
+  record_memory(0, 1);
+
+  /* free memory on host */
+  host_free(dual_array.host_ptr);
+  dual_array.host_ptr = nullptr;
+
+  /* free device elements, on their device or on host */
+  if (on_device)
+    device_free(dual_array.dev_ptr, device);
+  else
+    host_free(dual_array.dev_ptr);
+  dual_array.dev_ptr = nullptr;
+
+  return;
+}
+
+} // namespace MiMMO
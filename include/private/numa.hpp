@@ -0,0 +1,82 @@
+/**
+ * @file numa.hpp
+ *
+ * @brief Declaration of NUMA placement utilities for host memory.
+ *
+ * Internal utilities for placing host memory on the NUMA nodes of the
+ * system, and for querying where memory pages currently reside.
+ * Used by DualMemoryManager to allocate host memory of dual objects.
+ *
+ * @see numa.cpp for implementations
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace MiMMO {
+
+/**
+ * @brief Placement policy of host memory on NUMA nodes.
+ *
+ * @details
+ * Except for Default, host buffers are page aligned and placed through
+ * the memory policy of the kernel, which is only a hint: if the system
+ * does not support it, memory is placed as with Default.
+ */
+enum class NumaPolicy {
+  Default,    /*!< pages land where they are first touched */
+  Local,      /*!< pages are placed on the node of the allocating thread */
+  Interleave, /*!< pages are interleaved across all nodes */
+  Bind,       /*!< pages are placed on a given node */
+  FirstTouch  /*!< pages are first touched (zeroed) by the threads of the
+                   host pool, with the same partitioning as host parallel
+                   loops */
+};
+
+/**
+ * @brief Returns the name of a NUMA placement policy.
+ *
+ * @param policy NUMA placement policy.
+ *
+ * @return       Name of the policy.
+ */
+std::string numa_policy_name(const NumaPolicy policy);
+
+/**
+ * @brief Returns the number of NUMA nodes of the system.
+ *
+ * @return Number of NUMA nodes (1 if the system does not expose them).
+ */
+int numa_num_nodes();
+
+/**
+ * @brief Allocates host memory placed on NUMA nodes according to a policy.
+ *
+ * @param num_elements  Number of elements in the buffer.
+ * @param element_bytes Size in bytes of each element.
+ * @param policy        NUMA placement policy.
+ * @param node          Node on which memory is placed (Bind policy only).
+ *
+ * @return              Pointer to the buffer (nullptr if allocation
+ *                      failed). It should be freed with std::free().
+ */
+void *numa_alloc(const size_t num_elements, const size_t element_bytes,
+                 const NumaPolicy policy, const int node);
+
+/**
+ * @brief Adds the bytes of a host buffer residing on each NUMA node.
+ *
+ * @param ptr          Pointer to the buffer.
+ * @param size_bytes   Size in bytes of the buffer.
+ * @param distribution Bytes per node, updated with those of the buffer.
+ *
+ * @note Pages that were never touched reside on no node and are not
+ *       counted.
+ */
+void add_numa_distribution(const void *const ptr, const size_t size_bytes,
+                           std::vector<size_t> &distribution);
+
+} // namespace MiMMO
@@ -0,0 +1,90 @@
+/**
+ * @file numa.inl
+ *
+ * @brief Definition of methods placing host memory on NUMA nodes.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - host_alloc()
+ * - host_free()
+ * - set_numa_policy()
+ * - get_numa_policy()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Allocates host memory according to the NUMA placement policy.
+ *
+ * @param num_elements  Number of elements to be allocated.
+ * @param element_bytes Size in bytes of each element.
+ *
+ * @return              Pointer to host memory (nullptr if allocation
+ *                      failed).
+ */
+inline void *DualMemoryManager::host_alloc(const size_t num_elements,
+                                           const size_t element_bytes) {
+
+  void *const host_ptr =
+      numa_alloc(num_elements, element_bytes, numa_policy, numa_node);
+
+  /* remember buffer for the NUMA distribution */
+  if (host_ptr != nullptr)
+    host_buffers[host_ptr] = num_elements * element_bytes;
+
+  return host_ptr;
+}
+
+/**
+ * @brief Frees host memory allocated by host_alloc().
+ *
+ * @param host_ptr Pointer to host memory (nullptr is ignored).
+ */
+inline void DualMemoryManager::host_free(void *const host_ptr) {
+  host_buffers.erase(host_ptr);
+  std::free(host_ptr);
+  return;
+}
+
+/**
+ * @brief Sets the NUMA placement policy of host memory.
+ *
+ * @details
+ * The policy applies to host memory allocated afterwards by dual arrays,
+ * allocation groups and the scratch arena; existing memory is not moved.
+ * With NumaPolicy::FirstTouch, host memory of each array is zeroed at
+ * allocation by the threads of the host pool, each touching the range it
+ * works on in host parallel loops (e.g. the parallel primitives).
+ *
+ * @param policy NUMA placement policy.
+ * @param node   NUMA node on which memory is placed (NumaPolicy::Bind
+ *               only).
+ *
+ * @note If the node does not exist with NumaPolicy::Bind, the program
+ *       aborts.
+ */
+inline void DualMemoryManager::set_numa_policy(const NumaPolicy policy,
+                                               const int node) {
+
+  if (policy == NumaPolicy::Bind && (node < 0 || node >= numa_num_nodes()))
+    abort_mimmo("NUMA node " + std::to_string(node) + " does not exist.");
+
+  numa_policy = policy;
+  numa_node = node;
+
+  return;
+}
+
+/**
+ * @brief Returns the NUMA placement policy of host memory.
+ *
+ * @return Current NUMA placement policy.
+ */
+inline NumaPolicy DualMemoryManager::get_numa_policy() const {
+  return numa_policy;
+}
+
+} // namespace MiMMO
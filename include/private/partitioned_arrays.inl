@@ -0,0 +1,196 @@
+/**
+ * @file partitioned_arrays.inl
+ *
+ * @brief Definition of template methods for managing partitioned dual
+ * arrays.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - alloc_partitioned_array()
+ * - update_partitioned_array_host_to_device()
+ * - update_partitioned_array_device_to_host()
+ * - exchange_halos()
+ * - free_partitioned_array()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Allocates a dual array partitioned across devices.
+ *
+ * @tparam T                Type of elements in the array.
+ *
+ * @param partitioned_array Partitioned dual array to be allocated.
+ * @param label             Label that should be used to track the
+ *                          partitions in memory.
+ * @param size              Number of elements in the array.
+ * @param halo              Number of halo elements on each side of each
+ *                          partition.
+ * @param devices           Device of each partition (empty for one
+ *                          partition per device).
+ *
+ * @note If a device does not exist, the array has fewer elements than
+ *       partitions, or the halo is larger than a partition, the program
+ *       aborts.
+ */
+template <typename T>
+void DualMemoryManager::alloc_partitioned_array(
+    PartitionedDualArray<T> &partitioned_array, const std::string label,
+    const size_t size, const size_t halo, const std::vector<int> devices) {
+
+  /* without devices, a single partition lives on host */
+  const int available_devices = std::max(backend->num_devices(), 1);
+  std::vector<int> partition_devices = devices;
+
+  if (partition_devices.empty())
+    for (int d = 0; d < available_devices; d++)
+      partition_devices.push_back(d);
+
+  for (const int device : partition_devices)
+    if (device < 0 || device >= available_devices)
+      abort_mimmo("Device " + std::to_string(device) + " does not exist.");
+
+  /* split extent evenly (first partitions take one more element) */
+  const size_t num_partitions = partition_devices.size();
+
+  if (size < num_partitions)
+    abort_mimmo("Partitioned dual array '" + label + "' has fewer elements "
+                "than partitions.");
+
+  if (num_partitions > 1 && halo > size / num_partitions)
+    abort_mimmo("Halo of partitioned dual array '" + label +
+                "' is larger than a partition.");
+
+  partitioned_array.partitions = std::vector<DualArray<T>>(num_partitions);
+  partitioned_array.devices = partition_devices;
+  partitioned_array.first.assign(num_partitions, 0);
+  partitioned_array.offsets.assign(num_partitions + 1, size);
+  partitioned_array.size = size;
+  partitioned_array.halo = halo;
+
+  for (size_t p = 0; p < num_partitions; p++)
+    partitioned_array.offsets[p] = p * (size / num_partitions) +
+                                   std::min(p, size % num_partitions);
+
+  /* allocate each partition, with its halos, on its device */
+  for (size_t p = 0; p < num_partitions; p++) {
+    const size_t begin = partitioned_array.offsets[p];
+    const size_t end = partitioned_array.offsets[p + 1];
+    const size_t first = begin - std::min(halo, begin);
+    const size_t last = std::min(end + halo, size);
+
+    partitioned_array.first[p] = first;
+
+    const DeviceScope scope(*backend, partition_devices[p]);
+    alloc_array(partitioned_array.partitions[p],
+                label + "[" + std::to_string(p) + "]", last - first, true);
+  }
+
+  return;
+}
+
+/**
+ * @brief Copies all partitions of a partitioned dual array (halos
+ * included) from host to device.
+ *
+ * @tparam T                Type of elements in the array.
+ *
+ * @param partitioned_array Partitioned dual array to synchronize.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_partitioned_array_host_to_device(
+    PartitionedDualArray<T> &partitioned_array) {
+  for (DualArray<T> &partition : partitioned_array.partitions)
+    update_array_host_to_device(partition, 0, partition.size);
+  return;
+}
+
+/**
+ * @brief Copies all partitions of a partitioned dual array (halos
+ * included) from device to host.
+ *
+ * @tparam T                Type of elements in the array.
+ *
+ * @param partitioned_array Partitioned dual array to synchronize.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_partitioned_array_device_to_host(
+    PartitionedDualArray<T> &partitioned_array) {
+  for (DualArray<T> &partition : partitioned_array.partitions)
+    update_array_device_to_host(partition, 0, partition.size);
+  return;
+}
+
+/**
+ * @brief Refreshes halo elements of each partition with the elements
+ * owned by its neighbours.
+ *
+ * @tparam T                Type of elements in the array.
+ *
+ * @param partitioned_array Partitioned dual array whose halos should be
+ *                          exchanged.
+ * @param side              Side on which halos should be exchanged.
+ *
+ * @note Without device memory, an exchange on device is performed on
+ *       host, since compute regions work on host data.
+ */
+template <typename T>
+void DualMemoryManager::exchange_halos(
+    PartitionedDualArray<T> &partitioned_array, const Side side) {
+
+  const std::vector<size_t> &first = partitioned_array.first;
+
+  for (size_t p = 0; p + 1 < partitioned_array.partitions.size(); p++) {
+    DualArray<T> &left = partitioned_array.partitions[p];
+    DualArray<T> &right = partitioned_array.partitions[p + 1];
+    const size_t boundary = partitioned_array.offsets[p + 1];
+
+    /* halo of the right partition is owned by the left one */
+    const size_t right_halo = boundary - first[p + 1];
+    if (right_halo > 0)
+      copy_array(right, 0, left, first[p + 1] - first[p], right_halo, side);
+
+    /* halo of the left partition is owned by the right one */
+    const size_t left_halo = first[p] + left.size - boundary;
+    if (left_halo > 0)
+      copy_array(left, boundary - first[p], right, boundary - first[p + 1],
+                 left_halo, side);
+  }
+
+  return;
+}
+
+/**
+ * @brief Frees all partitions of a partitioned dual array.
+ *
+ * @tparam T                Type of elements in the array.
+ *
+ * @param partitioned_array Partitioned dual array to be freed.
+ *
+ * @note If a partition is not tracked, the program aborts.
+ */
+template <typename T>
+void DualMemoryManager::free_partitioned_array(
+    PartitionedDualArray<T> &partitioned_array) {
+
+  for (DualArray<T> &partition : partitioned_array.partitions)
+    free_array(partition);
+
+  partitioned_array.partitions.clear();
+  partitioned_array.devices.clear();
+  partitioned_array.first.clear();
+  partitioned_array.offsets.clear();
+  partitioned_array.size = 0;
+  partitioned_array.halo = 0;
+
+  return;
+}
+
+} // namespace MiMMO
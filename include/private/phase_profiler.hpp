@@ -0,0 +1,231 @@
+/**
+ * @file phase_profiler.hpp
+ *
+ * @brief Declaration of the phase profiler.
+ *
+ * The phase profiler splits the activity of the memory manager into
+ * nested named phases (e.g. solver phases): allocations, frees, peak
+ * memory and host-device transfers are charged to the innermost open
+ * phase, and reported for each phase inclusive and exclusive of its
+ * child phases.
+ *
+ * @see phase_profiler.cpp for implementations
+ * @see phase_profiler.inl for the corresponding DualMemoryManager methods
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace MiMMO {
+
+/**
+ * @brief Returns the time elapsed since a given instant.
+ *
+ * @param start Starting instant.
+ *
+ * @return      Elapsed time, in s.
+ */
+inline double
+seconds_since(const std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/**
+ * @brief Stores the counters of a phase.
+ */
+struct PhaseCounters {
+  double seconds;             /*!< wall time, in s */
+  size_t num_allocs;          /*!< number of allocated objects */
+  size_t num_frees;           /*!< number of freed objects */
+  size_t host_peak_bytes;     /*!< peak host memory used by the manager */
+  size_t dev_peak_bytes;      /*!< peak device memory used by the manager */
+  size_t to_device_count;     /*!< number of host-to-device transfers */
+  size_t to_device_bytes;     /*!< bytes copied from host to device */
+  double to_device_seconds;   /*!< time of host-to-device transfers, in s */
+  size_t from_device_count;   /*!< number of device-to-host transfers */
+  size_t from_device_bytes;   /*!< bytes copied from device to host */
+  double from_device_seconds; /*!< time of device-to-host transfers, in s */
+};
+
+/**
+ * @brief Stores the statistics of a phase.
+ */
+struct PhaseStats {
+  std::string name;        /*!< name of the phase */
+  std::string path;        /*!< names of the enclosing phases and of the
+                                phase, separated by '/' */
+  size_t depth;            /*!< nesting depth (0 for outermost phases) */
+  size_t num_calls;        /*!< number of times the phase was entered */
+  bool open;               /*!< whether the phase is still open */
+  PhaseCounters inclusive; /*!< counters including child phases */
+  PhaseCounters exclusive; /*!< counters excluding child phases (peaks
+                                are observed while no child was open) */
+};
+
+/**
+ * @brief Stores a phase of the phase tree.
+ */
+struct PhaseNode {
+  std::string name;             /*!< name of the phase */
+  size_t parent;                /*!< index of the enclosing phase */
+  std::vector<size_t> children; /*!< indices of child phases */
+  size_t num_calls;             /*!< number of times the phase was
+                                     entered */
+  bool open;                    /*!< whether the phase is open */
+  std::chrono::steady_clock::time_point
+      start;              /*!< instant of the last entry */
+  PhaseCounters counters; /*!< exclusive counters (seconds holds the
+                               inclusive time of closed calls) */
+};
+
+/**
+ * @brief Collects statistics of nested phases.
+ *
+ * @details
+ * Phases form a tree: a phase entered while another one is open becomes
+ * its child, and entering a phase with the same name under the same
+ * parent accumulates into the same node. Counters are only updated while
+ * a phase is open.
+ */
+class PhaseProfiler {
+public:
+  /**
+   * @brief Class constructor.
+   */
+  PhaseProfiler();
+
+  /**
+   * @brief Returns whether a phase is open.
+   *
+   * @return 'true' if at least one phase is open.
+   */
+  bool active() const { return stack.size() > 1; }
+
+  /**
+   * @brief Opens a phase, as child of the innermost open phase.
+   *
+   * @param name   Name of the phase.
+   * @param memory Host and device memory used by the manager.
+   */
+  void begin(const std::string &name, const std::pair<size_t, size_t> &memory);
+
+  /**
+   * @brief Closes the innermost open phase.
+   *
+   * @param name   Name of the phase.
+   * @param memory Host and device memory used by the manager.
+   *
+   * @note If no phase is open or the innermost one has a different name,
+   *       the program aborts.
+   */
+  void end(const std::string &name, const std::pair<size_t, size_t> &memory);
+
+  /**
+   * @brief Records allocations and frees in the innermost open phase.
+   *
+   * @param num_allocs Number of allocated objects.
+   * @param num_frees  Number of freed objects.
+   * @param memory     Host and device memory used by the manager
+   *                   afterwards.
+   */
+  void record_memory(const size_t num_allocs, const size_t num_frees,
+                     const std::pair<size_t, size_t> &memory) {
+    if (!active())
+      return;
+
+    PhaseCounters &counters = nodes[stack.back()].counters;
+    counters.num_allocs += num_allocs;
+    counters.num_frees += num_frees;
+    counters.host_peak_bytes = std::max(counters.host_peak_bytes, memory.first);
+    counters.dev_peak_bytes = std::max(counters.dev_peak_bytes, memory.second);
+    return;
+  }
+
+  /**
+   * @brief Records a transfer in the innermost open phase.
+   *
+   * @param to_device  Whether data was copied from host to device (or the
+   *                   other way round).
+   * @param size_bytes Number of bytes copied.
+   * @param seconds    Time of the transfer, in s.
+   */
+  void record_transfer(const bool to_device, const size_t size_bytes,
+                       const double seconds) {
+    if (!active())
+      return;
+
+    PhaseCounters &counters = nodes[stack.back()].counters;
+    if (to_device) {
+      counters.to_device_count++;
+      counters.to_device_bytes += size_bytes;
+      counters.to_device_seconds += seconds;
+    } else {
+      counters.from_device_count++;
+      counters.from_device_bytes += size_bytes;
+      counters.from_device_seconds += seconds;
+    }
+    return;
+  }
+
+  /**
+   * @brief Returns the statistics of all phases.
+   *
+   * @details
+   * Open phases are included, with their time up to now.
+   *
+   * @return Statistics of each phase, in depth-first order.
+   */
+  std::vector<PhaseStats> stats() const;
+
+  /**
+   * @brief Returns the statistics of all phases as a JSON document.
+   *
+   * @return JSON object with the tree of phases.
+   */
+  std::string json() const;
+
+  /**
+   * @brief Prints the statistics of all phases as an indented table.
+   */
+  void report() const;
+
+  /**
+   * @brief Forgets all phases.
+   *
+   * @note If a phase is open, the program aborts.
+   */
+  void reset();
+
+private:
+  std::vector<PhaseNode> nodes; /*!< phase tree (node 0 is a root holding
+                                     outermost phases) */
+  std::vector<size_t> stack;    /*!< indices of open phases, from the
+                                     root */
+
+  /**
+   * @brief Computes inclusive counters of a subtree and appends the
+   * statistics of its phases.
+   *
+   * @param node  Index of the root of the subtree.
+   * @param depth Nesting depth of the node.
+   * @param path  Path of the enclosing phases.
+   * @param now   Instant at which open phases are measured.
+   * @param stats Statistics to which phases are appended.
+   *
+   * @return      Inclusive counters of the node.
+   */
+  PhaseCounters
+  collect(const size_t node, const size_t depth, const std::string &path,
+          const std::chrono::steady_clock::time_point now,
+          std::vector<PhaseStats> &stats) const;
+};
+
+} // namespace MiMMO
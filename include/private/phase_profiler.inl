@@ -0,0 +1,82 @@
+/**
+ * @file phase_profiler.inl
+ *
+ * @brief Definition of methods for profiling nested phases.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - begin_phase()
+ * - end_phase()
+ * - return_phase_stats()
+ * - return_phase_report_json()
+ * - report_phases()
+ * - reset_phases()
+ *
+ * @see api.hpp for the corresponding declarations
+ * @see phase_profiler.cpp for the phase tree
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Opens a phase, nested in the innermost open phase.
+ *
+ * @param name Name of the phase.
+ */
+inline void DualMemoryManager::begin_phase(const std::string &name) {
+  require_phase_prefetches(name);
+  phases.begin(name, total_memory);
+  return;
+}
+
+/**
+ * @brief Closes the innermost open phase.
+ *
+ * @param name Name of the phase.
+ *
+ * @note If no phase is open or the innermost one has a different name,
+ *       the program aborts.
+ */
+inline void DualMemoryManager::end_phase(const std::string &name) {
+  phases.end(name, total_memory);
+  return;
+}
+
+/**
+ * @brief Returns the statistics of all phases.
+ *
+ * @return Statistics of each phase, in depth-first order.
+ */
+inline std::vector<PhaseStats> DualMemoryManager::return_phase_stats() {
+  return phases.stats();
+}
+
+/**
+ * @brief Returns the statistics of all phases as a JSON document.
+ *
+ * @return JSON object with the tree of phases.
+ */
+inline std::string DualMemoryManager::return_phase_report_json() {
+  return phases.json();
+}
+
+/**
+ * @brief Prints the statistics of all phases to standard output.
+ */
+inline void DualMemoryManager::report_phases() {
+  phases.report();
+  return;
+}
+
+/**
+ * @brief Forgets the statistics of all phases.
+ *
+ * @note If a phase is open, the program aborts.
+ */
+inline void DualMemoryManager::reset_phases() {
+  phases.reset();
+  return;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,56 @@
+/**
+ * @file prefetch.hpp
+ *
+ * @brief Declaration of the structures of residency prefetches.
+ *
+ * Prefetches are hints that data will soon be needed on one side: the
+ * transfer is enqueued right away on a dedicated queue, so that it runs
+ * in the background, and require() only blocks if it has not finished
+ * by the time the data is used. Prefetches can also be declared ahead of
+ * a phase, and are then required when the phase begins.
+ *
+ * @see prefetch.inl for the corresponding DualMemoryManager methods
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace MiMMO {
+
+/**
+ * @brief Asynchronous queue of prefetches.
+ */
+constexpr int prefetch_queue = 1 << 22;
+
+/**
+ * @brief Stores a prefetch in flight.
+ */
+struct PrefetchEntry {
+  const void *object;  /*!< address of the prefetched object */
+  size_t offset_bytes; /*!< offset in bytes of the prefetched range */
+  size_t size_bytes;   /*!< size in bytes of the prefetched range */
+  bool to_device;      /*!< whether data is copied to device (or host) */
+  int device;          /*!< device of the object, and of the queue */
+  bool complete;       /*!< whether the transfer is known to be done */
+};
+
+/**
+ * @brief Stores statistics of prefetches.
+ */
+struct PrefetchStats {
+  size_t num_prefetches;    /*!< number of prefetches issued */
+  size_t prefetch_bytes;    /*!< bytes copied by prefetches */
+  size_t num_hits;          /*!< requirements met by a finished
+                                 prefetch */
+  size_t num_late;          /*!< requirements that waited for a
+                                 prefetch */
+  size_t num_misses;        /*!< requirements without prefetch, copied
+                                 synchronously */
+  size_t num_unused;        /*!< prefetches of objects freed before
+                                 being required */
+  double late_wait_seconds; /*!< time spent waiting for late
+                                 prefetches */
+};
+
+} // namespace MiMMO
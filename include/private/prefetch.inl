@@ -0,0 +1,306 @@
+/**
+ * @file prefetch.inl
+ *
+ * @brief Definition of methods for residency prefetches.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - mark_prefetches_complete()
+ * - consume_prefetches()
+ * - drop_prefetches()
+ * - require_phase_prefetches()
+ * - prefetch_to_device()
+ * - prefetch_to_host()
+ * - require()
+ * - next_phase_uses()
+ * - return_prefetch_stats()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Marks the prefetches of a device as complete.
+ *
+ * @param device Device whose prefetch queue is idle.
+ */
+inline void DualMemoryManager::mark_prefetches_complete(const int device) {
+  for (PrefetchEntry &entry : prefetches)
+    if (entry.device == device)
+      entry.complete = true;
+  return;
+}
+
+/**
+ * @brief Completes the prefetches of an object overlapping a range,
+ * waiting for them if they are still in flight.
+ *
+ * @param object       Address of the object.
+ * @param to_device    Whether data is needed on device (or host).
+ * @param offset_bytes Offset in bytes of the needed range.
+ * @param size_bytes   Size in bytes of the needed range.
+ *
+ * @return             Whether prefetches covered the whole range (counted
+ *                     as a hit or as late).
+ */
+inline bool DualMemoryManager::consume_prefetches(const void *const object,
+                                                  const bool to_device,
+                                                  const size_t offset_bytes,
+                                                  const size_t size_bytes) {
+
+  const auto overlaps = [&](const PrefetchEntry &entry) {
+    return entry.object == object && entry.to_device == to_device &&
+           entry.offset_bytes < offset_bytes + size_bytes &&
+           offset_bytes < entry.offset_bytes + entry.size_bytes;
+  };
+
+  std::vector<std::pair<size_t, size_t>> ranges;
+  bool pending = false;
+  int device = 0;
+
+  for (const PrefetchEntry &entry : prefetches) {
+    if (!overlaps(entry))
+      continue;
+    ranges.push_back({entry.offset_bytes, entry.size_bytes});
+    pending = pending || !entry.complete;
+    device = entry.device;
+  }
+
+  if (ranges.empty())
+    return false;
+
+  /* check whether the ranges cover the needed one */
+  std::sort(ranges.begin(), ranges.end());
+  size_t covered_end = offset_bytes;
+  for (const auto &[range_offset, range_size] : ranges) {
+    if (range_offset > covered_end)
+      break;
+    covered_end = std::max(covered_end, range_offset + range_size);
+  }
+  const bool covered = covered_end >= offset_bytes + size_bytes;
+
+  /* wait only for prefetches that are still in flight */
+  const DeviceScope scope(*backend, device);
+  bool late = false;
+
+  if (pending && !backend->test(prefetch_queue)) {
+    const auto start = std::chrono::steady_clock::now();
+    backend->wait(prefetch_queue);
+    const std::chrono::duration<double> waited =
+        std::chrono::steady_clock::now() - start;
+
+    late = true;
+    if (covered)
+      prefetch_stats.late_wait_seconds += waited.count();
+  }
+
+  if (pending)
+    mark_prefetches_complete(device);
+
+  if (covered)
+    (late ? prefetch_stats.num_late : prefetch_stats.num_hits)++;
+
+  prefetches.erase(
+      std::remove_if(prefetches.begin(), prefetches.end(), overlaps),
+      prefetches.end());
+
+  return covered;
+}
+
+/**
+ * @brief Drops the prefetches of an object being freed, waiting for
+ * those still in flight.
+ *
+ * @param object Pointer to the object.
+ */
+inline void DualMemoryManager::drop_prefetches(const void *const object) {
+
+  for (auto &[phase, entries] : phase_prefetches)
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [object](const PrefetchEntry &entry) {
+                                   return entry.object == object;
+                                 }),
+                  entries.end());
+
+  for (const PrefetchEntry &entry : prefetches) {
+    if (entry.object != object)
+      continue;
+
+    /* memory must not be released under an enqueued copy */
+    if (!entry.complete) {
+      const DeviceScope scope(*backend, entry.device);
+      backend->wait(prefetch_queue);
+      mark_prefetches_complete(entry.device);
+    }
+
+    prefetch_stats.num_unused++;
+  }
+
+  prefetches.erase(std::remove_if(prefetches.begin(), prefetches.end(),
+                                  [object](const PrefetchEntry &entry) {
+                                    return entry.object == object;
+                                  }),
+                   prefetches.end());
+
+  return;
+}
+
+/**
+ * @brief Requires the prefetches declared for a phase.
+ *
+ * @param name Name of the phase.
+ */
+inline void
+DualMemoryManager::require_phase_prefetches(const std::string &name) {
+
+  const auto it = phase_prefetches.find(name);
+
+  if (it == phase_prefetches.end())
+    return;
+
+  for (const PrefetchEntry &entry : it->second)
+    consume_prefetches(entry.object, entry.to_device, entry.offset_bytes,
+                       entry.size_bytes);
+
+  phase_prefetches.erase(it);
+
+  return;
+}
+
+/**
+ * @brief Enqueues a copy of data from host to device in the background.
+ *
+ * @tparam T           Type of elements in the array.
+ *
+ * @param dual_array   Dual array to synchronize.
+ * @param offset       Index of first element to be copied.
+ * @param num_elements Number of elements to be copied.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::prefetch_to_device(DualArray<T> &dual_array,
+                                           const size_t offset,
+                                           const size_t num_elements) {
+
+  update_array_host_to_device_async(dual_array, offset, num_elements,
+                                    prefetch_queue);
+
+  if (!backend->has_device())
+    return;
+
+  prefetches.push_back({&dual_array, offset * sizeof(T),
+                        num_elements * sizeof(T), true,
+                        object_device(&dual_array), false});
+  prefetch_stats.num_prefetches++;
+  prefetch_stats.prefetch_bytes += num_elements * sizeof(T);
+
+  return;
+}
+
+/**
+ * @brief Enqueues a copy of data from device to host in the background.
+ *
+ * @tparam T           Type of elements in the array.
+ *
+ * @param dual_array   Dual array to synchronize.
+ * @param offset       Index of first element to be copied.
+ * @param num_elements Number of elements to be copied.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::prefetch_to_host(DualArray<T> &dual_array,
+                                         const size_t offset,
+                                         const size_t num_elements) {
+
+  update_array_device_to_host_async(dual_array, offset, num_elements,
+                                    prefetch_queue);
+
+  if (!backend->has_device())
+    return;
+
+  prefetches.push_back({&dual_array, offset * sizeof(T),
+                        num_elements * sizeof(T), false,
+                        object_device(&dual_array), false});
+  prefetch_stats.num_prefetches++;
+  prefetch_stats.prefetch_bytes += num_elements * sizeof(T);
+
+  return;
+}
+
+/**
+ * @brief Makes sure that data is up to date on one side before it is
+ * used.
+ *
+ * @tparam T           Type of elements in the array.
+ *
+ * @param dual_array   Dual array to be used.
+ * @param side         Side on which data is used.
+ * @param offset       Index of first element to be used.
+ * @param num_elements Number of elements to be used.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::require(DualArray<T> &dual_array, const Side side,
+                                const size_t offset,
+                                const size_t num_elements) {
+
+  if (!backend->has_device())
+    return;
+
+  const bool to_device = side == Side::Device;
+
+  if (consume_prefetches(&dual_array, to_device, offset * sizeof(T),
+                         num_elements * sizeof(T)))
+    return;
+
+  /* not prefetched: copy synchronously */
+  prefetch_stats.num_misses++;
+
+  if (to_device)
+    update_array_host_to_device(dual_array, offset, num_elements);
+  else
+    update_array_device_to_host(dual_array, offset, num_elements);
+
+  return;
+}
+
+/**
+ * @brief Prefetches whole dual arrays to device for a phase, and requires
+ * them when the phase begins.
+ *
+ * @tparam T     Types of elements in the arrays.
+ *
+ * @param phase  Name of the phase.
+ * @param arrays Dual arrays used on device by the phase.
+ */
+template <typename... T>
+void DualMemoryManager::next_phase_uses(const std::string &phase,
+                                        DualArray<T> &...arrays) {
+
+  (prefetch_to_device(arrays, 0, arrays.size), ...);
+
+  if (!backend->has_device())
+    return;
+
+  (phase_prefetches[phase].push_back(
+       {&arrays, 0, arrays.size_bytes, true, object_device(&arrays), false}),
+   ...);
+
+  return;
+}
+
+/**
+ * @brief Returns statistics of prefetches.
+ *
+ * @return Numbers of prefetches, hits, late prefetches and misses.
+ */
+inline PrefetchStats DualMemoryManager::return_prefetch_stats() {
+  return prefetch_stats;
+}
+
+} // namespace MiMMO
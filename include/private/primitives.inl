@@ -0,0 +1,736 @@
+/**
+ * @file primitives.inl
+ *
+ * @brief Definition of parallel primitives on dual arrays.
+ *
+ * Implements the following functions:
+ * - fill()
+ * - iota()
+ * - copy()
+ * - transform()
+ * - reduce()
+ * - dot()
+ * - axpy()
+ * - inclusive_scan()
+ * - exclusive_scan()
+ * - spmv()
+ * - popcount()
+ * - any()
+ * - all()
+ *
+ * With OpenACC, primitives run on device through gang/vector loops.
+ * Without OpenACC, they run on host through multithreaded loops whose
+ * bodies are written to be vectorized by the compiler.
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Vector length used by primitives on device.
+ */
+constexpr int primitives_vector_length = 256;
+
+/**
+ * @brief Number of elements scanned sequentially by each device thread.
+ */
+constexpr size_t scan_block_size = 512;
+
+/**
+ * @brief Returns the pointer primitives should work on.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be accessed.
+ *
+ * @return           Device pointer if OpenACC is enabled, host pointer
+ *                   otherwise.
+ *
+ * @note If the pointer is a null pointer, the program aborts.
+ */
+template <typename T> T *get_compute_ptr(const DualArray<T> &dual_array) {
+
+  T *const ptr = MIMMO_GET_PTR(dual_array);
+
+  if (ptr == nullptr) {
+#ifdef _OPENACC
+    abort_mimmo("Device pointer of dual array is a null pointer.");
+#else
+    abort_mimmo("Host pointer of dual array is a null pointer.");
+#endif // _OPENACC
+  }
+
+  return ptr;
+}
+
+/**
+ * @brief Returns the pointer primitives should write to.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be written.
+ *
+ * @return           Device pointer if OpenACC is enabled, host pointer
+ *                   otherwise.
+ *
+ * @note If the pointer is a null pointer, or host memory is shared and
+ *       read-only in this process, the program aborts.
+ */
+template <typename T> T *get_output_ptr(const DualArray<T> &dual_array) {
+
+  T *const ptr = get_compute_ptr(dual_array);
+
+  if (ptr == dual_array.host_ptr && is_read_only_shared(ptr))
+    abort_mimmo("Host memory of shared dual array is read-only and cannot "
+                "be written.");
+
+  return ptr;
+}
+
+/**
+ * @brief Checks that two dual arrays have the same number of elements.
+ *
+ * @tparam T     Type of elements in the arrays.
+ *
+ * @param first  First dual array.
+ * @param second Second dual array.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T>
+void check_same_size(const DualArray<T> &first, const DualArray<T> &second) {
+  if (first.size != second.size)
+    abort_mimmo("Sizes of dual arrays do not match (" +
+                std::to_string(first.size) + " and " +
+                std::to_string(second.size) + ").");
+  return;
+}
+
+/**
+ * @brief Stores a reduction result into a dual scalar, on both sides.
+ *
+ * @tparam T     Type of the scalar variable.
+ *
+ * @param result Dual scalar receiving the result.
+ * @param value  Result of the reduction.
+ */
+template <typename T>
+void store_reduction_result(DualScalar<T> &result, const T value) {
+
+  result.host_value = value;
+
+#ifdef _OPENACC
+  if (result.dev_ptr != nullptr)
+    acc_memcpy_to_device(result.dev_ptr, &result.host_value, sizeof(T));
+#else
+  /* emulated device memory is addressable from host */
+  if (result.dev_ptr != nullptr)
+    *(result.dev_ptr) = value;
+#endif // _OPENACC
+
+  return;
+}
+
+/**
+ * @brief Sums a range of elements (or of products of elements) on host.
+ *
+ * @details
+ * Independent partial sums are kept, so that the loop can be vectorized
+ * without reassociating floating point operations.
+ *
+ * @tparam T    Type of elements.
+ *
+ * @param first First range.
+ * @param second Second range (nullptr to sum elements of the first one).
+ * @param begin Index of first element.
+ * @param end   Index past last element.
+ *
+ * @return      Sum of the elements in the range.
+ */
+template <typename T>
+T host_range_sum(const T *const first, const T *const second,
+                 const size_t begin, const size_t end) {
+
+  constexpr size_t lanes = 8;
+  T partial[lanes] = {};
+  size_t i = begin;
+
+  if (second == nullptr) {
+    for (; i + lanes <= end; i += lanes)
+      for (size_t k = 0; k < lanes; k++)
+        partial[k] += first[i + k];
+    for (; i < end; i++)
+      partial[0] += first[i];
+  } else {
+    for (; i + lanes <= end; i += lanes)
+      for (size_t k = 0; k < lanes; k++)
+        partial[k] += first[i + k] * second[i + k];
+    for (; i < end; i++)
+      partial[0] += first[i] * second[i];
+  }
+
+  T sum = T(0);
+  for (size_t k = 0; k < lanes; k++)
+    sum += partial[k];
+
+  return sum;
+}
+
+/**
+ * @brief Sums all elements (or products of elements) of dual arrays.
+ *
+ * @tparam T     Type of elements in the arrays.
+ *
+ * @param first  First dual array.
+ * @param second Second dual array (nullptr to sum elements of the first
+ *               one).
+ *
+ * @return       Sum of the elements.
+ */
+template <typename T>
+T parallel_sum(const DualArray<T> &first, const DualArray<T> *const second) {
+
+  const T *const a = get_compute_ptr(first);
+  const T *const b = (second == nullptr) ? nullptr : get_compute_ptr(*second);
+  const size_t size = first.size;
+  T sum = T(0);
+
+#ifdef _OPENACC
+  if (b == nullptr) {
+#pragma acc parallel loop gang vector vector_length(primitives_vector_length) \
+    reduction(+ : sum) deviceptr(a)
+    for (size_t i = 0; i < size; i++)
+      sum += a[i];
+  } else {
+#pragma acc parallel loop gang vector vector_length(primitives_vector_length) \
+    reduction(+ : sum) deviceptr(a, b)
+    for (size_t i = 0; i < size; i++)
+      sum += a[i] * b[i];
+  }
+#else
+  const size_t num_chunks = host_num_chunks(size);
+  const size_t chunk = (size + num_chunks - 1) / num_chunks;
+  std::vector<T> partial(num_chunks, T(0));
+
+  parallel_for_chunks(num_chunks, [&](const size_t c) {
+    const size_t begin = std::min(c * chunk, size);
+    const size_t end = std::min(begin + chunk, size);
+    partial[c] = host_range_sum(a, b, begin, end);
+  });
+
+  for (size_t c = 0; c < num_chunks; c++)
+    sum += partial[c];
+#endif // _OPENACC
+
+  return sum;
+}
+
+/**
+ * @brief Computes an inclusive or exclusive prefix sum.
+ *
+ * @details
+ * Elements are split into blocks: block sums are computed in parallel,
+ * scanned, and used as offsets for a second parallel pass over the
+ * blocks.
+ *
+ * @tparam T        Type of elements in the arrays.
+ *
+ * @param dst       Dual array receiving the prefix sums.
+ * @param src       Dual array to be scanned.
+ * @param init      Initial value of the sums.
+ * @param inclusive Whether each sum includes the corresponding element.
+ */
+template <typename T>
+void parallel_scan(DualArray<T> &dst, const DualArray<T> &src, const T init,
+                   const bool inclusive) {
+
+  check_same_size(dst, src);
+
+  T *const d = get_output_ptr(dst);
+  const T *const s = get_compute_ptr(src);
+  const size_t size = src.size;
+
+  if (size == 0)
+    return;
+
+#ifdef _OPENACC
+  const size_t num_blocks = (size + scan_block_size - 1) / scan_block_size;
+  T *const block_sums = (T *)acc_malloc(num_blocks * sizeof(T));
+
+  if (!block_sums)
+    abort_mimmo("Failed to allocate device memory.");
+
+  /* sum each block */
+#pragma acc parallel loop gang vector vector_length(primitives_vector_length) \
+    deviceptr(s, block_sums)
+  for (size_t b = 0; b < num_blocks; b++) {
+    const size_t end = (b + 1) * scan_block_size < size
+                           ? (b + 1) * scan_block_size
+                           : size;
+    T sum = T(0);
+    for (size_t i = b * scan_block_size; i < end; i++)
+      sum += s[i];
+    block_sums[b] = sum;
+  }
+
+  /* scan block sums */
+#pragma acc serial deviceptr(block_sums)
+  {
+    T offset = init;
+    for (size_t b = 0; b < num_blocks; b++) {
+      const T value = block_sums[b];
+      block_sums[b] = offset;
+      offset += value;
+    }
+  }
+
+  /* scan each block starting from its offset */
+#pragma acc parallel loop gang vector vector_length(primitives_vector_length) \
+    deviceptr(s, d, block_sums)
+  for (size_t b = 0; b < num_blocks; b++) {
+    const size_t end = (b + 1) * scan_block_size < size
+                           ? (b + 1) * scan_block_size
+                           : size;
+    T sum = block_sums[b];
+    for (size_t i = b * scan_block_size; i < end; i++) {
+      const T value = s[i];
+      if (inclusive) {
+        sum += value;
+        d[i] = sum;
+      } else {
+        d[i] = sum;
+        sum += value;
+      }
+    }
+  }
+
+  acc_free(block_sums);
+#else
+  const size_t num_chunks = host_num_chunks(size);
+  const size_t chunk = (size + num_chunks - 1) / num_chunks;
+  std::vector<T> offsets(num_chunks, T(0));
+
+  /* sum each chunk (not needed for a single chunk) */
+  if (num_chunks > 1)
+    parallel_for_chunks(num_chunks, [&](const size_t c) {
+      const size_t begin = std::min(c * chunk, size);
+      const size_t end = std::min(begin + chunk, size);
+      offsets[c] = host_range_sum(s, (const T *)nullptr, begin, end);
+    });
+
+  /* scan chunk sums */
+  T offset = init;
+  for (size_t c = 0; c < num_chunks; c++) {
+    const T value = offsets[c];
+    offsets[c] = offset;
+    offset += value;
+  }
+
+  /* scan each chunk starting from its offset */
+  parallel_for_chunks(num_chunks, [&](const size_t c) {
+    const size_t begin = std::min(c * chunk, size);
+    const size_t end = std::min(begin + chunk, size);
+    T sum = offsets[c];
+    if (inclusive) {
+      for (size_t i = begin; i < end; i++) {
+        sum += s[i];
+        d[i] = sum;
+      }
+    } else {
+      for (size_t i = begin; i < end; i++) {
+        const T value = s[i];
+        d[i] = sum;
+        sum += value;
+      }
+    }
+  });
+#endif // _OPENACC
+
+  return;
+}
+
+/**
+ * @brief Sets all elements of a dual array to a value.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be filled.
+ * @param value      Value to be assigned.
+ */
+template <typename T> void fill(DualArray<T> &dual_array, const T value) {
+
+  T *const ptr = get_output_ptr(dual_array);
+  const size_t size = dual_array.size;
+
+#ifdef _OPENACC
+#pragma acc parallel loop gang vector vector_length(primitives_vector_length) \
+    deviceptr(ptr)
+  for (size_t i = 0; i < size; i++)
+    ptr[i] = value;
+#else
+  host_parallel_for(size, [=](const size_t begin, const size_t end) {
+    MIMMO_SIMD
+    for (size_t i = begin; i < end; i++)
+      ptr[i] = value;
+  });
+#endif // _OPENACC
+
+  return;
+}
+
+/**
+ * @brief Sets elements of a dual array to consecutive values.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be filled.
+ * @param start      Value of the first element.
+ */
+template <typename T> void iota(DualArray<T> &dual_array, const T start) {
+
+  T *const ptr = get_output_ptr(dual_array);
+  const size_t size = dual_array.size;
+
+#ifdef _OPENACC
+#pragma acc parallel loop gang vector vector_length(primitives_vector_length) \
+    deviceptr(ptr)
+  for (size_t i = 0; i < size; i++)
+    ptr[i] = start + static_cast<T>(i);
+#else
+  host_parallel_for(size, [=](const size_t begin, const size_t end) {
+    MIMMO_SIMD
+    for (size_t i = begin; i < end; i++)
+      ptr[i] = start + static_cast<T>(i);
+  });
+#endif // _OPENACC
+
+  return;
+}
+
+/**
+ * @brief Copies all elements of a dual array into another one.
+ *
+ * @tparam T  Type of elements in the arrays.
+ *
+ * @param dst Destination dual array.
+ * @param src Source dual array.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T> void copy(DualArray<T> &dst, const DualArray<T> &src) {
+
+  check_same_size(dst, src);
+
+  T *const d = get_output_ptr(dst);
+  const T *const s = get_compute_ptr(src);
+
+  if (d == s || src.size == 0)
+    return;
+
+#ifdef _OPENACC
+  acc_memcpy_device(d, (void *)s, src.size * sizeof(T));
+#else
+  parallel_memcpy(d, s, src.size * sizeof(T));
+#endif // _OPENACC
+
+  return;
+}
+
+/**
+ * @brief Applies an operation to each element of a dual array.
+ *
+ * @tparam T  Type of elements in the arrays.
+ * @tparam F  Type of the operation.
+ *
+ * @param dst Dual array receiving the results (can be src).
+ * @param src Dual array to be transformed.
+ * @param op  Operation taking an element and returning its result.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T, typename F>
+void transform(DualArray<T> &dst, const DualArray<T> &src, F op) {
+
+  check_same_size(dst, src);
+
+  T *const d = get_output_ptr(dst);
+  const T *const s = get_compute_ptr(src);
+  const size_t size = src.size;
+
+#ifdef _OPENACC
+#pragma acc parallel loop gang vector vector_length(primitives_vector_length) \
+    deviceptr(d, s)
+  for (size_t i = 0; i < size; i++)
+    d[i] = op(s[i]);
+#else
+  host_parallel_for(size, [=](const size_t begin, const size_t end) {
+    MIMMO_SIMD
+    for (size_t i = begin; i < end; i++)
+      d[i] = op(s[i]);
+  });
+#endif // _OPENACC
+
+  return;
+}
+
+/**
+ * @brief Sums all elements of a dual array into a dual scalar.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param result     Dual scalar receiving the sum (on host and, if
+ *                   present, on device).
+ * @param dual_array Dual array to be reduced.
+ */
+template <typename T>
+void reduce(DualScalar<T> &result, const DualArray<T> &dual_array) {
+  store_reduction_result(result, parallel_sum<T>(dual_array, nullptr));
+  return;
+}
+
+/**
+ * @brief Computes the scalar product of two dual arrays into a dual
+ * scalar.
+ *
+ * @tparam T     Type of elements in the arrays.
+ *
+ * @param result Dual scalar receiving the product (on host and, if
+ *               present, on device).
+ * @param first  First dual array.
+ * @param second Second dual array.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T>
+void dot(DualScalar<T> &result, const DualArray<T> &first,
+         const DualArray<T> &second) {
+  check_same_size(first, second);
+  store_reduction_result(result, parallel_sum(first, &second));
+  return;
+}
+
+/**
+ * @brief Adds a scaled dual array to another one (y = alpha * x + y).
+ *
+ * @tparam T    Type of elements in the arrays.
+ *
+ * @param y     Dual array to be updated.
+ * @param alpha Scaling factor.
+ * @param x     Dual array to be scaled and added.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T>
+void axpy(DualArray<T> &y, const T alpha, const DualArray<T> &x) {
+
+  check_same_size(y, x);
+
+  T *const py = get_output_ptr(y);
+  const T *const px = get_compute_ptr(x);
+  const size_t size = x.size;
+
+#ifdef _OPENACC
+#pragma acc parallel loop gang vector vector_length(primitives_vector_length) \
+    deviceptr(py, px)
+  for (size_t i = 0; i < size; i++)
+    py[i] += alpha * px[i];
+#else
+  host_parallel_for(size, [=](const size_t begin, const size_t end) {
+    MIMMO_SIMD
+    for (size_t i = begin; i < end; i++)
+      py[i] += alpha * px[i];
+  });
+#endif // _OPENACC
+
+  return;
+}
+
+/**
+ * @brief Computes the inclusive prefix sum of a dual array.
+ *
+ * @tparam T  Type of elements in the arrays.
+ *
+ * @param dst Dual array receiving the prefix sums (can be src).
+ * @param src Dual array to be scanned.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T>
+void inclusive_scan(DualArray<T> &dst, const DualArray<T> &src) {
+  parallel_scan(dst, src, T(0), true);
+  return;
+}
+
+/**
+ * @brief Computes the exclusive prefix sum of a dual array.
+ *
+ * @tparam T   Type of elements in the arrays.
+ *
+ * @param dst  Dual array receiving the prefix sums (can be src).
+ * @param src  Dual array to be scanned.
+ * @param init Value of the first sum.
+ *
+ * @note If sizes differ, the program aborts.
+ */
+template <typename T>
+void exclusive_scan(DualArray<T> &dst, const DualArray<T> &src,
+                    const T init) {
+  parallel_scan(dst, src, init, false);
+  return;
+}
+
+/**
+ * @brief Multiplies a sparse matrix by a dual array (y = A x).
+ *
+ * @details
+ * Each row is computed by one device thread with OpenACC, and rows are
+ * split among host threads otherwise.
+ *
+ * @tparam T     Type of matrix values and array elements.
+ * @tparam Index Type of column indices and row offsets.
+ *
+ * @param y      Dual array receiving the product (one element per row).
+ * @param matrix Sparse matrix.
+ * @param x      Dual array to be multiplied (one element per column).
+ *
+ * @note If sizes do not match the matrix, the program aborts.
+ */
+template <typename T, typename Index>
+void spmv(DualArray<T> &y, const DualCSR<T, Index> &matrix,
+          const DualArray<T> &x) {
+
+  if (y.size != matrix.num_rows || x.size != matrix.num_cols)
+    abort_mimmo("Sizes of dual arrays do not match the sparse matrix.");
+
+  const size_t num_rows = matrix.num_rows;
+
+  if (num_rows == 0)
+    return;
+
+  T *const py = get_output_ptr(y);
+  const T *const px = x.size > 0 ? get_compute_ptr(x) : nullptr;
+  const T *const values = get_compute_ptr(matrix.values);
+  const Index *const col_idx = get_compute_ptr(matrix.col_idx);
+  const Index *const row_ptr = get_compute_ptr(matrix.row_ptr);
+
+#ifdef _OPENACC
+#pragma acc parallel loop gang vector vector_length(primitives_vector_length) \
+    deviceptr(py, px, values, col_idx, row_ptr)
+  for (size_t r = 0; r < num_rows; r++) {
+    T sum = T(0);
+    for (Index k = row_ptr[r]; k < row_ptr[r + 1]; k++)
+      sum += values[k] * px[col_idx[k]];
+    py[r] = sum;
+  }
+#else
+  host_parallel_for(num_rows, [=](const size_t begin, const size_t end) {
+    for (size_t r = begin; r < end; r++) {
+      T sum = T(0);
+      for (Index k = row_ptr[r]; k < row_ptr[r + 1]; k++)
+        sum += values[k] * px[col_idx[k]];
+      py[r] = sum;
+    }
+  });
+#endif // _OPENACC
+
+  return;
+}
+
+/**
+ * @brief Counts the bits set in a bit-packed dual array.
+ *
+ * @details
+ * Bits past the size in the last word are ignored.
+ *
+ * @param bit_array Bit-packed dual array to be counted.
+ *
+ * @return          Number of bits set.
+ */
+inline size_t count_bits(const DualBitArray &bit_array) {
+
+  const size_t num_words = bit_array.words.size;
+
+  if (num_words == 0)
+    return 0;
+
+  const uint64_t *const words = get_compute_ptr(bit_array.words);
+  const size_t tail = bit_array.size % bits_per_word;
+  const uint64_t last_mask =
+      tail == 0 ? ~uint64_t(0) : (uint64_t(1) << tail) - 1;
+  size_t count = 0;
+
+#ifdef _OPENACC
+#pragma acc parallel loop gang vector vector_length(primitives_vector_length) \
+    reduction(+ : count) deviceptr(words)
+  for (size_t w = 0; w < num_words; w++)
+    count += count_word_bits(w + 1 == num_words ? words[w] & last_mask
+                                                : words[w]);
+#else
+  const size_t num_chunks = host_num_chunks(num_words);
+  const size_t chunk = (num_words + num_chunks - 1) / num_chunks;
+  std::vector<size_t> partial(num_chunks, 0);
+
+  parallel_for_chunks(num_chunks, [&](const size_t c) {
+    const size_t begin = std::min(c * chunk, num_words);
+    const size_t end = std::min(begin + chunk, num_words - 1);
+    size_t sum = 0;
+    MIMMO_SIMD
+    for (size_t w = begin; w < end; w++)
+      sum += count_word_bits(words[w]);
+    partial[c] = sum;
+  });
+
+  count = count_word_bits(words[num_words - 1] & last_mask);
+  for (size_t c = 0; c < num_chunks; c++)
+    count += partial[c];
+#endif // _OPENACC
+
+  return count;
+}
+
+/**
+ * @brief Counts the bits set in a bit-packed dual array into a dual
+ * scalar.
+ *
+ * @param result    Dual scalar receiving the count (on host and, if
+ *                  present, on device).
+ * @param bit_array Bit-packed dual array to be counted.
+ */
+inline void popcount(DualScalar<size_t> &result,
+                     const DualBitArray &bit_array) {
+  store_reduction_result(result, count_bits(bit_array));
+  return;
+}
+
+/**
+ * @brief Checks whether any bit of a bit-packed dual array is set, into a
+ * dual scalar.
+ *
+ * @param result    Dual scalar receiving the answer (on host and, if
+ *                  present, on device).
+ * @param bit_array Bit-packed dual array to be checked.
+ */
+inline void any(DualScalar<bool> &result, const DualBitArray &bit_array) {
+  store_reduction_result(result, count_bits(bit_array) > 0);
+  return;
+}
+
+/**
+ * @brief Checks whether all bits of a bit-packed dual array are set, into
+ * a dual scalar.
+ *
+ * @param result    Dual scalar receiving the answer (on host and, if
+ *                  present, on device).
+ * @param bit_array Bit-packed dual array to be checked.
+ *
+ * @note An empty array has all its bits set.
+ */
+inline void all(DualScalar<bool> &result, const DualBitArray &bit_array) {
+  store_reduction_result(result, count_bits(bit_array) == bit_array.size);
+  return;
+}
+
+} // namespace MiMMO
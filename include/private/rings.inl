@@ -0,0 +1,241 @@
+/**
+ * @file rings.inl
+ *
+ * @brief Definition of template methods for managing rings of time
+ * levels.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - alloc_ring()
+ * - rotate_ring()
+ * - update_ring_host_to_device()
+ * - update_ring_device_to_host()
+ * - update_ring_level_host_to_device()
+ * - update_ring_level_device_to_host()
+ * - free_ring()
+ *
+ * and the ring_level() function.
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Allocates a ring of time levels.
+ *
+ * @details
+ * Slots and descriptor are laid out in one allocation, each aligned for
+ * its type.
+ *
+ * @tparam T        Type of elements in each level.
+ * @tparam Levels   Number of time levels.
+ *
+ * @param ring      Ring to be allocated.
+ * @param label     Label that should be used to track the ring in
+ *                  memory.
+ * @param size      Number of elements of each level.
+ * @param on_device Whether the ring should be allocated on device as
+ *                  well (ignored without device memory).
+ */
+template <typename T, size_t Levels>
+void DualMemoryManager::alloc_ring(DualRing<T, Levels> &ring,
+                                   const std::string label, const size_t size,
+                                   const bool on_device) {
+
+  /* lay out components, each aligned for its type */
+  const size_t offsets_offset =
+      (Levels * size * sizeof(T) + alignof(size_t) - 1) / alignof(size_t) *
+      alignof(size_t);
+  const size_t size_bytes = offsets_offset + Levels * sizeof(size_t);
+
+  alloc_array(ring.storage, label, size_bytes, on_device);
+
+  set_storage_view(ring.values, ring.storage, 0, Levels * size);
+  set_storage_view(ring.offsets, ring.storage, offsets_offset, Levels);
+  ring.size = size;
+  ring.head = 0;
+
+  /* level l starts in slot l */
+  for (size_t level = 0; level < Levels; level++)
+    ring.offsets.host_ptr[level] = level * size;
+
+  if (ring.storage.dev_ptr != nullptr)
+    update_array_host_to_device(ring.storage, offsets_offset,
+                                ring.offsets.size_bytes);
+
+  return;
+}
+
+/**
+ * @brief Shifts every level of a ring to the next older one, in O(1).
+ *
+ * @tparam T      Type of elements in each level.
+ * @tparam Levels Number of time levels.
+ *
+ * @param ring    Ring to be rotated.
+ */
+template <typename T, size_t Levels>
+void DualMemoryManager::rotate_ring(DualRing<T, Levels> &ring) {
+
+  /* the slot of the oldest level becomes level 0 */
+  ring.head = (ring.head + Levels - 1) % Levels;
+
+  for (size_t level = 0; level < Levels; level++)
+    ring.offsets.host_ptr[level] = (ring.head + level) % Levels * ring.size;
+
+  /* only the descriptor moves */
+  if (ring.storage.dev_ptr != nullptr)
+    update_array_host_to_device(
+        ring.storage,
+        (unsigned char *)ring.offsets.host_ptr - ring.storage.host_ptr,
+        ring.offsets.size_bytes);
+
+  return;
+}
+
+/**
+ * @brief Copies all levels of a ring (and its descriptor) from host to
+ * device, in one transfer.
+ *
+ * @tparam T       Type of elements in each level.
+ * @tparam Levels  Number of time levels.
+ *
+ * @param ring     Ring to synchronize.
+ * @param location Call site, recorded in profiling mode.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T, size_t Levels>
+void DualMemoryManager::update_ring_host_to_device(
+    DualRing<T, Levels> &ring, const SourceLocation location) {
+  update_array_host_to_device(ring.storage, 0, ring.storage.size, location);
+  return;
+}
+
+/**
+ * @brief Copies all levels of a ring (and its descriptor) from device to
+ * host, in one transfer.
+ *
+ * @tparam T       Type of elements in each level.
+ * @tparam Levels  Number of time levels.
+ *
+ * @param ring     Ring to synchronize.
+ * @param location Call site, recorded in profiling mode.
+ *
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T, size_t Levels>
+void DualMemoryManager::update_ring_device_to_host(
+    DualRing<T, Levels> &ring, const SourceLocation location) {
+  update_array_device_to_host(ring.storage, 0, ring.storage.size, location);
+  return;
+}
+
+/**
+ * @brief Copies one level of a ring from host to device.
+ *
+ * @tparam T       Type of elements in each level.
+ * @tparam Levels  Number of time levels.
+ *
+ * @param ring     Ring to synchronize.
+ * @param level    Level to be copied (0 for the newest).
+ * @param location Call site, recorded in profiling mode.
+ *
+ * @note If the level is out of range, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T, size_t Levels>
+void DualMemoryManager::update_ring_level_host_to_device(
+    DualRing<T, Levels> &ring, const size_t level,
+    const SourceLocation location) {
+
+  if (level >= Levels)
+    abort_mimmo("Level out of range of ring.");
+
+  update_array_host_to_device(ring.storage,
+                              ring.offsets.host_ptr[level] * sizeof(T),
+                              ring.size * sizeof(T), location);
+
+  return;
+}
+
+/**
+ * @brief Copies one level of a ring from device to host.
+ *
+ * @tparam T       Type of elements in each level.
+ * @tparam Levels  Number of time levels.
+ *
+ * @param ring     Ring to synchronize.
+ * @param level    Level to be copied (0 for the newest).
+ * @param location Call site, recorded in profiling mode.
+ *
+ * @note If the level is out of range, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T, size_t Levels>
+void DualMemoryManager::update_ring_level_device_to_host(
+    DualRing<T, Levels> &ring, const size_t level,
+    const SourceLocation location) {
+
+  if (level >= Levels)
+    abort_mimmo("Level out of range of ring.");
+
+  update_array_device_to_host(ring.storage,
+                              ring.offsets.host_ptr[level] * sizeof(T),
+                              ring.size * sizeof(T), location);
+
+  return;
+}
+
+/**
+ * @brief Frees memory allocated for a ring.
+ *
+ * @tparam T      Type of elements in each level.
+ * @tparam Levels Number of time levels.
+ *
+ * @param ring    Ring to be freed.
+ *
+ * @note If the ring is not tracked, the program aborts.
+ */
+template <typename T, size_t Levels>
+void DualMemoryManager::free_ring(DualRing<T, Levels> &ring) {
+
+  free_array(ring.storage);
+
+  ring.values = {nullptr, nullptr, 0, 0};
+  ring.offsets = {nullptr, nullptr, 0, 0};
+  ring.size = 0;
+  ring.head = 0;
+
+  return;
+}
+
+/**
+ * @brief Returns a view of one level of a ring.
+ *
+ * @tparam T      Type of elements in each level.
+ * @tparam Levels Number of time levels.
+ *
+ * @param ring    Ring holding the level.
+ * @param level   Level to be viewed (0 for the newest).
+ *
+ * @return        View of the level.
+ *
+ * @note If the level is out of range, the program aborts.
+ */
+template <typename T, size_t Levels>
+DualArray<T> ring_level(const DualRing<T, Levels> &ring, const size_t level) {
+
+  if (level >= Levels)
+    abort_mimmo("Level out of range of ring.");
+
+  DualArray<T> view;
+  set_storage_view(view, ring.storage, ring.offsets.host_ptr[level] * sizeof(T),
+                   ring.size);
+
+  return view;
+}
+
+} // namespace MiMMO
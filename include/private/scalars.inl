@@ -7,7 +7,10 @@
  * - create_scalar()
  * - update_scalar_host_to_device()
  * - update_scalar_device_to_host()
+ * - update_scalar_host_to_device_async()
+ * - update_scalar_device_to_host_async()
  * - destroy_scalar()
+ * - untrack_scalar()
  *
  * @see api.hpp for the corresponding declarations
  * @see examples/globals/main.cpp for usage with global variables
@@ -27,8 +30,7 @@ namespace MiMMO {
  *                    memory.
  * @param value       Value to which the scalar should be initialized.
  * @param on_device   Whether the scalar should be created on device as
- *                    well (ignored if main code compiled without OpenACC
- *                    support).
+ *                    well (ignored without device memory).
  */
 template <typename T>
 void DualMemoryManager::create_scalar(DualScalar<T> &dual_scalar,
@@ -39,42 +41,30 @@ void DualMemoryManager::create_scalar(DualScalar<T> &dual_scalar,
   dual_scalar.host_value = value;
 
   /* if required, allocate memory on device */
-#ifdef _OPENACC
-  if (on_device) {
-    dual_scalar.dev_ptr = (T *)acc_malloc(sizeof(T));
+  const bool dev_alloc = on_device && backend->has_device();
+  dual_scalar.dev_ptr = nullptr;
 
-    if (!(dual_scalar.dev_ptr)) {
-      abort_mimmo("Failed to allocate device memory.");
-    }
+  if (dev_alloc) {
+    dual_scalar.dev_ptr = (T *)device_alloc(sizeof(T));
 
-  } else {
-    dual_scalar.dev_ptr = nullptr;
+    /* copy data from host to device */
+    copy_to_device(dual_scalar.dev_ptr, &(dual_scalar.host_value), sizeof(T));
   }
-#else
-  dual_scalar.dev_ptr = nullptr;
-#endif // _OPENACC
-
-  /* copy data from host to device */
-#ifdef _OPENACC
-  if (on_device)
-    acc_memcpy_to_device(dual_scalar.dev_ptr, &(dual_scalar.host_value),
-                         sizeof(T));
-#endif // _OPENACC
 
   /* update memory tracker */
-#ifdef _OPENACC
-  const bool ret =
-      add_to_memory_tracker(memory_tracker, total_memory, (void *)&dual_scalar,
-                            label, sizeof(T), on_device);
-#else
-  const bool ret =
-      add_to_memory_tracker(memory_tracker, total_memory, (void *)&dual_scalar,
-                            label, sizeof(T), false);
-#endif // _OPENACC
+  const bool ret = add_to_memory_tracker(
+      memory_tracker, total_memory, label_memory, (void *)&dual_scalar, label,
+      sizeof(T), dev_alloc, false, backend->get_device());
 
   if (ret)
     abort_mimmo("Failed to track memory for dual scalar '" + label + "'.");
 
+  record_memory(1, 0);
+
+  /* assign descriptor table slot */
+  register_descriptor((void *)&dual_scalar, (void *)&dual_scalar.host_value,
+                      (void *)dual_scalar.dev_ptr, 1);
+
   return;
 }
 
@@ -84,22 +74,32 @@ void DualMemoryManager::create_scalar(DualScalar<T> &dual_scalar,
  * @tparam T          Type of the scalar variable.
  *
  * @param dual_scalar Dual scalar to synchronize.
+ * @param location    Call site, recorded in profiling mode.
  *
  * @note The scalar must have been previously created using create_scalar().
  *       If the scalar is not present on device, the program aborts.
  */
 template <typename T>
 void DualMemoryManager::update_scalar_host_to_device(
-    DualScalar<T> &dual_scalar) {
+    DualScalar<T> &dual_scalar, const SourceLocation location) {
+
+  if (!backend->has_device())
+    return;
 
-#ifdef _OPENACC
   /* check that device pointer is initialized */
   if (dual_scalar.dev_ptr == nullptr)
     abort_mimmo("Device pointer of dual scalar is a null pointer.");
 
+  /* in profiling mode, compare host value with the shadow checksum */
+  if (transfer_profiling) {
+    const uint64_t hash = xxh64(&dual_scalar.host_value, sizeof(T));
+    profile_transfer((void *)&dual_scalar, 0, sizeof(T), hash, hash, true,
+                     location);
+  }
+
   /* copy data from host to device */
-  acc_memcpy_to_device(dual_scalar.dev_ptr, &dual_scalar.host_value, sizeof(T));
-#endif // _OPENACC
+  const DeviceScope scope(*backend, object_device(&dual_scalar));
+  copy_to_device(dual_scalar.dev_ptr, &dual_scalar.host_value, sizeof(T));
 
   return;
 }
@@ -110,24 +110,101 @@ void DualMemoryManager::update_scalar_host_to_device(
  * @tparam T          Type of the scalar variable.
  *
  * @param dual_scalar Dual scalar to synchronize.
+ * @param location    Call site, recorded in profiling mode.
  *
  * @note The scalar must have been previously created using create_scalar().
  *       If the scalar is not present on device, the program aborts.
- *       If OpenACC is not enabled, this function does nothing.
+ *       Without device memory, this function does nothing.
  */
 template <typename T>
 void DualMemoryManager::update_scalar_device_to_host(
-    DualScalar<T> &dual_scalar) {
+    DualScalar<T> &dual_scalar, const SourceLocation location) {
+
+  if (!backend->has_device())
+    return;
 
-#ifdef _OPENACC
   /* check that device pointer is initialized */
   if (dual_scalar.dev_ptr == nullptr)
     abort_mimmo("Device pointer of dual scalar is a null pointer.");
 
+  /* in profiling mode, checksum host value before and after the copy */
+  const uint64_t old_hash =
+      transfer_profiling ? xxh64(&dual_scalar.host_value, sizeof(T)) : 0;
+
   /* copy data from device to host */
-  acc_memcpy_from_device(&dual_scalar.host_value, dual_scalar.dev_ptr,
-                         sizeof(T));
-#endif // _OPENACC
+  const DeviceScope scope(*backend, object_device(&dual_scalar));
+  copy_from_device(&dual_scalar.host_value, dual_scalar.dev_ptr, sizeof(T));
+
+  if (transfer_profiling)
+    profile_transfer((void *)&dual_scalar, 0, sizeof(T), old_hash,
+                     xxh64(&dual_scalar.host_value, sizeof(T)), false,
+                     location);
+
+  return;
+}
+
+/**
+ * @brief Enqueues a copy of the value of a dual scalar from host to
+ * device.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar to synchronize.
+ * @param queue       Queue on which the copy is enqueued (on the device of
+ *                    the scalar).
+ *
+ * @note If the scalar is not present on device, the program aborts.
+ *       Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_scalar_host_to_device_async(
+    DualScalar<T> &dual_scalar, const int queue) {
+
+  if (!backend->has_device())
+    return;
+
+  /* check that device pointer is initialized */
+  if (dual_scalar.dev_ptr == nullptr)
+    abort_mimmo("Device pointer of dual scalar is a null pointer.");
+
+  /* enqueue copy from host to device (its time is not known) */
+  const DeviceScope scope(*backend, object_device(&dual_scalar));
+  backend->memcpy_to_device_async(dual_scalar.dev_ptr,
+                                  &dual_scalar.host_value, sizeof(T), queue);
+  record_transfer(true, sizeof(T), 0.0);
+
+  return;
+}
+
+/**
+ * @brief Enqueues a copy of the value of a dual scalar from device to
+ * host.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar to synchronize.
+ * @param queue       Queue on which the copy is enqueued (on the device of
+ *                    the scalar).
+ *
+ * @note If the scalar is not present on device, the program aborts.
+ *       Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_scalar_device_to_host_async(
+    DualScalar<T> &dual_scalar, const int queue) {
+
+  if (!backend->has_device())
+    return;
+
+  /* check that device pointer is initialized */
+  if (dual_scalar.dev_ptr == nullptr)
+    abort_mimmo("Device pointer of dual scalar is a null pointer.");
+
+  /* enqueue copy from device to host (its time is not known) */
+  const DeviceScope scope(*backend, object_device(&dual_scalar));
+  backend->memcpy_from_device_async(&dual_scalar.host_value,
+                                    dual_scalar.dev_ptr, sizeof(T), queue);
+  record_transfer(false, sizeof(T), 0.0);
 
   return;
 }
@@ -141,29 +218,50 @@ void DualMemoryManager::update_scalar_device_to_host(
  *
  * @note If the scalar is not tracked (i.e. was not allocated using this
  *       memory manager, or it was already freed), the program aborts.
- *       If OpenACC is not enabled, this function does nothing.
+ *       Without device memory, this function does nothing.
  */
 template <typename T>
 void DualMemoryManager::destroy_scalar(DualScalar<T> &dual_scalar) {
 
-  /* check that scalar was actually recorded and update memory
-   * tracker
-   * */
-  const bool ret = remove_from_memory_tracker(memory_tracker, total_memory,
-                                              (void *)&dual_scalar);
-  if (ret) {
+  const int device = untrack_scalar(dual_scalar);
+
+  /* free memory on its device */
+  device_free(dual_scalar.dev_ptr, device);
+  dual_scalar.dev_ptr = nullptr;
+
+  return;
+}
+
+/**
+ * @brief Stops tracking a dual scalar being destroyed.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar to be destroyed.
+ *
+ * @return            Device of the scalar.
+ *
+ * @note If the scalar is not tracked, the program aborts.
+ */
+template <typename T>
+int DualMemoryManager::untrack_scalar(DualScalar<T> &dual_scalar) {
+
+  /* check that scalar was actually recorded */
+  const auto it = memory_tracker.find((void *)&dual_scalar);
+  if (it == memory_tracker.end()) {
     abort_mimmo("Dual scalar was not found by memory manager.");
   }
 
-  /* free memory on device */
-#ifdef _OPENACC
-  if (dual_scalar.dev_ptr != nullptr) {
-    acc_free(dual_scalar.dev_ptr);
-    dual_scalar.dev_ptr = nullptr;
-  }
-#endif // _OPENACC
+  const int device = it->second.device;
 
-  return;
+  /* update memory tracker and descriptor table */
+  unregister_descriptor(it->second.slot);
+  remove_from_memory_tracker(memory_tracker, total_memory, label_memory,
+                             (void *)&dual_scalar);
+  release_transfer_state((void *)&dual_scalar);
+  record_memory(0, 1);
+
+  return device;
 }
 
 } // namespace MiMMO
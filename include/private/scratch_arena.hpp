@@ -0,0 +1,46 @@
+/**
+ * @file scratch_arena.hpp
+ *
+ * @brief Declaration of the scratch arena data structure.
+ *
+ * Internal data structure backing device-only scratch arrays.
+ * Used by DualMemoryManager to carve temporaries out of a single
+ * allocation with frame-based (push/pop) lifetimes.
+ *
+ * @see scratch_arena.inl for the corresponding DualMemoryManager methods
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace MiMMO {
+
+/**
+ * @brief Alignment in bytes of scratch arrays inside the arena.
+ */
+constexpr size_t scratch_alignment = 256;
+
+/**
+ * @brief Stores scratch arena data.
+ *
+ * @details
+ * The arena is a single buffer allocated on device (or on host without
+ * device memory). Allocations bump an offset, and each frame records the
+ * offset at which it was pushed, so that popping it releases all
+ * allocations made inside it at once.
+ */
+struct ScratchArena {
+  void *base_ptr;             /*!< pointer to arena memory */
+  size_t capacity;            /*!< size in bytes of the arena */
+  size_t offset;              /*!< number of bytes currently in use */
+  size_t high_water_mark;     /*!< maximum number of bytes ever in use */
+  bool on_device;             /*!< whether the arena is allocated on
+                                   device */
+  int device;                 /*!< device on which the arena is
+                                   allocated */
+  std::vector<size_t> frames; /*!< offsets at which frames were pushed */
+};
+
+} // namespace MiMMO
@@ -0,0 +1,169 @@
+/**
+ * @file scratch_arena.inl
+ *
+ * @brief Definition of methods for managing the scratch arena.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - reserve_scratch_arena()
+ * - release_scratch_arena()
+ * - push_frame()
+ * - pop_frame()
+ * - alloc_scratch_array()
+ * - return_scratch_arena_usage()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Reserves memory for the scratch arena.
+ *
+ * @param size_bytes Capacity in bytes of the arena.
+ *
+ * @note If a frame is currently open, the program aborts.
+ */
+inline void DualMemoryManager::reserve_scratch_arena(const size_t size_bytes) {
+
+  /* release previous arena, if any */
+  release_scratch_arena();
+
+  /* allocate arena on device (or on host without device memory) */
+  scratch_arena.on_device = backend->has_device();
+  scratch_arena.device = backend->get_device();
+  if (scratch_arena.on_device)
+    check_low_memory(size_bytes);
+  scratch_arena.base_ptr = scratch_arena.on_device ? backend->alloc(size_bytes)
+                                                   : host_alloc(size_bytes, 1);
+
+  if (!(scratch_arena.base_ptr))
+    abort_mimmo("Failed to allocate scratch arena.");
+
+  scratch_arena.capacity = size_bytes;
+  scratch_arena.offset = 0;
+  scratch_arena.high_water_mark = 0;
+
+  /* update total memory usage */
+  if (scratch_arena.on_device)
+    total_memory.second += size_bytes;
+  else
+    total_memory.first += size_bytes;
+
+  record_memory(0, 0);
+
+  return;
+}
+
+/**
+ * @brief Releases memory of the scratch arena.
+ *
+ * @note If a frame is currently open, the program aborts.
+ */
+inline void DualMemoryManager::release_scratch_arena() {
+
+  /* check that no scratch array is alive */
+  if (!scratch_arena.frames.empty())
+    abort_mimmo("Scratch arena released while a frame is open.");
+
+  if (scratch_arena.base_ptr == nullptr)
+    return;
+
+  /* free arena */
+  if (scratch_arena.on_device) {
+    device_free(scratch_arena.base_ptr, scratch_arena.device);
+    total_memory.second -= scratch_arena.capacity;
+  } else {
+    host_free(scratch_arena.base_ptr);
+    total_memory.first -= scratch_arena.capacity;
+  }
+
+  scratch_arena.base_ptr = nullptr;
+  scratch_arena.capacity = 0;
+  scratch_arena.offset = 0;
+
+  return;
+}
+
+/**
+ * @brief Opens a new scratch frame.
+ */
+inline void DualMemoryManager::push_frame() {
+  scratch_arena.frames.push_back(scratch_arena.offset);
+  return;
+}
+
+/**
+ * @brief Closes the innermost scratch frame.
+ *
+ * @note If no frame is open, the program aborts.
+ */
+inline void DualMemoryManager::pop_frame() {
+
+  if (scratch_arena.frames.empty())
+    abort_mimmo("No scratch frame to pop.");
+
+  /* release all scratch arrays allocated inside the frame */
+  scratch_arena.offset = scratch_arena.frames.back();
+  scratch_arena.frames.pop_back();
+
+  return;
+}
+
+/**
+ * @brief Allocates a device-only scratch array in the current frame.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be allocated.
+ * @param size       Number of elements in the array.
+ *
+ * @note If no frame is open, or the arena is exhausted, the program
+ *       aborts.
+ */
+template <typename T>
+void DualMemoryManager::alloc_scratch_array(DualArray<T> &dual_array,
+                                            const size_t size) {
+
+  /* check that a frame is open */
+  if (scratch_arena.frames.empty())
+    abort_mimmo("Scratch arrays must be allocated inside a frame.");
+
+  /* bump offset */
+  const size_t begin = (scratch_arena.offset + scratch_alignment - 1) /
+                       scratch_alignment * scratch_alignment;
+  const size_t end = begin + size * sizeof(T);
+
+  if (end > scratch_arena.capacity)
+    abort_mimmo("Scratch arena exhausted (" +
+                std::to_string(scratch_arena.capacity) + " bytes).");
+
+  scratch_arena.offset = end;
+  scratch_arena.high_water_mark = std::max(scratch_arena.high_water_mark, end);
+
+  /* set pointers (host pointer is used without device memory, where
+   * compute regions run on host data)
+   * */
+  T *const ptr = (T *)((char *)scratch_arena.base_ptr + begin);
+  dual_array.host_ptr = scratch_arena.on_device ? nullptr : ptr;
+  dual_array.dev_ptr = scratch_arena.on_device ? ptr : nullptr;
+
+  /* update number of elements and bytes */
+  dual_array.size = size;
+  dual_array.size_bytes = size * sizeof(T);
+
+  return;
+}
+
+/**
+ * @brief Returns usage statistics of the scratch arena.
+ *
+ * @return (bytes currently in use, high-water mark in bytes)
+ */
+inline std::pair<size_t, size_t>
+DualMemoryManager::return_scratch_arena_usage() {
+  return {scratch_arena.offset, scratch_arena.high_water_mark};
+}
+
+} // namespace MiMMO
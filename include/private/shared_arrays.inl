@@ -0,0 +1,187 @@
+/**
+ * @file shared_arrays.inl
+ *
+ * @brief Definition of template methods for managing dual arrays whose
+ * host memory is shared across processes.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - alloc_shared_array()
+ * - publish_shared_array()
+ * - free_shared_array()
+ * - check_host_writable()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Allocates a dual array whose host memory is shared by the
+ * processes of a node.
+ *
+ * @details
+ * Host memory is a named POSIX shared-memory segment. The first process
+ * allocating the name creates it, fills host memory, and then calls
+ * publish_shared_array(). The other processes wait for publication and
+ * attach host memory read-only. Each process has its own device memory,
+ * to be filled with update_array_host_to_device().
+ *
+ * Shared host memory is not counted in the host memory used by the
+ * memory manager (see return_shared_memory_usage()), so that it is not
+ * counted once per process when summing over processes.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to be allocated.
+ * @param label      Label that should be used to track the array in
+ *                   memory.
+ * @param name       Name of the shared-memory segment, the same in all
+ *                   processes.
+ * @param size       Number of elements in the array.
+ * @param on_device  Whether the array should be allocated on device as
+ *                   well (ignored without device memory).
+ *
+ * @return           'true' if this process created the segment and must
+ *                   fill it, 'false' if data is already available.
+ *
+ * @note If the segment cannot be created, has a different size, or is
+ *       not published within shared_attach_timeout seconds, the program
+ *       aborts.
+ */
+template <typename T>
+bool DualMemoryManager::alloc_shared_array(DualArray<T> &dual_array,
+                                           const std::string label,
+                                           const std::string name,
+                                           const size_t size,
+                                           const bool on_device) {
+
+  if (name.empty())
+    abort_mimmo("Shared dual array '" + label + "' has no segment name.");
+
+  /* create or attach host memory */
+  const SharedSegment segment = open_shared_segment(name, size * sizeof(T));
+  dual_array.host_ptr = (T *)segment.data_ptr;
+
+  /* if required, allocate private memory on device */
+  const bool dev_alloc = on_device && backend->has_device();
+  dual_array.dev_ptr = dev_alloc ? (T *)device_alloc(size * sizeof(T))
+                                 : nullptr;
+
+  /* update number of elements and bytes */
+  dual_array.size = size;
+  dual_array.size_bytes = size * sizeof(T);
+
+  /* update memory tracker (shared host memory is not counted) */
+  const bool ret = add_to_memory_tracker(
+      memory_tracker, total_memory, label_memory, (void *)&dual_array, label,
+      dual_array.size_bytes, dev_alloc, false, backend->get_device());
+
+  if (ret)
+    abort_mimmo("Failed to track memory for dual array '" + label + "'.");
+
+  memory_tracker[(void *)&dual_array].shared = true;
+  total_memory.first -= dual_array.size_bytes;
+  label_memory[label].host_bytes -= dual_array.size_bytes;
+  shared_segments[(void *)&dual_array] = segment;
+
+  record_memory(1, 0);
+
+  /* assign descriptor table slot */
+  register_descriptor((void *)&dual_array, (void *)dual_array.host_ptr,
+                      (void *)dual_array.dev_ptr, size);
+
+  return segment.creator;
+}
+
+/**
+ * @brief Publishes host memory of a shared dual array to the other
+ * processes.
+ *
+ * @details
+ * From then on, host memory is read-only in the creating process as
+ * well. In processes that attached the array, this function does
+ * nothing.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Shared dual array to be published.
+ *
+ * @note If the array is not a tracked shared array, the program aborts.
+ */
+template <typename T>
+void DualMemoryManager::publish_shared_array(DualArray<T> &dual_array) {
+
+  const auto it = shared_segments.find((void *)&dual_array);
+  if (it == shared_segments.end())
+    abort_mimmo("Dual array is not a shared dual array.");
+
+  publish_shared_segment(it->second);
+
+  return;
+}
+
+/**
+ * @brief Frees memory of a shared dual array.
+ *
+ * @details
+ * The process detaches from the shared-memory segment, which is removed
+ * once no process is attached anymore.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Shared dual array to be freed.
+ *
+ * @note If the array is not a tracked shared array, the program aborts.
+ */
+template <typename T>
+void DualMemoryManager::free_shared_array(DualArray<T> &dual_array) {
+
+  const auto it = shared_segments.find((void *)&dual_array);
+  if (it == shared_segments.end())
+    abort_mimmo("Dual array is not a shared dual array.");
+
+  const int device = memory_tracker[(void *)&dual_array].device;
+
+  /* update memory tracker and descriptor table */
+  unregister_descriptor(memory_tracker[(void *)&dual_array].slot);
+  remove_from_memory_tracker(memory_tracker, total_memory, label_memory,
+                             (void *)&dual_array);
+  release_transfer_state((void *)&dual_array);
+  record_memory(0, 1);
+
+  /* detach host memory */
+  close_shared_segment(it->second);
+  shared_segments.erase(it);
+  dual_array.host_ptr = nullptr;
+
+  /* free private memory on its device */
+  device_free(dual_array.dev_ptr, device);
+  dual_array.dev_ptr = nullptr;
+
+  return;
+}
+
+/**
+ * @brief Checks that host memory of a dual object can be written.
+ *
+ * @param object Pointer to the dual object.
+ *
+ * @note If host memory is shared and read-only in this process (attached,
+ *       or already published), the program aborts.
+ */
+inline void DualMemoryManager::check_host_writable(const void *const object) {
+
+  const auto it = memory_tracker.find((void *)object);
+  if (it == memory_tracker.end() || !it->second.shared)
+    return;
+
+  if (is_read_only_shared(shared_segments[(void *)object].data_ptr))
+    abort_mimmo("Host memory of shared dual array '" + it->second.label +
+                "' is read-only and cannot be written.");
+
+  return;
+}
+
+} // namespace MiMMO
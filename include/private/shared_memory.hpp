@@ -0,0 +1,84 @@
+/**
+ * @file shared_memory.hpp
+ *
+ * @brief Declaration of utilities for host memory shared across processes.
+ *
+ * Internal utilities for creating and attaching named POSIX shared-memory
+ * segments, so that processes on the same node can share read-only data.
+ * Used by DualMemoryManager to back shared dual arrays.
+ *
+ * @see shared_memory.cpp for implementations
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace MiMMO {
+
+/**
+ * @brief Seconds a process waits for the creator of a shared segment to
+ * publish it before aborting.
+ */
+constexpr double shared_attach_timeout = 60.0;
+
+/**
+ * @brief Stores the mapping of a shared-memory segment in one process.
+ *
+ * @details
+ * A segment starts with a header page (holding whether data was published
+ * and how many processes are attached), followed by the data. Only the
+ * creator may write data, until the segment is published; the other
+ * processes map data read-only.
+ */
+struct SharedSegment {
+  std::string name;  /*!< name of the segment */
+  void *header_ptr;  /*!< pointer to the header page */
+  void *data_ptr;    /*!< pointer to the data */
+  size_t size_bytes; /*!< size in bytes of the data */
+  bool creator;      /*!< whether this process created the segment */
+};
+
+/**
+ * @brief Creates a shared-memory segment, or attaches to it if another
+ * process already created it.
+ *
+ * @param name       Name of the segment.
+ * @param size_bytes Size in bytes of the data.
+ *
+ * @return           Mapping of the segment.
+ *
+ * @note If the segment cannot be created or mapped, has a different size,
+ *       or is not published in time, the program aborts.
+ */
+SharedSegment open_shared_segment(const std::string name,
+                                  const size_t size_bytes);
+
+/**
+ * @brief Publishes the data of a shared-memory segment to the other
+ * processes, and makes it read-only.
+ *
+ * @param segment Mapping of the segment (ignored if not the creator).
+ */
+void publish_shared_segment(SharedSegment &segment);
+
+/**
+ * @brief Detaches from a shared-memory segment, removing it once no
+ * process is attached anymore.
+ *
+ * @param segment Mapping of the segment.
+ */
+void close_shared_segment(SharedSegment &segment);
+
+/**
+ * @brief Returns whether memory lies in shared data that this process
+ * cannot write, i.e. attached or already published.
+ *
+ * @param ptr Address to be checked.
+ *
+ * @return    'true' if the memory is read-only shared data.
+ */
+bool is_read_only_shared(const void *const ptr);
+
+} // namespace MiMMO
@@ -0,0 +1,102 @@
+/**
+ * @file staging.inl
+ *
+ * @brief Definition of inline methods for managing staging buffers.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - reserve_staging_buffers()
+ * - ~DualMemoryManager()
+ *
+ * Staging buffers are kept in headers, like all other device memory
+ * operations, so that they follow the compilation flags of the main code.
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Makes sure staging buffers can hold a given number of bytes.
+ *
+ * @details
+ * Staging buffers are grown geometrically and never shrunk, so that
+ * repeated packed transfers of similar size do not reallocate. The device
+ * buffer follows the current device, and moves when it changes.
+ *
+ * @param size_bytes Minimum size in bytes of the staging buffers.
+ */
+inline void
+DualMemoryManager::reserve_staging_buffers(const size_t size_bytes) {
+
+  const int device = backend->get_device();
+  const bool grow = size_bytes > staging_size_bytes;
+  const bool move = (staging_dev_ptr != nullptr) && (staging_device != device);
+
+  /* nothing to do if buffers are large enough and on the current device */
+  if (!grow && !move)
+    return;
+
+  const size_t new_size_bytes =
+      grow ? std::max(size_bytes, 2 * staging_size_bytes) : staging_size_bytes;
+
+  /* reallocate host buffer (old content does not need to be kept) */
+  if (grow) {
+    std::free(staging_host_ptr);
+    staging_host_ptr = std::malloc(new_size_bytes);
+
+    if (!staging_host_ptr)
+      abort_mimmo("Failed to allocate host staging buffer.");
+  }
+
+  /* reallocate device buffer on the current device */
+  if (backend->has_device()) {
+    device_free(staging_dev_ptr, staging_device);
+    check_low_memory(new_size_bytes);
+    staging_dev_ptr = backend->alloc(new_size_bytes);
+
+    if (!staging_dev_ptr)
+      abort_mimmo("Failed to allocate device staging buffer.");
+
+    staging_device = device;
+  }
+
+  staging_size_bytes = new_size_bytes;
+
+  return;
+}
+
+/**
+ * @brief Class destructor.
+ *
+ * @details
+ * Releases the internal staging buffers, the scratch arena, the
+ * descriptor table and buffers of deferred frees. Dual arrays and
+ * scalars are not freed and must be released by the user.
+ */
+inline DualMemoryManager::~DualMemoryManager() {
+
+  /* free buffers of deferred frees, once their queues are idle */
+  flush_deferred_frees();
+
+  /* free host staging buffer */
+  std::free(staging_host_ptr);
+  staging_host_ptr = nullptr;
+
+  /* free device staging buffer */
+  device_free(staging_dev_ptr, staging_device);
+  staging_dev_ptr = nullptr;
+
+  staging_size_bytes = 0;
+
+  /* free scratch arena (frames left open are discarded) */
+  scratch_arena.frames.clear();
+  release_scratch_arena();
+
+  /* free device copy of descriptor table */
+  device_free(descriptors.dev_table, descriptors.dev_device);
+  descriptors.dev_table = nullptr;
+}
+
+} // namespace MiMMO
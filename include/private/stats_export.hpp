@@ -0,0 +1,290 @@
+/**
+ * @file stats_export.hpp
+ *
+ * @brief Declaration of the live statistics exporter.
+ *
+ * The exporter publishes counters of the memory manager (totals, peaks,
+ * sizes by label and transfer counters) into a named POSIX shared-memory
+ * page, so that external tools such as mimmo-top can monitor a running
+ * process. The page is protected by a sequence lock: the process writes
+ * without ever waiting for readers, and readers retry if an update
+ * happened while they were copying.
+ *
+ * @see stats_export.cpp for implementations
+ * @see stats_export.inl for the corresponding DualMemoryManager methods
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace MiMMO {
+
+/**
+ * @brief Identifies a statistics page ("MiMMOSTA" in ASCII).
+ */
+constexpr uint64_t stats_page_magic = 0x4D694D4D4F535441;
+
+/**
+ * @brief Version of the layout of statistics pages.
+ */
+constexpr uint64_t stats_page_version = 1;
+
+/**
+ * @brief Maximum number of labels in a statistics page.
+ */
+constexpr size_t stats_max_labels = 48;
+
+/**
+ * @brief Maximum length of a label in a statistics page, including the
+ * terminating null character.
+ */
+constexpr size_t stats_label_chars = 48;
+
+/**
+ * @brief Default minimum interval between updates of a statistics page,
+ * in seconds.
+ */
+constexpr double default_stats_interval = 0.1;
+
+/**
+ * @brief Stores the memory used by the objects of a label.
+ */
+struct StatsLabel {
+  char label[stats_label_chars]; /*!< label (truncated if too long) */
+  uint64_t host_bytes;           /*!< host memory used by the objects */
+  uint64_t dev_bytes;            /*!< device memory used by the objects */
+};
+
+/**
+ * @brief Stores the counters published in a statistics page.
+ */
+struct StatsSnapshot {
+  uint64_t pid;               /*!< process identifier */
+  uint64_t time_ns;           /*!< wall-clock time of the update, in ns
+                                   since the epoch */
+  uint64_t num_updates;       /*!< number of updates of the page */
+  uint64_t host_bytes;        /*!< host memory used by the manager */
+  uint64_t dev_bytes;         /*!< device memory used by the manager */
+  uint64_t host_peak_bytes;   /*!< peak host memory used */
+  uint64_t dev_peak_bytes;    /*!< peak device memory used */
+  uint64_t num_objects;       /*!< number of tracked objects */
+  uint64_t num_allocs;        /*!< number of allocated objects */
+  uint64_t num_frees;         /*!< number of freed objects */
+  uint64_t to_device_count;   /*!< number of host-to-device transfers */
+  uint64_t to_device_bytes;   /*!< bytes copied from host to device */
+  uint64_t from_device_count; /*!< number of device-to-host transfers */
+  uint64_t from_device_bytes; /*!< bytes copied from device to host */
+  uint64_t num_labels;        /*!< number of labels below, by decreasing
+                                   memory used */
+  uint64_t num_other_labels;  /*!< number of labels left out */
+  StatsLabel labels[stats_max_labels]; /*!< memory used by label */
+};
+
+/**
+ * @brief Layout of a statistics page.
+ *
+ * @details
+ * The sequence number is odd while the snapshot is being written.
+ */
+struct StatsPage {
+  uint64_t magic;                 /*!< stats_page_magic */
+  uint64_t version;               /*!< stats_page_version */
+  std::atomic<uint64_t> sequence; /*!< sequence number of the lock */
+  StatsSnapshot snapshot;         /*!< published counters */
+};
+
+static_assert(sizeof(StatsPage) <= 4096,
+              "Statistics must fit in a page of memory.");
+
+/**
+ * @brief Publishes counters of the memory manager into a statistics page.
+ *
+ * @details
+ * Counters are accumulated locally at every event, and written to the
+ * page when the update interval has elapsed, or when publish() is called.
+ */
+class StatsExporter {
+public:
+  /**
+   * @brief Class constructor.
+   */
+  StatsExporter();
+
+  /**
+   * @brief Class destructor, which removes the page.
+   */
+  ~StatsExporter() { close(); }
+
+  StatsExporter(const StatsExporter &) = delete;
+  StatsExporter &operator=(const StatsExporter &) = delete;
+
+  /**
+   * @brief Returns whether the exporter is enabled.
+   *
+   * @return 'true' if a statistics page is open.
+   */
+  bool enabled() const { return page != nullptr; }
+
+  /**
+   * @brief Creates the statistics page.
+   *
+   * @param name       Name of the page.
+   * @param interval_s Minimum interval between updates, in seconds.
+   *
+   * @note If the page cannot be created, the program aborts.
+   */
+  void open(const std::string &name, const double interval_s);
+
+  /**
+   * @brief Removes the statistics page, if any.
+   */
+  void close();
+
+  /**
+   * @brief Returns the name of the statistics page.
+   *
+   * @return Name of the page (empty if disabled).
+   */
+  const std::string &page_name() const { return name; }
+
+  /**
+   * @brief Returns whether the update interval has elapsed.
+   *
+   * @return 'true' if the page should be updated.
+   */
+  bool due() const {
+    return std::chrono::steady_clock::now() >= next_update;
+  }
+
+  /**
+   * @brief Records allocations and frees.
+   *
+   * @param num_allocs Number of allocated objects.
+   * @param num_frees  Number of freed objects.
+   * @param memory     Host and device memory used by the manager
+   *                   afterwards.
+   */
+  void record_memory(const size_t num_allocs, const size_t num_frees,
+                     const std::pair<size_t, size_t> &memory) {
+    snapshot.num_allocs += num_allocs;
+    snapshot.num_frees += num_frees;
+    snapshot.host_bytes = memory.first;
+    snapshot.dev_bytes = memory.second;
+    snapshot.host_peak_bytes =
+        std::max<uint64_t>(snapshot.host_peak_bytes, memory.first);
+    snapshot.dev_peak_bytes =
+        std::max<uint64_t>(snapshot.dev_peak_bytes, memory.second);
+    return;
+  }
+
+  /**
+   * @brief Records a transfer.
+   *
+   * @param to_device  Whether data was copied from host to device (or the
+   *                   other way round).
+   * @param size_bytes Number of bytes copied.
+   */
+  void record_transfer(const bool to_device, const size_t size_bytes) {
+    if (to_device) {
+      snapshot.to_device_count++;
+      snapshot.to_device_bytes += size_bytes;
+    } else {
+      snapshot.from_device_count++;
+      snapshot.from_device_bytes += size_bytes;
+    }
+    return;
+  }
+
+  /**
+   * @brief Starts filling the labels of the next update.
+   *
+   * @param num_objects Number of tracked objects.
+   */
+  void clear_labels(const size_t num_objects) {
+    snapshot.num_objects = num_objects;
+    snapshot.num_labels = 0;
+    snapshot.num_other_labels = 0;
+    return;
+  }
+
+  /**
+   * @brief Adds a label to the next update, in order of decreasing memory
+   * used.
+   *
+   * @param label      Label of the objects.
+   * @param host_bytes Host memory used by the objects.
+   * @param dev_bytes  Device memory used by the objects.
+   */
+  void add_label(const std::string &label, const size_t host_bytes,
+                 const size_t dev_bytes);
+
+  /**
+   * @brief Sets the number of labels left out of the next update.
+   *
+   * @param num_other_labels Number of labels that did not fit.
+   */
+  void set_other_labels(const size_t num_other_labels) {
+    snapshot.num_other_labels = num_other_labels;
+    return;
+  }
+
+  /**
+   * @brief Writes the counters into the statistics page.
+   */
+  void publish();
+
+private:
+  std::string name;        /*!< name of the page */
+  StatsPage *page;         /*!< mapping of the page */
+  StatsSnapshot snapshot;  /*!< counters of the next update */
+  double interval_seconds; /*!< minimum interval between updates, in s */
+  std::chrono::steady_clock::time_point
+      next_update; /*!< earliest instant of the next update */
+};
+
+/**
+ * @brief Returns the default name of the statistics page of a process.
+ *
+ * @param pid Process identifier (-1 for the current process).
+ *
+ * @return    Name of the page.
+ */
+std::string default_stats_page_name(const long pid = -1);
+
+/**
+ * @brief Maps a statistics page of another process for reading.
+ *
+ * @param name Name of the page.
+ *
+ * @return     Mapping of the page (nullptr if it does not exist or is not
+ *             a statistics page).
+ */
+const StatsPage *attach_stats_page(const std::string &name);
+
+/**
+ * @brief Unmaps a statistics page mapped by attach_stats_page().
+ *
+ * @param page Mapping of the page (nullptr is ignored).
+ */
+void detach_stats_page(const StatsPage *const page);
+
+/**
+ * @brief Copies a consistent snapshot out of a statistics page.
+ *
+ * @param page     Mapping of the page.
+ * @param snapshot Copy of the published counters.
+ *
+ * @return         Whether a consistent copy was made (the writer may keep
+ *                 updating the page in the meantime).
+ */
+bool read_stats_page(const StatsPage *const page, StatsSnapshot &snapshot);
+
+} // namespace MiMMO
@@ -0,0 +1,152 @@
+/**
+ * @file stats_export.inl
+ *
+ * @brief Definition of methods publishing live statistics.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - record_memory()
+ * - record_transfer()
+ * - export_stats()
+ * - enable_stats_export()
+ * - disable_stats_export()
+ * - publish_stats()
+ *
+ * @see api.hpp for the corresponding declarations
+ * @see stats_export.cpp for the statistics page
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Records allocations and frees of dual objects for phases and
+ * live statistics.
+ *
+ * @param num_allocs Number of allocated objects.
+ * @param num_frees  Number of freed objects.
+ */
+inline void DualMemoryManager::record_memory(const size_t num_allocs,
+                                             const size_t num_frees) {
+  phases.record_memory(num_allocs, num_frees, total_memory);
+
+  if (!stats_exporter.enabled())
+    return;
+
+  stats_exporter.record_memory(num_allocs, num_frees, total_memory);
+  if (stats_exporter.due())
+    export_stats();
+
+  return;
+}
+
+/**
+ * @brief Records a host-device transfer for phases and live statistics.
+ *
+ * @param to_device  Whether data was copied from host to device (or the
+ *                   other way round).
+ * @param size_bytes Number of bytes copied.
+ * @param seconds    Time of the transfer, in s.
+ */
+inline void DualMemoryManager::record_transfer(const bool to_device,
+                                               const size_t size_bytes,
+                                               const double seconds) {
+  phases.record_transfer(to_device, size_bytes, seconds);
+
+  if (!stats_exporter.enabled())
+    return;
+
+  stats_exporter.record_transfer(to_device, size_bytes);
+  if (stats_exporter.due())
+    export_stats();
+
+  return;
+}
+
+/**
+ * @brief Writes live statistics, with memory used by label, into the
+ * statistics page.
+ *
+ * @details
+ * Memory used by label is kept up to date by the memory tracker, so only
+ * the labels using the most memory are selected here (ties broken by
+ * name), through a heap bounded by the capacity of the page.
+ */
+inline void DualMemoryManager::export_stats() {
+
+  using LabelEntry = std::pair<const std::string, LabelMemory>;
+
+  const auto used = [](const LabelEntry *const entry) {
+    return entry->second.host_bytes + entry->second.dev_bytes;
+  };
+  const auto uses_more = [&used](const LabelEntry *const a,
+                                 const LabelEntry *const b) {
+    return used(a) > used(b) || (used(a) == used(b) && a->first < b->first);
+  };
+
+  /* keep the labels using the most memory in a min-heap */
+  std::array<const LabelEntry *, stats_max_labels> top;
+  size_t num_top = 0;
+
+  for (const LabelEntry &entry : label_memory) {
+    if (num_top < stats_max_labels) {
+      top[num_top++] = &entry;
+      std::push_heap(top.begin(), top.begin() + num_top, uses_more);
+    } else if (uses_more(&entry, top[0])) {
+      std::pop_heap(top.begin(), top.begin() + num_top, uses_more);
+      top[num_top - 1] = &entry;
+      std::push_heap(top.begin(), top.begin() + num_top, uses_more);
+    }
+  }
+
+  std::sort_heap(top.begin(), top.begin() + num_top, uses_more);
+
+  stats_exporter.clear_labels(memory_tracker.size());
+  for (size_t i = 0; i < num_top; i++)
+    stats_exporter.add_label(top[i]->first, top[i]->second.host_bytes,
+                             top[i]->second.dev_bytes);
+  stats_exporter.set_other_labels(label_memory.size() - num_top);
+
+  stats_exporter.record_memory(0, 0, total_memory);
+  stats_exporter.publish();
+
+  return;
+}
+
+/**
+ * @brief Starts publishing live statistics into a shared-memory page.
+ *
+ * @param name       Name of the page (by default "mimmo-stats-<pid>").
+ * @param interval_s Minimum interval between updates, in seconds.
+ *
+ * @return           Name of the page.
+ */
+inline std::string
+DualMemoryManager::enable_stats_export(const std::string &name,
+                                       const double interval_s) {
+
+  stats_exporter.open(name.empty() ? default_stats_page_name() : name,
+                      interval_s);
+  export_stats();
+
+  return stats_exporter.page_name();
+}
+
+/**
+ * @brief Stops publishing live statistics and removes the page.
+ */
+inline void DualMemoryManager::disable_stats_export() {
+  stats_exporter.close();
+  return;
+}
+
+/**
+ * @brief Updates the live statistics page immediately.
+ */
+inline void DualMemoryManager::publish_stats() {
+  if (stats_exporter.enabled())
+    export_stats();
+  return;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,117 @@
+/**
+ * @file task_graph.hpp
+ *
+ * @brief Declaration of the structures of task graphs.
+ *
+ * A task graph runs tasks that declare which dual arrays and scalars they
+ * read and write, on host or device. From these declarations the graph
+ * tracks on which side each object is up to date, enqueues only the
+ * transfers that tasks need, runs independent device tasks on separate
+ * asynchronous queues, and orders dependent work with waits between
+ * queues, so that transfers overlap with compute.
+ *
+ * @see task_graph.cpp for implementations
+ * @see task_graph.inl for the access declarations of dual objects
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace MiMMO {
+
+class DualMemoryManager;
+
+/**
+ * @brief First asynchronous queue of task graphs.
+ */
+constexpr int task_queue_base = 1 << 21;
+
+/**
+ * @brief Default number of asynchronous queues of a task graph.
+ */
+constexpr int task_num_queues = 4;
+
+/**
+ * @brief Access of a task to a dual object.
+ */
+enum class TaskAccessMode {
+  Read,     /*!< data is only read */
+  Write,    /*!< data is entirely overwritten, without being read */
+  ReadWrite /*!< data is read and modified */
+};
+
+/**
+ * @brief Stores the access of a task to a dual object.
+ */
+struct TaskAccess {
+  const void *object;  /*!< address of the dual object */
+  TaskAccessMode mode; /*!< access to the object */
+  size_t size_bytes;   /*!< size in bytes of the object */
+  std::function<void(DualMemoryManager &, bool, int)>
+      transfer; /*!< enqueues a copy of the object, to device (or to host),
+                     on a queue */
+};
+
+/**
+ * @brief Stores a task of a task graph.
+ */
+struct GraphTask {
+  std::string name;                 /*!< name of the task */
+  bool on_device;                   /*!< whether the task accesses device
+                                         (or host) data */
+  std::vector<TaskAccess> accesses; /*!< accesses of the task */
+  std::function<void(int)> run;     /*!< work of the task, given its queue
+                                         (-1 for host tasks) */
+};
+
+/**
+ * @brief Stores a task or a transfer executed by a task graph.
+ */
+struct GraphNode {
+  std::string name;         /*!< name of the task, or label of the copied
+                                 object */
+  bool is_transfer;         /*!< whether the node is a transfer (or a
+                                 task) */
+  bool on_device;           /*!< device task or copy to device (or host
+                                 task or copy to host) */
+  int queue;                /*!< queue of the node (-1 on host) */
+  size_t size_bytes;        /*!< bytes copied by a transfer */
+  std::vector<size_t> deps; /*!< nodes the node depends on */
+};
+
+/**
+ * @brief Stores on which sides a dual object is up to date.
+ */
+struct GraphObjectState {
+  bool host_valid; /*!< whether host data is up to date */
+  bool dev_valid;  /*!< whether device data is up to date */
+};
+
+/**
+ * @brief Stores the nodes of an execution that accessed a dual object.
+ */
+struct GraphObjectUse {
+  long last_writer;            /*!< node that last wrote the object (-1 if
+                                    none) */
+  std::vector<size_t> readers; /*!< nodes that read the object since */
+};
+
+/**
+ * @brief Stores statistics of the last execution of a task graph.
+ */
+struct TaskGraphStats {
+  size_t num_tasks;       /*!< number of tasks run */
+  size_t num_uploads;     /*!< number of host-to-device transfers */
+  size_t upload_bytes;    /*!< bytes copied from host to device */
+  size_t num_downloads;   /*!< number of device-to-host transfers */
+  size_t download_bytes;  /*!< bytes copied from device to host */
+  size_t num_queue_waits; /*!< number of waits between queues */
+  size_t num_host_waits;  /*!< number of waits of the host for a queue */
+  size_t num_queues;      /*!< number of queues used */
+};
+
+} // namespace MiMMO
@@ -0,0 +1,156 @@
+/**
+ * @file task_graph.inl
+ *
+ * @brief Definition of the access declarations of task graphs.
+ *
+ * Implements the following functions:
+ * - reads()
+ * - writes()
+ * - reads_writes()
+ *
+ * @see api.hpp for the corresponding declarations
+ * @see task_graph.cpp for the TaskGraph methods
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Returns the access of a task to a dual array.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array accessed by the task.
+ * @param mode       Access to the array.
+ *
+ * @return           Access of the task, copying the whole array.
+ */
+template <typename T>
+TaskAccess array_access(DualArray<T> &dual_array, const TaskAccessMode mode) {
+
+  DualArray<T> *const array = &dual_array;
+
+  const auto transfer = [array](DualMemoryManager &manager,
+                                const bool to_device, const int queue) {
+    if (to_device)
+      manager.update_array_host_to_device_async(*array, 0, array->size,
+                                                queue);
+    else
+      manager.update_array_device_to_host_async(*array, 0, array->size,
+                                                queue);
+    return;
+  };
+
+  return {array, mode, dual_array.size_bytes, transfer};
+}
+
+/**
+ * @brief Returns the access of a task to a dual scalar.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar accessed by the task.
+ * @param mode        Access to the scalar.
+ *
+ * @return            Access of the task, copying the value.
+ */
+template <typename T>
+TaskAccess scalar_access(DualScalar<T> &dual_scalar,
+                         const TaskAccessMode mode) {
+
+  DualScalar<T> *const scalar = &dual_scalar;
+
+  const auto transfer = [scalar](DualMemoryManager &manager,
+                                 const bool to_device, const int queue) {
+    if (to_device)
+      manager.update_scalar_host_to_device_async(*scalar, queue);
+    else
+      manager.update_scalar_device_to_host_async(*scalar, queue);
+    return;
+  };
+
+  return {scalar, mode, sizeof(T), transfer};
+}
+
+/**
+ * @brief Declares that a task reads a dual array.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array read by the task.
+ *
+ * @return           Access of the task.
+ */
+template <typename T> TaskAccess reads(DualArray<T> &dual_array) {
+  return array_access(dual_array, TaskAccessMode::Read);
+}
+
+/**
+ * @brief Declares that a task overwrites a dual array without reading
+ * it.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array written by the task.
+ *
+ * @return           Access of the task.
+ */
+template <typename T> TaskAccess writes(DualArray<T> &dual_array) {
+  return array_access(dual_array, TaskAccessMode::Write);
+}
+
+/**
+ * @brief Declares that a task reads and modifies a dual array.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array read and written by the task.
+ *
+ * @return           Access of the task.
+ */
+template <typename T> TaskAccess reads_writes(DualArray<T> &dual_array) {
+  return array_access(dual_array, TaskAccessMode::ReadWrite);
+}
+
+/**
+ * @brief Declares that a task reads a dual scalar.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar read by the task.
+ *
+ * @return            Access of the task.
+ */
+template <typename T> TaskAccess reads(DualScalar<T> &dual_scalar) {
+  return scalar_access(dual_scalar, TaskAccessMode::Read);
+}
+
+/**
+ * @brief Declares that a task overwrites a dual scalar without reading
+ * it.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar written by the task.
+ *
+ * @return            Access of the task.
+ */
+template <typename T> TaskAccess writes(DualScalar<T> &dual_scalar) {
+  return scalar_access(dual_scalar, TaskAccessMode::Write);
+}
+
+/**
+ * @brief Declares that a task reads and modifies a dual scalar.
+ *
+ * @tparam T          Type of the scalar variable.
+ *
+ * @param dual_scalar Dual scalar read and written by the task.
+ *
+ * @return            Access of the task.
+ */
+template <typename T> TaskAccess reads_writes(DualScalar<T> &dual_scalar) {
+  return scalar_access(dual_scalar, TaskAccessMode::ReadWrite);
+}
+
+} // namespace MiMMO
@@ -0,0 +1,140 @@
+/**
+ * @file transfer_planner.hpp
+ *
+ * @brief Declaration of the transfer model and planner.
+ *
+ * Internal utilities for planning transfers of several ranges of a dual
+ * array: overlapping ranges are merged, many small ranges are packed
+ * into a staging buffer, and large payloads are split into pipelined
+ * chunks. Decisions are based on a latency/bandwidth model of the
+ * machine, measured by DualMemoryManager::calibrate_transfers().
+ *
+ * @see transfer_planner.cpp for implementations
+ * @see transfer_planner.inl for the corresponding DualMemoryManager
+ *      methods
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace MiMMO {
+
+/**
+ * @brief First queue used for pipelined chunks of planned transfers.
+ */
+constexpr int planner_queue_base = 1 << 20;
+
+/**
+ * @brief Number of queues used for pipelined chunks of planned transfers.
+ */
+constexpr int planner_num_queues = 2;
+
+/**
+ * @brief Stores a measured transfer time.
+ */
+struct TransferSample {
+  size_t size_bytes; /*!< number of bytes transferred */
+  double seconds;    /*!< time of the transfer */
+};
+
+/**
+ * @brief Stores the latency/bandwidth model of host-device transfers.
+ *
+ * @details
+ * The time of a transfer of s bytes is modeled as latency + s /
+ * bandwidth, separately for each direction.
+ */
+struct TransferModel {
+  std::string backend;          /*!< name of the calibrated backend
+                                     (empty if not calibrated) */
+  double to_device_latency;     /*!< host-to-device latency, in s */
+  double to_device_bandwidth;   /*!< host-to-device bandwidth, in B/s */
+  double from_device_latency;   /*!< device-to-host latency, in s */
+  double from_device_bandwidth; /*!< device-to-host bandwidth, in B/s */
+  double host_bandwidth;        /*!< host copy bandwidth, in B/s */
+  std::vector<TransferSample>
+      to_device_samples; /*!< measured host-to-device curve */
+  std::vector<TransferSample>
+      from_device_samples; /*!< measured device-to-host curve */
+};
+
+/**
+ * @brief Stores a range of elements of a dual array.
+ */
+struct TransferRange {
+  size_t offset;       /*!< index of first element */
+  size_t num_elements; /*!< number of elements */
+};
+
+/**
+ * @brief Stores the plan of a multi-range transfer.
+ */
+struct TransferPlan {
+  std::vector<TransferRange> ranges; /*!< merged ranges to be
+                                          transferred */
+  bool staged;                       /*!< whether ranges are packed into a
+                                          staging buffer and moved as a
+                                          single payload */
+  size_t chunk_bytes;                /*!< size of pipelined chunks (0 if
+                                          payloads are not split) */
+  double estimated_seconds;          /*!< modeled time of the plan */
+};
+
+/**
+ * @brief Returns the model used before any calibration.
+ *
+ * @return Model of a typical PCIe-attached device.
+ */
+TransferModel default_transfer_model();
+
+/**
+ * @brief Fits latency and bandwidth of a model to its measured curves.
+ *
+ * @param model Model whose samples should be fitted.
+ */
+void fit_transfer_model(TransferModel &model);
+
+/**
+ * @brief Loads a model from a calibration file.
+ *
+ * @param file_name Name of the calibration file.
+ * @param backend   Name of the backend the model must refer to.
+ * @param model     Model to be loaded.
+ *
+ * @return          'true' if a valid model for the backend was loaded,
+ *                  'false' otherwise.
+ */
+bool load_transfer_model(const std::string &file_name,
+                         const std::string &backend, TransferModel &model);
+
+/**
+ * @brief Saves a model to a calibration file.
+ *
+ * @param file_name Name of the calibration file.
+ * @param model     Model to be saved.
+ *
+ * @return          'true' if the file was written, 'false' otherwise.
+ */
+bool save_transfer_model(const std::string &file_name,
+                         const TransferModel &model);
+
+/**
+ * @brief Plans the transfer of several ranges of an array.
+ *
+ * @param model         Transfer model of the machine.
+ * @param ranges        Ranges to be transferred (in any order, possibly
+ *                      overlapping).
+ * @param element_bytes Size in bytes of each element.
+ * @param to_device     Whether data is copied from host to device (or
+ *                      the other way round).
+ *
+ * @return              Plan of the transfer.
+ */
+TransferPlan plan_transfer(const TransferModel &model,
+                           std::vector<TransferRange> ranges,
+                           const size_t element_bytes, const bool to_device);
+
+} // namespace MiMMO
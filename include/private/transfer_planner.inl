@@ -0,0 +1,326 @@
+/**
+ * @file transfer_planner.inl
+ *
+ * @brief Definition of methods for planned multi-range transfers.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - update_array_ranges_host_to_device()
+ * - update_array_ranges_device_to_host()
+ * - update_array_ranges()
+ * - transfer_chunked()
+ * - set_transfer_model()
+ * - get_transfer_model()
+ *
+ * @see api.hpp for the corresponding declarations
+ * @see transfer_planner.cpp for the planner and calibrate_transfers()
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Copies a contiguous buffer between host and device, possibly
+ * split into pipelined chunks.
+ *
+ * @param dst_ptr     Destination buffer.
+ * @param src_ptr     Source buffer.
+ * @param size_bytes  Number of bytes to be copied.
+ * @param to_device   Whether data is copied from host to device (or the
+ *                    other way round).
+ * @param chunk_bytes Size of chunks (0 for a single transfer).
+ */
+inline void DualMemoryManager::transfer_chunked(void *const dst_ptr,
+                                                const void *const src_ptr,
+                                                const size_t size_bytes,
+                                                const bool to_device,
+                                                const size_t chunk_bytes) {
+
+  /* single transfer */
+  if (chunk_bytes == 0 || size_bytes <= chunk_bytes) {
+    if (to_device)
+      copy_to_device(dst_ptr, src_ptr, size_bytes);
+    else
+      copy_from_device(dst_ptr, src_ptr, size_bytes);
+    return;
+  }
+
+  /* enqueue chunks on alternating queues, then wait for all of them */
+  const auto start = std::chrono::steady_clock::now();
+  int chunk_index = 0;
+  for (size_t begin = 0; begin < size_bytes; begin += chunk_bytes) {
+    const size_t bytes = std::min(chunk_bytes, size_bytes - begin);
+    const int queue = planner_queue_base + chunk_index % planner_num_queues;
+
+    if (to_device)
+      backend->memcpy_to_device_async((char *)dst_ptr + begin,
+                                      (const char *)src_ptr + begin, bytes,
+                                      queue);
+    else
+      backend->memcpy_from_device_async((char *)dst_ptr + begin,
+                                        (const char *)src_ptr + begin, bytes,
+                                        queue);
+    chunk_index++;
+  }
+
+  for (int q = 0; q < planner_num_queues; q++)
+    backend->wait(planner_queue_base + q);
+
+  record_transfer(to_device, size_bytes, seconds_since(start));
+
+  return;
+}
+
+/**
+ * @brief Performs a planned multi-range transfer in the requested
+ * direction.
+ *
+ * @details
+ * Staged payloads are laid out as a table of ranges (offset, number of
+ * elements and position in the payload of each range) followed by the
+ * packed values.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to synchronize.
+ * @param ranges     Ranges of elements to be copied.
+ * @param to_device  Whether data should be copied from host to device (or
+ *                   the other way round).
+ *
+ * @return           Number of bytes moved between host and device.
+ */
+template <typename T>
+size_t DualMemoryManager::update_array_ranges(
+    DualArray<T> &dual_array, const std::vector<TransferRange> &ranges,
+    const bool to_device) {
+  /* materialize lazily allocated memory */
+  if (dual_array.host_ptr == nullptr)
+    materialize(dual_array, Side::Host);
+
+  /* check bounds */
+  for (const TransferRange &range : ranges)
+    if (range.offset + range.num_elements > dual_array.size)
+      abort_mimmo("Transfer range exceeds size of dual array.");
+
+  if (!backend->has_device())
+    return 0;
+
+  if (!to_device)
+    check_host_writable(&dual_array);
+
+  const DeviceScope scope(*backend, object_device(&dual_array));
+
+  if (dual_array.dev_ptr == nullptr)
+    materialize(dual_array, Side::Device);
+
+  const TransferPlan plan =
+      plan_transfer(transfer_model, ranges, sizeof(T), to_device);
+
+  /* move each range on its own */
+  if (!plan.staged) {
+    size_t moved_bytes = 0;
+    for (const TransferRange &range : plan.ranges) {
+      moved_bytes += range.num_elements * sizeof(T);
+      if (to_device)
+        transfer_chunked(dual_array.dev_ptr + range.offset,
+                         dual_array.host_ptr + range.offset,
+                         range.num_elements * sizeof(T), true,
+                         plan.chunk_bytes);
+      else
+        transfer_chunked(dual_array.host_ptr + range.offset,
+                         dual_array.dev_ptr + range.offset,
+                         range.num_elements * sizeof(T), false,
+                         plan.chunk_bytes);
+    }
+    return moved_bytes;
+  }
+
+  /* prepare staging buffers (values are aligned after the table) */
+  const size_t num_ranges = plan.ranges.size();
+  const size_t alignment = std::max(alignof(T), sizeof(size_t));
+  const size_t table_bytes = 3 * num_ranges * sizeof(size_t);
+  const size_t values_offset =
+      (table_bytes + alignment - 1) / alignment * alignment;
+
+  size_t num_values = 0;
+  for (const TransferRange &range : plan.ranges)
+    num_values += range.num_elements;
+
+  const size_t payload_bytes = values_offset + num_values * sizeof(T);
+  reserve_staging_buffers(payload_bytes);
+
+  size_t *const host_table = (size_t *)staging_host_ptr;
+  T *const host_values = (T *)((char *)staging_host_ptr + values_offset);
+  const size_t *const dev_table = (const size_t *)staging_dev_ptr;
+  T *const dev_values = (T *)((char *)staging_dev_ptr + values_offset);
+  T *const array_dev_ptr = dual_array.dev_ptr;
+
+  size_t index = 0;
+  for (size_t r = 0; r < num_ranges; r++) {
+    host_table[3 * r] = plan.ranges[r].offset;
+    host_table[3 * r + 1] = plan.ranges[r].num_elements;
+    host_table[3 * r + 2] = index;
+    index += plan.ranges[r].num_elements;
+  }
+
+  if (to_device) {
+    /* pack values on host, sending each chunk as soon as it is ready */
+    const size_t chunk_bytes =
+        (plan.chunk_bytes > 0) ? plan.chunk_bytes : payload_bytes;
+    const size_t piece = std::max(chunk_bytes / sizeof(T), size_t(1));
+    size_t sent = 0;
+    int chunk_index = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    const auto send_until = [&](const size_t end, const bool all) {
+      while (end - sent >= chunk_bytes || (all && end > sent)) {
+        const size_t bytes = std::min(chunk_bytes, end - sent);
+        backend->memcpy_to_device_async(
+            (char *)staging_dev_ptr + sent, (char *)staging_host_ptr + sent,
+            bytes, planner_queue_base + chunk_index % planner_num_queues);
+        sent += bytes;
+        chunk_index++;
+      }
+    };
+
+    for (size_t r = 0; r < num_ranges; r++) {
+      const TransferRange &range = plan.ranges[r];
+      for (size_t i = 0; i < range.num_elements; i += piece) {
+        const size_t count = std::min(piece, range.num_elements - i);
+        parallel_memcpy(host_values + host_table[3 * r + 2] + i,
+                        dual_array.host_ptr + range.offset + i,
+                        count * sizeof(T));
+        if (plan.chunk_bytes > 0)
+          send_until(values_offset +
+                         (host_table[3 * r + 2] + i + count) * sizeof(T),
+                     false);
+      }
+    }
+
+    if (plan.chunk_bytes > 0) {
+      send_until(payload_bytes, true);
+      for (int q = 0; q < planner_num_queues; q++)
+        backend->wait(planner_queue_base + q);
+
+      /* time of the pipeline, overlapping packing */
+      record_transfer(true, payload_bytes, seconds_since(start));
+    } else {
+      copy_to_device(staging_dev_ptr, staging_host_ptr, payload_bytes);
+    }
+
+    /* unpack values on device */
+#ifdef _OPENACC
+#pragma acc parallel loop gang deviceptr(array_dev_ptr, dev_table, dev_values)
+    for (size_t r = 0; r < num_ranges; r++) {
+      const size_t offset = dev_table[3 * r];
+      const size_t count = dev_table[3 * r + 1];
+      const size_t position = dev_table[3 * r + 2];
+#pragma acc loop vector
+      for (size_t i = 0; i < count; i++)
+        array_dev_ptr[offset + i] = dev_values[position + i];
+    }
+#else
+    /* emulated device memory is addressable from host */
+    for (size_t r = 0; r < num_ranges; r++)
+      std::memcpy(array_dev_ptr + dev_table[3 * r],
+                  dev_values + dev_table[3 * r + 2],
+                  dev_table[3 * r + 1] * sizeof(T));
+#endif // _OPENACC
+
+  } else {
+    /* move table to device and pack values there */
+    copy_to_device(staging_dev_ptr, staging_host_ptr, table_bytes);
+
+#ifdef _OPENACC
+#pragma acc parallel loop gang deviceptr(array_dev_ptr, dev_table, dev_values)
+    for (size_t r = 0; r < num_ranges; r++) {
+      const size_t offset = dev_table[3 * r];
+      const size_t count = dev_table[3 * r + 1];
+      const size_t position = dev_table[3 * r + 2];
+#pragma acc loop vector
+      for (size_t i = 0; i < count; i++)
+        dev_values[position + i] = array_dev_ptr[offset + i];
+    }
+#else
+    /* emulated device memory is addressable from host */
+    for (size_t r = 0; r < num_ranges; r++)
+      std::memcpy(dev_values + dev_table[3 * r + 2],
+                  array_dev_ptr + dev_table[3 * r],
+                  dev_table[3 * r + 1] * sizeof(T));
+#endif // _OPENACC
+
+    /* move values and unpack them on host */
+    transfer_chunked(host_values, dev_values, num_values * sizeof(T), false,
+                     plan.chunk_bytes);
+
+    for (size_t r = 0; r < num_ranges; r++)
+      parallel_memcpy(dual_array.host_ptr + plan.ranges[r].offset,
+                      host_values + host_table[3 * r + 2],
+                      plan.ranges[r].num_elements * sizeof(T));
+  }
+
+  /* values and table go to device, or only values come back */
+  return to_device ? payload_bytes : table_bytes + num_values * sizeof(T);
+}
+
+/**
+ * @brief Copies several ranges of elements from host to device.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to synchronize.
+ * @param ranges     Ranges of elements to be copied.
+ *
+ * @note If a range exceeds the size of the array, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_array_ranges_host_to_device(
+    DualArray<T> &dual_array, const std::vector<TransferRange> &ranges) {
+  update_array_ranges(dual_array, ranges, true);
+  return;
+}
+
+/**
+ * @brief Copies several ranges of elements from device to host.
+ *
+ * @tparam T         Type of elements in the array.
+ *
+ * @param dual_array Dual array to synchronize.
+ * @param ranges     Ranges of elements to be copied.
+ *
+ * @note If a range exceeds the size of the array, the program aborts.
+ * @note Without device memory, this function does nothing.
+ */
+template <typename T>
+void DualMemoryManager::update_array_ranges_device_to_host(
+    DualArray<T> &dual_array, const std::vector<TransferRange> &ranges) {
+  update_array_ranges(dual_array, ranges, false);
+  return;
+}
+
+/**
+ * @brief Sets the transfer model used by the planner.
+ *
+ * @param model Transfer model (e.g. measured on another run).
+ */
+inline void DualMemoryManager::set_transfer_model(const TransferModel &model) {
+  if (model.to_device_bandwidth <= 0.0 || model.from_device_bandwidth <= 0.0 ||
+      model.host_bandwidth <= 0.0)
+    abort_mimmo("Bandwidths of transfer model must be positive.");
+
+  transfer_model = model;
+
+  return;
+}
+
+/**
+ * @brief Returns the transfer model used by the planner.
+ *
+ * @return Current transfer model.
+ */
+inline const TransferModel &DualMemoryManager::get_transfer_model() const {
+  return transfer_model;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,62 @@
+/**
+ * @file transfer_profiler.hpp
+ *
+ * @brief Declaration of the structures of the transfer profiler.
+ *
+ * In profiling mode, the memory manager checks each host-device transfer
+ * of dual arrays and scalars for redundancy, i.e. whether it moved data
+ * already identical on both sides, and counts wasted bytes per label and
+ * call site.
+ *
+ * @see transfer_profiler.inl for the corresponding DualMemoryManager
+ *      methods
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace MiMMO {
+
+/**
+ * @brief Stores the source location of a call.
+ *
+ * @details
+ * Used as a default argument, current() records the location of the
+ * caller, like std::source_location in C++20.
+ */
+struct SourceLocation {
+  const char *file; /*!< name of the source file */
+  int line;         /*!< line in the source file */
+
+  /**
+   * @brief Returns the location of the call using it as default argument.
+   *
+   * @param file Name of the source file (filled in by the compiler).
+   * @param line Line in the source file (filled in by the compiler).
+   *
+   * @return     Location of the call.
+   */
+  static SourceLocation current(const char *const file = __builtin_FILE(),
+                                const int line = __builtin_LINE()) {
+    return {file, line};
+  }
+};
+
+/**
+ * @brief Stores transfer statistics of a call site, collected in
+ * profiling mode.
+ */
+struct TransferSiteStats {
+  std::string label;        /*!< label of the transferred object */
+  std::string file;         /*!< source file of the call site */
+  int line;                 /*!< line of the call site */
+  bool to_device;           /*!< whether transfers are host to device */
+  size_t num_transfers;     /*!< number of transfers */
+  size_t num_redundant;     /*!< number of redundant transfers */
+  size_t transferred_bytes; /*!< bytes moved by all transfers */
+  size_t wasted_bytes;      /*!< bytes moved by redundant transfers */
+};
+
+} // namespace MiMMO
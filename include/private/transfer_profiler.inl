@@ -0,0 +1,119 @@
+/**
+ * @file transfer_profiler.inl
+ *
+ * @brief Definition of methods of the transfer profiler.
+ *
+ * Implements the following DualMemoryManager methods:
+ * - profile_transfer()
+ * - release_transfer_state()
+ * - set_transfer_profiling()
+ * - return_transfer_profile()
+ *
+ * @see api.hpp for the corresponding declarations
+ */
+
+#pragma once
+
+namespace MiMMO {
+
+/**
+ * @brief Records a profiled transfer of a tracked object.
+ *
+ * @details
+ * The checksum of the transferred range, as left on both sides, becomes
+ * the shadow checksum of the range. A transfer is redundant if host data
+ * matched the shadow checksum before an upload, or did not change with
+ * a download.
+ *
+ * @param object     Pointer to the tracked object.
+ * @param offset     Offset in bytes of the range in the object.
+ * @param size_bytes Number of bytes transferred.
+ * @param old_hash   Checksum of host data before the transfer.
+ * @param new_hash   Checksum of host data after the transfer.
+ * @param to_device  Whether data was copied from host to device (or the
+ *                   other way round).
+ * @param location   Call site of the transfer.
+ */
+inline void DualMemoryManager::profile_transfer(
+    void *const object, const size_t offset, const size_t size_bytes,
+    const uint64_t old_hash, const uint64_t new_hash, const bool to_device,
+    const SourceLocation &location) {
+
+  /* compare with the shadow checksum of the range */
+  std::map<std::pair<size_t, size_t>, uint64_t> &shadows =
+      transfer_shadows[object];
+  const auto shadow = shadows.find({offset, size_bytes});
+
+  const bool redundant =
+      to_device ? (shadow != shadows.end() && shadow->second == old_hash)
+                : (old_hash == new_hash);
+
+  shadows[{offset, size_bytes}] = new_hash;
+
+  /* update statistics of the call site */
+  const auto it = memory_tracker.find(object);
+  const std::string label = it != memory_tracker.end() ? it->second.label : "";
+
+  TransferSiteStats &site =
+      transfer_sites[{label, location.file, location.line, to_device}];
+
+  if (site.num_transfers == 0)
+    site = {label, location.file, location.line, to_device, 0, 0, 0, 0};
+
+  site.num_transfers++;
+  site.transferred_bytes += size_bytes;
+
+  if (redundant) {
+    site.num_redundant++;
+    site.wasted_bytes += size_bytes;
+  }
+
+  return;
+}
+
+/**
+ * @brief Drops the transfer state (delta synchronization, shadow
+ * checksums and prefetches) of an object being freed.
+ *
+ * @param object Pointer to the object.
+ */
+inline void DualMemoryManager::release_transfer_state(void *const object) {
+  delta_states.erase(object);
+  transfer_shadows.erase(object);
+  drop_prefetches(object);
+  return;
+}
+
+/**
+ * @brief Enables or disables profiling mode of transfers.
+ *
+ * @param enabled Whether transfers should be profiled.
+ */
+inline void DualMemoryManager::set_transfer_profiling(const bool enabled) {
+  transfer_profiling = enabled;
+  transfer_shadows.clear();
+  transfer_sites.clear();
+  return;
+}
+
+/**
+ * @brief Returns the statistics of profiled transfers of each call site.
+ *
+ * @return Statistics of each call site, by decreasing wasted bytes.
+ */
+inline std::vector<TransferSiteStats>
+DualMemoryManager::return_transfer_profile() {
+
+  std::vector<TransferSiteStats> sites;
+  for (const auto &[key, site] : transfer_sites)
+    sites.push_back(site);
+
+  std::stable_sort(sites.begin(), sites.end(),
+                   [](const TransferSiteStats &a, const TransferSiteStats &b) {
+                     return a.wasted_bytes > b.wasted_bytes;
+                   });
+
+  return sites;
+}
+
+} // namespace MiMMO
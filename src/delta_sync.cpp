@@ -0,0 +1,153 @@
+/**
+ * @file delta_sync.cpp
+ *
+ * @brief Implementation of content hashing for delta synchronization.
+ *
+ * @see delta_sync.hpp
+ */
+
+#include "../include/private/delta_sync.hpp"
+#include <cstring>
+
+namespace MiMMO {
+
+/**
+ * @brief Primes of the XXH64 algorithm.
+ */
+static constexpr uint64_t prime_1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t prime_2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t prime_3 = 0x165667B19E3779F9ULL;
+static constexpr uint64_t prime_4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64_t prime_5 = 0x27D4EB2F165667C5ULL;
+
+/**
+ * @brief Rotates a word to the left.
+ *
+ * @param value Word to be rotated.
+ * @param bits  Number of bits of the rotation (between 1 and 63).
+ *
+ * @return      Rotated word.
+ */
+static inline uint64_t rotate_left(const uint64_t value, const int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+/**
+ * @brief Reads a possibly unaligned 64-bit word.
+ *
+ * @param ptr Pointer to the word.
+ *
+ * @return    Word in native byte order.
+ */
+static inline uint64_t read_64(const unsigned char *const ptr) {
+  uint64_t value;
+  std::memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+/**
+ * @brief Reads a possibly unaligned 32-bit word.
+ *
+ * @param ptr Pointer to the word.
+ *
+ * @return    Word in native byte order.
+ */
+static inline uint32_t read_32(const unsigned char *const ptr) {
+  uint32_t value;
+  std::memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+/**
+ * @brief Accumulates a word into a lane.
+ *
+ * @param acc   Lane accumulator.
+ * @param input Word to be accumulated.
+ *
+ * @return      Updated accumulator.
+ */
+static inline uint64_t hash_round(uint64_t acc, const uint64_t input) {
+  acc += input * prime_2;
+  acc = rotate_left(acc, 31);
+  return acc * prime_1;
+}
+
+/**
+ * @brief Merges a lane into the hash.
+ *
+ * @param acc  Hash accumulator.
+ * @param lane Lane to be merged.
+ *
+ * @return     Updated accumulator.
+ */
+static inline uint64_t merge_round(uint64_t acc, const uint64_t lane) {
+  acc ^= hash_round(0, lane);
+  return acc * prime_1 + prime_4;
+}
+
+/**
+ * @brief Computes the XXH64 hash of a buffer.
+ *
+ * @param data       Buffer to be hashed.
+ * @param size_bytes Size in bytes of the buffer.
+ * @param seed       Seed of the hash.
+ *
+ * @return           Hash of the buffer.
+ *
+ * @note Words are read in native byte order, so hashes match the
+ *       reference implementation on little-endian machines.
+ */
+uint64_t xxh64(const void *const data, const size_t size_bytes,
+               const uint64_t seed) {
+
+  const unsigned char *ptr = (const unsigned char *)data;
+  const unsigned char *const end = ptr + size_bytes;
+  uint64_t hash;
+
+  /* stripes of 32 bytes, on four lanes */
+  if (size_bytes >= 32) {
+    uint64_t lanes[4] = {seed + prime_1 + prime_2, seed + prime_2, seed,
+                         seed - prime_1};
+
+    for (; ptr + 32 <= end; ptr += 32)
+      for (int l = 0; l < 4; l++)
+        lanes[l] = hash_round(lanes[l], read_64(ptr + 8 * l));
+
+    hash = rotate_left(lanes[0], 1) + rotate_left(lanes[1], 7) +
+           rotate_left(lanes[2], 12) + rotate_left(lanes[3], 18);
+    for (int l = 0; l < 4; l++)
+      hash = merge_round(hash, lanes[l]);
+  } else {
+    hash = seed + prime_5;
+  }
+
+  hash += size_bytes;
+
+  /* remaining words, half-word and bytes */
+  for (; ptr + 8 <= end; ptr += 8) {
+    hash ^= hash_round(0, read_64(ptr));
+    hash = rotate_left(hash, 27) * prime_1 + prime_4;
+  }
+
+  if (ptr + 4 <= end) {
+    hash ^= uint64_t(read_32(ptr)) * prime_1;
+    hash = rotate_left(hash, 23) * prime_2 + prime_3;
+    ptr += 4;
+  }
+
+  for (; ptr < end; ptr++) {
+    hash ^= uint64_t(*ptr) * prime_5;
+    hash = rotate_left(hash, 11) * prime_1;
+  }
+
+  /* final avalanche */
+  hash ^= hash >> 33;
+  hash *= prime_2;
+  hash ^= hash >> 29;
+  hash *= prime_3;
+  hash ^= hash >> 32;
+
+  return hash;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,618 @@
+/**
+ * @file device_backend.cpp
+ *
+ * @brief Implementation of device backends not based on OpenACC.
+ *
+ * @see device_backend.hpp for the corresponding declarations
+ */
+
+#include "../include/private/device_backend.hpp"
+#include "../include/private/abort.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace MiMMO {
+
+/**
+ * @brief Byte pattern written into new emulated device allocations.
+ */
+constexpr unsigned char emulated_garbage = 0xA5;
+
+/* --- backend without device --- */
+
+const char *NoDeviceBackend::name() const { return "none"; }
+
+bool NoDeviceBackend::has_device() const { return false; }
+
+void *NoDeviceBackend::alloc(const size_t) { return nullptr; }
+
+void NoDeviceBackend::free(void *const) { return; }
+
+void NoDeviceBackend::memcpy_to_device(void *const, const void *const,
+                                       const size_t) {
+  return;
+}
+
+void NoDeviceBackend::memcpy_from_device(void *const, const void *const,
+                                         const size_t) {
+  return;
+}
+
+void NoDeviceBackend::memcpy_device(void *const, const void *const,
+                                    const size_t) {
+  return;
+}
+
+void NoDeviceBackend::memcpy_to_device_async(void *const, const void *const,
+                                             const size_t, const int) {
+  return;
+}
+
+void NoDeviceBackend::memcpy_from_device_async(void *const, const void *const,
+                                               const size_t, const int) {
+  return;
+}
+
+void NoDeviceBackend::wait(const int) { return; }
+
+void NoDeviceBackend::wait_all() { return; }
+
+bool NoDeviceBackend::test(const int) { return true; }
+
+/* --- default ordering between queues --- */
+
+void DeviceBackend::wait_async(const int queue, const int) {
+  wait(queue);
+  return;
+}
+
+/* --- defaults for single-device backends --- */
+
+int DeviceBackend::num_devices() const { return has_device() ? 1 : 0; }
+
+int DeviceBackend::get_device() const { return 0; }
+
+void DeviceBackend::set_device(const int device) {
+  if (device != 0)
+    abort_mimmo("Device " + std::to_string(device) + " does not exist.");
+  return;
+}
+
+/**
+ * @brief Copies data between buffers on two devices, through a temporary
+ * host buffer.
+ *
+ * @param dst_ptr    Destination on device.
+ * @param dst_device Device of the destination.
+ * @param src_ptr    Source on device.
+ * @param src_device Device of the source.
+ * @param size_bytes Number of bytes to be copied.
+ */
+void DeviceBackend::memcpy_peer(void *const dst_ptr, const int dst_device,
+                                const void *const src_ptr,
+                                const int src_device,
+                                const size_t size_bytes) {
+  const DeviceScope scope(*this, src_device);
+
+  if (src_device == dst_device) {
+    memcpy_device(dst_ptr, src_ptr, size_bytes);
+    return;
+  }
+
+  std::vector<char> buffer(size_bytes);
+  memcpy_from_device(buffer.data(), src_ptr, size_bytes);
+  set_device(dst_device);
+  memcpy_to_device(dst_ptr, buffer.data(), size_bytes);
+
+  return;
+}
+
+bool DeviceBackend::memory_info(size_t &, size_t &) const { return false; }
+
+/* --- emulated device --- */
+
+/**
+ * @brief Class constructor.
+ *
+ * @param config      Performance model of each device.
+ * @param num_devices Number of emulated devices.
+ *
+ * @note If the number of devices is not positive, the program aborts.
+ */
+EmulatedDeviceBackend::EmulatedDeviceBackend(const EmulatedDeviceConfig config,
+                                             const int num_devices)
+    : config(config), counters({0, 0, 0, 0, 0, 0, 0.0, 0, 0}),
+      device_counters(), allocations(), queues(), link_ready(),
+      current_device(0) {
+  if (num_devices < 1)
+    abort_mimmo("Number of emulated devices must be positive.");
+
+  const Clock::time_point now = Clock::now();
+  device_counters.assign(num_devices, counters);
+  link_ready.assign(num_devices, {now, now, now});
+}
+
+/**
+ * @brief Class destructor.
+ *
+ * @details
+ * Completes enqueued transfers and releases device buffers that were not
+ * freed.
+ */
+EmulatedDeviceBackend::~EmulatedDeviceBackend() {
+  wait_all();
+
+  for (const auto &allocation : allocations)
+    std::free((void *)allocation.first);
+}
+
+const char *EmulatedDeviceBackend::name() const { return "emulated"; }
+
+bool EmulatedDeviceBackend::has_device() const { return true; }
+
+int EmulatedDeviceBackend::num_devices() const {
+  return static_cast<int>(device_counters.size());
+}
+
+int EmulatedDeviceBackend::get_device() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return current_device;
+}
+
+void EmulatedDeviceBackend::set_device(const int device) {
+  if (device < 0 || device >= num_devices())
+    abort_mimmo("Device " + std::to_string(device) + " does not exist.");
+
+  std::lock_guard<std::mutex> lock(mutex);
+  current_device = device;
+
+  return;
+}
+
+/**
+ * @brief Allocates emulated device memory on the current device.
+ *
+ * @param size_bytes Number of bytes to be allocated.
+ *
+ * @return           Pointer to device memory (nullptr if capacity is
+ *                   exceeded).
+ */
+void *EmulatedDeviceBackend::alloc(const size_t size_bytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  EmulatedDeviceStats &device = device_counters[current_device];
+
+  if (config.capacity_bytes > 0 &&
+      device.allocated_bytes + size_bytes > config.capacity_bytes)
+    return nullptr;
+
+  /* allocate at least one byte, so that each buffer has its own address */
+  char *const dev_ptr = (char *)std::malloc(std::max(size_bytes, size_t(1)));
+
+  if (dev_ptr == nullptr)
+    return nullptr;
+
+  std::memset(dev_ptr, emulated_garbage, size_bytes);
+
+  allocations[dev_ptr] = {size_bytes, current_device};
+  for (EmulatedDeviceStats *stats : {&counters, &device}) {
+    stats->allocated_bytes += size_bytes;
+    stats->peak_allocated_bytes =
+        std::max(stats->peak_allocated_bytes, stats->allocated_bytes);
+  }
+
+  return dev_ptr;
+}
+
+/**
+ * @brief Frees emulated device memory.
+ *
+ * @details
+ * Enqueued transfers are completed first, since they may involve the
+ * buffer.
+ *
+ * @param dev_ptr Pointer to device memory.
+ *
+ * @note If the pointer was not allocated by this backend on the current
+ *       device, the program aborts.
+ */
+void EmulatedDeviceBackend::free(void *const dev_ptr) {
+  if (dev_ptr == nullptr)
+    return;
+
+  wait_all();
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  const auto it = allocations.find((const char *)dev_ptr);
+
+  if (it == allocations.end())
+    abort_mimmo("Pointer was not allocated on emulated device.");
+
+  if (it->second.device != current_device)
+    abort_mimmo("Pointer was allocated on emulated device " +
+                std::to_string(it->second.device) + ", not on device " +
+                std::to_string(current_device) + ".");
+
+  counters.allocated_bytes -= it->second.size_bytes;
+  device_counters[current_device].allocated_bytes -= it->second.size_bytes;
+  allocations.erase(it);
+  std::free(dev_ptr);
+
+  return;
+}
+
+/**
+ * @brief Checks that a range lies inside an emulated device buffer.
+ *
+ * @param dev_ptr    First byte of the range.
+ * @param size_bytes Number of bytes of the range.
+ * @param device     Device the buffer must belong to.
+ *
+ * @note If the range is not inside a buffer of the device, the program
+ *       aborts.
+ */
+void EmulatedDeviceBackend::check_range(const void *const dev_ptr,
+                                        const size_t size_bytes,
+                                        const int device) {
+  const char *const begin = (const char *)dev_ptr;
+
+  /* find last buffer starting at or before the range */
+  auto it = allocations.upper_bound(begin);
+
+  if (it == allocations.begin())
+    abort_mimmo("Transfer range is not on emulated device.");
+
+  --it;
+
+  if (begin + size_bytes > it->first + it->second.size_bytes)
+    abort_mimmo("Transfer range is not on emulated device.");
+
+  if (it->second.device != device)
+    abort_mimmo("Transfer range is on emulated device " +
+                std::to_string(it->second.device) + ", not on device " +
+                std::to_string(device) + ".");
+
+  return;
+}
+
+/**
+ * @brief Updates statistics of a transfer and returns its modeled time.
+ *
+ * @param link       Link used by the transfer.
+ * @param size_bytes Number of bytes transferred.
+ * @param device     Device whose statistics are updated.
+ *
+ * @return           Modeled time in seconds.
+ */
+double EmulatedDeviceBackend::model_transfer(const Link link,
+                                             const size_t size_bytes,
+                                             const int device) {
+  const double bandwidth =
+      (link == OnDevice) ? config.dev_bandwidth_gbs : config.bandwidth_gbs;
+  const double latency = (link == OnDevice) ? 0.0 : config.latency_us * 1e-6;
+  const double seconds =
+      latency + ((bandwidth > 0.0) ? size_bytes / (bandwidth * 1e9) : 0.0);
+
+  for (EmulatedDeviceStats *stats : {&counters, &device_counters[device]}) {
+    if (link == ToDevice) {
+      stats->num_to_device++;
+      stats->bytes_to_device += size_bytes;
+    } else if (link == FromDevice) {
+      stats->num_from_device++;
+      stats->bytes_from_device += size_bytes;
+    } else {
+      stats->num_device_copies++;
+      stats->bytes_device_copy += size_bytes;
+    }
+
+    stats->modeled_time_s += seconds;
+  }
+
+  return seconds;
+}
+
+/**
+ * @brief Reserves a link for a transfer and returns its completion time.
+ *
+ * @param link    Link used by the transfer (peer copies use the device
+ *                link of the source).
+ * @param seconds Modeled time of the transfer.
+ * @param device  Device owning the link.
+ *
+ * @return        Time at which the transfer completes.
+ */
+EmulatedDeviceBackend::Clock::time_point
+EmulatedDeviceBackend::schedule(const Link link, const double seconds,
+                                const int device) {
+  Clock::time_point &ready =
+      link_ready[device][(link == Peer) ? OnDevice : link];
+  const Clock::time_point start = std::max(Clock::now(), ready);
+
+  ready = start + std::chrono::duration_cast<Clock::duration>(
+                      std::chrono::duration<double>(seconds));
+
+  return ready;
+}
+
+/**
+ * @brief Performs enqueued transfers, waiting for their completion time
+ * if delays are injected.
+ *
+ * @param copies Transfers to be performed, in order.
+ */
+void EmulatedDeviceBackend::complete(std::vector<PendingCopy> &copies) {
+  for (const PendingCopy &copy : copies) {
+    if (config.inject_delays)
+      std::this_thread::sleep_until(copy.completion);
+    std::memcpy(copy.dst_ptr, copy.src_ptr, copy.size_bytes);
+  }
+
+  copies.clear();
+
+  return;
+}
+
+void EmulatedDeviceBackend::memcpy_to_device(void *const dev_ptr,
+                                             const void *const host_ptr,
+                                             const size_t size_bytes) {
+  std::vector<PendingCopy> copy;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const int device = current_device;
+    check_range(dev_ptr, size_bytes, device);
+    copy.push_back({dev_ptr, host_ptr, size_bytes,
+                    schedule(ToDevice,
+                             model_transfer(ToDevice, size_bytes, device),
+                             device)});
+  }
+
+  complete(copy);
+
+  return;
+}
+
+void EmulatedDeviceBackend::memcpy_from_device(void *const host_ptr,
+                                               const void *const dev_ptr,
+                                               const size_t size_bytes) {
+  std::vector<PendingCopy> copy;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const int device = current_device;
+    check_range(dev_ptr, size_bytes, device);
+    copy.push_back({host_ptr, dev_ptr, size_bytes,
+                    schedule(FromDevice,
+                             model_transfer(FromDevice, size_bytes, device),
+                             device)});
+  }
+
+  complete(copy);
+
+  return;
+}
+
+void EmulatedDeviceBackend::memcpy_device(void *const dst_ptr,
+                                          const void *const src_ptr,
+                                          const size_t size_bytes) {
+  std::vector<PendingCopy> copy;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const int device = current_device;
+    check_range(dst_ptr, size_bytes, device);
+    check_range(src_ptr, size_bytes, device);
+    copy.push_back({dst_ptr, src_ptr, size_bytes,
+                    schedule(OnDevice,
+                             model_transfer(OnDevice, size_bytes, device),
+                             device)});
+  }
+
+  complete(copy);
+
+  return;
+}
+
+/**
+ * @brief Copies data between buffers on two emulated devices.
+ *
+ * @param dst_ptr    Destination on device.
+ * @param dst_device Device of the destination.
+ * @param src_ptr    Source on device.
+ * @param src_device Device of the source.
+ * @param size_bytes Number of bytes to be copied.
+ */
+void EmulatedDeviceBackend::memcpy_peer(void *const dst_ptr,
+                                        const int dst_device,
+                                        const void *const src_ptr,
+                                        const int src_device,
+                                        const size_t size_bytes) {
+  if (src_device == dst_device) {
+    const DeviceScope scope(*this, src_device);
+    memcpy_device(dst_ptr, src_ptr, size_bytes);
+    return;
+  }
+
+  std::vector<PendingCopy> copy;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    check_range(dst_ptr, size_bytes, dst_device);
+    check_range(src_ptr, size_bytes, src_device);
+    copy.push_back({dst_ptr, src_ptr, size_bytes,
+                    schedule(Peer, model_transfer(Peer, size_bytes, src_device),
+                             src_device)});
+  }
+
+  complete(copy);
+
+  return;
+}
+
+/**
+ * @brief Returns free and total memory of the current emulated device.
+ *
+ * @param free_bytes  Capacity not allocated, in bytes.
+ * @param total_bytes Capacity of the device, in bytes.
+ *
+ * @return            Whether the capacity of the device is limited.
+ */
+bool EmulatedDeviceBackend::memory_info(size_t &free_bytes,
+                                        size_t &total_bytes) const {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (config.capacity_bytes == 0)
+    return false;
+
+  const size_t allocated = device_counters[current_device].allocated_bytes;
+  total_bytes = config.capacity_bytes;
+  free_bytes = config.capacity_bytes - std::min(allocated, total_bytes);
+
+  return true;
+}
+
+void EmulatedDeviceBackend::memcpy_to_device_async(void *const dev_ptr,
+                                                   const void *const host_ptr,
+                                                   const size_t size_bytes,
+                                                   const int queue) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  const int device = current_device;
+  check_range(dev_ptr, size_bytes, device);
+  queues[{device, queue}].push_back(
+      {dev_ptr, host_ptr, size_bytes,
+       schedule(ToDevice, model_transfer(ToDevice, size_bytes, device),
+                device)});
+
+  return;
+}
+
+void EmulatedDeviceBackend::memcpy_from_device_async(void *const host_ptr,
+                                                     const void *const dev_ptr,
+                                                     const size_t size_bytes,
+                                                     const int queue) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  const int device = current_device;
+  check_range(dev_ptr, size_bytes, device);
+  queues[{device, queue}].push_back(
+      {host_ptr, dev_ptr, size_bytes,
+       schedule(FromDevice, model_transfer(FromDevice, size_bytes, device),
+                device)});
+
+  return;
+}
+
+void EmulatedDeviceBackend::wait(const int queue) {
+  std::vector<PendingCopy> copies;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = queues.find({current_device, queue});
+    if (it == queues.end())
+      return;
+    copies.swap(it->second);
+    queues.erase(it);
+  }
+
+  complete(copies);
+
+  return;
+}
+
+/**
+ * @brief Waits for all transfers enqueued on any queue of any device.
+ */
+void EmulatedDeviceBackend::wait_all() {
+  std::vector<PendingCopy> copies;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &queue : queues)
+      copies.insert(copies.end(), queue.second.begin(), queue.second.end());
+    queues.clear();
+  }
+
+  /* complete transfers in order of completion time */
+  std::stable_sort(copies.begin(), copies.end(),
+                   [](const PendingCopy &a, const PendingCopy &b) {
+                     return a.completion < b.completion;
+                   });
+  complete(copies);
+
+  return;
+}
+
+/**
+ * @brief Checks whether a queue of the current device is idle,
+ * performing its transfers if their modeled time has elapsed.
+ *
+ * @param queue Queue to be checked.
+ *
+ * @return      Whether the queue is idle.
+ */
+bool EmulatedDeviceBackend::test(const int queue) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = queues.find({current_device, queue});
+    if (it == queues.end())
+      return true;
+    if (config.inject_delays && it->second.back().completion > Clock::now())
+      return false;
+  }
+
+  wait(queue);
+
+  return true;
+}
+
+/**
+ * @brief Returns transfer statistics of all devices.
+ *
+ * @return Statistics since construction or last reset.
+ */
+EmulatedDeviceStats EmulatedDeviceBackend::stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return counters;
+}
+
+/**
+ * @brief Returns transfer statistics of one device.
+ *
+ * @param device Index of the device.
+ *
+ * @return       Statistics since construction or last reset.
+ *
+ * @note If the device does not exist, the program aborts.
+ */
+EmulatedDeviceStats EmulatedDeviceBackend::stats(const int device) {
+  if (device < 0 || device >= num_devices())
+    abort_mimmo("Device " + std::to_string(device) + " does not exist.");
+
+  std::lock_guard<std::mutex> lock(mutex);
+  return device_counters[device];
+}
+
+/**
+ * @brief Resets transfer counters and modeled time.
+ */
+void EmulatedDeviceBackend::reset_stats() {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  for (EmulatedDeviceStats &stats : device_counters)
+    stats = {0, 0, 0, 0, 0, 0, 0.0, stats.allocated_bytes,
+             stats.peak_allocated_bytes};
+
+  counters = {0,   0,   0,
+              0,   0,   0,
+              0.0, counters.allocated_bytes,
+              counters.peak_allocated_bytes};
+
+  return;
+}
+
+} // namespace MiMMO
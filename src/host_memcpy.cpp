@@ -0,0 +1,115 @@
+/**
+ * @file host_memcpy.cpp
+ *
+ * @brief Implementation of host memory copy utilities.
+ *
+ * @see host_memcpy.hpp
+ */
+
+#include "../include/private/host_memcpy.hpp"
+#include "../include/private/host_parallel.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+namespace MiMMO {
+
+/**
+ * @brief Minimum number of bytes handled by each copying thread.
+ */
+static constexpr size_t min_bytes_per_thread = size_t(4) << 20;
+
+/**
+ * @brief Minimum number of bytes for which non-temporal stores are used.
+ */
+static constexpr size_t min_streaming_bytes = size_t(1) << 20;
+
+/**
+ * @brief Copies a host buffer on the calling thread.
+ *
+ * @param dst        Destination buffer.
+ * @param src        Source buffer.
+ * @param size_bytes Number of bytes to be copied.
+ */
+static void serial_memcpy(char *dst, const char *src, size_t size_bytes) {
+
+#ifdef __SSE2__
+  if (size_bytes >= min_streaming_bytes) {
+    /* copy head until destination is aligned to 16 bytes */
+    const size_t head =
+        (16 - (reinterpret_cast<std::uintptr_t>(dst) & 15)) & 15;
+    std::memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size_bytes -= head;
+
+    /* copy body with streaming stores */
+    const size_t body = size_bytes & ~size_t(63);
+    for (size_t i = 0; i < body; i += 64) {
+      const __m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+      const __m128i b = _mm_loadu_si128((const __m128i *)(src + i + 16));
+      const __m128i c = _mm_loadu_si128((const __m128i *)(src + i + 32));
+      const __m128i d = _mm_loadu_si128((const __m128i *)(src + i + 48));
+      _mm_stream_si128((__m128i *)(dst + i), a);
+      _mm_stream_si128((__m128i *)(dst + i + 16), b);
+      _mm_stream_si128((__m128i *)(dst + i + 32), c);
+      _mm_stream_si128((__m128i *)(dst + i + 48), d);
+    }
+
+    /* make streaming stores visible to other threads */
+    _mm_sfence();
+
+    /* copy tail */
+    std::memcpy(dst + body, src + body, size_bytes - body);
+
+    return;
+  }
+#endif // __SSE2__
+
+  std::memcpy(dst, src, size_bytes);
+
+  return;
+}
+
+/**
+ * @brief Copies a host buffer using multiple threads.
+ *
+ * @param dst        Destination buffer.
+ * @param src        Source buffer.
+ * @param size_bytes Number of bytes to be copied.
+ *
+ * @note Source and destination buffers must not overlap.
+ */
+void parallel_memcpy(void *const dst, const void *const src,
+                     const size_t size_bytes) {
+
+  /* choose number of chunks */
+  const size_t num_chunks =
+      std::min(host_num_threads(), std::max(size_bytes / min_bytes_per_thread,
+                                            static_cast<size_t>(1)));
+
+  char *const dst_bytes = static_cast<char *>(dst);
+  const char *const src_bytes = static_cast<const char *>(src);
+
+  /* small copies are done by the calling thread */
+  if (num_chunks == 1) {
+    serial_memcpy(dst_bytes, src_bytes, size_bytes);
+    return;
+  }
+
+  /* split copy in chunks aligned to cache lines */
+  const size_t chunk = ((size_bytes / num_chunks) + 63) & ~size_t(63);
+
+  parallel_for_chunks(num_chunks, [&](const size_t c) {
+    const size_t begin = std::min(c * chunk, size_bytes);
+    const size_t end = std::min(begin + chunk, size_bytes);
+    serial_memcpy(dst_bytes + begin, src_bytes + begin, end - begin);
+  });
+
+  return;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,193 @@
+/**
+ * @file host_parallel.cpp
+ *
+ * @brief Implementation of host-side parallel loop utilities.
+ *
+ * @see host_parallel.hpp
+ */
+
+#include "../include/private/host_parallel.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MiMMO {
+
+/**
+ * @brief Persistent pool of worker threads.
+ *
+ * @details
+ * Workers sleep until a new set of chunks is published. Chunks are
+ * assigned statically: thread t (the calling thread being thread 0) runs
+ * chunks t, t + T, t + 2T, ..., with T threads. Since loops over the same
+ * iteration space are split the same way, each thread touches the same
+ * memory in every loop, which keeps first-touch NUMA placement effective.
+ */
+class ThreadPool {
+private:
+  std::vector<std::thread> workers;         /*!< worker threads */
+  std::mutex mutex;                         /*!< protects pool state */
+  std::condition_variable start_cv;         /*!< wakes workers up */
+  std::condition_variable done_cv;          /*!< wakes the caller up */
+  const std::function<void(size_t)> *task;  /*!< function to be run */
+  size_t num_chunks;                        /*!< number of chunks */
+  size_t active_workers;                    /*!< workers still running */
+  size_t generation;                        /*!< index of current task */
+  bool stop;                                /*!< whether workers should
+                                                 exit */
+  std::atomic<bool> busy;                   /*!< whether a task is
+                                                 running */
+
+  /**
+   * @brief Runs the chunks of the current task assigned to a thread.
+   *
+   * @param thread Index of the thread.
+   */
+  void run_chunks(const size_t thread) {
+    for (size_t c = thread; c < num_chunks; c += size())
+      (*task)(c);
+    return;
+  }
+
+  /**
+   * @brief Main loop of worker threads.
+   *
+   * @param thread Index of the worker thread.
+   */
+  void worker_loop(const size_t thread) {
+    size_t seen_generation = 0;
+
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex);
+      start_cv.wait(lock,
+                    [&]() { return stop || generation != seen_generation; });
+      if (stop)
+        return;
+      seen_generation = generation;
+      lock.unlock();
+
+      run_chunks(thread);
+
+      lock.lock();
+      if (--active_workers == 0)
+        done_cv.notify_one();
+    }
+  }
+
+public:
+  /**
+   * @brief Class constructor.
+   *
+   * @param num_threads Number of threads, including the calling one.
+   */
+  explicit ThreadPool(const size_t num_threads)
+      : task(nullptr), num_chunks(0), active_workers(0), generation(0),
+        stop(false), busy(false) {
+    for (size_t t = 1; t < num_threads; t++)
+      workers.emplace_back(&ThreadPool::worker_loop, this, t);
+  }
+
+  /**
+   * @brief Class destructor.
+   */
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    start_cv.notify_all();
+    for (auto &worker : workers)
+      worker.join();
+  }
+
+  /**
+   * @brief Returns the number of threads, including the calling one.
+   *
+   * @return Number of threads.
+   */
+  size_t size() const { return workers.size() + 1; }
+
+  /**
+   * @brief Runs a function on a number of chunks.
+   *
+   * @param chunks   Number of chunks.
+   * @param chunk_fn Function called with the index of each chunk.
+   */
+  void run(const size_t chunks, const std::function<void(size_t)> &chunk_fn) {
+
+    /* run serially if pool is busy or has no workers */
+    if (workers.empty() || busy.exchange(true)) {
+      for (size_t c = 0; c < chunks; c++)
+        chunk_fn(c);
+      return;
+    }
+
+    /* publish task */
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      task = &chunk_fn;
+      num_chunks = chunks;
+      active_workers = workers.size();
+      generation++;
+    }
+    start_cv.notify_all();
+
+    /* calling thread works as well */
+    run_chunks(0);
+
+    /* wait for workers */
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      done_cv.wait(lock, [&]() { return active_workers == 0; });
+    }
+
+    busy.store(false);
+
+    return;
+  }
+};
+
+/**
+ * @brief Returns the thread pool, creating it on first use.
+ *
+ * @details
+ * The number of threads is read from the MIMMO_NUM_THREADS environment
+ * variable if set, and defaults to the number of hardware threads.
+ *
+ * @return Reference to the thread pool.
+ */
+static ThreadPool &thread_pool() {
+  static ThreadPool pool([]() {
+    const char *const env = std::getenv("MIMMO_NUM_THREADS");
+    const long requested = (env != nullptr) ? std::atol(env) : 0;
+    if (requested > 0)
+      return static_cast<size_t>(requested);
+    return std::max(static_cast<size_t>(std::thread::hardware_concurrency()),
+                    static_cast<size_t>(1));
+  }());
+  return pool;
+}
+
+/**
+ * @brief Returns the number of threads used for host-side parallel loops.
+ *
+ * @return Number of threads (including the calling one).
+ */
+size_t host_num_threads() { return thread_pool().size(); }
+
+/**
+ * @brief Runs a function on a number of chunks using the thread pool.
+ *
+ * @param num_chunks Number of chunks.
+ * @param chunk_fn   Function called with the index of each chunk.
+ */
+void parallel_for_chunks(const size_t num_chunks,
+                         const std::function<void(size_t)> &chunk_fn) {
+  thread_pool().run(num_chunks, chunk_fn);
+  return;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,181 @@
+/**
+ * @file memory_reconciliation.cpp
+ *
+ * @brief Implementation of memory reconciliation methods.
+ *
+ * Implements read_process_memory(),
+ * DualMemoryManager::sample_memory() and
+ * DualMemoryManager::report_memory_reconciliation().
+ *
+ * @see memory_reconciliation.hpp
+ * @see api.hpp
+ */
+
+#include "../include/mimmo/api.hpp"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace MiMMO {
+
+/**
+ * @brief Reads resident memory of the process from /proc/self/status.
+ *
+ * @param rss_bytes Resident memory (VmRSS), in bytes.
+ * @param hwm_bytes Peak resident memory (VmHWM), in bytes.
+ *
+ * @return          Whether both values could be read (otherwise they
+ *                  are left unchanged).
+ */
+bool read_process_memory(size_t &rss_bytes, size_t &hwm_bytes) {
+
+  std::ifstream status("/proc/self/status");
+  size_t rss_kb = 0;
+  size_t hwm_kb = 0;
+  bool rss_found = false;
+  bool hwm_found = false;
+
+  /* values are given in kB, e.g. "VmRSS:     1234 kB" */
+  std::string line;
+  while (std::getline(status, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    fields >> key;
+
+    if (key == "VmRSS:")
+      rss_found = static_cast<bool>(fields >> rss_kb);
+    else if (key == "VmHWM:")
+      hwm_found = static_cast<bool>(fields >> hwm_kb);
+  }
+
+  if (!rss_found || !hwm_found)
+    return false;
+
+  rss_bytes = rss_kb * 1024;
+  hwm_bytes = hwm_kb * 1024;
+
+  return true;
+}
+
+/**
+ * @brief Returns the difference between actual and tracked memory as a
+ * string.
+ *
+ * @param actual  Memory actually used, in bytes.
+ * @param tracked Memory tracked by the manager, in bytes.
+ *
+ * @return        Signed difference in bytes.
+ */
+static std::string gap_string(const size_t actual, const size_t tracked) {
+  return actual >= tracked ? std::to_string(actual - tracked)
+                           : "-" + std::to_string(tracked - actual);
+}
+
+/**
+ * @brief Samples tracked memory against actual memory of the process and
+ * of the current device, and appends the sample to the history.
+ *
+ * @return Sample taken.
+ */
+MemorySample DualMemoryManager::sample_memory() {
+
+  MemorySample sample = {seconds_since(creation_time),
+                         total_memory.first,
+                         return_device_memory_usage(backend->get_device()),
+                         false,
+                         0,
+                         0,
+                         false,
+                         0,
+                         0};
+
+  sample.host_known =
+      read_process_memory(sample.host_rss_bytes, sample.host_hwm_bytes);
+  sample.dev_known =
+      backend->memory_info(sample.dev_free_bytes, sample.dev_total_bytes);
+
+  memory_samples.push_back(sample);
+
+  return sample;
+}
+
+/**
+ * @brief Reports tracked memory against actual memory over time.
+ *
+ * @details
+ * A sample is taken first. For each sample, host and device columns show
+ * tracked memory, memory actually used and the untracked gap; "n/a"
+ * marks values that could not be read.
+ */
+void DualMemoryManager::report_memory_reconciliation() {
+
+  sample_memory();
+
+  const std::vector<std::string> headers = {
+      "Time (s)",       "Tracked host",  "Host RSS",
+      "Untracked host", "Tracked dev",   "Device used",
+      "Untracked dev",  "Device free"};
+  const size_t time_col_width = 12;
+  const size_t col_width = 16;
+  const size_t total_width = time_col_width + (headers.size() - 1) * col_width;
+
+  /* define graphic separators */
+  const std::string big_separator = std::string(total_width, '=') + "\n";
+  const std::string small_separator = std::string(total_width, '-') + "\n";
+
+  std::cout << "\n" << big_separator;
+  std::cout << "Memory Reconciliation Report:\n";
+  std::cout << big_separator;
+
+  std::cout << std::right << std::setw(time_col_width) << headers[0];
+  for (size_t i = 1; i < headers.size(); i++)
+    std::cout << std::setw(col_width) << headers[i];
+  std::cout << "\n" << small_separator;
+
+  for (const MemorySample &sample : memory_samples) {
+    const std::string na = "n/a";
+    const size_t dev_used = sample.dev_total_bytes - sample.dev_free_bytes;
+
+    std::cout << std::fixed << std::setprecision(3)
+              << std::setw(time_col_width) << sample.seconds
+              << std::defaultfloat << std::setw(col_width)
+              << sample.tracked_host_bytes << std::setw(col_width)
+              << (sample.host_known ? std::to_string(sample.host_rss_bytes)
+                                    : na)
+              << std::setw(col_width)
+              << (sample.host_known ? gap_string(sample.host_rss_bytes,
+                                                 sample.tracked_host_bytes)
+                                    : na)
+              << std::setw(col_width) << sample.tracked_dev_bytes
+              << std::setw(col_width)
+              << (sample.dev_known ? std::to_string(dev_used) : na)
+              << std::setw(col_width)
+              << (sample.dev_known
+                      ? gap_string(dev_used, sample.tracked_dev_bytes)
+                      : na)
+              << std::setw(col_width)
+              << (sample.dev_known ? std::to_string(sample.dev_free_bytes)
+                                   : na)
+              << "\n";
+  }
+  std::cout << small_separator;
+
+  /* peak resident memory of the process */
+  const MemorySample &last = memory_samples.back();
+  std::cout << "Peak host RSS (VmHWM): "
+            << (last.host_known ? std::to_string(last.host_hwm_bytes) +
+                                      " bytes"
+                                : "n/a")
+            << "\n";
+  std::cout << "Device memory: "
+            << (last.dev_known ? std::to_string(last.dev_total_bytes) +
+                                     " bytes total"
+                               : "n/a")
+            << "\n";
+  std::cout << big_separator << "\n";
+
+  return;
+}
+
+} // namespace MiMMO
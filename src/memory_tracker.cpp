@@ -16,32 +16,131 @@ namespace MiMMO {
  * @param memory_tracker   Memory tracker to update.
  * @param tot_memory_usage Pair containing total host and device memory
  *                         usage.
+ * @param label_memory     Memory used by label, to update.
  * @param object           Pointer to dual object to be added.
  * @param label            Label of the array to be added.
  * @param size             Size in bytes of the array to be added.
  * @param on_device        Whether the array is allocated on device.
+ * @param lazy             Whether memory is only reserved, and will be
+ *                         materialized later.
+ * @param device           Device on which device memory is allocated.
  *
  * @return                 'true' if the array was already tracked, 'false'
  *                         otherwise.
  *
  * @note If the label (key) is already present, the entry is ignored.
  */
-bool add_to_memory_tracker(
-    std::map<void *, std::tuple<std::string, size_t, bool>> &memory_tracker,
-    std::pair<size_t, size_t> &tot_memory_usage, void *const object,
-    const std::string label, const size_t size, const bool on_device) {
+bool add_to_memory_tracker(std::map<void *, TrackerEntry> &memory_tracker,
+                           std::pair<size_t, size_t> &tot_memory_usage,
+                           std::map<std::string, LabelMemory> &label_memory,
+                           void *const object, const std::string label,
+                           const size_t size, const bool on_device,
+                           const bool lazy, const int device) {
 
   /* attempt to add new element */
-  const auto ret = memory_tracker.insert({object, {label, size, on_device}});
+  const auto ret = memory_tracker.insert(
+      {object,
+       {label, size, size, on_device, !lazy, on_device && !lazy, "", 0, device,
+        false}});
 
   /* if element was already present, return error */
   if (!(ret.second))
     return true;
 
-  /* update total memory usage */
+  /* update total memory usage (reserved memory is not counted) */
+  LabelMemory &label_usage = label_memory[label];
+  label_usage.num_objects++;
+
+  if (lazy)
+    return false;
+
   tot_memory_usage.first += size;
-  if (on_device)
+  label_usage.host_bytes += size;
+  if (on_device) {
     tot_memory_usage.second += size;
+    label_usage.dev_bytes += size;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Marks memory of a tracked object as materialized on one side.
+ *
+ * @param memory_tracker   Memory tracker to update.
+ * @param tot_memory_usage Pair containing total host and device memory
+ *                         usage.
+ * @param label_memory     Memory used by label, to update.
+ * @param object           Pointer to tracked dual object.
+ * @param on_device        Whether device (rather than host) memory was
+ *                         materialized.
+ *
+ * @return                 'true' if the object was not tracked, 'false'
+ *                         otherwise.
+ */
+bool mark_as_materialized(std::map<void *, TrackerEntry> &memory_tracker,
+                          std::pair<size_t, size_t> &tot_memory_usage,
+                          std::map<std::string, LabelMemory> &label_memory,
+                          void *const object, const bool on_device) {
+
+  /* look for element */
+  const auto it = memory_tracker.find(object);
+
+  /* if element was not found, return error */
+  if (it == memory_tracker.end())
+    return true;
+
+  /* update entry and total memory usage */
+  TrackerEntry &entry = it->second;
+
+  if (on_device && !entry.dev_materialized) {
+    entry.dev_materialized = true;
+    tot_memory_usage.second += entry.dev_size;
+    label_memory[entry.label].dev_bytes += entry.dev_size;
+  } else if (!on_device && !entry.host_materialized) {
+    entry.host_materialized = true;
+    tot_memory_usage.first += entry.size;
+    label_memory[entry.label].host_bytes += entry.size;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Sets the size of device memory of a tracked object.
+ *
+ * @param memory_tracker   Memory tracker to update.
+ * @param tot_memory_usage Pair containing total host and device memory
+ *                         usage.
+ * @param label_memory     Memory used by label, to update.
+ * @param object           Pointer to tracked dual object.
+ * @param dev_size         Size in bytes of the object on device.
+ *
+ * @return                 'true' if the object was not tracked, 'false'
+ *                         otherwise.
+ */
+bool set_device_size(std::map<void *, TrackerEntry> &memory_tracker,
+                     std::pair<size_t, size_t> &tot_memory_usage,
+                     std::map<std::string, LabelMemory> &label_memory,
+                     void *const object, const size_t dev_size) {
+
+  /* look for element */
+  const auto it = memory_tracker.find(object);
+
+  /* if element was not found, return error */
+  if (it == memory_tracker.end())
+    return true;
+
+  /* update entry and total memory usage (if already counted) */
+  TrackerEntry &entry = it->second;
+
+  if (entry.dev_materialized) {
+    tot_memory_usage.second = tot_memory_usage.second - entry.dev_size +
+                              dev_size;
+    LabelMemory &label_usage = label_memory[entry.label];
+    label_usage.dev_bytes = label_usage.dev_bytes - entry.dev_size + dev_size;
+  }
+  entry.dev_size = dev_size;
 
   return false;
 }
@@ -52,16 +151,19 @@ bool add_to_memory_tracker(
  * @param memory_tracker   Memory tracker to update.
  * @param tot_memory_usage Pair containing total host and device memory
  *                         usage.
+ * @param label_memory     Memory used by label, to update.
  * @param object           Pointer to dual object to be removed.
  *
  * @return                 'true' if the array was not tracked, 'false'
  *                         otherwise.
  *
  * @note If the object is not tracked, the operation is ignored.
+ * @note Shared host memory is not subtracted, since it was not counted.
  */
 bool remove_from_memory_tracker(
-    std::map<void *, std::tuple<std::string, size_t, bool>> &memory_tracker,
-    std::pair<size_t, size_t> &tot_memory_usage, void *const object) {
+    std::map<void *, TrackerEntry> &memory_tracker,
+    std::pair<size_t, size_t> &tot_memory_usage,
+    std::map<std::string, LabelMemory> &label_memory, void *const object) {
 
   /* try to remove element */
   const auto ret = memory_tracker.extract(object);
@@ -70,12 +172,23 @@ bool remove_from_memory_tracker(
   if (ret.empty())
     return true;
 
-  /* update total memory usage */
-  const size_t size = std::get<1>(ret.mapped());
-  const bool on_device = std::get<2>(ret.mapped());
-  tot_memory_usage.first -= size;
-  if (on_device)
-    tot_memory_usage.second -= size;
+  /* update total memory usage (only materialized memory was counted) */
+  const TrackerEntry &entry = ret.mapped();
+  const auto label_it = label_memory.find(entry.label);
+  LabelMemory &label_usage = label_it->second;
+
+  if (entry.host_materialized && !entry.shared) {
+    tot_memory_usage.first -= entry.size;
+    label_usage.host_bytes -= entry.size;
+  }
+  if (entry.dev_materialized) {
+    tot_memory_usage.second -= entry.dev_size;
+    label_usage.dev_bytes -= entry.dev_size;
+  }
+
+  /* forget labels without objects */
+  if (--label_usage.num_objects == 0)
+    label_memory.erase(label_it);
 
   return false;
 }
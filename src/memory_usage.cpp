@@ -3,7 +3,12 @@
  *
  * @brief Implementation of memory reporting methods.
  *
- * Implements DualMemoryManager::return_total_memory_usage() and
+ * Implements DualMemoryManager::return_total_memory_usage(),
+ * DualMemoryManager::return_reserved_memory_usage(),
+ * DualMemoryManager::return_device_memory_usage(),
+ * DualMemoryManager::return_numa_distribution(),
+ * DualMemoryManager::return_shared_memory_usage(),
+ * DualMemoryManager::return_label() and
  * DualMemoryManager::report_memory_usage().
  *
  * @see api.hpp
@@ -29,6 +34,122 @@ std::pair<size_t, size_t> DualMemoryManager::return_total_memory_usage() {
   return total_memory;
 }
 
+/**
+ * @brief Returns the total host and device memory reserved by the
+ * memory manager.
+ *
+ * @details
+ * Reserved memory includes memory of lazily allocated arrays that has
+ * not been materialized yet. For eagerly allocated objects reserved and
+ * used memory coincide. Shared host memory is not counted, and group
+ * slabs are counted as a whole rather than the arrays carved from them.
+ *
+ * @return (total host memory reserved, total device memory reserved)
+ */
+std::pair<size_t, size_t> DualMemoryManager::return_reserved_memory_usage() {
+
+  std::pair<size_t, size_t> reserved_memory = {0, 0};
+
+  for (const auto &[object, entry] : memory_tracker) {
+    /* arrays carved from a slab are counted in it */
+    if (!entry.group.empty() && groups.at(entry.group).slab_capacity > 0)
+      continue;
+
+    if (!entry.shared)
+      reserved_memory.first += entry.size;
+    if (entry.on_device)
+      reserved_memory.second += entry.dev_size;
+  }
+
+  /* group slabs are reserved and used as a whole */
+  for (const auto &[name, group] : groups) {
+    reserved_memory.first += group.slab_capacity;
+    if (group.on_device)
+      reserved_memory.second += group.slab_capacity;
+  }
+
+  /* scratch arena is reserved and used as a whole */
+  if (scratch_arena.on_device)
+    reserved_memory.second += scratch_arena.capacity;
+  else
+    reserved_memory.first += scratch_arena.capacity;
+
+  return reserved_memory;
+}
+
+/**
+ * @brief Returns the memory used by the memory manager on one device.
+ *
+ * @param device Index of the device.
+ *
+ * @return       Device memory used on the device, in bytes.
+ */
+size_t DualMemoryManager::return_device_memory_usage(const int device) {
+
+  size_t device_memory = 0;
+
+  for (const auto &[object, entry] : memory_tracker)
+    if (entry.dev_materialized && entry.device == device)
+      device_memory += entry.dev_size;
+
+  if (scratch_arena.on_device && scratch_arena.device == device)
+    device_memory += scratch_arena.capacity;
+
+  return device_memory;
+}
+
+/**
+ * @brief Returns the host memory used by the memory manager on each NUMA
+ * node.
+ *
+ * @details
+ * Pages of host memory that were never touched reside on no node and
+ * are not counted, so the total may be lower than the host memory used.
+ *
+ * @return Host memory used on each node, in bytes.
+ */
+std::vector<size_t> DualMemoryManager::return_numa_distribution() {
+
+  std::vector<size_t> distribution(numa_num_nodes(), 0);
+
+  for (const auto &[host_ptr, size_bytes] : host_buffers)
+    add_numa_distribution(host_ptr, size_bytes, distribution);
+
+  return distribution;
+}
+
+/**
+ * @brief Returns the host memory of shared dual arrays attached by the
+ * memory manager.
+ *
+ * @return Shared host memory, in bytes (not counted in host memory
+ *         used).
+ */
+size_t DualMemoryManager::return_shared_memory_usage() {
+
+  size_t shared_memory = 0;
+
+  for (const auto &[object, entry] : memory_tracker)
+    if (entry.shared)
+      shared_memory += entry.size;
+
+  return shared_memory;
+}
+
+/**
+ * @brief Returns the label of a tracked object.
+ *
+ * @param object Address of the dual object.
+ *
+ * @return       Label of the object (empty if it is not tracked).
+ */
+std::string DualMemoryManager::return_label(const void *const object) {
+
+  const auto it = memory_tracker.find((void *)object);
+
+  return it == memory_tracker.end() ? std::string() : it->second.label;
+}
+
 /**
  * @brief Reports memory used by the memory manager.
  *
@@ -36,8 +157,15 @@ std::pair<size_t, size_t> DualMemoryManager::return_total_memory_usage() {
  * This function prints to standard output a complete report of memory
  * usage of the memory manager.
  *
- * A list of all allocated arrays is shown, with size (in bytes) and
- * whether the array is present on device or not.
+ * A list of all allocated arrays is shown, with size (in bytes),
+ * whether the array is present on device or not, and on which sides its
+ * memory is materialized. Subtotals of allocation groups follow, and
+ * totals of each device if there are several, as well as host memory on
+ * each NUMA node if there are several or a placement policy is set.
+ * Shared host memory is marked as such, and totaled separately. Sizes
+ * of mixed-precision arrays are shown on host and device (host/device).
+ * Memory of pending frees and of the reuse cache is shown if any.
+ * Prefetch hits, late prefetches and misses are shown if any.
  */
 void DualMemoryManager::report_memory_usage() {
 
@@ -45,27 +173,37 @@ void DualMemoryManager::report_memory_usage() {
   const std::string label_header = "Label";
   const std::string size_header = "Size (bytes)";
   const std::string on_device_header = "On Device";
+  const std::string materialized_header = "Materialized";
+
+  /* sizes on each side differ for mixed-precision arrays */
+  const auto size_string = [](const TrackerEntry &entry) {
+    std::string size = std::to_string(entry.size);
+    if (entry.on_device && entry.dev_size != entry.size)
+      size += "/" + std::to_string(entry.dev_size);
+    return size;
+  };
 
   /* set width of columns */
   size_t label_col_width = label_header.length();
+  size_t size_col_width = size_header.length();
 
-  for (const auto &[object, tuple] : memory_tracker)
-    label_col_width = std::max(label_col_width, std::get<0>(tuple).length());
+  for (const auto &[object, entry] : memory_tracker) {
+    label_col_width = std::max(label_col_width, entry.label.length());
+    size_col_width = std::max(size_col_width, size_string(entry).length());
+  }
 
   label_col_width += 4;
-
-  const size_t size_col_width =
-      std::max(size_header.length() + 4, static_cast<size_t>(10));
+  size_col_width = std::max(size_col_width + 4, static_cast<size_t>(10));
   const size_t on_device_col_width =
-      std::max(on_device_header.length(), static_cast<size_t>(10));
+      std::max(on_device_header.length() + 4, static_cast<size_t>(10));
+  const size_t materialized_col_width =
+      std::max(materialized_header.length(), static_cast<size_t>(10));
+  const size_t total_width = label_col_width + size_col_width +
+                             on_device_col_width + materialized_col_width;
 
   /* define graphic separators */
-  const std::string big_separator =
-      std::string(label_col_width + size_col_width + on_device_col_width, '=') +
-      "\n";
-  const std::string small_separator =
-      std::string(label_col_width + size_col_width + on_device_col_width, '-') +
-      "\n";
+  const std::string big_separator = std::string(total_width, '=') + "\n";
+  const std::string small_separator = std::string(total_width, '-') + "\n";
 
   /* print header */
   std::cout << "\n" << big_separator;
@@ -73,15 +211,34 @@ void DualMemoryManager::report_memory_usage() {
   std::cout << big_separator;
   std::cout << std::left << std::setw(label_col_width) << label_header
             << std::setw(size_col_width) << size_header
-            << std::setw(on_device_col_width) << on_device_header << "\n";
+            << std::setw(on_device_col_width) << on_device_header
+            << std::setw(materialized_col_width) << materialized_header
+            << "\n";
   std::cout << small_separator;
 
-  /* print tracker's content */
-  for (const auto &[object, tuple] : memory_tracker) {
-    const std::string on_device = std::get<2>(tuple) ? "yes" : "no";
-    std::cout << std::left << std::setw(label_col_width) << std::get<0>(tuple)
-              << std::setw(size_col_width) << std::get<1>(tuple)
-              << std::setw(on_device_col_width) << on_device << "\n";
+  /* print tracker's content (with devices, if there are several) */
+  const int num_devices = backend->num_devices();
+
+  for (const auto &[object, entry] : memory_tracker) {
+    std::string on_device = entry.on_device ? "yes" : "no";
+    if (entry.on_device && num_devices > 1)
+      on_device += " (" + std::to_string(entry.device) + ")";
+
+    std::string materialized = "none";
+    if (entry.host_materialized && entry.dev_materialized)
+      materialized = "both";
+    else if (entry.host_materialized)
+      materialized = "host";
+    else if (entry.dev_materialized)
+      materialized = "device";
+
+    if (entry.shared)
+      materialized += " (shared)";
+
+    std::cout << std::left << std::setw(label_col_width) << entry.label
+              << std::setw(size_col_width) << size_string(entry)
+              << std::setw(on_device_col_width) << on_device
+              << std::setw(materialized_col_width) << materialized << "\n";
   }
   std::cout << big_separator;
 
@@ -90,6 +247,131 @@ void DualMemoryManager::report_memory_usage() {
             << "\n";
   std::cout << "Total device memory used: " << total_memory.second << " bytes"
             << "\n";
+  std::cout << "Device backend: " << backend->name() << "\n";
+
+  /* print shared host memory, counted apart */
+  const size_t shared_memory = return_shared_memory_usage();
+
+  if (shared_memory > 0)
+    std::cout << "Shared host memory attached: " << shared_memory << " bytes"
+              << "\n";
+
+  /* print totals of each device */
+  if (num_devices > 1)
+    for (int device = 0; device < num_devices; device++)
+      std::cout << "Device " << device
+                << " memory used: " << return_device_memory_usage(device)
+                << " bytes"
+                << "\n";
+
+  /* print host memory of each NUMA node */
+  if (numa_num_nodes() > 1 || numa_policy != NumaPolicy::Default) {
+    const std::vector<size_t> distribution = return_numa_distribution();
+
+    std::cout << "NUMA policy: " << numa_policy_name(numa_policy);
+    if (numa_policy == NumaPolicy::Bind)
+      std::cout << " (node " << numa_node << ")";
+    std::cout << "\n";
+
+    for (size_t node = 0; node < distribution.size(); node++)
+      std::cout << "Host memory on NUMA node " << node << ": "
+                << distribution[node] << " bytes"
+                << "\n";
+  }
+
+  /* print reserved memory, if different from used memory */
+  const std::pair<size_t, size_t> reserved_memory =
+      return_reserved_memory_usage();
+
+  if (reserved_memory != total_memory) {
+    std::cout << "Total host memory reserved: " << reserved_memory.first
+              << " bytes"
+              << "\n";
+    std::cout << "Total device memory reserved: " << reserved_memory.second
+              << " bytes"
+              << "\n";
+  }
+
+  /* print subtotals of allocation groups */
+  if (!groups.empty()) {
+    std::cout << small_separator;
+    for (const auto &[name, group] : groups) {
+      const std::pair<size_t, size_t> group_memory =
+          return_group_memory_usage(name);
+      std::cout << "Group '" << name << "': " << group.members.size()
+                << " arrays, " << group_memory.first << " bytes on host, "
+                << group_memory.second << " bytes on device";
+      if (group.slab_capacity > 0)
+        std::cout << " (slab: " << group.slab_offset << "/"
+                  << group.slab_capacity << " bytes)";
+      std::cout << "\n";
+    }
+  }
+
+  /* print scratch arena usage */
+  if (scratch_arena.capacity > 0) {
+    std::cout << small_separator;
+    std::cout << "Scratch arena capacity: " << scratch_arena.capacity
+              << " bytes"
+              << "\n";
+    std::cout << "Scratch arena in use: " << scratch_arena.offset << " bytes ("
+              << scratch_arena.frames.size() << " open frames)"
+              << "\n";
+    std::cout << "Scratch arena high-water mark: "
+              << scratch_arena.high_water_mark << " bytes"
+              << "\n";
+  }
+
+  /* print buffers of deferred frees */
+  const DeferredFreeStats deferred = return_deferred_free_stats();
+  if (deferred.pending_blocks > 0 || deferred.cached_blocks > 0) {
+    std::cout << small_separator;
+    std::cout << "Pending frees: " << deferred.pending_host_bytes
+              << " bytes on host, " << deferred.pending_dev_bytes
+              << " bytes on device (" << deferred.pending_blocks
+              << " buffers)"
+              << "\n";
+    std::cout << "Reuse cache: " << deferred.cached_host_bytes
+              << " bytes on host, " << deferred.cached_dev_bytes
+              << " bytes on device (" << deferred.cached_blocks
+              << " buffers)"
+              << "\n";
+  }
+
+  /* print outcomes of prefetches */
+  if (prefetch_stats.num_prefetches > 0 || prefetch_stats.num_misses > 0) {
+    std::cout << small_separator;
+    std::cout << "Prefetches: " << prefetch_stats.num_prefetches << " ("
+              << prefetch_stats.prefetch_bytes << " bytes), "
+              << prefetch_stats.num_hits << " hits, "
+              << prefetch_stats.num_late << " late ("
+              << prefetch_stats.late_wait_seconds << " s waited), "
+              << prefetch_stats.num_misses << " misses, "
+              << prefetch_stats.num_unused << " unused"
+              << "\n";
+  }
+
+  /* rank call sites by bandwidth wasted on redundant transfers */
+  if (transfer_profiling) {
+    std::cout << small_separator;
+    std::cout << "Wasted bandwidth (redundant transfers):\n";
+
+    size_t num_wasteful_sites = 0;
+    for (const TransferSiteStats &site : return_transfer_profile()) {
+      if (site.wasted_bytes == 0)
+        break;
+
+      std::cout << "  " << site.wasted_bytes << " bytes in "
+                << site.num_redundant << "/" << site.num_transfers
+                << " transfers of '" << site.label << "' "
+                << (site.to_device ? "to device" : "from device") << " at "
+                << site.file << ":" << site.line << "\n";
+      num_wasteful_sites++;
+    }
+
+    if (num_wasteful_sites == 0)
+      std::cout << "  none\n";
+  }
   std::cout << big_separator << "\n";
 
   return;
@@ -0,0 +1,241 @@
+/**
+ * @file numa.cpp
+ *
+ * @brief Implementation of NUMA placement utilities for host memory.
+ *
+ * Memory policies are set through the mbind and move_pages system calls
+ * directly, so that no NUMA library is needed.
+ *
+ * @see numa.hpp
+ */
+
+#include "../include/private/numa.hpp"
+#include "../include/private/host_parallel.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace MiMMO {
+
+/* memory policy modes of the kernel (see mbind(2)) */
+constexpr int mpol_bind = 2;
+constexpr int mpol_interleave = 3;
+constexpr int mpol_local = 4;
+
+/* bits in a word of a node mask */
+constexpr size_t mask_word_bits = 8 * sizeof(unsigned long);
+
+/* pages queried per move_pages call */
+constexpr size_t query_batch = 1024;
+
+/**
+ * @brief Returns the size of memory pages.
+ *
+ * @return Size in bytes of a page.
+ */
+static size_t page_size() {
+#ifdef __linux__
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+#else
+  return 4096;
+#endif
+}
+
+/**
+ * @brief Sets the memory policy of a page-aligned range of host memory.
+ *
+ * @param ptr        Pointer to the range (page aligned).
+ * @param size_bytes Size in bytes of the range.
+ * @param mode       Memory policy mode.
+ * @param nodes      Nodes of the policy (empty for none).
+ *
+ * @note Failures are ignored, since placement is only a hint.
+ */
+static void set_memory_policy(void *const ptr, const size_t size_bytes,
+                              const int mode, const std::vector<int> &nodes) {
+#if defined(__linux__) && defined(SYS_mbind)
+  size_t max_node = 0;
+  for (const int node : nodes)
+    max_node = std::max(max_node, static_cast<size_t>(node));
+
+  std::vector<unsigned long> mask(max_node / mask_word_bits + 1, 0);
+  for (const int node : nodes)
+    mask[node / mask_word_bits] |= 1UL << (node % mask_word_bits);
+
+  /* kernel reads one bit less than the given number of nodes */
+  syscall(SYS_mbind, ptr, size_bytes, mode,
+          nodes.empty() ? nullptr : mask.data(),
+          nodes.empty() ? 0 : mask.size() * mask_word_bits + 1, 0);
+#endif
+  return;
+}
+
+/**
+ * @brief Returns the name of a NUMA placement policy.
+ *
+ * @param policy NUMA placement policy.
+ *
+ * @return       Name of the policy.
+ */
+std::string numa_policy_name(const NumaPolicy policy) {
+  switch (policy) {
+  case NumaPolicy::Local:
+    return "local";
+  case NumaPolicy::Interleave:
+    return "interleave";
+  case NumaPolicy::Bind:
+    return "bind";
+  case NumaPolicy::FirstTouch:
+    return "first touch";
+  default:
+    return "default";
+  }
+}
+
+/**
+ * @brief Returns the number of NUMA nodes of the system.
+ *
+ * @details
+ * Nodes are read once from the list of online nodes exposed by the
+ * kernel (e.g. "0-1,3"), and are numbered up to the highest one.
+ *
+ * @return Number of NUMA nodes (1 if the system does not expose them).
+ */
+int numa_num_nodes() {
+
+  static const int num_nodes = []() {
+    std::ifstream file("/sys/devices/system/node/online");
+    std::string list;
+    if (!(file >> list))
+      return 1;
+
+    /* highest node is the last number of the list */
+    const size_t last = list.find_last_of(",-");
+    const std::string highest =
+        last == std::string::npos ? list : list.substr(last + 1);
+
+    return std::max(std::atoi(highest.c_str()) + 1, 1);
+  }();
+
+  return num_nodes;
+}
+
+/**
+ * @brief Allocates host memory placed on NUMA nodes according to a policy.
+ *
+ * @details
+ * Except for the default policy, the buffer is page aligned and its size
+ * rounded up to whole pages, so that the policy covers no memory of other
+ * buffers. With the first-touch policy, the buffer is zeroed by the
+ * threads of the host pool, split as host_parallel_for() splits a loop
+ * over its elements: later parallel loops over the same elements then
+ * work on memory local to each thread.
+ *
+ * @param num_elements  Number of elements in the buffer.
+ * @param element_bytes Size in bytes of each element.
+ * @param policy        NUMA placement policy.
+ * @param node          Node on which memory is placed (Bind policy only).
+ *
+ * @return              Pointer to the buffer (nullptr if allocation
+ *                      failed). It should be freed with std::free().
+ */
+void *numa_alloc(const size_t num_elements, const size_t element_bytes,
+                 const NumaPolicy policy, const int node) {
+
+  const size_t size_bytes = num_elements * element_bytes;
+
+  if (policy == NumaPolicy::Default || size_bytes == 0)
+    return std::malloc(size_bytes);
+
+  const size_t page = page_size();
+  const size_t rounded_bytes = (size_bytes + page - 1) / page * page;
+  void *const ptr = std::aligned_alloc(page, rounded_bytes);
+
+  if (ptr == nullptr)
+    return nullptr;
+
+  /* set policy before pages are touched */
+  if (policy == NumaPolicy::Local) {
+    set_memory_policy(ptr, rounded_bytes, mpol_local, {});
+  } else if (policy == NumaPolicy::Interleave) {
+    std::vector<int> nodes(numa_num_nodes());
+    for (size_t n = 0; n < nodes.size(); n++)
+      nodes[n] = static_cast<int>(n);
+    set_memory_policy(ptr, rounded_bytes, mpol_interleave, nodes);
+  } else if (policy == NumaPolicy::Bind) {
+    set_memory_policy(ptr, rounded_bytes, mpol_bind, {node});
+  } else if (policy == NumaPolicy::FirstTouch) {
+    char *const bytes = static_cast<char *>(ptr);
+    host_parallel_for(num_elements, [&](const size_t begin,
+                                        const size_t end) {
+      std::memset(bytes + begin * element_bytes, 0,
+                  (end - begin) * element_bytes);
+    });
+  }
+
+  return ptr;
+}
+
+/**
+ * @brief Adds the bytes of a host buffer residing on each NUMA node.
+ *
+ * @details
+ * The node of each page is queried in batches through move_pages, which
+ * moves nothing when no target nodes are given. Pages shared with
+ * neighbouring buffers only count for the bytes of the buffer.
+ *
+ * @param ptr          Pointer to the buffer.
+ * @param size_bytes   Size in bytes of the buffer.
+ * @param distribution Bytes per node, updated with those of the buffer.
+ *
+ * @note Pages that were never touched reside on no node and are not
+ *       counted.
+ */
+void add_numa_distribution(const void *const ptr, const size_t size_bytes,
+                           std::vector<size_t> &distribution) {
+#if defined(__linux__) && defined(SYS_move_pages)
+  if (ptr == nullptr || size_bytes == 0)
+    return;
+
+  const size_t page = page_size();
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(ptr);
+  const uintptr_t end = begin + size_bytes;
+  const uintptr_t first_page = begin / page * page;
+
+  std::vector<void *> pages;
+  std::vector<int> status;
+
+  for (uintptr_t batch = first_page; batch < end;
+       batch += query_batch * page) {
+    pages.clear();
+    for (uintptr_t p = batch; p < end && pages.size() < query_batch;
+         p += page)
+      pages.push_back(reinterpret_cast<void *>(p));
+    status.assign(pages.size(), -1);
+
+    if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr,
+                status.data(), 0) != 0)
+      return;
+
+    for (size_t i = 0; i < pages.size(); i++) {
+      const int node = status[i];
+      if (node < 0 || static_cast<size_t>(node) >= distribution.size())
+        continue;
+
+      const uintptr_t page_begin = reinterpret_cast<uintptr_t>(pages[i]);
+      distribution[node] += std::min(page_begin + page, end) -
+                            std::max(page_begin, begin);
+    }
+  }
+#endif
+  return;
+}
+
+} // namespace MiMMO
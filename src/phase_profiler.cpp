@@ -0,0 +1,336 @@
+/**
+ * @file phase_profiler.cpp
+ *
+ * @brief Implementation of the phase profiler.
+ *
+ * @see phase_profiler.hpp
+ */
+
+#include "../include/private/phase_profiler.hpp"
+#include "../include/private/abort.hpp"
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace MiMMO {
+
+/**
+ * @brief Returns a string as a JSON string literal.
+ *
+ * @param value String to be quoted.
+ *
+ * @return      Quoted and escaped string.
+ */
+static std::string json_string(const std::string &value) {
+  std::string quoted = "\"";
+
+  for (const char c : value) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if ((unsigned char)c < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      quoted += escaped;
+    } else {
+      quoted += c;
+    }
+  }
+
+  return quoted + "\"";
+}
+
+/**
+ * @brief Returns counters of a phase as a JSON object.
+ *
+ * @param counters Counters of the phase.
+ *
+ * @return         JSON object.
+ */
+static std::string json_counters(const PhaseCounters &counters) {
+  std::ostringstream out;
+  out << std::setprecision(9) << "{\"seconds\": " << counters.seconds
+      << ", \"allocs\": " << counters.num_allocs
+      << ", \"frees\": " << counters.num_frees
+      << ", \"host_peak_bytes\": " << counters.host_peak_bytes
+      << ", \"device_peak_bytes\": " << counters.dev_peak_bytes
+      << ", \"to_device\": {\"count\": " << counters.to_device_count
+      << ", \"bytes\": " << counters.to_device_bytes
+      << ", \"seconds\": " << counters.to_device_seconds << "}"
+      << ", \"from_device\": {\"count\": " << counters.from_device_count
+      << ", \"bytes\": " << counters.from_device_bytes
+      << ", \"seconds\": " << counters.from_device_seconds << "}}";
+  return out.str();
+}
+
+/**
+ * @brief Class constructor.
+ */
+PhaseProfiler::PhaseProfiler() {
+  reset();
+}
+
+/**
+ * @brief Opens a phase, as child of the innermost open phase.
+ *
+ * @param name   Name of the phase.
+ * @param memory Host and device memory used by the manager.
+ */
+void PhaseProfiler::begin(const std::string &name,
+                          const std::pair<size_t, size_t> &memory) {
+
+  /* look for the phase among children of the innermost one */
+  const size_t parent = stack.back();
+  size_t node = 0;
+
+  for (const size_t child : nodes[parent].children)
+    if (nodes[child].name == name) {
+      node = child;
+      break;
+    }
+
+  if (node == 0) {
+    node = nodes.size();
+    nodes.push_back({name, parent, {}, 0, false, {}, {}});
+    nodes[parent].children.push_back(node);
+  }
+
+  PhaseNode &phase = nodes[node];
+  phase.num_calls++;
+  phase.open = true;
+  stack.push_back(node);
+  record_memory(0, 0, memory);
+
+  phase.start = std::chrono::steady_clock::now();
+
+  return;
+}
+
+/**
+ * @brief Closes the innermost open phase.
+ *
+ * @param name   Name of the phase.
+ * @param memory Host and device memory used by the manager.
+ *
+ * @note If no phase is open or the innermost one has a different name,
+ *       the program aborts.
+ */
+void PhaseProfiler::end(const std::string &name,
+                        const std::pair<size_t, size_t> &memory) {
+
+  const auto now = std::chrono::steady_clock::now();
+
+  if (!active())
+    abort_mimmo("Phase '" + name + "' ended while no phase is open.");
+
+  PhaseNode &phase = nodes[stack.back()];
+
+  if (phase.name != name)
+    abort_mimmo("Phase '" + name + "' ended while phase '" + phase.name +
+                "' is open inside it.");
+
+  phase.counters.seconds +=
+      std::chrono::duration<double>(now - phase.start).count();
+  phase.open = false;
+  stack.pop_back();
+
+  /* memory is now charged to the enclosing phase */
+  record_memory(0, 0, memory);
+
+  return;
+}
+
+/**
+ * @brief Computes inclusive counters of a subtree and appends the
+ * statistics of its phases.
+ *
+ * @param node  Index of the root of the subtree.
+ * @param depth Nesting depth of the node.
+ * @param path  Path of the enclosing phases.
+ * @param now   Instant at which open phases are measured.
+ * @param stats Statistics to which phases are appended.
+ *
+ * @return      Inclusive counters of the node.
+ */
+PhaseCounters
+PhaseProfiler::collect(const size_t node, const size_t depth,
+                       const std::string &path,
+                       const std::chrono::steady_clock::time_point now,
+                       std::vector<PhaseStats> &stats) const {
+
+  const PhaseNode &phase = nodes[node];
+  const std::string phase_path =
+      path.empty() ? phase.name : path + "/" + phase.name;
+  const size_t index = stats.size();
+  stats.push_back({phase.name, phase_path, depth, phase.num_calls, phase.open,
+                   {}, phase.counters});
+
+  /* time of open calls runs up to now */
+  PhaseCounters inclusive = phase.counters;
+  if (phase.open)
+    inclusive.seconds +=
+        std::chrono::duration<double>(now - phase.start).count();
+
+  /* add counters of children */
+  double children_seconds = 0.0;
+
+  for (const size_t child : phase.children) {
+    const PhaseCounters counters =
+        collect(child, depth + 1, phase_path, now, stats);
+
+    children_seconds += counters.seconds;
+    inclusive.num_allocs += counters.num_allocs;
+    inclusive.num_frees += counters.num_frees;
+    inclusive.host_peak_bytes =
+        std::max(inclusive.host_peak_bytes, counters.host_peak_bytes);
+    inclusive.dev_peak_bytes =
+        std::max(inclusive.dev_peak_bytes, counters.dev_peak_bytes);
+    inclusive.to_device_count += counters.to_device_count;
+    inclusive.to_device_bytes += counters.to_device_bytes;
+    inclusive.to_device_seconds += counters.to_device_seconds;
+    inclusive.from_device_count += counters.from_device_count;
+    inclusive.from_device_bytes += counters.from_device_bytes;
+    inclusive.from_device_seconds += counters.from_device_seconds;
+  }
+
+  stats[index].inclusive = inclusive;
+  stats[index].exclusive.seconds =
+      std::max(inclusive.seconds - children_seconds, 0.0);
+
+  return inclusive;
+}
+
+/**
+ * @brief Returns the statistics of all phases.
+ *
+ * @return Statistics of each phase, in depth-first order.
+ */
+std::vector<PhaseStats> PhaseProfiler::stats() const {
+
+  const auto now = std::chrono::steady_clock::now();
+  std::vector<PhaseStats> stats;
+
+  for (const size_t child : nodes[0].children)
+    collect(child, 0, "", now, stats);
+
+  return stats;
+}
+
+/**
+ * @brief Returns the statistics of all phases as a JSON document.
+ *
+ * @details
+ * Each phase is an object with its name, path, number of calls,
+ * inclusive and exclusive counters, and child phases.
+ *
+ * @return JSON object with the tree of phases.
+ */
+std::string PhaseProfiler::json() const {
+
+  const std::vector<PhaseStats> phases = stats();
+  std::string json = "{\"phases\": [";
+
+  for (size_t i = 0; i < phases.size(); i++) {
+    const PhaseStats &phase = phases[i];
+
+    /* close previous phases that are not enclosing this one */
+    if (i > 0 && phase.depth <= phases[i - 1].depth) {
+      for (size_t d = phase.depth; d <= phases[i - 1].depth; d++)
+        json += "]}";
+      json += ", ";
+    }
+
+    json += "{\"name\": " + json_string(phase.name) +
+            ", \"path\": " + json_string(phase.path) +
+            ", \"calls\": " + std::to_string(phase.num_calls) +
+            ", \"open\": " + (phase.open ? "true" : "false") +
+            ", \"inclusive\": " + json_counters(phase.inclusive) +
+            ", \"exclusive\": " + json_counters(phase.exclusive) +
+            ", \"children\": [";
+  }
+
+  if (!phases.empty())
+    for (size_t d = 0; d <= phases.back().depth; d++)
+      json += "]}";
+
+  return json + "]}";
+}
+
+/**
+ * @brief Prints the statistics of all phases as an indented table.
+ *
+ * @details
+ * Times, transferred bytes, allocations and frees are shown inclusive of
+ * child phases, with exclusive times alongside; open phases are marked
+ * with '*'.
+ */
+void PhaseProfiler::report() const {
+
+  const std::vector<PhaseStats> phases = stats();
+
+  /* set width of the phase column */
+  const std::string phase_header = "Phase";
+  size_t phase_col_width = phase_header.length();
+
+  for (const PhaseStats &phase : phases)
+    phase_col_width =
+        std::max(phase_col_width, 2 * phase.depth + phase.name.length() + 1);
+  phase_col_width += 2;
+
+  const size_t total_width = phase_col_width + 8 + 2 * 12 + 2 * 16 + 2 * 8 +
+                             2 * 16;
+  const std::string big_separator = std::string(total_width, '=') + "\n";
+  const std::string small_separator = std::string(total_width, '-') + "\n";
+
+  std::cout << "\n" << big_separator;
+  std::cout << "Phase Report:\n";
+  std::cout << big_separator;
+  std::cout << std::left << std::setw(phase_col_width) << phase_header
+            << std::right << std::setw(8) << "Calls" << std::setw(12)
+            << "Incl (s)" << std::setw(12) << "Excl (s)" << std::setw(16)
+            << "H2D (bytes)" << std::setw(16) << "D2H (bytes)"
+            << std::setw(8) << "Allocs" << std::setw(8) << "Frees"
+            << std::setw(16) << "Peak host" << std::setw(16) << "Peak device"
+            << "\n";
+  std::cout << small_separator;
+
+  for (const PhaseStats &phase : phases) {
+    const std::string name = std::string(2 * phase.depth, ' ') + phase.name +
+                             (phase.open ? "*" : "");
+
+    std::cout << std::left << std::setw(phase_col_width) << name
+              << std::right << std::setw(8) << phase.num_calls << std::fixed
+              << std::setprecision(6) << std::setw(12)
+              << phase.inclusive.seconds << std::setw(12)
+              << phase.exclusive.seconds << std::setw(16)
+              << phase.inclusive.to_device_bytes << std::setw(16)
+              << phase.inclusive.from_device_bytes << std::setw(8)
+              << phase.inclusive.num_allocs << std::setw(8)
+              << phase.inclusive.num_frees << std::setw(16)
+              << phase.inclusive.host_peak_bytes << std::setw(16)
+              << phase.inclusive.dev_peak_bytes << "\n"
+              << std::defaultfloat;
+  }
+  std::cout << big_separator << "\n";
+
+  return;
+}
+
+/**
+ * @brief Forgets all phases.
+ *
+ * @note If a phase is open, the program aborts.
+ */
+void PhaseProfiler::reset() {
+
+  if (active())
+    abort_mimmo("Phases cannot be reset while a phase is open.");
+
+  nodes.assign(1, {"", 0, {}, 0, false, {}, {}});
+  stack.assign(1, 0);
+
+  return;
+}
+
+} // namespace MiMMO
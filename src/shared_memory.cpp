@@ -0,0 +1,305 @@
+/**
+ * @file shared_memory.cpp
+ *
+ * @brief Implementation of utilities for host memory shared across
+ * processes.
+ *
+ * @see shared_memory.hpp
+ */
+
+#include "../include/private/shared_memory.hpp"
+#include "../include/private/abort.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace MiMMO {
+
+/**
+ * @brief Header at the beginning of a shared-memory segment.
+ *
+ * @details
+ * Atomics are lock-free for 64-bit integers on supported platforms, so
+ * they work across processes mapping the same memory. The header starts
+ * zero-filled, as the segment is sized by ftruncate.
+ */
+struct SharedHeader {
+  std::atomic<uint64_t> published;  /*!< whether data can be read */
+  std::atomic<uint64_t> references; /*!< number of attached processes */
+  uint64_t size_bytes;              /*!< size in bytes of the data */
+};
+
+/**
+ * @brief Returns the size of memory pages.
+ *
+ * @return Size in bytes of a page.
+ */
+static size_t page_size() {
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+/**
+ * @brief Returns the size of the data mapping of a segment.
+ *
+ * @param size_bytes Size in bytes of the data.
+ *
+ * @return           Size rounded up to whole pages.
+ */
+static size_t mapped_bytes(const size_t size_bytes) {
+  const size_t page = page_size();
+  return (size_bytes + page - 1) / page * page;
+}
+
+/**
+ * @brief Returns the POSIX name of a segment.
+ *
+ * @param name Name of the segment.
+ *
+ * @return     Name starting with a slash.
+ */
+static std::string posix_name(const std::string &name) {
+  return name[0] == '/' ? name : "/" + name;
+}
+
+/**
+ * @brief Maps a range of a shared-memory segment.
+ *
+ * @param fd     File descriptor of the segment.
+ * @param size   Size in bytes of the range.
+ * @param offset Offset in bytes of the range.
+ * @param prot   Memory protection of the mapping.
+ * @param name   Name of the segment (for error messages).
+ *
+ * @return       Pointer to the mapping.
+ *
+ * @note If mapping fails, the program aborts.
+ */
+static void *map_segment(const int fd, const size_t size, const off_t offset,
+                         const int prot, const std::string &name) {
+
+  void *const ptr = mmap(nullptr, size, prot, MAP_SHARED, fd, offset);
+
+  if (ptr == MAP_FAILED) {
+    close(fd);
+    abort_mimmo("Failed to map shared segment '" + name + "'.");
+  }
+
+  return ptr;
+}
+
+/**
+ * @brief Returns the read-only data mappings of this process.
+ *
+ * @param lock Lock on the mappings, held while they are used.
+ *
+ * @return     Size in bytes of each mapping, by start address.
+ */
+static std::map<const char *, size_t> &
+read_only_mappings(std::unique_lock<std::mutex> &lock) {
+  static std::mutex mutex;
+  static std::map<const char *, size_t> mappings;
+
+  lock = std::unique_lock<std::mutex>(mutex);
+
+  return mappings;
+}
+
+/**
+ * @brief Registers the data mapping of a segment as read-only.
+ *
+ * @param segment Mapping of the segment.
+ */
+static void add_read_only_mapping(const SharedSegment &segment) {
+  if (segment.data_ptr == nullptr)
+    return;
+
+  std::unique_lock<std::mutex> lock;
+  read_only_mappings(lock)[(const char *)segment.data_ptr] =
+      segment.size_bytes;
+
+  return;
+}
+
+/**
+ * @brief Creates a shared-memory segment, or attaches to it if another
+ * process already created it.
+ *
+ * @details
+ * The first process to open the name creates the segment and may fill its
+ * data until it is published. The others wait for publication (up to
+ * shared_attach_timeout seconds) and map data read-only.
+ *
+ * @param name       Name of the segment.
+ * @param size_bytes Size in bytes of the data.
+ *
+ * @return           Mapping of the segment.
+ *
+ * @note If the segment cannot be created or mapped, has a different size,
+ *       or is not published in time, the program aborts.
+ */
+SharedSegment open_shared_segment(const std::string name,
+                                  const size_t size_bytes) {
+
+  const std::string shm_name = posix_name(name);
+  const size_t page = page_size();
+  const size_t total_bytes = page + mapped_bytes(size_bytes);
+  const auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration<double>(shared_attach_timeout);
+
+  SharedSegment segment = {name, nullptr, nullptr, size_bytes, false};
+  int fd = -1;
+
+  /* create segment, or open it (retrying if it vanishes meanwhile) */
+  while (fd < 0) {
+    fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    segment.creator = fd >= 0;
+
+    if (fd < 0 && errno == EEXIST)
+      fd = shm_open(shm_name.c_str(), O_RDWR, 0600);
+
+    if (fd < 0 && errno != ENOENT)
+      abort_mimmo("Failed to open shared segment '" + name + "'.");
+  }
+
+  if (segment.creator) {
+    if (ftruncate(fd, total_bytes) != 0) {
+      close(fd);
+      shm_unlink(shm_name.c_str());
+      abort_mimmo("Failed to size shared segment '" + name + "'.");
+    }
+
+    segment.header_ptr =
+        map_segment(fd, page, 0, PROT_READ | PROT_WRITE, name);
+    /* the header is zero-filled by ftruncate, and attachers may already
+     * reference it: only count the creator in */
+    SharedHeader *const header =
+        static_cast<SharedHeader *>(segment.header_ptr);
+    header->references.fetch_add(1);
+    header->size_bytes = size_bytes;
+
+    if (size_bytes > 0)
+      segment.data_ptr = map_segment(fd, mapped_bytes(size_bytes), page,
+                                     PROT_READ | PROT_WRITE, name);
+    close(fd);
+
+    return segment;
+  }
+
+  /* wait for the creator to size the segment */
+  struct stat status;
+  while (fstat(fd, &status) == 0 && status.st_size == 0 &&
+         std::chrono::steady_clock::now() < deadline)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  if (status.st_size != static_cast<off_t>(total_bytes)) {
+    close(fd);
+    abort_mimmo("Shared segment '" + name + "' has a different size.");
+  }
+
+  segment.header_ptr = map_segment(fd, page, 0, PROT_READ | PROT_WRITE, name);
+  SharedHeader *const header = static_cast<SharedHeader *>(segment.header_ptr);
+  header->references.fetch_add(1);
+
+  /* wait for the creator to publish data */
+  while (header->published.load(std::memory_order_acquire) == 0) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      close(fd);
+      abort_mimmo("Shared segment '" + name + "' was not published in time.");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  if (size_bytes > 0)
+    segment.data_ptr =
+        map_segment(fd, mapped_bytes(size_bytes), page, PROT_READ, name);
+  close(fd);
+
+  add_read_only_mapping(segment);
+
+  return segment;
+}
+
+/**
+ * @brief Publishes the data of a shared-memory segment to the other
+ * processes, and makes it read-only.
+ *
+ * @param segment Mapping of the segment (ignored if not the creator).
+ */
+void publish_shared_segment(SharedSegment &segment) {
+
+  if (!segment.creator)
+    return;
+
+  if (segment.data_ptr != nullptr)
+    mprotect(segment.data_ptr, mapped_bytes(segment.size_bytes), PROT_READ);
+  add_read_only_mapping(segment);
+
+  SharedHeader *const header = static_cast<SharedHeader *>(segment.header_ptr);
+  header->published.store(1, std::memory_order_release);
+
+  return;
+}
+
+/**
+ * @brief Detaches from a shared-memory segment, removing it once no
+ * process is attached anymore.
+ *
+ * @details
+ * Once removed, the name can be used for a new segment, e.g. by a process
+ * starting after all others have detached.
+ *
+ * @param segment Mapping of the segment.
+ */
+void close_shared_segment(SharedSegment &segment) {
+
+  if (segment.data_ptr != nullptr) {
+    std::unique_lock<std::mutex> lock;
+    read_only_mappings(lock).erase((const char *)segment.data_ptr);
+    munmap(segment.data_ptr, mapped_bytes(segment.size_bytes));
+  }
+
+  SharedHeader *const header = static_cast<SharedHeader *>(segment.header_ptr);
+
+  if (header->references.fetch_sub(1) == 1)
+    shm_unlink(posix_name(segment.name).c_str());
+
+  munmap(segment.header_ptr, page_size());
+
+  segment.header_ptr = nullptr;
+  segment.data_ptr = nullptr;
+
+  return;
+}
+
+/**
+ * @brief Returns whether memory lies in shared data that this process
+ * cannot write, i.e. attached or already published.
+ *
+ * @param ptr Address to be checked.
+ *
+ * @return    'true' if the memory is read-only shared data.
+ */
+bool is_read_only_shared(const void *const ptr) {
+
+  std::unique_lock<std::mutex> lock;
+  const std::map<const char *, size_t> &mappings = read_only_mappings(lock);
+
+  auto it = mappings.upper_bound((const char *)ptr);
+  if (it == mappings.begin())
+    return false;
+  it--;
+
+  return (const char *)ptr < it->first + it->second;
+}
+
+} // namespace MiMMO
@@ -0,0 +1,276 @@
+/**
+ * @file stats_export.cpp
+ *
+ * @brief Implementation of the live statistics exporter.
+ *
+ * @see stats_export.hpp
+ */
+
+#include "../include/private/stats_export.hpp"
+#include "../include/private/abort.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MiMMO {
+
+/**
+ * @brief Returns the POSIX name of a statistics page.
+ *
+ * @param name Name of the page.
+ *
+ * @return     Name starting with a slash.
+ */
+static std::string posix_name(const std::string &name) {
+  return name[0] == '/' ? name : "/" + name;
+}
+
+/**
+ * @brief Class constructor.
+ */
+StatsExporter::StatsExporter()
+    : name(), page(nullptr), snapshot(),
+      interval_seconds(default_stats_interval), next_update() {}
+
+/**
+ * @brief Creates the statistics page.
+ *
+ * @details
+ * A page left by a previous process with the same name is replaced.
+ *
+ * @param name       Name of the page.
+ * @param interval_s Minimum interval between updates, in seconds.
+ *
+ * @note If the page cannot be created, the program aborts.
+ */
+void StatsExporter::open(const std::string &name, const double interval_s) {
+
+  close();
+
+  const std::string shm_name = posix_name(name);
+  shm_unlink(shm_name.c_str());
+
+  const int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+
+  if (fd < 0)
+    abort_mimmo("Failed to create statistics page '" + name + "'.");
+
+  if (ftruncate(fd, sizeof(StatsPage)) != 0) {
+    ::close(fd);
+    shm_unlink(shm_name.c_str());
+    abort_mimmo("Failed to size statistics page '" + name + "'.");
+  }
+
+  void *const ptr = mmap(nullptr, sizeof(StatsPage), PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (ptr == MAP_FAILED) {
+    shm_unlink(shm_name.c_str());
+    abort_mimmo("Failed to map statistics page '" + name + "'.");
+  }
+
+  page = new (ptr) StatsPage;
+  page->magic = stats_page_magic;
+  page->version = stats_page_version;
+  page->sequence.store(0);
+
+  this->name = name;
+  interval_seconds = interval_s;
+  snapshot.pid = static_cast<uint64_t>(getpid());
+
+  return;
+}
+
+/**
+ * @brief Removes the statistics page, if any.
+ *
+ * @details
+ * Readers still attached keep their mapping, with the last counters.
+ */
+void StatsExporter::close() {
+
+  if (page == nullptr)
+    return;
+
+  munmap(page, sizeof(StatsPage));
+  shm_unlink(posix_name(name).c_str());
+
+  page = nullptr;
+  name.clear();
+
+  return;
+}
+
+/**
+ * @brief Adds a label to the next update, in order of decreasing memory
+ * used.
+ *
+ * @details
+ * Labels beyond stats_max_labels are only counted.
+ *
+ * @param label      Label of the objects.
+ * @param host_bytes Host memory used by the objects.
+ * @param dev_bytes  Device memory used by the objects.
+ */
+void StatsExporter::add_label(const std::string &label,
+                              const size_t host_bytes,
+                              const size_t dev_bytes) {
+
+  if (snapshot.num_labels == stats_max_labels) {
+    snapshot.num_other_labels++;
+    return;
+  }
+
+  StatsLabel &entry = snapshot.labels[snapshot.num_labels++];
+  const size_t length = std::min(label.length(), stats_label_chars - 1);
+
+  std::memcpy(entry.label, label.data(), length);
+  entry.label[length] = '\0';
+  entry.host_bytes = host_bytes;
+  entry.dev_bytes = dev_bytes;
+
+  return;
+}
+
+/**
+ * @brief Writes the counters into the statistics page.
+ *
+ * @details
+ * The sequence number is made odd while the snapshot is copied, and even
+ * again afterwards, so the writer never waits for readers.
+ */
+void StatsExporter::publish() {
+
+  if (page == nullptr)
+    return;
+
+  snapshot.num_updates++;
+  snapshot.time_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+
+  /* only labels in use are copied */
+  const size_t used_bytes = offsetof(StatsSnapshot, labels) +
+                            snapshot.num_labels * sizeof(StatsLabel);
+
+  const uint64_t sequence = page->sequence.load(std::memory_order_relaxed);
+  page->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  std::memcpy(&page->snapshot, &snapshot, used_bytes);
+
+  page->sequence.store(sequence + 2, std::memory_order_release);
+
+  next_update = std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(interval_seconds));
+
+  return;
+}
+
+/**
+ * @brief Returns the default name of the statistics page of a process.
+ *
+ * @param pid Process identifier (-1 for the current process).
+ *
+ * @return    Name of the page.
+ */
+std::string default_stats_page_name(const long pid) {
+  return "mimmo-stats-" +
+         std::to_string(pid < 0 ? static_cast<long>(getpid()) : pid);
+}
+
+/**
+ * @brief Maps a statistics page of another process for reading.
+ *
+ * @param name Name of the page.
+ *
+ * @return     Mapping of the page (nullptr if it does not exist or is not
+ *             a statistics page).
+ */
+const StatsPage *attach_stats_page(const std::string &name) {
+
+  const int fd = shm_open(posix_name(name).c_str(), O_RDONLY, 0);
+
+  if (fd < 0)
+    return nullptr;
+
+  struct stat status;
+  if (fstat(fd, &status) != 0 ||
+      status.st_size != static_cast<off_t>(sizeof(StatsPage))) {
+    ::close(fd);
+    return nullptr;
+  }
+
+  void *const ptr =
+      mmap(nullptr, sizeof(StatsPage), PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (ptr == MAP_FAILED)
+    return nullptr;
+
+  const StatsPage *const page = static_cast<const StatsPage *>(ptr);
+
+  if (page->magic != stats_page_magic ||
+      page->version != stats_page_version) {
+    munmap(ptr, sizeof(StatsPage));
+    return nullptr;
+  }
+
+  return page;
+}
+
+/**
+ * @brief Unmaps a statistics page mapped by attach_stats_page().
+ *
+ * @param page Mapping of the page (nullptr is ignored).
+ */
+void detach_stats_page(const StatsPage *const page) {
+  if (page != nullptr)
+    munmap((void *)page, sizeof(StatsPage));
+  return;
+}
+
+/**
+ * @brief Copies a consistent snapshot out of a statistics page.
+ *
+ * @details
+ * The copy is retried a few times if the writer updated the page
+ * meanwhile.
+ *
+ * @param page     Mapping of the page.
+ * @param snapshot Copy of the published counters.
+ *
+ * @return         Whether a consistent copy was made (the writer may keep
+ *                 updating the page in the meantime).
+ */
+bool read_stats_page(const StatsPage *const page, StatsSnapshot &snapshot) {
+
+  for (int attempt = 0; attempt < 100; attempt++) {
+    const uint64_t before = page->sequence.load(std::memory_order_acquire);
+
+    /* nothing published yet, or an update is in progress */
+    if (before == 0 || (before & 1) != 0) {
+      usleep(10);
+      continue;
+    }
+
+    std::memcpy(&snapshot, &page->snapshot, sizeof(StatsSnapshot));
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (page->sequence.load(std::memory_order_relaxed) == before) {
+      snapshot.num_labels = std::min<uint64_t>(snapshot.num_labels,
+                                               stats_max_labels);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace MiMMO
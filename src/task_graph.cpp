@@ -0,0 +1,336 @@
+/**
+ * @file task_graph.cpp
+ *
+ * @brief Implementation of task graphs.
+ *
+ * @see task_graph.hpp
+ */
+
+#include "../include/mimmo/api.hpp"
+#include <set>
+#include <sstream>
+
+namespace MiMMO {
+
+/**
+ * @brief Escapes a label for a quoted DOT string.
+ *
+ * @param label Label of a node.
+ *
+ * @return      Label with quotes and backslashes escaped.
+ */
+static std::string dot_escape(const std::string &label) {
+  std::string escaped;
+
+  for (const char c : label) {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    escaped += c;
+  }
+
+  return escaped;
+}
+
+/**
+ * @brief Class constructor.
+ *
+ * @param manager    Memory manager of the accessed objects.
+ * @param queue_base First asynchronous queue of the graph.
+ * @param num_queues Number of asynchronous queues of the graph.
+ *
+ * @note If the number of queues is not positive, the program aborts.
+ */
+TaskGraph::TaskGraph(DualMemoryManager &manager, const int queue_base,
+                     const int num_queues)
+    : manager(manager), queue_base(queue_base), num_queues(num_queues),
+      queue_counter(0), tasks(), states(), nodes(),
+      stats({0, 0, 0, 0, 0, 0, 0, 0}), ordered() {
+  if (num_queues < 1)
+    abort_mimmo("A task graph needs at least one queue.");
+}
+
+/**
+ * @brief Adds a task at the end of the graph.
+ *
+ * @param name     Name of the task.
+ * @param side     Side on which the task accesses its objects.
+ * @param accesses Objects accessed by the task.
+ * @param run      Work of the task, given its queue (-1 for host tasks).
+ *
+ * @note If an object is accessed twice by the task, the program aborts.
+ */
+void TaskGraph::add_task(const std::string &name, const Side side,
+                         const std::vector<TaskAccess> &accesses,
+                         const std::function<void(int)> &run) {
+
+  for (size_t i = 0; i < accesses.size(); i++)
+    for (size_t j = i + 1; j < accesses.size(); j++)
+      if (accesses[i].object == accesses[j].object)
+        abort_mimmo("Task '" + name + "' accesses an object twice.");
+
+  tasks.push_back({name, side == Side::Device, accesses, run});
+
+  return;
+}
+
+/**
+ * @brief Declares on which sides a dual object is up to date.
+ *
+ * @param object     Address of the dual object.
+ * @param host_valid Whether host data is up to date.
+ * @param dev_valid  Whether device data is up to date.
+ */
+void TaskGraph::set_valid(const void *const object, const bool host_valid,
+                          const bool dev_valid) {
+  states[object] = {host_valid, dev_valid};
+  return;
+}
+
+/**
+ * @brief Returns the next queue of the graph, in round-robin order.
+ *
+ * @return Asynchronous queue.
+ */
+int TaskGraph::next_queue() {
+  return queue_base + (queue_counter++ % num_queues);
+}
+
+/**
+ * @brief Orders a node after its dependencies.
+ *
+ * @details
+ * Waits already covering all dependencies on a queue are not repeated.
+ *
+ * @param node Node to be ordered (not yet added to the nodes).
+ */
+void TaskGraph::order_after_deps(const GraphNode &node) {
+
+  /* latest dependency on each other queue */
+  std::map<int, size_t> latest;
+
+  for (const size_t dep : node.deps) {
+    const int queue = nodes[dep].queue;
+    if (queue >= 0 && queue != node.queue)
+      latest[queue] = std::max(latest[queue], dep);
+  }
+
+  for (const auto &[queue, dep] : latest) {
+    const std::pair<int, int> key = {queue, node.queue};
+    const auto it = ordered.find(key);
+
+    if (it != ordered.end() && dep < it->second)
+      continue;
+
+    if (node.queue >= 0) {
+      manager.wait_queue_async(queue, node.queue);
+      stats.num_queue_waits++;
+    } else {
+      manager.wait_queue(queue);
+      stats.num_host_waits++;
+    }
+
+    /* nodes up to this one are now ordered before the waiting side */
+    ordered[key] = nodes.size();
+  }
+
+  return;
+}
+
+/**
+ * @brief Runs all tasks, then waits for the queues of the graph.
+ */
+void TaskGraph::execute() {
+
+  const bool has_device = manager.num_devices() > 0;
+
+  nodes.clear();
+  ordered.clear();
+  stats = {0, 0, 0, 0, 0, 0, 0, 0};
+  queue_counter = 0;
+
+  std::map<const void *, GraphObjectUse> uses;
+  std::set<int> used_queues;
+
+  for (const GraphTask &task : tasks) {
+
+    /* read after write, and write after read or write */
+    std::set<size_t> deps;
+
+    for (const TaskAccess &access : task.accesses) {
+      const GraphObjectUse &use =
+          uses.try_emplace(access.object, GraphObjectUse{-1, {}})
+              .first->second;
+
+      if (use.last_writer >= 0)
+        deps.insert(static_cast<size_t>(use.last_writer));
+      if (access.mode != TaskAccessMode::Read)
+        deps.insert(use.readers.begin(), use.readers.end());
+    }
+
+    /* continue the queue of the latest device dependency, or start an
+     * independent one */
+    int queue = -1;
+
+    if (task.on_device) {
+      for (auto it = deps.rbegin(); it != deps.rend() && queue < 0; it++)
+        queue = nodes[*it].queue;
+
+      if (queue < 0)
+        queue = next_queue();
+      used_queues.insert(queue);
+    }
+
+    /* copy read objects that are out of date on the side of the task */
+    for (const TaskAccess &access : task.accesses) {
+      GraphObjectState &state =
+          states.try_emplace(access.object, GraphObjectState{true, false})
+              .first->second;
+      bool &valid = task.on_device ? state.dev_valid : state.host_valid;
+      const bool other_valid =
+          task.on_device ? state.host_valid : state.dev_valid;
+
+      if (access.mode == TaskAccessMode::Write || !has_device || valid ||
+          !other_valid)
+        continue;
+
+      GraphObjectUse &use = uses[access.object];
+
+      /* downloads follow the device work that wrote the object */
+      int transfer_queue = queue;
+      if (!task.on_device) {
+        transfer_queue =
+            use.last_writer >= 0 ? nodes[use.last_writer].queue : -1;
+        if (transfer_queue < 0)
+          transfer_queue = next_queue();
+      }
+      used_queues.insert(transfer_queue);
+
+      GraphNode transfer = {manager.return_label(access.object),
+                            true,
+                            task.on_device,
+                            transfer_queue,
+                            access.size_bytes,
+                            {}};
+      if (use.last_writer >= 0)
+        transfer.deps.push_back(static_cast<size_t>(use.last_writer));
+
+      order_after_deps(transfer);
+      access.transfer(manager, task.on_device, transfer_queue);
+
+      if (task.on_device) {
+        stats.num_uploads++;
+        stats.upload_bytes += access.size_bytes;
+      } else {
+        stats.num_downloads++;
+        stats.download_bytes += access.size_bytes;
+      }
+
+      /* the transfer reads the other side, and the task depends on it */
+      deps.insert(nodes.size());
+      use.readers.push_back(nodes.size());
+      nodes.push_back(transfer);
+
+      valid = true;
+    }
+
+    GraphNode node = {task.name,
+                      false,
+                      task.on_device,
+                      queue,
+                      0,
+                      std::vector<size_t>(deps.begin(), deps.end())};
+    order_after_deps(node);
+
+#ifndef _OPENACC
+    /* device work runs on host, once its transfers are complete */
+    if (task.on_device)
+      manager.wait_queue(queue);
+#endif
+
+    task.run(queue);
+
+    const size_t id = nodes.size();
+    nodes.push_back(node);
+    stats.num_tasks++;
+
+    /* written objects are only up to date on the side of the task */
+    for (const TaskAccess &access : task.accesses) {
+      GraphObjectUse &use = uses[access.object];
+
+      if (access.mode == TaskAccessMode::Read) {
+        use.readers.push_back(id);
+        continue;
+      }
+
+      use.last_writer = static_cast<long>(id);
+      use.readers.clear();
+      states[access.object] = {!task.on_device || !has_device,
+                               task.on_device || !has_device};
+    }
+  }
+
+  for (const int queue : used_queues)
+    manager.wait_queue(queue);
+
+  stats.num_queues = used_queues.size();
+
+  return;
+}
+
+/**
+ * @brief Returns statistics of the last execution.
+ *
+ * @return Numbers of tasks, transfers and waits.
+ */
+TaskGraphStats TaskGraph::return_stats() const { return stats; }
+
+/**
+ * @brief Returns the graph of the last execution in DOT format.
+ *
+ * @return Graph description for Graphviz.
+ */
+std::string TaskGraph::return_dot() const {
+
+  const char *const colors[] = {"blue",   "red",    "darkgreen", "orange",
+                                "purple", "brown",  "cyan4",     "magenta"};
+  const int num_colors = sizeof(colors) / sizeof(colors[0]);
+
+  std::ostringstream dot;
+  dot << "digraph tasks {\n";
+
+  for (size_t i = 0; i < nodes.size(); i++) {
+    const GraphNode &node = nodes[i];
+
+    std::string label;
+    if (node.is_transfer)
+      label = (node.on_device ? "upload " : "download ") +
+              dot_escape(node.name) + "\\n" +
+              std::to_string(node.size_bytes) + " B";
+    else
+      label = dot_escape(node.name) + "\\n" +
+              (node.queue >= 0 ? "queue " + std::to_string(node.queue)
+                               : std::string("host"));
+
+    const char *const color =
+        node.queue < 0
+            ? "black"
+            : colors[((node.queue - queue_base) % num_colors + num_colors) %
+                     num_colors];
+
+    dot << "  n" << i << " [shape=" << (node.is_transfer ? "ellipse" : "box")
+        << ", color=" << color << ", label=\"" << label << "\"];\n";
+  }
+
+  /* edges between queues are dashed */
+  for (size_t i = 0; i < nodes.size(); i++)
+    for (const size_t dep : nodes[i].deps)
+      dot << "  n" << dep << " -> n" << i
+          << (nodes[dep].queue != nodes[i].queue ? " [style=dashed]" : "")
+          << ";\n";
+
+  dot << "}\n";
+
+  return dot.str();
+}
+
+} // namespace MiMMO
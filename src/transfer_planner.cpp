@@ -0,0 +1,368 @@
+/**
+ * @file transfer_planner.cpp
+ *
+ * @brief Implementation of the transfer model and planner.
+ *
+ * Also implements DualMemoryManager::calibrate_transfers().
+ *
+ * @see transfer_planner.hpp
+ * @see api.hpp
+ */
+
+#include "../include/mimmo/api.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace MiMMO {
+
+/**
+ * @brief Minimum size in bytes of pipelined chunks.
+ */
+constexpr size_t min_chunk_bytes = size_t(1) << 20;
+
+/**
+ * @brief Returns the model used before any calibration.
+ *
+ * @return Model of a typical PCIe-attached device.
+ */
+TransferModel default_transfer_model() {
+  return {"", 10e-6, 12e9, 10e-6, 12e9, 10e9, {}, {}};
+}
+
+/**
+ * @brief Fits latency and bandwidth to a curve by least squares.
+ *
+ * @param samples   Measured transfer times.
+ * @param latency   Fitted latency (unchanged if the fit fails).
+ * @param bandwidth Fitted bandwidth (unchanged if the fit fails).
+ */
+static void fit_curve(const std::vector<TransferSample> &samples,
+                      double &latency, double &bandwidth) {
+
+  const double n = static_cast<double>(samples.size());
+
+  if (samples.size() < 2)
+    return;
+
+  double sum_s = 0.0, sum_t = 0.0, sum_ss = 0.0, sum_st = 0.0;
+  for (const TransferSample &sample : samples) {
+    const double s = static_cast<double>(sample.size_bytes);
+    sum_s += s;
+    sum_t += sample.seconds;
+    sum_ss += s * s;
+    sum_st += s * sample.seconds;
+  }
+
+  const double denominator = n * sum_ss - sum_s * sum_s;
+
+  if (denominator <= 0.0)
+    return;
+
+  /* time = latency + size * inverse_bandwidth */
+  const double inverse_bandwidth = (n * sum_st - sum_s * sum_t) / denominator;
+
+  if (inverse_bandwidth <= 0.0)
+    return;
+
+  bandwidth = 1.0 / inverse_bandwidth;
+  latency = std::max((sum_t - inverse_bandwidth * sum_s) / n, 0.0);
+
+  return;
+}
+
+/**
+ * @brief Fits latency and bandwidth of a model to its measured curves.
+ *
+ * @param model Model whose samples should be fitted.
+ */
+void fit_transfer_model(TransferModel &model) {
+  fit_curve(model.to_device_samples, model.to_device_latency,
+            model.to_device_bandwidth);
+  fit_curve(model.from_device_samples, model.from_device_latency,
+            model.from_device_bandwidth);
+  return;
+}
+
+/**
+ * @brief Loads a model from a calibration file.
+ *
+ * @details
+ * The file is made of lines with a key followed by values; lines
+ * starting with '#' are ignored.
+ *
+ * @param file_name Name of the calibration file.
+ * @param backend   Name of the backend the model must refer to.
+ * @param model     Model to be loaded.
+ *
+ * @return          'true' if a valid model for the backend was loaded,
+ *                  'false' otherwise.
+ */
+bool load_transfer_model(const std::string &file_name,
+                         const std::string &backend, TransferModel &model) {
+
+  std::ifstream file(file_name);
+
+  if (!file)
+    return false;
+
+  TransferModel loaded = default_transfer_model();
+  std::string line;
+
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream fields(line);
+    std::string key;
+    fields >> key;
+
+    if (key == "backend") {
+      fields >> loaded.backend;
+    } else if (key == "host_bandwidth") {
+      fields >> loaded.host_bandwidth;
+    } else if (key == "to_device" || key == "from_device") {
+      TransferSample sample = {0, 0.0};
+      fields >> sample.size_bytes >> sample.seconds;
+      if (!fields)
+        return false;
+      (key == "to_device" ? loaded.to_device_samples
+                          : loaded.from_device_samples)
+          .push_back(sample);
+    }
+  }
+
+  /* reject files of other backends, or without curves */
+  if (loaded.backend != backend || loaded.to_device_samples.size() < 2 ||
+      loaded.from_device_samples.size() < 2)
+    return false;
+
+  fit_transfer_model(loaded);
+  model = loaded;
+
+  return true;
+}
+
+/**
+ * @brief Saves a model to a calibration file.
+ *
+ * @param file_name Name of the calibration file.
+ * @param model     Model to be saved.
+ *
+ * @return          'true' if the file was written, 'false' otherwise.
+ */
+bool save_transfer_model(const std::string &file_name,
+                         const TransferModel &model) {
+
+  std::ofstream file(file_name);
+
+  if (!file)
+    return false;
+
+  file.precision(9);
+  file << "# MiMMO transfer calibration (size in bytes, time in seconds)\n";
+  file << "backend " << model.backend << "\n";
+  file << "host_bandwidth " << model.host_bandwidth << "\n";
+  for (const TransferSample &sample : model.to_device_samples)
+    file << "to_device " << sample.size_bytes << " " << sample.seconds
+         << "\n";
+  for (const TransferSample &sample : model.from_device_samples)
+    file << "from_device " << sample.size_bytes << " " << sample.seconds
+         << "\n";
+
+  return static_cast<bool>(file);
+}
+
+/**
+ * @brief Plans the transfer of several ranges of an array.
+ *
+ * @details
+ * Ranges are sorted and merged when they overlap or touch; elements
+ * between disjoint ranges are never moved, since they may hold data that
+ * must not be overwritten on the destination. If several ranges remain
+ * and packing them costs less than the latencies it saves, they are
+ * packed into a staging buffer and moved as a single payload (together
+ * with a table of ranges used to unpack them on device). Payloads much
+ * larger than the bandwidth-latency product are split into chunks, so
+ * that host-side packing and transfers can be pipelined.
+ *
+ * @param model         Transfer model of the machine.
+ * @param ranges        Ranges to be transferred (in any order, possibly
+ *                      overlapping).
+ * @param element_bytes Size in bytes of each element.
+ * @param to_device     Whether data is copied from host to device (or
+ *                      the other way round).
+ *
+ * @return              Plan of the transfer.
+ */
+TransferPlan plan_transfer(const TransferModel &model,
+                           std::vector<TransferRange> ranges,
+                           const size_t element_bytes, const bool to_device) {
+
+  TransferPlan plan = {{}, false, 0, 0.0};
+
+  const double latency =
+      to_device ? model.to_device_latency : model.from_device_latency;
+  const double bandwidth =
+      to_device ? model.to_device_bandwidth : model.from_device_bandwidth;
+
+  /* drop empty ranges and sort the others */
+  ranges.erase(std::remove_if(ranges.begin(), ranges.end(),
+                              [](const TransferRange &range) {
+                                return range.num_elements == 0;
+                              }),
+               ranges.end());
+
+  if (ranges.empty())
+    return plan;
+
+  std::sort(ranges.begin(), ranges.end(),
+            [](const TransferRange &a, const TransferRange &b) {
+              return a.offset < b.offset;
+            });
+
+  /* merge overlapping or touching ranges */
+  plan.ranges.push_back(ranges[0]);
+  for (size_t i = 1; i < ranges.size(); i++) {
+    TransferRange &last = plan.ranges.back();
+    const size_t last_end = last.offset + last.num_elements;
+    const size_t end = ranges[i].offset + ranges[i].num_elements;
+
+    if (ranges[i].offset <= last_end)
+      last.num_elements = std::max(last_end, end) - last.offset;
+    else
+      plan.ranges.push_back(ranges[i]);
+  }
+
+  /* compare separate transfers with a single staged payload */
+  const double num_ranges = static_cast<double>(plan.ranges.size());
+  size_t payload_bytes = 0;
+  size_t max_range_bytes = 0;
+  for (const TransferRange &range : plan.ranges) {
+    payload_bytes += range.num_elements * element_bytes;
+    max_range_bytes =
+        std::max(max_range_bytes, range.num_elements * element_bytes);
+  }
+
+  const size_t table_bytes = plan.ranges.size() * 3 * sizeof(size_t);
+  const double direct_seconds =
+      num_ranges * latency + payload_bytes / bandwidth;
+  const double staged_seconds = 2.0 * latency +
+                                (payload_bytes + table_bytes) / bandwidth +
+                                2.0 * payload_bytes / model.host_bandwidth;
+
+  plan.staged = (plan.ranges.size() > 1) && (staged_seconds < direct_seconds);
+  plan.estimated_seconds = plan.staged ? staged_seconds : direct_seconds;
+
+  /* split large payloads into chunks whose latency is negligible */
+  const size_t chunk_bytes =
+      std::max(min_chunk_bytes, static_cast<size_t>(64.0 * latency *
+                                                   bandwidth));
+  const size_t largest_payload =
+      plan.staged ? payload_bytes + table_bytes : max_range_bytes;
+
+  if (largest_payload >= 4 * chunk_bytes) {
+    plan.chunk_bytes = chunk_bytes;
+
+    /* packing overlaps with transfers, except for one chunk */
+    const double num_chunks =
+        static_cast<double>((largest_payload + chunk_bytes - 1) / chunk_bytes);
+    plan.estimated_seconds += (num_chunks - 1.0) * latency;
+    if (plan.staged)
+      plan.estimated_seconds -=
+          (payload_bytes - chunk_bytes) / model.host_bandwidth;
+  }
+
+  return plan;
+}
+
+/**
+ * @brief Measures transfer latency and bandwidth, or loads them from a
+ * calibration file.
+ *
+ * @param cache_file Calibration file to be read if valid for the current
+ *                   backend, and written otherwise (empty for none).
+ * @param max_bytes  Size in bytes of the largest measured transfer.
+ *
+ * @note If the calibration file cannot be written, a warning is
+ *       printed and the measured calibration is still used.
+ */
+void DualMemoryManager::calibrate_transfers(const std::string cache_file,
+                                            const size_t max_bytes) {
+
+  /* nothing to measure without device memory */
+  if (!backend->has_device())
+    return;
+
+  /* use cached calibration, if valid for this backend */
+  if (!cache_file.empty() &&
+      load_transfer_model(cache_file, backend->name(), transfer_model))
+    return;
+
+  using Clock = std::chrono::steady_clock;
+  constexpr int num_repetitions = 5;
+  const size_t size_bytes = std::max(max_bytes, size_t(1) << 12);
+
+  char *const host_ptr = (char *)std::malloc(size_bytes);
+  char *const host_copy_ptr = (char *)std::malloc(size_bytes);
+
+  if (!host_ptr || !host_copy_ptr)
+    abort_mimmo("Failed to allocate host calibration buffers.");
+
+  void *const dev_ptr = device_alloc(size_bytes);
+  std::memset(host_ptr, 0, size_bytes);
+
+  TransferModel model = default_transfer_model();
+  model.backend = backend->name();
+
+  /* measure curves (minimum over repetitions) from 1 KiB to max_bytes */
+  for (size_t bytes = 1024; bytes <= size_bytes; bytes *= 4) {
+    double to_device = 1e30, from_device = 1e30;
+
+    for (int r = 0; r < num_repetitions; r++) {
+      const Clock::time_point start = Clock::now();
+      backend->memcpy_to_device(dev_ptr, host_ptr, bytes);
+      const Clock::time_point middle = Clock::now();
+      backend->memcpy_from_device(host_ptr, dev_ptr, bytes);
+      const Clock::time_point end = Clock::now();
+
+      to_device = std::min(
+          to_device, std::chrono::duration<double>(middle - start).count());
+      from_device = std::min(
+          from_device, std::chrono::duration<double>(end - middle).count());
+    }
+
+    model.to_device_samples.push_back({bytes, to_device});
+    model.from_device_samples.push_back({bytes, from_device});
+  }
+
+  /* measure host copy bandwidth, used for packing */
+  double host_seconds = 1e30;
+  for (int r = 0; r < num_repetitions; r++) {
+    const Clock::time_point start = Clock::now();
+    parallel_memcpy(host_copy_ptr, host_ptr, size_bytes);
+    host_seconds = std::min(
+        host_seconds,
+        std::chrono::duration<double>(Clock::now() - start).count());
+  }
+  model.host_bandwidth = size_bytes / std::max(host_seconds, 1e-9);
+
+  device_free(dev_ptr);
+  std::free(host_ptr);
+  std::free(host_copy_ptr);
+
+  fit_transfer_model(model);
+  transfer_model = model;
+
+  /* cache calibration (a failure only costs a later recalibration) */
+  if (!cache_file.empty() && !save_transfer_model(cache_file, model))
+    std::cerr << "DualMemoryManager warning: failed to write transfer "
+                 "calibration file '"
+              << cache_file << "'." << std::endl;
+
+  return;
+}
+
+} // namespace MiMMO
@@ -5,9 +5,34 @@
  *
  * Tests cover:
  * - Basic memory allocation and deallocation
+ * - Lazy (deferred) allocation
+ * - Scratch arena and device-only scratch arrays
+ * - Allocation groups
  * - Memory copy operations (host-to-device and device-to-host)
  * - Partial memory copies
+ * - Indexed (gather/scatter) memory copies
+ * - Copies between dual arrays and cloning
  * - Scalar creation and updates
+ * - Descriptor table and MIMMO_TABLE_* macros
+ * - Parallel primitives (fill, iota, copy, transform, reductions, scans)
+ * - Emulated device backend (separate buffers, async queues, model)
+ * - Transfer planner (merging, staging, chunking, calibration cache)
+ * - Multiple devices and partitioned arrays with halos
+ * - NUMA placement policies of host memory
+ * - Dual arrays with host memory shared across processes
+ * - Mixed-precision dual arrays (conversion during transfers)
+ * - Bit-packed dual arrays (accessors, bit-range transfers, counts)
+ * - Sparse matrices in CSR format and sparse matrix-vector products
+ * - Jagged dual arrays (single transfer, row transfers, row macros)
+ * - Delta synchronization (XXH64 block hashes, changed-block uploads)
+ * - Transfer profiling (redundant transfers by label and call site)
+ * - Phase profiling (nested phases, inclusive/exclusive counters, JSON)
+ * - Memory reconciliation (process and device samples, low-memory alarm)
+ * - Live statistics export (seqlock-protected shared-memory page)
+ * - Deferred frees (queue-ordered reuse, reuse cache, pending bytes)
+ * - Task graphs (inserted transfers, independent queues, DOT export)
+ * - Prefetches (background transfers, hits, late prefetches, misses)
+ * - Rings of time levels (O(1) rotation, descriptor, level transfers)
  * - Macro functionality (MIMMO_GET_PTR, MIMMO_GET_VALUE, MIMMO_PRESENT)
  *
  * @see DualMemoryManager
@@ -17,6 +42,10 @@
 
 #include "../include/mimmo/api.hpp"
 #include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
 
 /**
  * @brief Simple struct for library testing.
@@ -133,6 +162,255 @@ TEST_CASE("Memory manager - struct", "[mimmo]") {
 #endif // _OPENACC
 }
 
+/**
+ * @brief Lazy allocation test.
+ */
+TEST_CASE("Memory manager - lazy allocation", "[mimmo]") {
+  MiMMO::DualMemoryManager memory_manager = MiMMO::DualMemoryManager();
+
+  const size_t first_size = 10 * sizeof(int);
+  const size_t second_size = 20 * sizeof(float);
+
+  MiMMO::DualArray<int> first_test_array;
+  memory_manager.alloc_array_lazy(first_test_array, "first_test_array", 10,
+                                  true);
+  MiMMO::DualArray<float> second_test_array;
+  memory_manager.alloc_array_lazy(second_test_array, "second_test_array", 20,
+                                  true);
+
+  const bool null_before = (first_test_array.host_ptr == nullptr &&
+                            first_test_array.dev_ptr == nullptr);
+  const std::pair<size_t, size_t> tot_mem_usage_1 =
+      memory_manager.return_total_memory_usage();
+  const std::pair<size_t, size_t> res_mem_usage_1 =
+      memory_manager.return_reserved_memory_usage();
+
+  /* first access through accessor materializes host memory */
+  int *const host_ptr = memory_manager.get_host_ptr(first_test_array);
+  for (int i = 0; i < 10; i++)
+    host_ptr[i] = i;
+
+  memory_manager.report_memory_usage();
+  const std::pair<size_t, size_t> tot_mem_usage_2 =
+      memory_manager.return_total_memory_usage();
+
+  /* first transfer materializes device memory */
+  memory_manager.update_array_host_to_device(first_test_array, 0,
+                                             first_test_array.size);
+
+  memory_manager.report_memory_usage();
+  const std::pair<size_t, size_t> tot_mem_usage_3 =
+      memory_manager.return_total_memory_usage();
+
+  /* second array is never used */
+  memory_manager.free_array(first_test_array);
+  memory_manager.free_array(second_test_array);
+
+  const std::pair<size_t, size_t> tot_mem_usage_4 =
+      memory_manager.return_total_memory_usage();
+  const std::pair<size_t, size_t> res_mem_usage_4 =
+      memory_manager.return_reserved_memory_usage();
+
+#ifdef _OPENACC
+  REQUIRE((null_before && tot_mem_usage_1.first == 0 &&
+           tot_mem_usage_1.second == 0 &&
+           res_mem_usage_1.first == first_size + second_size &&
+           res_mem_usage_1.second == first_size + second_size &&
+           tot_mem_usage_2.first == first_size &&
+           tot_mem_usage_2.second == 0 &&
+           tot_mem_usage_3.first == first_size &&
+           tot_mem_usage_3.second == first_size &&
+           tot_mem_usage_4.first == 0 && tot_mem_usage_4.second == 0 &&
+           res_mem_usage_4.first == 0 && res_mem_usage_4.second == 0));
+#else
+  REQUIRE((null_before && tot_mem_usage_1.first == 0 &&
+           tot_mem_usage_1.second == 0 &&
+           res_mem_usage_1.first == first_size + second_size &&
+           res_mem_usage_1.second == 0 &&
+           tot_mem_usage_2.first == first_size &&
+           tot_mem_usage_2.second == 0 &&
+           tot_mem_usage_3.first == first_size &&
+           tot_mem_usage_3.second == 0 && tot_mem_usage_4.first == 0 &&
+           tot_mem_usage_4.second == 0 && res_mem_usage_4.first == 0 &&
+           res_mem_usage_4.second == 0));
+#endif // _OPENACC
+}
+
+/**
+ * @brief Scratch arena test with nested frames.
+ */
+TEST_CASE("Memory manager - scratch arena", "[mimmo]") {
+  MiMMO::DualMemoryManager memory_manager = MiMMO::DualMemoryManager();
+
+  const size_t arena_size = 4096;
+
+  memory_manager.reserve_scratch_arena(arena_size);
+  const std::pair<size_t, size_t> tot_mem_usage_1 =
+      memory_manager.return_total_memory_usage();
+
+  MiMMO::DualArray<int> result_array;
+  memory_manager.alloc_array(result_array, "result_array", 100, true);
+
+  memory_manager.push_frame();
+
+  MiMMO::DualArray<int> first_scratch_array;
+  memory_manager.alloc_scratch_array(first_scratch_array, 100);
+
+  memory_manager.push_frame();
+
+  MiMMO::DualArray<double> second_scratch_array;
+  memory_manager.alloc_scratch_array(second_scratch_array, 200);
+
+  const std::pair<size_t, size_t> arena_usage_1 =
+      memory_manager.return_scratch_arena_usage();
+
+  memory_manager.pop_frame();
+
+  const std::pair<size_t, size_t> arena_usage_2 =
+      memory_manager.return_scratch_arena_usage();
+
+  /* scratch array can be used in compute regions */
+#pragma acc parallel MIMMO_PRESENT(first_scratch_array) default(none)
+  {
+#pragma acc loop
+    for (int i = 0; i < 100; i++)
+      MIMMO_GET_PTR(first_scratch_array)[i] = 2 * i;
+  }
+
+  memory_manager.copy_array(result_array, 0, first_scratch_array, 0, 100,
+                            MiMMO::Side::Device);
+  memory_manager.update_array_device_to_host(result_array, 0,
+                                             result_array.size);
+
+  memory_manager.report_memory_usage();
+  memory_manager.pop_frame();
+
+  const std::pair<size_t, size_t> arena_usage_3 =
+      memory_manager.return_scratch_arena_usage();
+
+  bool correct = true;
+  for (int i = 0; i < 100; i++)
+    correct = correct && (result_array.host_ptr[i] == 2 * i);
+
+  memory_manager.free_array(result_array);
+  memory_manager.release_scratch_arena();
+  const std::pair<size_t, size_t> tot_mem_usage_2 =
+      memory_manager.return_total_memory_usage();
+
+  REQUIRE((correct && first_scratch_array.size_bytes == 100 * sizeof(int) &&
+           arena_usage_1.first == 512 + 200 * sizeof(double) &&
+           arena_usage_2.first == 100 * sizeof(int) &&
+           arena_usage_2.second == arena_usage_1.first &&
+           arena_usage_3.first == 0 &&
+           arena_usage_3.second == arena_usage_1.first &&
+           tot_mem_usage_2.first == 0 && tot_mem_usage_2.second == 0));
+#ifdef _OPENACC
+  REQUIRE((first_scratch_array.host_ptr == nullptr &&
+           tot_mem_usage_1.first == 0 &&
+           tot_mem_usage_1.second == arena_size));
+#else
+  REQUIRE((first_scratch_array.dev_ptr == nullptr &&
+           tot_mem_usage_1.first == arena_size &&
+           tot_mem_usage_1.second == 0));
+#endif // _OPENACC
+}
+
+/**
+ * @brief Allocation groups test, with and without backing slab.
+ */
+TEST_CASE("Memory manager - allocation groups", "[mimmo]") {
+  MiMMO::DualMemoryManager memory_manager = MiMMO::DualMemoryManager();
+
+  memory_manager.create_group("slab_group", 4096, true);
+  memory_manager.create_group("plain_group", 0, true);
+
+  MiMMO::DualArray<int> first_test_array;
+  memory_manager.alloc_array_in_group(first_test_array, "first_test_array", 10,
+                                      "slab_group");
+  MiMMO::DualArray<double> second_test_array;
+  memory_manager.alloc_array_in_group(second_test_array, "second_test_array",
+                                      20, "slab_group");
+  MiMMO::DualArray<int> third_test_array;
+  memory_manager.alloc_array_in_group(third_test_array, "third_test_array", 5,
+                                      "plain_group");
+
+  for (int i = 0; i < 10; i++)
+    first_test_array.host_ptr[i] = i;
+  for (int i = 0; i < 20; i++)
+    second_test_array.host_ptr[i] = 0.5 * i;
+  for (int i = 0; i < 5; i++)
+    third_test_array.host_ptr[i] = -i;
+
+  memory_manager.upload_group("slab_group");
+  memory_manager.upload_group("plain_group");
+
+#pragma acc parallel MIMMO_PRESENT(first_test_array)                           \
+    MIMMO_PRESENT(second_test_array) MIMMO_PRESENT(third_test_array)           \
+    default(none)
+  {
+#pragma acc loop
+    for (int i = 0; i < 10; i++)
+      MIMMO_GET_PTR(first_test_array)[i] += 1;
+#pragma acc loop
+    for (int i = 0; i < 20; i++)
+      MIMMO_GET_PTR(second_test_array)[i] *= 2.0;
+#pragma acc loop
+    for (int i = 0; i < 5; i++)
+      MIMMO_GET_PTR(third_test_array)[i] -= 1;
+  }
+
+  memory_manager.download_group("slab_group");
+  memory_manager.download_group("plain_group");
+
+  bool correct = true;
+  for (int i = 0; i < 10; i++)
+    correct = correct && (first_test_array.host_ptr[i] == i + 1);
+  for (int i = 0; i < 20; i++)
+    correct = correct && (second_test_array.host_ptr[i] == 1.0 * i);
+  for (int i = 0; i < 5; i++)
+    correct = correct && (third_test_array.host_ptr[i] == -i - 1);
+
+  memory_manager.report_memory_usage();
+  const std::pair<size_t, size_t> group_mem_usage =
+      memory_manager.return_group_memory_usage("slab_group");
+  const std::pair<size_t, size_t> tot_mem_usage_1 =
+      memory_manager.return_total_memory_usage();
+  const std::pair<size_t, size_t> res_mem_usage =
+      memory_manager.return_reserved_memory_usage();
+
+  memory_manager.free_group("slab_group");
+  const std::pair<size_t, size_t> tot_mem_usage_2 =
+      memory_manager.return_total_memory_usage();
+
+  memory_manager.free_group("plain_group");
+  const std::pair<size_t, size_t> tot_mem_usage_3 =
+      memory_manager.return_total_memory_usage();
+
+  /*
+   * totals count the whole slab, group usage only its arrays; reserved
+   * memory matches used memory, as nothing is lazily allocated
+   */
+  const size_t slab_capacity = 4096;
+  const size_t slab_size = 10 * sizeof(int) + 20 * sizeof(double);
+  const size_t plain_size = 5 * sizeof(int);
+
+  REQUIRE((correct && first_test_array.host_ptr == nullptr &&
+           third_test_array.host_ptr == nullptr &&
+           tot_mem_usage_1.first == slab_capacity + plain_size &&
+           res_mem_usage == tot_mem_usage_1 &&
+           tot_mem_usage_2.first == plain_size && tot_mem_usage_3.first == 0 &&
+           tot_mem_usage_3.second == 0));
+#ifdef _OPENACC
+  REQUIRE((group_mem_usage.first == slab_size &&
+           group_mem_usage.second == slab_size &&
+           tot_mem_usage_1.second == slab_capacity + plain_size &&
+           tot_mem_usage_2.second == plain_size));
+#else
+  REQUIRE((group_mem_usage.first == slab_size && group_mem_usage.second == 0 &&
+           tot_mem_usage_1.second == 0 && tot_mem_usage_2.second == 0));
+#endif // _OPENACC
+}
+
 /**
  * @brief Memory movements test (host-to-device and device-to-host).
  */
@@ -217,6 +495,1896 @@ TEST_CASE("Memcopy - partial copy", "[mimmo]") {
   memory_manager.free_array(test_array_copy);
 }
 
+/**
+ * @brief Indexed memory movements test (host-to-device and device-to-host).
+ */
+TEST_CASE("Memcopy - indexed copy", "[mimmo]") {
+  MiMMO::DualMemoryManager memory_manager = MiMMO::DualMemoryManager();
+
+  MiMMO::DualArray<int> test_array;
+  memory_manager.alloc_array(test_array, "test_array", 10, true);
+  MiMMO::DualArray<size_t> test_indices;
+  memory_manager.alloc_array(test_indices, "test_indices", 2, true);
+
+  for (int i = 0; i < 10; i++)
+    test_array.host_ptr[i] = i;
+  test_indices.host_ptr[0] = 0;
+  test_indices.host_ptr[1] = 9;
+
+  memory_manager.update_array_host_to_device(test_array, 0, test_array.size);
+  memory_manager.update_array_host_to_device(test_indices, 0,
+                                             test_indices.size);
+
+#pragma acc parallel MIMMO_PRESENT(test_array) default(none)
+  {
+#pragma acc loop
+    for (int i = 0; i < 10; i++)
+      MIMMO_GET_PTR(test_array)[i] *= 10;
+  }
+
+  /* sparse indices: packed transfer */
+  memory_manager.set_indexed_transfer_threshold(100.0);
+  memory_manager.update_array_indexed_device_to_host(test_array, {1, 7});
+
+  /* forced fallback: covering range is copied */
+  memory_manager.set_indexed_transfer_threshold(0.0);
+  memory_manager.update_array_indexed_device_to_host(test_array, {4, 2});
+
+  const std::vector<int> result_1(test_array.host_ptr,
+                                  test_array.host_ptr + 10);
+
+  /* indices already on device */
+  for (int i = 0; i < 10; i++)
+    test_array.host_ptr[i] = 100 + i;
+
+  memory_manager.set_indexed_transfer_threshold(100.0);
+  memory_manager.update_array_indexed_host_to_device(test_array, test_indices);
+  memory_manager.update_array_device_to_host(test_array, 0, test_array.size);
+
+  const std::vector<int> result_2(test_array.host_ptr,
+                                  test_array.host_ptr + 10);
+
+#ifdef _OPENACC
+  REQUIRE((result_1 == std::vector<int>{0, 10, 20, 30, 40, 5, 6, 70, 8, 9} &&
+           result_2 ==
+               std::vector<int>{100, 10, 20, 30, 40, 50, 60, 70, 80, 109}));
+#else
+  REQUIRE(
+      (result_1 == std::vector<int>{0, 10, 20, 30, 40, 50, 60, 70, 80, 90} &&
+       result_2 ==
+           std::vector<int>{100, 101, 102, 103, 104, 105, 106, 107, 108, 109}));
+#endif // _OPENACC
+
+  memory_manager.free_array(test_array);
+  memory_manager.free_array(test_indices);
+}
+
+/**
+ * @brief Indexed transfers test with emulated device memory (packed
+ * transfers and contiguous fallback).
+ */
+#ifndef _OPENACC
+TEST_CASE("Memcopy - indexed copy on emulated device", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>();
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t n = 1000;
+  MiMMO::DualArray<double> test_array;
+  memory_manager.alloc_array(test_array, "test_array", n, true);
+  MiMMO::DualArray<size_t> test_indices;
+  memory_manager.alloc_array(test_indices, "test_indices", 3, true);
+
+  for (size_t i = 0; i < n; i++)
+    test_array.host_ptr[i] = double(i);
+  test_indices.host_ptr[0] = 3;
+  test_indices.host_ptr[1] = 500;
+  test_indices.host_ptr[2] = 997;
+
+  memory_manager.update_array_host_to_device(test_array, 0, n);
+  memory_manager.update_array_host_to_device(test_indices, 0, 3);
+
+  /* sparse indices: values and indices packed in a single upload, then
+   * scattered on device */
+  memory_manager.set_indexed_transfer_threshold(100.0);
+
+  for (size_t i = 0; i < n; i++)
+    test_array.host_ptr[i] = -double(i);
+
+  MiMMO::EmulatedDeviceStats before = backend->stats();
+  memory_manager.update_array_indexed_host_to_device(test_array,
+                                                     {3, 500, 997});
+  MiMMO::EmulatedDeviceStats after = backend->stats();
+
+  bool correct =
+      (after.num_to_device == before.num_to_device + 1) &&
+      (after.bytes_to_device ==
+       before.bytes_to_device + 3 * sizeof(double) + 3 * sizeof(size_t)) &&
+      (after.num_from_device == before.num_from_device) &&
+      (test_array.dev_ptr[3] == -3.0) && (test_array.dev_ptr[500] == -500.0) &&
+      (test_array.dev_ptr[997] == -997.0) && (test_array.dev_ptr[4] == 4.0);
+
+  /* indices already on device: values gathered on device, then only they
+   * are downloaded */
+  for (size_t i = 0; i < n; i++)
+    test_array.dev_ptr[i] = 2.0 * i;
+
+  before = backend->stats();
+  memory_manager.update_array_indexed_device_to_host(test_array,
+                                                     test_indices);
+  after = backend->stats();
+
+  correct = correct && (after.num_from_device == before.num_from_device + 1) &&
+            (after.bytes_from_device ==
+             before.bytes_from_device + 3 * sizeof(double)) &&
+            (after.num_to_device == before.num_to_device) &&
+            (test_array.host_ptr[3] == 6.0) &&
+            (test_array.host_ptr[500] == 1000.0) &&
+            (test_array.host_ptr[997] == 1994.0) &&
+            (test_array.host_ptr[4] == -4.0);
+
+  /* forced fallback: the covering range is copied in one transfer */
+  memory_manager.set_indexed_transfer_threshold(0.0);
+
+  before = backend->stats();
+  memory_manager.update_array_indexed_device_to_host(test_array,
+                                                     {10, 14, 12});
+  after = backend->stats();
+
+  correct = correct && (after.num_from_device == before.num_from_device + 1) &&
+            (after.bytes_from_device ==
+             before.bytes_from_device + 5 * sizeof(double)) &&
+            (after.num_to_device == before.num_to_device) &&
+            (test_array.host_ptr[11] == 22.0) &&
+            (test_array.host_ptr[14] == 28.0) &&
+            (test_array.host_ptr[15] == -15.0);
+
+  memory_manager.free_array(test_array);
+  memory_manager.free_array(test_indices);
+
+  REQUIRE(correct);
+}
+#endif // _OPENACC
+
+/**
+ * @brief Copy and clone test for dual arrays.
+ */
+TEST_CASE("Copy and clone", "[mimmo]") {
+  MiMMO::DualMemoryManager memory_manager = MiMMO::DualMemoryManager();
+
+  MiMMO::DualArray<int> test_array;
+  memory_manager.alloc_array(test_array, "test_array", 10, true);
+  MiMMO::DualArray<int> test_array_copy;
+  memory_manager.alloc_array(test_array_copy, "test_array_copy", 10, true);
+
+  for (int i = 0; i < 10; i++) {
+    test_array.host_ptr[i] = i;
+    test_array_copy.host_ptr[i] = 0;
+  }
+
+  memory_manager.update_array_host_to_device(test_array, 0, test_array.size);
+  memory_manager.update_array_host_to_device(test_array_copy, 0,
+                                             test_array_copy.size);
+
+  memory_manager.copy_array(test_array_copy, 3, test_array, 0, 4,
+                            MiMMO::Side::Device);
+  memory_manager.copy_array(test_array_copy, 0, test_array, 8, 2,
+                            MiMMO::Side::Host);
+
+  MiMMO::DualArray<int> test_array_clone;
+  memory_manager.clone_array(test_array_clone, test_array, "test_array_clone");
+
+  const std::pair<size_t, size_t> tot_mem_usage =
+      memory_manager.return_total_memory_usage();
+
+  const std::vector<int> host_clone(test_array_clone.host_ptr,
+                                    test_array_clone.host_ptr + 10);
+
+  memory_manager.update_array_device_to_host(test_array_copy, 0,
+                                             test_array_copy.size);
+  memory_manager.update_array_device_to_host(test_array_clone, 0,
+                                             test_array_clone.size);
+
+  const std::vector<int> result(test_array_copy.host_ptr,
+                                test_array_copy.host_ptr + 10);
+  const std::vector<int> dev_clone(test_array_clone.host_ptr,
+                                   test_array_clone.host_ptr + 10);
+  const std::vector<int> ref(test_array.host_ptr, test_array.host_ptr + 10);
+
+#ifdef _OPENACC
+  REQUIRE((result == std::vector<int>{0, 0, 0, 0, 1, 2, 3, 0, 0, 0} &&
+           host_clone == ref && dev_clone == ref &&
+           tot_mem_usage.first == 30 * sizeof(int) &&
+           tot_mem_usage.second == 30 * sizeof(int)));
+#else
+  REQUIRE((result == std::vector<int>{8, 9, 0, 0, 1, 2, 3, 0, 0, 0} &&
+           host_clone == ref && dev_clone == ref &&
+           tot_mem_usage.first == 30 * sizeof(int) &&
+           tot_mem_usage.second == 0));
+#endif // _OPENACC
+
+  memory_manager.free_array(test_array);
+  memory_manager.free_array(test_array_copy);
+  memory_manager.free_array(test_array_clone);
+}
+
+/**
+ * @brief Multithreaded host copy test for large dual arrays.
+ */
+TEST_CASE("Copy - large host copy", "[mimmo]") {
+  MiMMO::DualMemoryManager memory_manager = MiMMO::DualMemoryManager();
+
+  const size_t size = (size_t(24) << 20) / sizeof(int) + 7;
+
+  MiMMO::DualArray<int> test_array;
+  memory_manager.alloc_array(test_array, "test_array", size, false);
+  MiMMO::DualArray<int> test_array_copy;
+  memory_manager.alloc_array(test_array_copy, "test_array_copy", size, false);
+
+  for (size_t i = 0; i < size; i++) {
+    test_array.host_ptr[i] = static_cast<int>(i);
+    test_array_copy.host_ptr[i] = -1;
+  }
+
+  memory_manager.copy_array(test_array_copy, 1, test_array, 0, size - 1,
+                            MiMMO::Side::Host);
+
+  bool correct = (test_array_copy.host_ptr[0] == -1);
+  for (size_t i = 1; i < size; i++)
+    correct =
+        correct && (test_array_copy.host_ptr[i] == static_cast<int>(i - 1));
+
+  REQUIRE(correct);
+
+  memory_manager.free_array(test_array);
+  memory_manager.free_array(test_array_copy);
+}
+
+/**
+ * @brief Descriptor table test for compute regions.
+ */
+TEST_CASE("Descriptor table", "[mimmo]") {
+  MiMMO::DualMemoryManager memory_manager = MiMMO::DualMemoryManager();
+
+  MiMMO::DualArray<int> test_array;
+  memory_manager.alloc_array(test_array, "test_array", 5, true);
+  MiMMO::DualScalar<int> test_scalar;
+  memory_manager.create_scalar(test_scalar, "test_scalar", 10, true);
+  MiMMO::DualArray<int> test_array_lazy;
+  memory_manager.alloc_array_lazy(test_array_lazy, "test_array_lazy", 5, true);
+
+  for (int i = 0; i < 5; i++)
+    test_array.host_ptr[i] = i;
+
+  memory_manager.update_array_host_to_device(test_array, 0, test_array.size);
+
+  const MiMMO::Descriptor *table = memory_manager.descriptor_table();
+  const size_t array_slot = memory_manager.descriptor_slot(test_array);
+  const size_t scalar_slot = memory_manager.descriptor_slot(test_scalar);
+
+#pragma acc parallel MIMMO_TABLE_PRESENT(table)                                \
+    firstprivate(array_slot, scalar_slot) default(none)
+  {
+#pragma acc loop
+    for (size_t i = 0; i < MIMMO_TABLE_GET_SIZE(table, array_slot); i++)
+      MIMMO_TABLE_GET_PTR(table, int, array_slot)
+    [i] *= MIMMO_TABLE_GET_VALUE(table, int, scalar_slot);
+  }
+
+  memory_manager.update_array_device_to_host(test_array, 0, test_array.size);
+
+  bool correct = true;
+  for (int i = 0; i < 5; i++)
+    correct = correct && (test_array.host_ptr[i] == 10 * i);
+
+  /* freed slots are reused */
+  const size_t lazy_slot = memory_manager.descriptor_slot(test_array_lazy);
+  memory_manager.free_array(test_array_lazy);
+
+  MiMMO::DualArray<int> test_array_new;
+  memory_manager.alloc_array(test_array_new, "test_array_new", 5, true);
+  const size_t new_slot = memory_manager.descriptor_slot(test_array_new);
+
+  REQUIRE((correct && array_slot != scalar_slot && new_slot == lazy_slot));
+
+  memory_manager.free_array(test_array);
+  memory_manager.free_array(test_array_new);
+  memory_manager.destroy_scalar(test_scalar);
+}
+
+/**
+ * @brief Parallel primitives test.
+ */
+TEST_CASE("Parallel primitives", "[mimmo]") {
+  MiMMO::DualMemoryManager memory_manager = MiMMO::DualMemoryManager();
+
+  /* large enough to be split among threads on host */
+  const size_t n = size_t(1) << 18;
+
+  MiMMO::DualArray<long> x;
+  memory_manager.alloc_array(x, "x", n, true);
+  MiMMO::DualArray<long> y;
+  memory_manager.alloc_array(y, "y", n, true);
+  MiMMO::DualArray<long> scan;
+  memory_manager.alloc_array(scan, "scan", n, true);
+  MiMMO::DualScalar<long> result;
+  memory_manager.create_scalar(result, "result", 0L, true);
+
+  MiMMO::iota(x, 1L);
+  MiMMO::fill(y, 2L);
+  MiMMO::axpy(y, 3L, x);
+
+  MiMMO::reduce(result, x);
+  const long sum = result.host_value;
+  MiMMO::dot(result, x, y);
+  const long product = result.host_value;
+
+  MiMMO::transform(scan, x, [](const long v) { return 2 * v; });
+  MiMMO::inclusive_scan(scan, scan);
+  MiMMO::copy(y, x);
+  MiMMO::exclusive_scan(y, y, 5L);
+
+  memory_manager.update_array_device_to_host(scan, 0, n);
+  memory_manager.update_array_device_to_host(y, 0, n);
+
+  /* compare with closed forms */
+  const long m = static_cast<long>(n);
+  long expected_product = 0;
+  for (long i = 1; i <= m; i++)
+    expected_product += i * (3 * i + 2);
+
+  bool correct = (sum == m * (m + 1) / 2) && (product == expected_product);
+  for (long i = 0; i < m; i++)
+    correct = correct && (scan.host_ptr[i] == (i + 1) * (i + 2)) &&
+              (y.host_ptr[i] == 5 + i * (i + 1) / 2);
+
+  REQUIRE(correct);
+
+  memory_manager.free_array(x);
+  memory_manager.free_array(y);
+  memory_manager.free_array(scan);
+  memory_manager.destroy_scalar(result);
+}
+
+/**
+ * @brief Emulated device backend test.
+ */
+#ifndef _OPENACC
+TEST_CASE("Emulated device backend", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>(
+      MiMMO::EmulatedDeviceConfig{10.0, 1.0, 0.0, 0, false});
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  MiMMO::DualArray<double> test_array;
+  memory_manager.alloc_array(test_array, "test_array", 1000, true);
+
+  for (int i = 0; i < 1000; i++)
+    test_array.host_ptr[i] = i;
+
+  memory_manager.update_array_host_to_device(test_array, 0, test_array.size);
+
+  /* compute regions work on emulated device memory */
+  for (int i = 0; i < 1000; i++)
+    MIMMO_GET_PTR(test_array)[i] *= 2.0;
+
+  bool correct = (test_array.dev_ptr != nullptr) &&
+                 (test_array.dev_ptr != test_array.host_ptr) &&
+                 (test_array.host_ptr[10] == 10.0);
+
+  memory_manager.update_array_device_to_host(test_array, 0, test_array.size);
+
+  for (int i = 0; i < 1000; i++)
+    correct = correct && (test_array.host_ptr[i] == 2.0 * i);
+
+  /* asynchronous copies complete only when waited for */
+  test_array.host_ptr[0] = -1.0;
+  memory_manager.update_array_host_to_device_async(test_array, 0, 1, 1);
+  correct = correct && (test_array.dev_ptr[0] == 0.0);
+  memory_manager.wait_queue(1);
+  correct = correct && (test_array.dev_ptr[0] == -1.0);
+
+  /* transfers are counted and modeled */
+  const MiMMO::EmulatedDeviceStats stats = backend->stats();
+  const double expected_time = 3 * 10e-6 + (2 * 8000 + 8) / 1e9;
+
+  correct = correct && (stats.num_to_device == 2) &&
+            (stats.num_from_device == 1) &&
+            (stats.bytes_to_device == 8008) &&
+            (stats.allocated_bytes == 8000) &&
+            (stats.modeled_time_s > 0.99 * expected_time) &&
+            (stats.modeled_time_s < 1.01 * expected_time);
+
+  REQUIRE(correct);
+
+  memory_manager.free_array(test_array);
+
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+/**
+ * @brief Transfer planner decisions test.
+ */
+TEST_CASE("Transfer planner", "[mimmo]") {
+  const MiMMO::TransferModel model = {"", 1e-5, 1e9, 1e-5, 1e9, 1e10, {}, {}};
+
+  /* overlapping and touching ranges are merged, small gaps are kept */
+  MiMMO::TransferPlan plan = MiMMO::plan_transfer(
+      model, {{500, 100}, {0, 100}, {50, 10}, {100, 20}}, 8, true);
+
+  bool correct = (plan.ranges.size() == 2) && (plan.ranges[0].offset == 0) &&
+                 (plan.ranges[0].num_elements == 120) &&
+                 (plan.ranges[1].offset == 500) &&
+                 (plan.ranges[1].num_elements == 100) && !plan.staged &&
+                 (plan.chunk_bytes == 0);
+
+  /* many scattered ranges are staged */
+  std::vector<MiMMO::TransferRange> ranges;
+  for (size_t i = 0; i < 100; i++)
+    ranges.push_back({i * 5000, 10});
+
+  plan = MiMMO::plan_transfer(model, ranges, 8, true);
+
+  correct = correct && (plan.ranges.size() == 100) && plan.staged &&
+            (plan.chunk_bytes == 0);
+
+  /* few large ranges are moved separately, in chunks */
+  plan = MiMMO::plan_transfer(model, {{0, 1 << 20}, {1 << 21, 1 << 20}}, 8,
+                              false);
+
+  correct = correct && (plan.ranges.size() == 2) && !plan.staged &&
+            (plan.chunk_bytes == (1 << 20));
+
+  /* empty requests give empty plans */
+  plan = MiMMO::plan_transfer(model, {{10, 0}}, 8, true);
+
+  correct = correct && plan.ranges.empty() && (plan.estimated_seconds == 0.0);
+
+  REQUIRE(correct);
+}
+
+/**
+ * @brief Planned transfers test.
+ */
+#ifndef _OPENACC
+TEST_CASE("Transfer planner - planned transfers", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>(
+      MiMMO::EmulatedDeviceConfig{10.0, 1.0, 0.0, 0, false});
+  MiMMO::DualMemoryManager memory_manager(backend);
+  memory_manager.set_transfer_model(
+      {"", 1e-5, 1e9, 1e-5, 1e9, 1e10, {}, {}});
+
+  const size_t size = 1 << 20;
+  MiMMO::DualArray<double> test_array;
+  memory_manager.alloc_array(test_array, "test_array", size, true);
+
+  /*
+   * small staged ranges, large staged (chunked) ranges, one large range,
+   * ranges separated by a gap cheaper than a transfer latency
+   */
+  std::vector<std::vector<MiMMO::TransferRange>> requests(4);
+  for (size_t i = 0; i < 100; i++)
+    requests[0].push_back({i * 5000 + 7, 10});
+  for (size_t i = 0; i < 200; i++)
+    requests[1].push_back({i * 5000, 3000});
+  requests[2].push_back({1000, 600000});
+  requests[3] = {{0, 10}, {500, 10}};
+
+  bool correct = true;
+
+  for (const std::vector<MiMMO::TransferRange> &ranges : requests) {
+    std::vector<bool> selected(size, false);
+    for (const MiMMO::TransferRange &range : ranges)
+      for (size_t i = 0; i < range.num_elements; i++)
+        selected[range.offset + i] = true;
+
+    /* host to device */
+    for (size_t i = 0; i < size; i++)
+      test_array.host_ptr[i] = -1.0;
+    memory_manager.update_array_host_to_device(test_array, 0, size);
+    for (size_t i = 0; i < size; i++)
+      test_array.host_ptr[i] = i;
+
+    memory_manager.update_array_ranges_host_to_device(test_array, ranges);
+
+    for (size_t i = 0; i < size; i++)
+      correct = correct && (test_array.dev_ptr[i] ==
+                            (selected[i] ? double(i) : -1.0));
+
+    /* device to host */
+    for (size_t i = 0; i < size; i++) {
+      test_array.dev_ptr[i] = 2.0 * i;
+      test_array.host_ptr[i] = -1.0;
+    }
+
+    memory_manager.update_array_ranges_device_to_host(test_array, ranges);
+
+    for (size_t i = 0; i < size; i++)
+      correct = correct && (test_array.host_ptr[i] ==
+                            (selected[i] ? 2.0 * i : -1.0));
+  }
+
+  REQUIRE(correct);
+
+  memory_manager.free_array(test_array);
+
+  /* calibration is cached per backend */
+  const std::string cache_file = "mimmo_calibration_test.txt";
+  std::remove(cache_file.c_str());
+
+  memory_manager.calibrate_transfers(cache_file, 1 << 16);
+  const MiMMO::TransferModel measured = memory_manager.get_transfer_model();
+
+  MiMMO::DualMemoryManager other_manager(backend);
+  other_manager.calibrate_transfers(cache_file, 1 << 16);
+  const MiMMO::TransferModel loaded = other_manager.get_transfer_model();
+
+  correct = (measured.backend == backend->name()) &&
+            (loaded.backend == backend->name()) &&
+            (measured.to_device_samples.size() == 4) &&
+            (loaded.to_device_samples.size() == 4) &&
+            (loaded.from_device_samples.size() == 4) &&
+            (loaded.to_device_samples[3].size_bytes == (1 << 16));
+
+  std::remove(cache_file.c_str());
+
+  REQUIRE(correct);
+
+  /* a calibration that cannot be cached is still used */
+  MiMMO::DualMemoryManager uncached_manager(backend);
+  uncached_manager.calibrate_transfers("mimmo_missing_dir/calibration.txt",
+                                       1 << 16);
+  const MiMMO::TransferModel uncached = uncached_manager.get_transfer_model();
+
+  REQUIRE(uncached.backend == backend->name());
+  REQUIRE(uncached.to_device_samples.size() == 4);
+}
+#endif // _OPENACC
+
+/**
+ * @brief Multi-device and partitioned dual array test.
+ */
+#ifndef _OPENACC
+TEST_CASE("Multiple devices", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>(
+      MiMMO::EmulatedDeviceConfig{10.0, 1.0, 0.0, 0, false}, 2);
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  bool correct = (memory_manager.num_devices() == 2) &&
+                 (memory_manager.get_device() == 0);
+
+  /* arrays remember their device */
+  MiMMO::DualArray<double> test_array;
+  memory_manager.set_device(1);
+  memory_manager.alloc_array(test_array, "test_array", 100, true);
+  memory_manager.set_device(0);
+
+  for (int i = 0; i < 100; i++)
+    test_array.host_ptr[i] = i;
+
+  memory_manager.update_array_host_to_device(test_array, 0, test_array.size);
+
+  correct = correct && (memory_manager.get_device() == 0) &&
+            (backend->stats(0).num_to_device == 0) &&
+            (backend->stats(1).num_to_device == 1) &&
+            (test_array.dev_ptr[99] == 99.0);
+
+  /* partitions (two of them on the same device) exchange halos */
+  MiMMO::PartitionedDualArray<double> partitioned;
+  memory_manager.alloc_partitioned_array(partitioned, "partitioned", 12, 2,
+                                         {0, 1, 1});
+
+  correct = correct && (partitioned.partitions.size() == 3) &&
+            (partitioned.offsets == std::vector<size_t>{0, 4, 8, 12}) &&
+            (partitioned.first == std::vector<size_t>{0, 2, 6}) &&
+            (partitioned.partitions[0].size == 6) &&
+            (partitioned.partitions[1].size == 8) &&
+            (partitioned.partitions[2].size == 6);
+
+  for (size_t p = 0; p < 3; p++) {
+    MiMMO::DualArray<double> &partition = partitioned.partitions[p];
+    for (size_t i = 0; i < partition.size; i++) {
+      const size_t global = partitioned.first[p] + i;
+      const bool owned = global >= partitioned.offsets[p] &&
+                         global < partitioned.offsets[p + 1];
+      partition.host_ptr[i] = owned ? double(global) : -1.0;
+    }
+  }
+
+  memory_manager.update_partitioned_array_host_to_device(partitioned);
+  backend->reset_stats();
+  memory_manager.exchange_halos(partitioned);
+
+  correct = correct && (backend->stats(0).num_device_copies == 1) &&
+            (backend->stats(1).num_device_copies == 3);
+
+  for (MiMMO::DualArray<double> &partition : partitioned.partitions)
+    for (size_t i = 0; i < partition.size; i++)
+      partition.host_ptr[i] = -1.0;
+
+  memory_manager.update_partitioned_array_device_to_host(partitioned);
+
+  for (size_t p = 0; p < 3; p++)
+    for (size_t i = 0; i < partitioned.partitions[p].size; i++)
+      correct = correct && (partitioned.partitions[p].host_ptr[i] ==
+                            double(partitioned.first[p] + i));
+
+  /* device totals add up to the total device memory */
+  const size_t device_0 = memory_manager.return_device_memory_usage(0);
+  const size_t device_1 = memory_manager.return_device_memory_usage(1);
+
+  correct = correct && (device_0 == 6 * sizeof(double)) &&
+            (device_1 == (100 + 8 + 6) * sizeof(double)) &&
+            (device_0 + device_1 ==
+             memory_manager.return_total_memory_usage().second);
+
+  REQUIRE(correct);
+
+  memory_manager.report_memory_usage();
+
+  memory_manager.free_partitioned_array(partitioned);
+  memory_manager.free_array(test_array);
+
+  REQUIRE(backend->stats(0).allocated_bytes == 0);
+  REQUIRE(backend->stats(1).allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+/**
+ * @brief NUMA placement policy test.
+ */
+TEST_CASE("NUMA placement", "[mimmo]") {
+  MiMMO::DualMemoryManager memory_manager = MiMMO::DualMemoryManager();
+
+  const size_t size = size_t(1) << 17;
+  const size_t size_bytes = size * sizeof(double);
+
+  bool correct = (memory_manager.get_numa_policy() ==
+                  MiMMO::NumaPolicy::Default) &&
+                 (memory_manager.return_numa_distribution().size() ==
+                  size_t(MiMMO::numa_num_nodes()));
+
+  /* first touch zeroes memory in parallel */
+  MiMMO::DualArray<double> touched_array;
+  memory_manager.set_numa_policy(MiMMO::NumaPolicy::FirstTouch);
+  memory_manager.alloc_array(touched_array, "touched_array", size, false);
+
+  for (size_t i = 0; i < size; i++)
+    correct = correct && (touched_array.host_ptr[i] == 0.0);
+
+  /* all pages are resident (unless the system cannot tell) */
+  size_t resident_bytes = 0;
+  for (const size_t node_bytes : memory_manager.return_numa_distribution())
+    resident_bytes += node_bytes;
+
+  correct = correct && (resident_bytes == size_bytes || resident_bytes == 0);
+
+  /* other policies give page-aligned, usable memory */
+  const std::vector<MiMMO::NumaPolicy> policies = {
+      MiMMO::NumaPolicy::Local, MiMMO::NumaPolicy::Interleave,
+      MiMMO::NumaPolicy::Bind};
+
+  for (const MiMMO::NumaPolicy policy : policies) {
+    MiMMO::DualArray<double> test_array;
+    memory_manager.set_numa_policy(policy, 0);
+    memory_manager.alloc_array(test_array, "test_array", size, false);
+
+    for (size_t i = 0; i < size; i++)
+      test_array.host_ptr[i] = 2.0;
+
+    correct = correct && ((size_t)test_array.host_ptr % 4096 == 0) &&
+              (test_array.host_ptr[size - 1] == 2.0);
+
+    memory_manager.free_array(test_array);
+  }
+
+  /* groups and lazily materialized arrays follow the policy */
+  MiMMO::DualArray<double> lazy_array, member_array;
+  memory_manager.create_group("numa_group", size_bytes, false);
+  memory_manager.alloc_array_in_group(member_array, "member_array", size,
+                                      "numa_group");
+  memory_manager.alloc_array_lazy(lazy_array, "lazy_array", size, false);
+  memory_manager.materialize(lazy_array, MiMMO::Side::Host);
+
+  for (size_t i = 0; i < size; i++) {
+    member_array.host_ptr[i] = 1.0;
+    lazy_array.host_ptr[i] = 1.0;
+  }
+
+  resident_bytes = 0;
+  for (const size_t node_bytes : memory_manager.return_numa_distribution())
+    resident_bytes += node_bytes;
+
+  correct = correct && (resident_bytes == 3 * size_bytes ||
+                        resident_bytes == 0);
+
+  memory_manager.report_memory_usage();
+
+  memory_manager.free_group("numa_group");
+  memory_manager.free_array(lazy_array);
+  memory_manager.free_array(touched_array);
+
+  /* freed memory is not counted anymore */
+  for (const size_t node_bytes : memory_manager.return_numa_distribution())
+    correct = correct && (node_bytes == 0);
+
+  REQUIRE(correct);
+}
+
+/**
+ * @brief Shared dual array test (two managers standing for two processes).
+ */
+#ifndef _OPENACC
+TEST_CASE("Shared dual arrays", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>();
+  MiMMO::DualMemoryManager creator_manager(backend);
+  MiMMO::DualMemoryManager attached_manager(backend);
+
+  const std::string name = "mimmo_shared_test";
+  const size_t size = 1000;
+
+  /* first allocation creates and fills the segment */
+  MiMMO::DualArray<double> created_array;
+  const bool created = creator_manager.alloc_shared_array(
+      created_array, "created_array", name, size, true);
+
+  for (size_t i = 0; i < size; i++)
+    created_array.host_ptr[i] = 0.5 * i;
+
+  creator_manager.publish_shared_array(created_array);
+
+  /* second allocation attaches the same data, with its own device copy */
+  MiMMO::DualArray<double> attached_array;
+  const bool attached_created = attached_manager.alloc_shared_array(
+      attached_array, "attached_array", name, size, true);
+
+  attached_manager.update_array_host_to_device(attached_array, 0, size);
+
+  bool correct = created && !attached_created &&
+                 (attached_array.host_ptr != created_array.host_ptr) &&
+                 (attached_array.dev_ptr != created_array.dev_ptr) &&
+                 (attached_array.host_ptr[size - 1] == 0.5 * (size - 1)) &&
+                 (attached_array.dev_ptr[size - 1] == 0.5 * (size - 1));
+
+  /* shared host memory is counted apart */
+  const size_t size_bytes = size * sizeof(double);
+
+  correct = correct &&
+            (attached_manager.return_total_memory_usage().first == 0) &&
+            (attached_manager.return_total_memory_usage().second ==
+             size_bytes) &&
+            (attached_manager.return_reserved_memory_usage().first == 0) &&
+            (attached_manager.return_shared_memory_usage() == size_bytes);
+
+  attached_manager.report_memory_usage();
+
+  /* downloading into read-only shared memory aborts */
+  const pid_t pid = fork();
+  if (pid == 0) {
+    attached_manager.update_array_device_to_host(attached_array, 0, size);
+    _exit(0);
+  }
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  correct = correct && WIFEXITED(status) && (WEXITSTATUS(status) == 1);
+
+  attached_manager.free_shared_array(attached_array);
+  creator_manager.free_shared_array(created_array);
+
+  correct = correct && (attached_array.host_ptr == nullptr) &&
+            (creator_manager.return_shared_memory_usage() == 0) &&
+            (creator_manager.return_total_memory_usage().second == 0);
+
+  /* once all have detached, the name creates a new segment */
+  MiMMO::DualArray<int> new_array;
+  correct = correct && creator_manager.alloc_shared_array(
+                           new_array, "new_array", name, 10);
+  creator_manager.free_shared_array(new_array);
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+/**
+ * @brief Mixed-precision dual array test.
+ */
+#ifndef _OPENACC
+TEST_CASE("Mixed-precision arrays", "[mimmo]") {
+  MiMMO::DualMemoryManager memory_manager = MiMMO::DualMemoryManager();
+
+  /* without device memory, device elements are kept on host */
+  const size_t size = 1000;
+  MiMMO::DualArray<double, float> test_array;
+  memory_manager.alloc_array(test_array, "test_array", size, true);
+
+  for (size_t i = 0; i < size; i++)
+    test_array.host_ptr[i] = i + 0.25;
+
+  memory_manager.update_array_host_to_device(test_array, 0, size);
+
+  float *const dev_ptr = MIMMO_GET_PTR(test_array);
+  bool correct = (dev_ptr == test_array.dev_ptr) &&
+                 (dev_ptr[size - 1] == float(size - 1 + 0.25)) &&
+                 (memory_manager.return_total_memory_usage().first ==
+                  size * (sizeof(double) + sizeof(float)));
+
+  for (size_t i = 0; i < size; i++)
+    dev_ptr[i] *= 2.0f;
+
+  memory_manager.update_array_device_to_host(test_array, 10, size - 10);
+
+  correct = correct && (test_array.host_ptr[0] == 0.25) &&
+            (test_array.host_ptr[10] == 20.5);
+
+  memory_manager.free_array(test_array);
+
+  /* with device memory, only device elements are moved (in chunks) */
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>();
+  MiMMO::DualMemoryManager device_manager(backend);
+
+  const size_t large_size = 3000000;
+  MiMMO::DualArray<double, float> large_array;
+  MiMMO::DualArray<double> plain_array;
+  device_manager.alloc_array(large_array, "large_array", large_size, true);
+  device_manager.alloc_array(plain_array, "plain_array", 10, true);
+
+  for (size_t i = 0; i < large_size; i++)
+    large_array.host_ptr[i] = 0.5 * i;
+
+  device_manager.update_array_host_to_device(large_array, 0, large_size);
+
+  correct = correct &&
+            (backend->stats().bytes_to_device == large_size * sizeof(float)) &&
+            (backend->stats().num_to_device > 1) &&
+            (large_array.dev_ptr[large_size - 1] ==
+             float(0.5 * (large_size - 1)));
+
+  for (size_t i = 0; i < large_size; i++)
+    large_array.host_ptr[i] = 0.0;
+
+  device_manager.update_array_device_to_host(large_array, 0, large_size);
+
+  correct = correct &&
+            (backend->stats().bytes_from_device ==
+             large_size * sizeof(float)) &&
+            (large_array.host_ptr[large_size - 1] ==
+             double(float(0.5 * (large_size - 1))));
+
+  /* accounting reports the actual bytes on each side */
+  correct = correct && (device_manager.return_total_memory_usage() ==
+                        std::pair<size_t, size_t>(
+                            (large_size + 10) * sizeof(double),
+                            large_size * sizeof(float) + 10 * sizeof(double)));
+
+  device_manager.report_memory_usage();
+
+  device_manager.free_array(large_array);
+  device_manager.free_array(plain_array);
+
+  /* only the staging buffer is left */
+  correct = correct && (backend->stats().allocated_bytes ==
+                        MiMMO::mixed_chunk_bytes);
+
+  REQUIRE(correct);
+}
+#endif // _OPENACC
+
+/**
+ * @brief Bit-packed dual array test.
+ */
+#ifndef _OPENACC
+TEST_CASE("Bit-packed arrays", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>();
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t size = 1000;
+  MiMMO::DualBitArray flags;
+  MiMMO::DualScalar<size_t> count;
+  MiMMO::DualScalar<bool> any_set, all_set;
+  memory_manager.alloc_bit_array(flags, "flags", size, true);
+  memory_manager.create_scalar(count, "count", size_t(0), true);
+  memory_manager.create_scalar(any_set, "any_set", true, true);
+  memory_manager.create_scalar(all_set, "all_set", true, true);
+
+  /* bits start cleared, in 16 words */
+  MiMMO::any(any_set, flags);
+
+  bool correct = (flags.words.size == 16) && !any_set.host_value &&
+                 (memory_manager.return_total_memory_usage().first ==
+                  16 * sizeof(uint64_t) + sizeof(size_t) + 2 * sizeof(bool));
+
+  /* set every third bit on device, from several threads */
+  uint64_t *const dev_words = MIMMO_GET_PTR(flags.words);
+  MiMMO::host_parallel_for(size, [&](const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; i++)
+      if (i % 3 == 0)
+        MiMMO::set_bit_atomic(dev_words, i, true);
+  });
+
+  MiMMO::popcount(count, flags);
+  MiMMO::all(all_set, flags);
+
+  correct = correct && (count.host_value == 334) && (*count.dev_ptr == 334) &&
+            !all_set.host_value;
+
+  /* a bit range moves whole words only */
+  backend->reset_stats();
+  memory_manager.update_bit_array_device_to_host(flags, 100, 100);
+
+  correct = correct &&
+            (backend->stats().bytes_from_device == 3 * sizeof(uint64_t)) &&
+            MiMMO::get_bit(flags.words.host_ptr, 99) &&
+            !MiMMO::get_bit(flags.words.host_ptr, 100) &&
+            MiMMO::get_bit(flags.words.host_ptr, 102) &&
+            !MiMMO::get_bit(flags.words.host_ptr, 300);
+
+  /* padding bits of the last word are not counted */
+  for (size_t i = 0; i < size; i++)
+    MiMMO::set_bit(dev_words, i, true);
+  dev_words[15] = ~uint64_t(0);
+
+  MiMMO::popcount(count, flags);
+  MiMMO::all(all_set, flags);
+
+  correct = correct && (count.host_value == size) && all_set.host_value;
+
+  memory_manager.free_bit_array(flags);
+  memory_manager.destroy_scalar(count);
+  memory_manager.destroy_scalar(any_set);
+  memory_manager.destroy_scalar(all_set);
+
+  REQUIRE(correct);
+}
+#endif // _OPENACC
+
+/**
+ * @brief Sparse matrix test (tridiagonal matrix with 32 and 64-bit indices).
+ */
+#ifndef _OPENACC
+TEST_CASE("Sparse matrices", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>();
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t n = 100;
+  const size_t nnz = 3 * n - 2;
+  MiMMO::DualCSR<double> matrix;
+  MiMMO::DualCSR<double, int64_t> wide_matrix;
+  MiMMO::DualArray<double> x, y, wide_y;
+
+  memory_manager.alloc_csr(matrix, "matrix", n, n, nnz, true);
+  memory_manager.alloc_csr(wide_matrix, "wide_matrix", n, n, nnz, true);
+  memory_manager.alloc_array(x, "x", n, true);
+  memory_manager.alloc_array(y, "y", n, true);
+  memory_manager.alloc_array(wide_y, "wide_y", n, true);
+
+  /* fill matrix with (-1, 2, -1) stencil rows */
+  int32_t k = 0;
+  for (size_t r = 0; r < n; r++) {
+    matrix.row_ptr.host_ptr[r] = k;
+    for (size_t c = (r > 0 ? r - 1 : 0); c <= std::min(r + 1, n - 1); c++) {
+      matrix.col_idx.host_ptr[k] = c;
+      matrix.values.host_ptr[k] = (c == r) ? 2.0 : -1.0;
+      wide_matrix.col_idx.host_ptr[k] = c;
+      wide_matrix.values.host_ptr[k] = (c == r) ? 2.0 : -1.0;
+      k++;
+    }
+  }
+  matrix.row_ptr.host_ptr[n] = k;
+  for (size_t r = 0; r <= n; r++)
+    wide_matrix.row_ptr.host_ptr[r] = matrix.row_ptr.host_ptr[r];
+
+  for (size_t i = 0; i < n; i++)
+    x.host_ptr[i] = double(i * i);
+
+  /* whole matrix moves in one transfer */
+  backend->reset_stats();
+  memory_manager.update_csr_host_to_device(matrix);
+  memory_manager.update_csr_host_to_device(wide_matrix);
+  memory_manager.update_array_host_to_device(x, 0, n);
+
+  bool correct = (k == int32_t(nnz)) &&
+                 (backend->stats().num_to_device == 3) &&
+                 (matrix.storage.size_bytes ==
+                  nnz * (sizeof(double) + 4) + (n + 1) * 4) &&
+                 (wide_matrix.storage.size_bytes ==
+                  nnz * (sizeof(double) + 8) + (n + 1) * 8);
+
+  /* second differences of squares are 2 in the interior */
+  MiMMO::spmv(y, matrix, x);
+  MiMMO::spmv(wide_y, wide_matrix, x);
+  memory_manager.update_array_device_to_host(y, 0, n);
+  memory_manager.update_array_device_to_host(wide_y, 0, n);
+
+  correct = correct && (y.host_ptr[0] == -1.0) && (y.host_ptr[50] == -2.0) &&
+            (y.host_ptr[n - 1] == 2.0 * (n - 1) * (n - 1) -
+                                      double((n - 2) * (n - 2))) &&
+            (wide_y.host_ptr[50] == -2.0);
+
+  /* values alone are refreshed for a fixed sparsity pattern */
+  for (size_t i = 0; i < nnz; i++)
+    matrix.values.host_ptr[i] *= -1.0;
+
+  backend->reset_stats();
+  memory_manager.update_csr_values_host_to_device(matrix);
+  MiMMO::spmv(y, matrix, x);
+  memory_manager.update_array_device_to_host(y, 0, n);
+
+  correct = correct &&
+            (backend->stats().bytes_to_device == nnz * sizeof(double)) &&
+            (y.host_ptr[50] == 2.0);
+
+  memory_manager.free_csr(matrix);
+  memory_manager.free_csr(wide_matrix);
+  memory_manager.free_array(x);
+  memory_manager.free_array(y);
+  memory_manager.free_array(wide_y);
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+#ifndef _OPENACC
+/**
+ * @brief Jagged dual array test with emulated device memory.
+ */
+TEST_CASE("Jagged arrays", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>();
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  /* row r holds r + 1 copies of r */
+  const size_t num_rows = 20;
+  std::vector<std::vector<int>> rows(num_rows);
+  for (size_t r = 0; r < num_rows; r++)
+    rows[r].assign(r + 1, int(r));
+
+  MiMMO::DualJaggedArray<int> jagged;
+  MiMMO::DualArray<int> row_sums;
+  memory_manager.alloc_jagged_array(jagged, "jagged", rows, true);
+  memory_manager.alloc_array(row_sums, "row_sums", num_rows, true);
+
+  const size_t num_values = num_rows * (num_rows + 1) / 2;
+  bool correct = (jagged.num_rows == num_rows) &&
+                 (jagged.values.size == num_values) &&
+                 (jagged.offsets.host_ptr[num_rows] == num_values) &&
+                 (jagged.values.host_ptr[jagged.offsets.host_ptr[7]] == 7);
+
+  /* whole array moves in one transfer */
+  backend->reset_stats();
+  memory_manager.update_jagged_array_host_to_device(jagged);
+
+  correct = correct && (backend->stats().num_to_device == 1) &&
+            (backend->stats().bytes_to_device == jagged.storage.size_bytes);
+
+  int *const sums_ptr = MIMMO_GET_PTR(row_sums);
+  for (size_t r = 0; r < num_rows; r++) {
+    const int *const row_ptr = MIMMO_JAGGED_ROW_PTR(jagged, r);
+    int sum = 0;
+    for (size_t i = 0; i < MIMMO_JAGGED_ROW_SIZE(jagged, r); i++)
+      sum += row_ptr[i];
+    sums_ptr[r] = sum;
+  }
+  memory_manager.update_array_device_to_host(row_sums, 0, num_rows);
+
+  for (size_t r = 0; r < num_rows; r++)
+    correct = correct && (row_sums.host_ptr[r] == int(r * (r + 1)));
+
+  /* rows move on their own, values only */
+  for (size_t r = 3; r < 6; r++)
+    for (size_t i = 0; i <= r; i++)
+      jagged.values.host_ptr[jagged.offsets.host_ptr[r] + i] = -1;
+
+  backend->reset_stats();
+  memory_manager.update_jagged_rows_host_to_device(jagged, 3, 3);
+
+  correct = correct && (backend->stats().num_to_device == 1) &&
+            (backend->stats().bytes_to_device == (4 + 5 + 6) * sizeof(int)) &&
+            (MIMMO_JAGGED_ROW_PTR(jagged, 4)[0] == -1) &&
+            (MIMMO_JAGGED_ROW_PTR(jagged, 6)[0] == 6);
+
+  MIMMO_JAGGED_ROW_PTR(jagged, 10)[0] = 100;
+  backend->reset_stats();
+  memory_manager.update_jagged_rows_device_to_host(jagged, 10);
+
+  correct = correct &&
+            (backend->stats().bytes_from_device == 11 * sizeof(int)) &&
+            (jagged.values.host_ptr[jagged.offsets.host_ptr[10]] == 100);
+
+  /* rows of a jagged array allocated from sizes start out addressable */
+  MiMMO::DualJaggedArray<double> sized;
+  memory_manager.alloc_jagged_array(sized, "sized",
+                                    std::vector<size_t>{2, 0, 3}, true);
+
+  correct = correct && (sized.values.size == 5) &&
+            (MIMMO_JAGGED_ROW_SIZE(sized, 1) == 0) &&
+            (MIMMO_JAGGED_ROW_SIZE(sized, 2) == 3);
+
+  memory_manager.free_jagged_array(jagged);
+  memory_manager.free_jagged_array(sized);
+  memory_manager.free_array(row_sums);
+
+  correct = correct && (jagged.values.host_ptr == nullptr) &&
+            (jagged.num_rows == 0);
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+#ifndef _OPENACC
+/**
+ * @brief Delta synchronization test with emulated device memory.
+ */
+TEST_CASE("Delta synchronization", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>();
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  /* reference values of XXH64 with seed 0 */
+  std::vector<unsigned char> bytes(100);
+  for (size_t i = 0; i < bytes.size(); i++)
+    bytes[i] = (unsigned char)i;
+
+  bool correct = (MiMMO::xxh64("", 0) == 0xEF46DB3751D8E999ULL) &&
+                 (MiMMO::xxh64("abc", 3) == 0x44BC2CF5AD770999ULL) &&
+                 (MiMMO::xxh64(bytes.data(), 100) == 0x6AC1E58032166597ULL);
+
+  /* 128 blocks of 512 elements */
+  const size_t n = size_t(1) << 16;
+  const size_t block_bytes = 4096;
+  MiMMO::DualArray<double> array;
+  memory_manager.alloc_array(array, "array", n, true);
+  memory_manager.enable_delta_sync(array, block_bytes);
+
+  for (size_t i = 0; i < n; i++)
+    array.host_ptr[i] = double(i);
+
+  /* first upload sends everything */
+  memory_manager.update_array_host_to_device(array, 0, n);
+  MiMMO::DeltaSyncStats stats = memory_manager.return_delta_sync_stats(array);
+
+  correct = correct && (stats.num_syncs == 1) &&
+            (stats.hashed_bytes == array.size_bytes) &&
+            (stats.transferred_bytes == array.size_bytes);
+
+  /* unchanged data is hashed but not sent */
+  backend->reset_stats();
+  memory_manager.update_array_host_to_device(array, 0, n);
+  stats = memory_manager.return_delta_sync_stats(array);
+
+  correct = correct && (backend->stats().num_to_device == 0) &&
+            (stats.hashed_bytes == 2 * array.size_bytes) &&
+            (stats.transferred_bytes == array.size_bytes);
+
+  /* only changed blocks are sent */
+  array.host_ptr[3 * 512 + 7] = -1.0;
+  array.host_ptr[100 * 512] = -2.0;
+  array.host_ptr[100 * 512 + 511] = -3.0;
+  memory_manager.update_array_host_to_device(array, 0, n);
+  stats = memory_manager.return_delta_sync_stats(array);
+
+  const double *const dev_ptr = MIMMO_GET_PTR(array);
+  correct = correct &&
+            (stats.transferred_bytes == array.size_bytes + 2 * block_bytes) &&
+            (dev_ptr[3 * 512 + 7] == -1.0) && (dev_ptr[100 * 512] == -2.0) &&
+            (dev_ptr[100 * 512 + 511] == -3.0) && (dev_ptr[3 * 512] == 1536.0);
+
+  /* blocks partly inside a range are sent without hashing */
+  array.host_ptr[1000] = -4.0;
+  memory_manager.update_array_host_to_device(array, 1000, 100);
+  stats = memory_manager.return_delta_sync_stats(array);
+
+  correct = correct && (dev_ptr[1000] == -4.0) &&
+            (stats.hashed_bytes == 3 * array.size_bytes) &&
+            (stats.transferred_bytes ==
+             array.size_bytes + 2 * block_bytes + 100 * sizeof(double));
+
+  /* ... and forgotten, so the next full upload sends them again */
+  memory_manager.update_array_host_to_device(array, 0, n);
+  stats = memory_manager.return_delta_sync_stats(array);
+
+  correct = correct && (stats.transferred_bytes ==
+                        array.size_bytes + 4 * block_bytes +
+                            100 * sizeof(double));
+
+  /* blocks in between changed blocks are not sent */
+  const size_t sent_bytes = stats.transferred_bytes;
+  array.host_ptr[0] = -5.0;
+  array.host_ptr[20 * 512] = -6.0;
+  backend->reset_stats();
+  memory_manager.update_array_host_to_device(array, 0, n);
+  stats = memory_manager.return_delta_sync_stats(array);
+
+  correct = correct && (stats.transferred_bytes - sent_bytes ==
+                        backend->stats().bytes_to_device) &&
+            (backend->stats().bytes_to_device == 2 * block_bytes) &&
+            (dev_ptr[0] == -5.0) && (dev_ptr[20 * 512] == -6.0);
+
+  /* without delta synchronization, whole ranges are copied */
+  memory_manager.disable_delta_sync(array);
+  backend->reset_stats();
+  memory_manager.update_array_host_to_device(array, 0, n);
+
+  correct = correct && (backend->stats().bytes_to_device == array.size_bytes);
+
+  memory_manager.free_array(array);
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+#ifndef _OPENACC
+/**
+ * @brief Transfer profiling test with emulated device memory.
+ */
+TEST_CASE("Transfer profiling", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>();
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t n = 1000;
+  MiMMO::DualArray<double> array;
+  MiMMO::DualScalar<double> scalar;
+  memory_manager.alloc_array(array, "array", n, true);
+  memory_manager.create_scalar(scalar, "scalar", 1.0, true);
+  memory_manager.set_transfer_profiling(true);
+
+  for (size_t i = 0; i < n; i++)
+    array.host_ptr[i] = double(i);
+
+  /* repeated uploads of unchanged data: all but the first are wasted */
+  for (int step = 0; step < 3; step++)
+    memory_manager.update_array_host_to_device(array, 0, n);
+
+  /* download leaving host data unchanged is wasted */
+  memory_manager.update_array_device_to_host(array, 0, n);
+
+  /* download of data written on device is useful, uploading it back is
+   * wasted */
+  MIMMO_GET_PTR(array)[5] = -5.0;
+  memory_manager.update_array_device_to_host(array, 0, n);
+  memory_manager.update_array_host_to_device(array, 0, n);
+
+  /* upload of data written on host is useful */
+  array.host_ptr[0] = -1.0;
+  memory_manager.update_array_host_to_device(array, 0, n);
+
+  for (int step = 0; step < 2; step++)
+    memory_manager.update_scalar_host_to_device(scalar);
+
+  memory_manager.report_memory_usage();
+  const std::vector<MiMMO::TransferSiteStats> profile =
+      memory_manager.return_transfer_profile();
+
+  const size_t bytes = array.size_bytes;
+  bool correct = (profile.size() == 6) && (profile[0].label == "array") &&
+                 profile[0].to_device && (profile[0].num_transfers == 3) &&
+                 (profile[0].num_redundant == 2) &&
+                 (profile[0].wasted_bytes == 2 * bytes) &&
+                 (profile[0].transferred_bytes == 3 * bytes) &&
+                 (profile[0].file.find("unit_tests_main.cpp") !=
+                  std::string::npos) &&
+                 (profile[1].wasted_bytes == bytes) &&
+                 (profile[2].wasted_bytes == bytes) &&
+                 (profile[1].to_device != profile[2].to_device) &&
+                 (profile[3].label == "scalar") &&
+                 (profile[3].wasted_bytes == sizeof(double)) &&
+                 (profile[4].wasted_bytes == 0) &&
+                 (profile[5].wasted_bytes == 0);
+
+  /* enabling profiling again starts from scratch */
+  memory_manager.set_transfer_profiling(true);
+  memory_manager.update_array_host_to_device(array, 0, n);
+
+  correct = correct && (memory_manager.return_transfer_profile().size() == 1) &&
+            (memory_manager.return_transfer_profile()[0].num_redundant == 0);
+
+  /* transfers of composite objects are attributed to their caller */
+  MiMMO::DualBitArray bits;
+  memory_manager.alloc_bit_array(bits, "bits", 64, true);
+  memory_manager.set_transfer_profiling(true);
+  memory_manager.update_bit_array_host_to_device(bits, 0, 64);
+
+  correct = correct && (memory_manager.return_transfer_profile().size() == 1) &&
+            (memory_manager.return_transfer_profile()[0].file.find(
+                 "unit_tests_main.cpp") != std::string::npos);
+
+  /* uploads of delta-synchronized arrays are profiled as well */
+  memory_manager.enable_delta_sync(array, 1024);
+  memory_manager.set_transfer_profiling(true);
+  for (int step = 0; step < 2; step++)
+    memory_manager.update_array_host_to_device(array, 0, n);
+
+  correct = correct && (memory_manager.return_transfer_profile().size() == 1) &&
+            (memory_manager.return_transfer_profile()[0].num_transfers == 2) &&
+            (memory_manager.return_transfer_profile()[0].num_redundant == 1);
+
+  memory_manager.disable_delta_sync(array);
+  memory_manager.set_transfer_profiling(false);
+  memory_manager.update_array_host_to_device(array, 0, n);
+
+  correct = correct && memory_manager.return_transfer_profile().empty();
+
+  memory_manager.free_bit_array(bits);
+  memory_manager.free_array(array);
+  memory_manager.destroy_scalar(scalar);
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+#ifndef _OPENACC
+/**
+ * @brief Phase profiling test with emulated device memory.
+ */
+TEST_CASE("Phase profiling", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>();
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t n = 1000;
+  const size_t bytes = n * sizeof(double);
+  MiMMO::DualArray<double> array;
+  std::vector<MiMMO::PhaseStats> open_stats;
+
+  {
+    MiMMO::PhaseScope solve(memory_manager, "solve");
+    memory_manager.alloc_array(array, "array", n, true);
+
+    for (int step = 0; step < 3; step++) {
+      MiMMO::PhaseScope assemble(memory_manager, "assemble");
+      memory_manager.update_array_host_to_device(array, 0, n);
+    }
+
+    {
+      MiMMO::PhaseScope output(memory_manager, "output");
+      memory_manager.update_array_device_to_host(array, 0, n);
+      open_stats = memory_manager.return_phase_stats();
+    }
+  }
+
+  memory_manager.begin_phase("cleanup");
+  memory_manager.free_array(array);
+  memory_manager.end_phase("cleanup");
+
+  /* transfers outside phases are not counted */
+  memory_manager.alloc_array(array, "array", n, true);
+  memory_manager.update_array_host_to_device(array, 0, n);
+  memory_manager.free_array(array);
+
+  memory_manager.report_phases();
+  const std::vector<MiMMO::PhaseStats> stats =
+      memory_manager.return_phase_stats();
+
+  bool correct = (open_stats.size() == 3) && open_stats[0].open &&
+                 open_stats[2].open && !open_stats[1].open;
+
+  correct = correct && (stats.size() == 4) && (stats[0].name == "solve") &&
+            (stats[1].path == "solve/assemble") &&
+            (stats[2].path == "solve/output") && (stats[3].depth == 0) &&
+            !stats[0].open;
+
+  /* inclusive counters sum children, exclusive ones do not */
+  const MiMMO::PhaseStats &solve = stats[0];
+  correct = correct && (solve.num_calls == 1) &&
+            (solve.inclusive.num_allocs == 1) &&
+            (solve.exclusive.num_allocs == 1) &&
+            (solve.inclusive.to_device_count == 3) &&
+            (solve.inclusive.to_device_bytes == 3 * bytes) &&
+            (solve.exclusive.to_device_count == 0) &&
+            (solve.inclusive.from_device_bytes == bytes) &&
+            (solve.inclusive.host_peak_bytes == bytes) &&
+            (solve.inclusive.dev_peak_bytes == bytes) &&
+            (solve.inclusive.seconds >=
+             stats[1].inclusive.seconds + stats[2].inclusive.seconds) &&
+            (solve.exclusive.seconds <= solve.inclusive.seconds);
+
+  correct = correct && (stats[1].num_calls == 3) &&
+            (stats[1].exclusive.to_device_count == 3) &&
+            (stats[1].inclusive.to_device_seconds >= 0.0) &&
+            (stats[3].inclusive.num_frees == 1) &&
+            (stats[3].inclusive.host_peak_bytes == bytes);
+
+  /* hierarchical JSON report */
+  const std::string json = memory_manager.return_phase_report_json();
+  correct = correct &&
+            (json.rfind("{\"phases\": [{\"name\": \"solve\"", 0) == 0) &&
+            (json.find("\"path\": \"solve/assemble\"") !=
+             std::string::npos) &&
+            (std::count(json.begin(), json.end(), '{') ==
+             std::count(json.begin(), json.end(), '}')) &&
+            (std::count(json.begin(), json.end(), '[') ==
+             std::count(json.begin(), json.end(), ']'));
+
+  /* markers are cheap enough to stay enabled */
+  memory_manager.reset_phases();
+  const int num_markers = 100000;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_markers; i++) {
+    MiMMO::PhaseScope marker(memory_manager, "marker");
+  }
+  const double seconds_per_marker = MiMMO::seconds_since(start) / num_markers;
+
+  correct = correct && (memory_manager.return_phase_stats().size() == 1) &&
+            (seconds_per_marker < 1e-5);
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+#ifndef _OPENACC
+/**
+ * @brief Memory reconciliation test with an emulated device of limited
+ * capacity.
+ */
+TEST_CASE("Memory reconciliation", "[mimmo]") {
+  const size_t capacity = size_t(1) << 20;
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>(
+      MiMMO::EmulatedDeviceConfig{10.0, 16.0, 0.0, capacity, false});
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t n = capacity / 4 / sizeof(double);
+  const size_t bytes = n * sizeof(double);
+  MiMMO::DualArray<double> first, second, third;
+  std::vector<MiMMO::MemorySample> alarms;
+
+  memory_manager.alloc_array(first, "first", n, true);
+
+  /* sample tracked memory against process and device memory */
+  const MiMMO::MemorySample sample = memory_manager.sample_memory();
+
+  bool correct = sample.tracked_host_bytes == bytes &&
+                 sample.tracked_dev_bytes == bytes && sample.dev_known &&
+                 sample.dev_total_bytes == capacity &&
+                 sample.dev_free_bytes == capacity - bytes;
+#ifdef __linux__
+  correct = correct && sample.host_known && sample.host_rss_bytes > 0 &&
+            sample.host_hwm_bytes >= sample.host_rss_bytes;
+#endif
+
+  /* alarm is raised once free memory would fall below half capacity */
+  memory_manager.set_low_memory_alarm(
+      capacity / 2,
+      [&alarms](const MiMMO::MemorySample &s) { alarms.push_back(s); });
+
+  memory_manager.alloc_array(second, "second", n, true);
+  correct = correct && alarms.empty();
+
+  memory_manager.alloc_array(third, "third", n, true);
+  correct = correct && alarms.size() == 1 &&
+            alarms[0].tracked_dev_bytes == 2 * bytes &&
+            alarms[0].dev_free_bytes == capacity - 2 * bytes;
+
+  /* samples of the alarm are kept in the history */
+  memory_manager.report_memory_reconciliation();
+  const std::vector<MiMMO::MemorySample> samples =
+      memory_manager.return_memory_samples();
+
+  correct = correct && samples.size() == 3 &&
+            samples[2].tracked_dev_bytes == 3 * bytes &&
+            samples[0].seconds <= samples[2].seconds;
+
+  memory_manager.clear_memory_samples();
+  memory_manager.set_low_memory_alarm(0, {});
+  correct = correct && memory_manager.return_memory_samples().empty();
+
+  memory_manager.free_array(first);
+  memory_manager.free_array(second);
+  memory_manager.free_array(third);
+
+  /* without device memory, device values are unknown */
+  MiMMO::DualMemoryManager host_manager(
+      std::make_shared<MiMMO::NoDeviceBackend>());
+  correct = correct && !host_manager.sample_memory().dev_known;
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+#ifndef _OPENACC
+/**
+ * @brief Live statistics export test with emulated device memory.
+ */
+TEST_CASE("Live statistics export", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>();
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t n = 1000;
+  const size_t bytes = n * sizeof(double);
+  MiMMO::DualArray<double> big, small;
+  MiMMO::StatsSnapshot snapshot;
+
+  /* a long interval leaves updates to publish_stats() */
+  const std::string name =
+      memory_manager.enable_stats_export("mimmo-stats-unit-test", 3600.0);
+  const MiMMO::StatsPage *const page = MiMMO::attach_stats_page(name);
+
+  bool correct = name == "mimmo-stats-unit-test" && page != nullptr &&
+                 MiMMO::read_stats_page(page, snapshot) &&
+                 snapshot.num_updates == 1 && snapshot.num_objects == 0;
+
+  memory_manager.alloc_array(big, "big", n, true);
+  memory_manager.alloc_array(small, "small", n / 10, true);
+  memory_manager.update_array_host_to_device(big, 0, n);
+  memory_manager.update_array_device_to_host(small, 0, n / 10);
+
+  /* updates are throttled by the interval */
+  correct = correct && MiMMO::read_stats_page(page, snapshot) &&
+            snapshot.num_updates == 1;
+
+  memory_manager.publish_stats();
+  correct = correct && MiMMO::read_stats_page(page, snapshot) &&
+            snapshot.num_updates == 2 && snapshot.num_objects == 2 &&
+            snapshot.num_allocs == 2 &&
+            snapshot.host_bytes == bytes + bytes / 10 &&
+            snapshot.dev_peak_bytes == bytes + bytes / 10 &&
+            snapshot.to_device_count == 1 &&
+            snapshot.to_device_bytes == bytes &&
+            snapshot.from_device_count == 1 &&
+            snapshot.from_device_bytes == bytes / 10 &&
+            snapshot.num_labels == 2 &&
+            std::string(snapshot.labels[0].label) == "big" &&
+            snapshot.labels[0].dev_bytes == bytes &&
+            std::string(snapshot.labels[1].label) == "small";
+
+  /* objects sharing a label are summed, and labels beyond the page
+   * capacity are only counted */
+  MiMMO::DualArray<double> big_too;
+  std::vector<MiMMO::DualArray<char>> extra(MiMMO::stats_max_labels);
+  memory_manager.alloc_array(big_too, "big", n / 10, true);
+  for (size_t i = 0; i < extra.size(); i++)
+    memory_manager.alloc_array(extra[i], "extra_" + std::to_string(i), 1);
+
+  memory_manager.publish_stats();
+  correct = correct && MiMMO::read_stats_page(page, snapshot) &&
+            snapshot.num_labels == MiMMO::stats_max_labels &&
+            snapshot.num_other_labels == 2 &&
+            std::string(snapshot.labels[0].label) == "big" &&
+            snapshot.labels[0].host_bytes == bytes + bytes / 10 &&
+            std::string(snapshot.labels[1].label) == "small" &&
+            std::string(snapshot.labels[2].label) == "extra_0";
+
+  memory_manager.free_array(big_too);
+  for (MiMMO::DualArray<char> &array : extra)
+    memory_manager.free_array(array);
+
+  memory_manager.free_array(big);
+  memory_manager.free_array(small);
+  memory_manager.publish_stats();
+
+  correct = correct && MiMMO::read_stats_page(page, snapshot) &&
+            snapshot.num_frees == 3 + MiMMO::stats_max_labels &&
+            snapshot.host_bytes == 0 &&
+            snapshot.host_peak_bytes ==
+                2 * bytes / 10 + bytes + MiMMO::stats_max_labels &&
+            snapshot.num_labels == 0 && snapshot.num_other_labels == 0;
+
+  /* the page is removed, while attached readers keep their mapping */
+  memory_manager.disable_stats_export();
+  correct = correct && MiMMO::attach_stats_page(name) == nullptr &&
+            MiMMO::read_stats_page(page, snapshot);
+  MiMMO::detach_stats_page(page);
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+#ifndef _OPENACC
+/**
+ * @brief Deferred frees and queue-ordered allocations test with emulated
+ * device memory.
+ */
+TEST_CASE("Deferred frees", "[mimmo]") {
+  /* slow transfers keep queues busy for a while */
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>(
+      MiMMO::EmulatedDeviceConfig{10.0, 0.0005, 0.0, 0, true});
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t n = 10000;
+  const size_t bytes = n * sizeof(double);
+  MiMMO::DualArray<double> a, b, c, d;
+  MiMMO::DualScalar<double> scalar;
+
+  /* buffers used by an enqueued copy stay pending */
+  memory_manager.alloc_array(a, "a", n, true);
+  double *const a_host = a.host_ptr;
+  double *const a_dev = a.dev_ptr;
+  memory_manager.update_array_host_to_device_async(a, 0, n, 1);
+  memory_manager.free_array_async(a, 1);
+
+  MiMMO::DeferredFreeStats stats = memory_manager.return_deferred_free_stats();
+  bool correct = a.host_ptr == nullptr && a.dev_ptr == nullptr &&
+                 stats.pending_blocks == 2 &&
+                 stats.pending_host_bytes == bytes &&
+                 stats.pending_dev_bytes == bytes &&
+                 memory_manager.return_total_memory_usage().second == 0;
+
+  /* device memory is reused in order on the same queue, not host memory */
+  memory_manager.alloc_array_async(b, "b", n, 1, true);
+  stats = memory_manager.return_deferred_free_stats();
+  correct = correct && b.dev_ptr == a_dev && b.host_ptr != a_host &&
+            stats.num_reused == 1 && stats.pending_blocks == 1 &&
+            backend->stats().allocated_bytes == bytes;
+
+  /* pending buffers are released once the queue is idle */
+  memory_manager.free_array_async(b, 1);
+  memory_manager.wait_queue(1);
+  memory_manager.collect_deferred_frees();
+  stats = memory_manager.return_deferred_free_stats();
+  correct = correct && stats.pending_blocks == 0 &&
+            stats.cached_blocks == 0 && stats.num_released == 3 &&
+            backend->stats().allocated_bytes == 0;
+
+  /* with a reuse cache, buffers of idle queues are kept for reuse */
+  memory_manager.set_reuse_cache_limit(4 * bytes);
+  memory_manager.alloc_array(c, "c", n, true);
+  double *const c_host = c.host_ptr;
+  double *const c_dev = c.dev_ptr;
+  memory_manager.free_array_async(c, 2);
+  memory_manager.create_scalar(scalar, "scalar", 1.0, true);
+  memory_manager.destroy_scalar_async(scalar, 2);
+
+  stats = memory_manager.return_deferred_free_stats();
+  correct = correct && stats.cached_blocks == 3 &&
+            stats.cached_host_bytes == bytes &&
+            stats.cached_dev_bytes == bytes + sizeof(double);
+
+  memory_manager.alloc_array_async(d, "d", n, 3, true);
+  memory_manager.report_memory_usage();
+  stats = memory_manager.return_deferred_free_stats();
+  correct = correct && d.host_ptr == c_host && d.dev_ptr == c_dev &&
+            stats.num_reused == 3 && stats.cached_blocks == 1 &&
+            memory_manager.return_total_memory_usage().first == bytes;
+
+  /* flushing releases pending and cached buffers */
+  memory_manager.free_array_async(d, 3);
+  memory_manager.flush_deferred_frees();
+  stats = memory_manager.return_deferred_free_stats();
+  correct = correct && stats.pending_blocks == 0 &&
+            stats.cached_blocks == 0 && stats.num_deferred == 9 &&
+            stats.num_released == 9 - 3;
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+#ifndef _OPENACC
+/**
+ * @brief Task graph test with emulated device memory.
+ */
+TEST_CASE("Task graph", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>(
+      MiMMO::EmulatedDeviceConfig{0.0, 0.0, 0.0, 0, false});
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t n = 1000;
+  MiMMO::DualArray<double> a, b, c;
+  MiMMO::DualScalar<double> total;
+  memory_manager.alloc_array(a, "a", n, true);
+  memory_manager.alloc_array(b, "b", n, true);
+  memory_manager.alloc_array(c, "c", n, true);
+  memory_manager.create_scalar(total, "total", 0.0, true);
+
+  /* device work of the emulated backend runs on host, on device buffers */
+  MiMMO::TaskGraph graph(memory_manager);
+  graph.add_task("init", MiMMO::Side::Host,
+                 {MiMMO::writes(a), MiMMO::writes(b)}, [&](int) {
+                   for (size_t i = 0; i < n; i++) {
+                     a.host_ptr[i] = i;
+                     b.host_ptr[i] = 1.0;
+                   }
+                 });
+  graph.add_task("scale a", MiMMO::Side::Device, {MiMMO::reads_writes(a)},
+                 [&](int) {
+                   for (size_t i = 0; i < n; i++)
+                     a.dev_ptr[i] *= 2.0;
+                 });
+  graph.add_task("scale b", MiMMO::Side::Device, {MiMMO::reads_writes(b)},
+                 [&](int) {
+                   for (size_t i = 0; i < n; i++)
+                     b.dev_ptr[i] *= 3.0;
+                 });
+  graph.add_task("sum", MiMMO::Side::Device,
+                 {MiMMO::reads(a), MiMMO::reads(b), MiMMO::writes(c),
+                  MiMMO::writes(total)},
+                 [&](int) {
+                   double sum = 0.0;
+                   for (size_t i = 0; i < n; i++) {
+                     c.dev_ptr[i] = a.dev_ptr[i] + b.dev_ptr[i];
+                     sum += c.dev_ptr[i];
+                   }
+                   *total.dev_ptr = sum;
+                 });
+  graph.add_task("check", MiMMO::Side::Host,
+                 {MiMMO::reads(c), MiMMO::reads(total)}, [](int) {});
+
+  /* only the inputs are uploaded, and only the results downloaded */
+  graph.execute();
+  MiMMO::TaskGraphStats stats = graph.return_stats();
+
+  bool correct = stats.num_tasks == 5 && stats.num_uploads == 2 &&
+                 stats.upload_bytes == 2 * n * sizeof(double) &&
+                 stats.num_downloads == 2 &&
+                 stats.download_bytes == (n + 1) * sizeof(double) &&
+                 stats.num_queues == 2 && stats.num_queue_waits == 1 &&
+                 stats.num_host_waits == 1;
+
+  for (size_t i = 0; i < n; i++)
+    correct = correct && c.host_ptr[i] == 2.0 * i + 3.0;
+  correct = correct && total.host_value == n * (n - 1.0) + 3.0 * n;
+
+  /* the executed graph has transfers, and a dashed edge between queues */
+  const std::string dot = graph.return_dot();
+  correct = correct && dot.find("upload a") != std::string::npos &&
+            dot.find("download total") != std::string::npos &&
+            dot.find("style=dashed") != std::string::npos;
+
+  /* a graph that only reads up-to-date data transfers nothing */
+  MiMMO::TaskGraph reader(memory_manager);
+  reader.set_valid(&c, true, true);
+  reader.add_task("read c", MiMMO::Side::Device, {MiMMO::reads(c)},
+                  [](int) {});
+  reader.add_task("read c on host", MiMMO::Side::Host, {MiMMO::reads(c)},
+                  [](int) {});
+  reader.execute();
+  stats = reader.return_stats();
+  correct = correct && stats.num_uploads == 0 && stats.num_downloads == 0 &&
+            stats.num_host_waits == 0;
+
+  memory_manager.free_array(a);
+  memory_manager.free_array(b);
+  memory_manager.free_array(c);
+  memory_manager.destroy_scalar(total);
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+#ifndef _OPENACC
+/**
+ * @brief Prefetch test with emulated device memory.
+ */
+TEST_CASE("Prefetches", "[mimmo]") {
+  /* slow transfers keep the prefetch queue busy for a while */
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>(
+      MiMMO::EmulatedDeviceConfig{10.0, 0.0005, 0.0, 0, true});
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t n = 1000;
+  MiMMO::DualArray<double> a, b, c;
+  memory_manager.alloc_array(a, "a", n, true);
+  memory_manager.alloc_array(b, "b", n, true);
+  memory_manager.alloc_array(c, "c", n, true);
+
+  for (size_t i = 0; i < n; i++) {
+    a.host_ptr[i] = i;
+    b.host_ptr[i] = 2.0 * i;
+    c.host_ptr[i] = 3.0 * i;
+  }
+
+  /* required right away: late */
+  memory_manager.prefetch_to_device(a, 0, n);
+  memory_manager.require(a, MiMMO::Side::Device, 0, n);
+  MiMMO::PrefetchStats stats = memory_manager.return_prefetch_stats();
+  bool correct = stats.num_prefetches == 1 && stats.num_late == 1 &&
+                 stats.late_wait_seconds > 0.0 && a.dev_ptr[n - 1] == n - 1.0;
+
+  /* required once finished, for a part of the range: hit */
+  memory_manager.prefetch_to_device(b, 0, n);
+  memory_manager.wait_queue(MiMMO::prefetch_queue);
+  memory_manager.require(b, MiMMO::Side::Device, 0, n / 2);
+  stats = memory_manager.return_prefetch_stats();
+  correct = correct && stats.num_hits == 1 && stats.num_late == 1 &&
+            b.dev_ptr[n / 2 - 1] == n - 2.0;
+
+  /* not prefetched, or not the whole range: miss */
+  memory_manager.require(c, MiMMO::Side::Device, 0, n);
+  c.dev_ptr[0] = -1.0;
+  memory_manager.prefetch_to_host(c, 0, n / 2);
+  memory_manager.require(c, MiMMO::Side::Host, 0, n);
+  stats = memory_manager.return_prefetch_stats();
+  correct = correct && stats.num_misses == 2 && c.host_ptr[0] == -1.0 &&
+            c.dev_ptr[n - 1] == 3.0 * (n - 1);
+
+  /* phase-ahead uploads are required when the phase begins */
+  a.host_ptr[0] = 5.0;
+  b.host_ptr[0] = 6.0;
+  memory_manager.next_phase_uses("solve", a, b);
+  memory_manager.begin_phase("solve");
+  stats = memory_manager.return_prefetch_stats();
+  correct = correct && stats.num_prefetches == 5 &&
+            stats.num_hits + stats.num_late == 4 && a.dev_ptr[0] == 5.0 &&
+            b.dev_ptr[0] == 6.0;
+  memory_manager.end_phase("solve");
+
+  /* prefetches of freed objects are unused */
+  memory_manager.prefetch_to_device(a, 0, n);
+  memory_manager.report_memory_usage();
+  memory_manager.free_array(a);
+  memory_manager.free_array(b);
+  memory_manager.free_array(c);
+  stats = memory_manager.return_prefetch_stats();
+  correct = correct && stats.num_unused == 1 &&
+            stats.prefetch_bytes == 4 * n * sizeof(double) +
+                                        (n / 2) * sizeof(double) +
+                                        n * sizeof(double);
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
+#ifndef _OPENACC
+/**
+ * @brief Ring of time levels test with emulated device memory.
+ */
+TEST_CASE("Rings of time levels", "[mimmo]") {
+  auto backend = std::make_shared<MiMMO::EmulatedDeviceBackend>(
+      MiMMO::EmulatedDeviceConfig{0.0, 0.0, 0.0, 0, false});
+  MiMMO::DualMemoryManager memory_manager(backend);
+
+  const size_t n = 100;
+  MiMMO::DualRing<double, 3> ring;
+  memory_manager.alloc_ring(ring, "u", n, true);
+  const std::pair<size_t, size_t> usage =
+      memory_manager.return_total_memory_usage();
+
+  /* level l holds value l */
+  for (size_t level = 0; level < 3; level++) {
+    const MiMMO::DualArray<double> view = MiMMO::ring_level(ring, level);
+    for (size_t i = 0; i < n; i++)
+      view.host_ptr[i] = level;
+  }
+  memory_manager.update_ring_host_to_device(ring);
+  double *const slot_0 = MIMMO_RING_LEVEL_PTR(ring, 0);
+
+  /* rotation moves the descriptor only */
+  const size_t transferred = backend->stats().bytes_to_device;
+  memory_manager.rotate_ring(ring);
+
+  bool correct = backend->stats().bytes_to_device - transferred ==
+                     3 * sizeof(size_t) &&
+                 MIMMO_RING_LEVEL_PTR(ring, 1) == slot_0 &&
+                 memory_manager.return_total_memory_usage() == usage;
+
+  for (size_t i = 0; i < n; i++)
+    correct = correct && MIMMO_RING_LEVEL_PTR(ring, 0)[i] == 2.0 &&
+              MIMMO_RING_LEVEL_PTR(ring, 1)[i] == 0.0 &&
+              MIMMO_RING_LEVEL_PTR(ring, 2)[i] == 1.0;
+
+  /* each level moves on its own */
+  double *const new_level = MIMMO_RING_LEVEL_PTR(ring, 0);
+  for (size_t i = 0; i < n; i++)
+    new_level[i] = -1.0;
+
+  const size_t downloaded = backend->stats().bytes_from_device;
+  memory_manager.update_ring_level_device_to_host(ring, 0);
+
+  const MiMMO::DualArray<double> level_0 = MiMMO::ring_level(ring, 0);
+  const MiMMO::DualArray<double> level_1 = MiMMO::ring_level(ring, 1);
+  correct = correct &&
+            backend->stats().bytes_from_device - downloaded ==
+                n * sizeof(double) &&
+            level_0.host_ptr[n - 1] == -1.0 && level_1.host_ptr[0] == 0.0;
+
+  /* a full turn restores the initial levels */
+  memory_manager.rotate_ring(ring);
+  memory_manager.rotate_ring(ring);
+  correct = correct && ring.head == 0 &&
+            MIMMO_RING_LEVEL_PTR(ring, 0) == slot_0;
+
+  memory_manager.free_ring(ring);
+
+  REQUIRE(correct);
+  REQUIRE(backend->stats().allocated_bytes == 0);
+}
+#endif // _OPENACC
+
 /**
  * @brief Scalar value update test.
  */
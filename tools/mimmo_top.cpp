@@ -0,0 +1,184 @@
+/**
+ * @file mimmo_top.cpp
+ *
+ * @brief Live monitor of the statistics published by a running process.
+ *
+ * Attaches to the statistics page of a process that called
+ * DualMemoryManager::enable_stats_export(), and periodically displays
+ * its memory totals and peaks, transfer rates, and the labels using the
+ * most memory. The monitored process is never slowed down or blocked.
+ *
+ * Usage: mimmo-top <pid | page name> [refresh interval in s] [refreshes]
+ *
+ * @see MiMMO::DualMemoryManager::enable_stats_export
+ */
+
+#include "mimmo/api.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <signal.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Returns a number of bytes in human-readable units.
+ *
+ * @param bytes Number of bytes.
+ *
+ * @return      Formatted size (e.g. "12.3 MiB").
+ */
+static std::string format_bytes(const double bytes) {
+  const char *const units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+  double value = bytes;
+  int unit = 0;
+
+  while (value >= 1024.0 && unit < 4) {
+    value /= 1024.0;
+    unit++;
+  }
+
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << value << " "
+      << units[unit];
+  return out.str();
+}
+
+/**
+ * @brief Prints a snapshot, with transfer rates since an older one.
+ *
+ * @param name     Name of the statistics page.
+ * @param current  Current snapshot.
+ * @param previous Snapshot of an older update (same as current at the
+ *                 first refresh).
+ */
+static void display(const std::string &name,
+                    const MiMMO::StatsSnapshot &current,
+                    const MiMMO::StatsSnapshot &previous) {
+
+  const double seconds = (current.time_ns - previous.time_ns) * 1e-9;
+  const auto rate = [seconds](const uint64_t now, const uint64_t before) {
+    return seconds > 0.0 ? (now - before) / seconds : 0.0;
+  };
+
+  /* clear screen and move to the top left corner */
+  std::cout << "\033[H\033[2J";
+
+  std::cout << "mimmo-top - " << name << " (pid " << current.pid
+            << ", update " << current.num_updates << ")\n\n";
+  std::cout << std::left << std::setw(12) << "" << std::right
+            << std::setw(14) << "Used" << std::setw(14) << "Peak" << "\n";
+  std::cout << std::left << std::setw(12) << "Host" << std::right
+            << std::setw(14) << format_bytes(current.host_bytes)
+            << std::setw(14) << format_bytes(current.host_peak_bytes)
+            << "\n";
+  std::cout << std::left << std::setw(12) << "Device" << std::right
+            << std::setw(14) << format_bytes(current.dev_bytes)
+            << std::setw(14) << format_bytes(current.dev_peak_bytes)
+            << "\n\n";
+
+  std::cout << "Objects: " << current.num_objects
+            << "   Allocs: " << current.num_allocs
+            << "   Frees: " << current.num_frees << "\n\n";
+
+  std::cout << std::left << std::setw(12) << "Transfers" << std::right
+            << std::setw(14) << "Count" << std::setw(14) << "Total"
+            << std::setw(14) << "Rate/s" << std::setw(14) << "Count/s"
+            << "\n";
+  std::cout << std::left << std::setw(12) << "H2D" << std::right
+            << std::setw(14) << current.to_device_count << std::setw(14)
+            << format_bytes(current.to_device_bytes) << std::setw(14)
+            << format_bytes(
+                   rate(current.to_device_bytes, previous.to_device_bytes))
+            << std::setw(14) << std::fixed << std::setprecision(1)
+            << rate(current.to_device_count, previous.to_device_count)
+            << "\n";
+  std::cout << std::left << std::setw(12) << "D2H" << std::right
+            << std::setw(14) << current.from_device_count << std::setw(14)
+            << format_bytes(current.from_device_bytes) << std::setw(14)
+            << format_bytes(rate(current.from_device_bytes,
+                                 previous.from_device_bytes))
+            << std::setw(14)
+            << rate(current.from_device_count, previous.from_device_count)
+            << "\n\n";
+
+  std::cout << std::left << std::setw(MiMMO::stats_label_chars) << "Label"
+            << std::right << std::setw(14) << "Host" << std::setw(14)
+            << "Device" << "\n";
+  for (uint64_t i = 0; i < current.num_labels; i++) {
+    const MiMMO::StatsLabel &label = current.labels[i];
+    std::cout << std::left << std::setw(MiMMO::stats_label_chars)
+              << label.label << std::right << std::setw(14)
+              << format_bytes(label.host_bytes) << std::setw(14)
+              << format_bytes(label.dev_bytes) << "\n";
+  }
+  if (current.num_other_labels > 0)
+    std::cout << "(" << current.num_other_labels << " more labels)\n";
+
+  std::cout << std::flush;
+
+  return;
+}
+
+int main(int argc, char *argv[]) {
+
+  if (argc < 2 || argc > 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " <pid | page name> [interval in s] [refreshes]\n";
+    return EXIT_FAILURE;
+  }
+
+  /* a number is a process identifier */
+  const std::string target = argv[1];
+  char *end = nullptr;
+  const long pid = std::strtol(target.c_str(), &end, 10);
+  const std::string name =
+      (*end == '\0' && pid > 0) ? MiMMO::default_stats_page_name(pid)
+                                : target;
+
+  const double interval = argc > 2 ? std::atof(argv[2]) : 1.0;
+  const long refreshes = argc > 3 ? std::atol(argv[3]) : 0;
+
+  const MiMMO::StatsPage *const page = MiMMO::attach_stats_page(name);
+
+  if (page == nullptr) {
+    std::cerr << "No statistics page '" << name << "' found.\n";
+    return EXIT_FAILURE;
+  }
+
+  MiMMO::StatsSnapshot current;
+  MiMMO::StatsSnapshot last;     /* last snapshot read */
+  MiMMO::StatsSnapshot previous; /* last snapshot of an older update */
+  bool first = true;
+
+  for (long refresh = 0; refreshes == 0 || refresh < refreshes; refresh++) {
+    if (refresh > 0)
+      std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+
+    if (!MiMMO::read_stats_page(page, current))
+      continue;
+
+    /* rates are measured between two different updates */
+    if (first)
+      previous = current;
+    else if (current.num_updates != last.num_updates)
+      previous = last;
+    last = current;
+    first = false;
+
+    display(name, current, previous);
+
+    /* stop once the monitored process exited */
+    if (kill(static_cast<pid_t>(current.pid), 0) != 0) {
+      std::cout << "\nProcess " << current.pid << " exited.\n";
+      break;
+    }
+  }
+
+  MiMMO::detach_stats_page(page);
+
+  return EXIT_SUCCESS;
+}